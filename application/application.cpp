@@ -27,6 +27,7 @@
 #include "../physics/constraints/fixedConstraint.h"
 
 #include "../physics/misc/serialization.h"
+#include "../physics/misc/tickCapture.h"
 
 #include "worlds.h"
 #include "tickerThread.h"
@@ -344,6 +345,8 @@ void setupWorld(int argc, const char** args) {
 }
 
 void setupPhysics() {
+	// the debug overlay shows the tick latency percentiles of the last 5 seconds
+	physicsMeasure.setLatencyWindow(std::chrono::seconds(5));
 	physicsThread = TickerThread(TICKS_PER_SECOND, TICK_SKIP_TIME, [] () {
 		physicsMeasure.mark(PhysicsProcess::OTHER);
 
@@ -366,6 +369,7 @@ void setupDebug() {
 void stop(int returnCode) {
 	Log::info("Closing physics");
 	physicsThread.stop();
+	stopCapture();
 
 	Log::info("Closing screen");
 	screen.onClose();
@@ -413,6 +417,39 @@ void runTick() {
 }
 
 
+// Capture
+
+std::ofstream captureFile;
+std::unique_ptr<TickCapture> capture;
+
+void startCapture(const char* fileName) {
+	if (capture != nullptr) stopCapture();
+	captureFile.open(fileName, std::ios::binary);
+	if (!captureFile) {
+		Log::error("Could not open %s for the tick capture", fileName);
+		return;
+	}
+	capture = std::make_unique<TickCapture>(captureFile, world.deltaT);
+	world.setCapture(capture.get());
+	Log::info("Capturing ticks to %s", fileName);
+}
+
+void stopCapture() {
+	if (capture == nullptr) return;
+	world.setCapture(nullptr);
+	world.syncReadOnlyOperation([] () {
+		capture->finish(world);
+	});
+	Log::info("Captured %d ticks with %d keyframes", int(capture->getTickCount()), int(capture->getKeyframeCount()));
+	capture.reset();
+	captureFile.close();
+}
+
+bool isCapturing() {
+	return capture != nullptr;
+}
+
+
 // Flying
 
 void toggleFlying() {
@@ -18,4 +18,9 @@ double getSpeed();
 void stop(int returnCode);
 void toggleFlying();
 
+// records every tick of the world to the given file, to be rerun with benchmarks --replay
+void startCapture(const char* fileName);
+void stopCapture();
+bool isCapturing();
+
 };
\ No newline at end of file
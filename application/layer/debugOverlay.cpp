@@ -62,6 +62,10 @@ void DebugOverlay::onRender() {
 	addDebugField(screen->dimension, GUI::font, "AVG No Collide GJK Iterations", gjkNoCollideIterStats.avg(), "");
 	addDebugField(screen->dimension, GUI::font, "TPS", physicsMeasure.getAvgTPS(), "");
 	addDebugField(screen->dimension, GUI::font, "FPS", graphicsMeasure.getAvgTPS(), "");
+	const LatencyHistogram& tickLatency = physicsMeasure.getLatency().tick;
+	addDebugField(screen->dimension, GUI::font, "Tick p50", tickLatency.getPercentile(50.0) / 1000000.0, "ms");
+	addDebugField(screen->dimension, GUI::font, "Tick p99", tickLatency.getPercentile(99.0) / 1000000.0, "ms");
+	addDebugField(screen->dimension, GUI::font, "Tick p99.9", tickLatency.getPercentile(99.9) / 1000000.0, "ms");
 	/*addDebugField(screen->dimension, GUI::font, "World Kinetic Energy", screen->world->getTotalKineticEnergy(), "");
 	addDebugField(screen->dimension, GUI::font, "World Potential Energy", screen->world->getTotalPotentialEnergy(), "");
 	addDebugField(screen->dimension, GUI::font, "World Energy", screen->world->getTotalEnergy(), "");*/
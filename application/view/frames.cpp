@@ -3,6 +3,7 @@
 
 #include "../physics/misc/toString.h"
 #include "../graphics/debug/visualDebug.h"
+#include "../graphics/debug/debug.h"
 #include "../graphics/renderUtils.h"
 #include "../graphics/texture.h"
 
@@ -424,6 +425,23 @@ void BigFrame::renderDebugFrame() {
 
 			ImGui::TreePop();
 		}
+
+		if (ImGui::TreeNode("Tick capture")) {
+			if (isCapturing()) {
+				if (ImGui::Button("Stop capture")) stopCapture();
+			} else {
+				if (ImGui::Button("Start capture")) startCapture("capture.p3dticks");
+			}
+
+			ImGui::TreePop();
+		}
+
+		if (ImGui::TreeNode("Debug capture")) {
+			ImGui::Text("Records: %d, overwritten: %d", int(Debug::getRecordCount()), int(Debug::getDroppedRecordCount()));
+			if (ImGui::Button("Dump debug capture")) AppDebug::dumpDebugCapture("debug.p3ddebug");
+
+			ImGui::TreePop();
+		}
 	}
 }
 
@@ -0,0 +1,83 @@
+#include "worldBenchmark.h"
+
+#include <chrono>
+
+#include "../util/log.h"
+#include "../physics/world.h"
+#include "../physics/misc/shapeLibrary.h"
+
+/*
+	Moves selections of 2000 and 10000 parts in a world of 20000 parts back and forth, like dragging them in the editor
+	Times moving them one by one against moving them in a single batch edit
+*/
+class BatchEditBenchmark : public WorldBenchmark {
+	std::vector<Part*> parts;
+	double separateNanos[2]{0.0, 0.0};
+	double batchNanos[2]{0.0, 0.0};
+	// the moves of each selection since the last clearResults
+	int moveCount = 0;
+	size_t selectionSizes[2]{2000, 10000};
+public:
+	BatchEditBenchmark() : WorldBenchmark("batchEdit", 100) {}
+
+	void init() {
+		Polyhedron partShape = Library::createBox(0.5f, 0.5f, 0.5f);
+		for(int x = 0; x < 40; x++) {
+			for(int y = 0; y < 25; y++) {
+				for(int z = 0; z < 20; z++) {
+					parts.push_back(new Part(partShape, GlobalCFrame(x * 1.5, y * 1.5, z * 1.5), basicProperties));
+				}
+			}
+		}
+		world.addParts(parts);
+	}
+
+	void moveSelection(size_t selectionSize, Vec3 offset) {
+		for(size_t i = 0; i < selectionSize; i++) {
+			parts[i]->setCFrame(parts[i]->getCFrame().translated(offset));
+		}
+	}
+
+	void run() override {
+		for(int s = 0; s < 2; s++) {
+			for(int i = 0; i < tickCount; i++) {
+				Vec3 offset(0.0, 0.0, i % 2 == 0 ? 50.0 : -50.0);
+
+				auto start = std::chrono::high_resolution_clock::now();
+				moveSelection(selectionSizes[s], offset);
+				auto middle = std::chrono::high_resolution_clock::now();
+				{
+					BatchEdit batch(world);
+					moveSelection(selectionSizes[s], -offset);
+				}
+				auto finish = std::chrono::high_resolution_clock::now();
+
+				separateNanos[s] += (middle - start).count();
+				batchNanos[s] += (finish - middle).count();
+			}
+		}
+		moveCount += tickCount;
+	}
+
+	void cleanup() override {
+		parts.clear();
+		WorldBenchmark::cleanup();
+	}
+
+	void clearResults() override {
+		WorldBenchmark::clearResults();
+		for(int s = 0; s < 2; s++) {
+			separateNanos[s] = 0.0;
+			batchNanos[s] = 0.0;
+		}
+		moveCount = 0;
+	}
+
+	void printResults(double timeTakenMillis) override {
+		for(int s = 0; s < 2; s++) {
+			Log::print("%d of %d parts moved, %d times\n", int(selectionSizes[s]), int(world.getPartCount()), moveCount);
+			Log::print("one by one:   %.4fms per move\n", separateNanos[s] / moveCount / 1000000.0);
+			Log::print("batch edit:   %.4fms per move\n", batchNanos[s] / moveCount / 1000000.0);
+		}
+	}
+} batchEditBenchmark;
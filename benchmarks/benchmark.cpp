@@ -1,27 +1,161 @@
 #include "benchmark.h"
+#include "benchmarkResults.h"
+#include "benchmarkCompare.h"
+#include "sceneSweep.h"
+#include "worldBenchmark.h"
+#include "tickReplayRunner.h"
 
 #include <chrono>
 #include <vector>
 #include <iostream>
+#include <fstream>
+#include <sstream>
 #include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
 
 #include "../util/log.h"
+#include "../physics/zoneProfiler.h"
+#include "../physics/hardwareCounters.h"
 
-std::vector<Benchmark*>* knownBenchmarks = nullptr;
+// '*' matches any sequence of characters and '?' any single character
+static bool matchesPattern(const char* pattern, const char* name) {
+	if(*pattern == '\0') return *name == '\0';
+	if(*pattern == '*') {
+		for(const char* rest = name; ; rest++) {
+			if(matchesPattern(pattern + 1, rest)) return true;
+			if(*rest == '\0') return false;
+		}
+	}
+	if(*name == '\0') return false;
+	if(*pattern == '?' || *pattern == *name) return matchesPattern(pattern + 1, name + 1);
+	return false;
+}
+
+static double millisSince(std::chrono::high_resolution_clock::time_point start) {
+	return (std::chrono::high_resolution_clock::now() - start).count() / 1000000.0;
+}
+
+// every warmup and measured run starts from a fresh init, the benchmark is cleaned up between runs and after the results are printed
+static BenchmarkResult runBenchmark(Benchmark* bench, int warmupRuns, int measuredRuns) {
+	BenchmarkResult result{bench};
+
+	Log::setColor(Log::WHITE);
+	std::cout << "creating benchmark " << bench->name << "\n";
+	auto createStart = std::chrono::high_resolution_clock::now();
+	bench->init();
+	result.initMillis = millisSince(createStart);
+	std::cout << "finished creating benchmark, took " << result.initMillis << "ms\n";
+
+	bool isFirstRun = true;
+	auto recreate = [&]() {
+		if(!isFirstRun) {
+			bench->cleanup();
+			bench->init();
+		}
+		isFirstRun = false;
+	};
+
+	for(int i = 0; i < warmupRuns; i++) {
+		recreate();
+		std::cout << "warmup " << (i + 1) << "/" << warmupRuns << "...\n";
+		auto runStart = std::chrono::high_resolution_clock::now();
+		bench->run();
+		std::cout << "finished warmup after " << millisSince(runStart) << "ms\n";
+	}
+	bench->clearResults();
+
+	for(int i = 0; i < measuredRuns; i++) {
+		recreate();
+		std::cout << "running " << (i + 1) << "/" << measuredRuns << "...\n";
+		auto runStart = std::chrono::high_resolution_clock::now();
+		bench->run();
+		double deltaTimeMS = millisSince(runStart);
+		std::cout << "finished after " << deltaTimeMS << "ms\n";
+		result.runMillis.push_back(deltaTimeMS);
+	}
+	result.statistics = computeStatistics(result.runMillis);
+
+	bench->printResults(result.statistics.mean);
+	bench->cleanup();
+	Log::setColor(Log::WHITE);
+	if(measuredRuns > 1) {
+		Log::print("%s: mean %.3fms, median %.3fms, stddev %.3fms, min %.3fms over %d runs\n", bench->name, result.statistics.mean, result.statistics.median, result.statistics.stddev, result.statistics.min, measuredRuns);
+	}
 
-Benchmark::Benchmark(const char* name) : name(name) {
-	if(knownBenchmarks == nullptr) { knownBenchmarks = new std::vector<Benchmark*>(); }
-	knownBenchmarks->push_back(this);
+#ifdef ENABLE_ZONE_PROFILER
+	std::string traceFile = std::string(bench->name) + ".trace.json";
+	std::ofstream traceStream(traceFile);
+	ZoneProfiler::exportChromeTrace(traceStream);
+	std::cout << "wrote " << ZoneProfiler::getEventCount() << " zones to " << traceFile << "\n";
+	ZoneProfiler::clear();
+#endif
+	return result;
 }
 
-int main() {
+// returns the exit code, 2 when something got slower or is missing
+static int compareToBaseline(const char* baselineFile, std::istream& results, double thresholdPercent) {
+	std::ifstream baselineStream(baselineFile);
+	if(!baselineStream) {
+		Log::error("Could not open %s", baselineFile);
+		return 1;
+	}
+	try {
+		Log::print("\ncompared to %s:\n", baselineFile);
+		if(compareBenchmarkResults(baselineStream, results, thresholdPercent)) {
+			Log::error("Benchmarks got slower than the baseline or are missing");
+			return 2;
+		}
+		return 0;
+	} catch(const char* error) {
+		Log::error("%s", error);
+		return 1;
+	}
+}
+
+// parses a list like "1000,2000,4000", returns an empty list if malformed
+static std::vector<size_t> parseSizes(const char* list) {
+	std::vector<size_t> sizes;
+	const char* cur = list;
+	while(*cur != '\0') {
+		char* end;
+		long long size = std::strtoll(cur, &end, 10);
+		if(end == cur || size <= 0 || (*end != ',' && *end != '\0')) return std::vector<size_t>();
+		sizes.push_back(static_cast<size_t>(size));
+		cur = (*end == ',') ? end + 1 : end;
+	}
+	return sizes;
+}
+
+static void printUsage() {
+	std::cout << "usage: benchmarks [--all] [--list] [--warmup N] [--repeat N] [--counters] [--memory] [--json FILE] [--compare BASELINE [--results FILE] [--threshold P]] [NAME_OR_GLOB...]\n";
+	std::cout << "       benchmarks --sweep N1,N2,... [--scene NAME=VALUE,...] [--ticks T] [--json FILE]\n";
+	std::cout << "       benchmarks --replay CAPTURE [--range FIRST-LAST] [--json FILE]\n";
+	std::cout << "  with no arguments a benchmark name is read from the console\n";
+	std::cout << "  --warmup N   runs each benchmark N times before measuring, default 1\n";
+	std::cout << "  --repeat N   measures N runs of each benchmark, default 5\n";
+	std::cout << "  --counters   counts cycles, instructions, cache and branch misses per physics process, Linux only\n";
+	std::cout << "  --memory     samples the memory of the world after every tick for per tick peaks, slows the ticks down\n";
+	std::cout << "  --json FILE  writes the results to FILE\n";
+	std::cout << "  --compare BASELINE  compares the results to those in BASELINE, exits with 2 if anything got slower\n";
+	std::cout << "  --results FILE      compares the results in FILE instead of running benchmarks\n";
+	std::cout << "  --threshold P       the percentage a benchmark or phase must slow down by to count, default 5\n";
+	std::cout << "  --sweep N1,N2,...   generates the scene at each part count and reports ticks per second and the growth of each phase\n";
+	std::cout << "  --scene LIST        the parameters of the generated scene, see SceneParameters, such as terrainFraction=0.2,chainCount=10\n";
+	std::cout << "  --ticks T           the ticks measured at each size of a sweep, after T/5 warmup ticks, default 500\n";
+	std::cout << "  --replay CAPTURE    reruns a tick capture of the application and profiles every tick, listing the slowest\n";
+	std::cout << "  --range FIRST-LAST  only profiles the ticks of the replay from age FIRST up to LAST, the ticks before are run unprofiled\n";
+}
+
+static Benchmark* askForBenchmark() {
 	std::cout << "The following benchmarks are available:\n";
 	Log::setColor(Log::AQUA);
 	for(Benchmark* b : *knownBenchmarks) {
 		std::cout << "  " << b->name << "\n";
 	}
 
-	Benchmark* bench;
 	while(true) {
 		Log::setColor(Log::WHITE);
 		std::cout << "Run> ";
@@ -30,27 +164,174 @@ int main() {
 		std::cin >> benchName;
 		for(Benchmark* b : *knownBenchmarks) {
 			if(benchName == b->name) {
-				bench = b;
-				goto found;
+				return b;
 			}
 		}
 	}
-	found:
+}
 
-	Log::setColor(Log::WHITE);
-	
-	std::cout << "creating benchmark\n";
-	auto createStart = std::chrono::high_resolution_clock::now();
-	bench->init();
-	auto createFinish = std::chrono::high_resolution_clock::now();
-	std::cout << "finished creating benchmark, took " << (createFinish - createStart).count() / 1000000.0 << "ms\n";
-	std::cout << "running...\n";
-	auto runStart = std::chrono::high_resolution_clock::now();
-	bench->run();
-	auto runFinish = std::chrono::high_resolution_clock::now();
-	double deltaTimeMS = (runFinish - runStart).count() / 1000000.0;
-	std::cout << "finished after " << deltaTimeMS << "ms\n";
-	bench->printResults(deltaTimeMS);
-	Log::setColor(Log::WHITE);
+int main(int argc, const char** argv) {
+	if(argc <= 1) {
+		runBenchmark(askForBenchmark(), 0, 1);
+		return 0;
+	}
+
+	std::vector<Benchmark*> selected;
+	int warmupRuns = 1;
+	int measuredRuns = 5;
+	const char* jsonFile = nullptr;
+	const char* baselineFile = nullptr;
+	const char* resultsFile = nullptr;
+	double thresholdPercent = 5.0;
+	std::vector<size_t> sweepSizes;
+	SceneParameters scene;
+	int sweepTicks = 500;
+	const char* replayFile = nullptr;
+	size_t replayFirstAge = 0;
+	size_t replayLastAge = SIZE_MAX;
+
+	for(int i = 1; i < argc; i++) {
+		const char* arg = argv[i];
+		if(std::strcmp(arg, "--all") == 0) {
+			selected = *knownBenchmarks;
+		} else if(std::strcmp(arg, "--list") == 0) {
+			for(Benchmark* b : *knownBenchmarks) std::cout << b->name << "\n";
+			return 0;
+		} else if(std::strcmp(arg, "--help") == 0) {
+			printUsage();
+			return 0;
+		} else if(std::strcmp(arg, "--warmup") == 0 && i + 1 < argc) {
+			warmupRuns = std::atoi(argv[++i]);
+		} else if(std::strcmp(arg, "--repeat") == 0 && i + 1 < argc) {
+			measuredRuns = std::atoi(argv[++i]);
+		} else if(std::strcmp(arg, "--counters") == 0) {
+			// benchmarks tick on the main thread, which is the thread the counters count
+			if(!HardwareCounters::enable()) {
+				Log::warn("Hardware counters unavailable: %s", HardwareCounters::getUnavailableReason());
+			} else if(HardwareCounters::getUnavailableReason() != nullptr) {
+				Log::warn("Some hardware counters are unavailable: %s", HardwareCounters::getUnavailableReason());
+			}
+		} else if(std::strcmp(arg, "--memory") == 0) {
+			WorldBenchmark::sampleMemoryEveryTick = true;
+		} else if(std::strcmp(arg, "--json") == 0 && i + 1 < argc) {
+			jsonFile = argv[++i];
+		} else if(std::strcmp(arg, "--compare") == 0 && i + 1 < argc) {
+			baselineFile = argv[++i];
+		} else if(std::strcmp(arg, "--results") == 0 && i + 1 < argc) {
+			resultsFile = argv[++i];
+		} else if(std::strcmp(arg, "--threshold") == 0 && i + 1 < argc) {
+			thresholdPercent = std::atof(argv[++i]);
+		} else if(std::strcmp(arg, "--sweep") == 0 && i + 1 < argc) {
+			sweepSizes = parseSizes(argv[++i]);
+			if(sweepSizes.empty()) {
+				Log::error("Malformed sweep sizes %s", argv[i]);
+				return 1;
+			}
+		} else if(std::strcmp(arg, "--scene") == 0 && i + 1 < argc) {
+			if(!scene.parse(argv[++i])) {
+				Log::error("Malformed scene parameters %s", argv[i]);
+				return 1;
+			}
+		} else if(std::strcmp(arg, "--ticks") == 0 && i + 1 < argc) {
+			sweepTicks = std::atoi(argv[++i]);
+		} else if(std::strcmp(arg, "--replay") == 0 && i + 1 < argc) {
+			replayFile = argv[++i];
+		} else if(std::strcmp(arg, "--range") == 0 && i + 1 < argc) {
+			char* end;
+			replayFirstAge = static_cast<size_t>(std::strtoull(argv[++i], &end, 10));
+			if(*end != '-') {
+				Log::error("Malformed range %s", argv[i]);
+				return 1;
+			}
+			replayLastAge = static_cast<size_t>(std::strtoull(end + 1, &end, 10));
+		} else if(arg[0] == '-') {
+			Log::error("Unknown option %s", arg);
+			printUsage();
+			return 1;
+		} else {
+			bool found = false;
+			for(Benchmark* b : *knownBenchmarks) {
+				if(matchesPattern(arg, b->name)) {
+					if(std::find(selected.begin(), selected.end(), b) == selected.end()) selected.push_back(b);
+					found = true;
+				}
+			}
+			if(!found) {
+				Log::error("No benchmark matches %s", arg);
+				return 1;
+			}
+		}
+	}
+
+	if(replayFile != nullptr) {
+		std::ofstream jsonStream;
+		if(jsonFile != nullptr) {
+			jsonStream.open(jsonFile);
+			if(!jsonStream) {
+				Log::error("Could not open %s", jsonFile);
+				return 1;
+			}
+		}
+		int exitCode = runTickReplay(replayFile, replayFirstAge, replayLastAge, (jsonFile != nullptr) ? &jsonStream : nullptr);
+		if(exitCode == 0 && jsonFile != nullptr) std::cout << "wrote replay to " << jsonFile << "\n";
+		return exitCode;
+	}
+
+	if(!sweepSizes.empty()) {
+		if(sweepTicks < 1) {
+			printUsage();
+			return 1;
+		}
+		std::ofstream jsonStream;
+		if(jsonFile != nullptr) {
+			jsonStream.open(jsonFile);
+			if(!jsonStream) {
+				Log::error("Could not open %s", jsonFile);
+				return 1;
+			}
+		}
+		runSceneSweep(scene, sweepSizes, sweepTicks / 5, sweepTicks, (jsonFile != nullptr) ? &jsonStream : nullptr);
+		if(jsonFile != nullptr) std::cout << "wrote sweep to " << jsonFile << "\n";
+		return 0;
+	}
+
+	if(resultsFile != nullptr) {
+		if(baselineFile == nullptr) {
+			printUsage();
+			return 1;
+		}
+		std::ifstream resultsStream(resultsFile);
+		if(!resultsStream) {
+			Log::error("Could not open %s", resultsFile);
+			return 1;
+		}
+		return compareToBaseline(baselineFile, resultsStream, thresholdPercent);
+	}
+
+	if(selected.empty() || measuredRuns < 1 || warmupRuns < 0) {
+		printUsage();
+		return 1;
+	}
+
+	std::vector<BenchmarkResult> results;
+	for(Benchmark* bench : selected) {
+		results.push_back(runBenchmark(bench, warmupRuns, measuredRuns));
+	}
+
+	if(jsonFile != nullptr) {
+		std::ofstream jsonStream(jsonFile);
+		if(!jsonStream) {
+			Log::error("Could not open %s", jsonFile);
+			return 1;
+		}
+		writeJSON(jsonStream, results, warmupRuns, measuredRuns);
+		std::cout << "wrote results to " << jsonFile << "\n";
+	}
+
+	if(baselineFile != nullptr) {
+		std::stringstream resultsStream;
+		writeJSON(resultsStream, results, warmupRuns, measuredRuns);
+		return compareToBaseline(baselineFile, resultsStream, thresholdPercent);
+	}
 	return 0;
 }
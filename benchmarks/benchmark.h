@@ -1,5 +1,6 @@
 #pragma once
 
+#include <ostream>
 
 class Benchmark {
 public:
@@ -9,4 +10,11 @@ public:
 	virtual void init() {}
 	virtual void run() = 0;
 	virtual void printResults(double timeTaken) {}
+	// frees what init created, so init can start over for the next run, the results must stay available for writeJSONResults
+	virtual void cleanup() {}
+
+	// called after the warmup runs, so the results only cover the measured runs
+	virtual void clearResults() {}
+	// writes the benchmark specific results as the members of a JSON object, each preceded by a ','
+	virtual void writeJSONResults(std::ostream& ostream) const {}
 };
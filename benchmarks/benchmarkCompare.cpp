@@ -0,0 +1,277 @@
+#include "benchmarkCompare.h"
+
+#include <string>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cctype>
+
+#include "../util/log.h"
+
+// a difference must be this many standard errors large before it is not noise
+#define NOISE_SIGMAS 3.0
+
+/*
+	Just enough JSON to read the results the runner writes
+*/
+struct JSONValue {
+	enum class Type {
+		NUL,
+		BOOLEAN,
+		NUMBER,
+		STRING,
+		ARRAY,
+		OBJECT
+	};
+
+	Type type = Type::NUL;
+	bool boolean = false;
+	double number = 0.0;
+	std::string string;
+	std::vector<JSONValue> elements;
+	std::vector<std::pair<std::string, JSONValue>> members;
+
+	const JSONValue* get(const std::string& key) const {
+		for(const std::pair<std::string, JSONValue>& member : members) {
+			if(member.first == key) return &member.second;
+		}
+		return nullptr;
+	}
+};
+
+class JSONParser {
+	const std::string& text;
+	size_t pos = 0;
+
+	void skipWhitespace() {
+		while(pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) pos++;
+	}
+
+	void expect(char c) {
+		skipWhitespace();
+		if(pos >= text.size() || text[pos] != c) throw "Malformed benchmark results";
+		pos++;
+	}
+
+	std::string parseString() {
+		expect('"');
+		std::string result;
+		while(pos < text.size() && text[pos] != '"') {
+			if(text[pos] == '\\') pos++;
+			if(pos < text.size()) result += text[pos++];
+		}
+		expect('"');
+		return result;
+	}
+
+public:
+	JSONParser(const std::string& text) : text(text) {}
+
+	JSONValue parseValue() {
+		skipWhitespace();
+		if(pos >= text.size()) throw "Unexpected end of benchmark results";
+		JSONValue result;
+		char c = text[pos];
+		if(c == '{') {
+			result.type = JSONValue::Type::OBJECT;
+			pos++;
+			skipWhitespace();
+			if(pos < text.size() && text[pos] == '}') {
+				pos++;
+				return result;
+			}
+			while(true) {
+				std::string key = parseString();
+				expect(':');
+				result.members.emplace_back(std::move(key), parseValue());
+				skipWhitespace();
+				if(pos < text.size() && text[pos] == ',') {
+					pos++;
+					continue;
+				}
+				expect('}');
+				return result;
+			}
+		} else if(c == '[') {
+			result.type = JSONValue::Type::ARRAY;
+			pos++;
+			skipWhitespace();
+			if(pos < text.size() && text[pos] == ']') {
+				pos++;
+				return result;
+			}
+			while(true) {
+				result.elements.push_back(parseValue());
+				skipWhitespace();
+				if(pos < text.size() && text[pos] == ',') {
+					pos++;
+					continue;
+				}
+				expect(']');
+				return result;
+			}
+		} else if(c == '"') {
+			result.type = JSONValue::Type::STRING;
+			result.string = parseString();
+			return result;
+		} else if(text.compare(pos, 4, "null") == 0) {
+			pos += 4;
+			return result;
+		} else if(text.compare(pos, 4, "true") == 0) {
+			result.type = JSONValue::Type::BOOLEAN;
+			result.boolean = true;
+			pos += 4;
+			return result;
+		} else if(text.compare(pos, 5, "false") == 0) {
+			result.type = JSONValue::Type::BOOLEAN;
+			result.boolean = false;
+			pos += 5;
+			return result;
+		} else {
+			const char* start = text.c_str() + pos;
+			char* end;
+			result.type = JSONValue::Type::NUMBER;
+			result.number = std::strtod(start, &end);
+			if(end == start) throw "Malformed benchmark results";
+			pos += end - start;
+			return result;
+		}
+	}
+};
+
+static JSONValue readResults(std::istream& istream) {
+	std::string text((std::istreambuf_iterator<char>(istream)), std::istreambuf_iterator<char>());
+	JSONParser parser(text);
+	JSONValue result = parser.parseValue();
+	if(result.type != JSONValue::Type::OBJECT) throw "Not a benchmark results file";
+	const JSONValue* benchmarks = result.get("benchmarks");
+	if(benchmarks == nullptr || benchmarks->type != JSONValue::Type::ARRAY) throw "Not a benchmark results file";
+	for(const JSONValue& bench : benchmarks->elements) {
+		const JSONValue* name = bench.get("name");
+		if(name == nullptr || name->type != JSONValue::Type::STRING) throw "Benchmark without a name in the results";
+	}
+	return result;
+}
+
+struct Samples {
+	double mean = 0.0;
+	double variance = 0.0;
+	size_t count = 0;
+
+	Samples() = default;
+	Samples(const JSONValue* values) {
+		if(values == nullptr) return;
+		for(const JSONValue& v : values->elements) {
+			mean += v.number;
+			count++;
+		}
+		if(count == 0) return;
+		mean /= count;
+		if(count > 1) {
+			for(const JSONValue& v : values->elements) variance += (v.number - mean) * (v.number - mean);
+			variance /= count - 1;
+		}
+	}
+};
+
+struct Change {
+	std::string name;
+	Samples baseline;
+	Samples current;
+
+	double delta() const { return current.mean - baseline.mean; }
+	double relative() const { return (baseline.mean != 0.0) ? delta() / baseline.mean * 100.0 : 0.0; }
+	double standardError() const {
+		double baselineError = (baseline.count != 0) ? baseline.variance / baseline.count : 0.0;
+		double currentError = (current.count != 0) ? current.variance / current.count : 0.0;
+		return std::sqrt(baselineError + currentError);
+	}
+	// 1 if significantly slower, -1 if significantly faster, compared to minimumChange
+	int significance(double minimumChange) const {
+		double d = delta();
+		if(std::abs(d) <= minimumChange || std::abs(d) <= NOISE_SIGMAS * standardError()) return 0;
+		return (d > 0) ? 1 : -1;
+	}
+};
+
+static const JSONValue* findBenchmark(const JSONValue& results, const std::string& name) {
+	for(const JSONValue& bench : results.get("benchmarks")->elements) {
+		if(bench.get("name")->string == name) return &bench;
+	}
+	return nullptr;
+}
+
+// --memory samples the world after every tick, which slows the ticks down
+static bool sampledMemoryEveryTick(const JSONValue& bench) {
+	const JSONValue* memoryPeakPerTick = bench.get("memoryPeakPerTick");
+	return memoryPeakPerTick != nullptr && memoryPeakPerTick->type == JSONValue::Type::BOOLEAN && memoryPeakPerTick->boolean;
+}
+
+static void printChange(const char* indent, const Change& change, int significance, const char* unit) {
+	if(significance > 0) Log::setColor(Log::STRONG | Log::RED);
+	else if(significance < 0) Log::setColor(Log::STRONG | Log::GREEN);
+	else Log::setColor(Log::WHITE);
+	const char* verdict = (significance > 0) ? "SLOWER" : (significance < 0) ? "faster" : "";
+	Log::print("%s%-24s %10.4f%s -> %10.4f%s  %+9.4f%s %+7.2f%%  %s\n", indent, (change.name + ":").c_str(), change.baseline.mean, unit, change.current.mean, unit, change.delta(), unit, change.relative(), verdict);
+}
+
+bool compareBenchmarkResults(std::istream& baselineStream, std::istream& currentStream, double thresholdPercent) {
+	JSONValue baseline = readResults(baselineStream);
+	JSONValue current = readResults(currentStream);
+	double threshold = thresholdPercent / 100.0;
+
+	bool anySlower = false;
+	for(const JSONValue& bench : current.get("benchmarks")->elements) {
+		const std::string& name = bench.get("name")->string;
+		const JSONValue* baseBench = findBenchmark(baseline, name);
+		if(baseBench == nullptr) {
+			Log::setColor(Log::WHITE);
+			Log::print("%s: not in the baseline\n", name.c_str());
+			continue;
+		}
+
+		if(sampledMemoryEveryTick(*baseBench) != sampledMemoryEveryTick(bench)) {
+			Log::setColor(Log::STRONG | Log::YELLOW);
+			Log::print("%s: only one side sampled memory every tick, its times include the sampling\n", name.c_str());
+		}
+
+		Change total{name, Samples(baseBench->get("runsMs")), Samples(bench.get("runsMs"))};
+		int totalSignificance = total.significance(threshold * total.baseline.mean);
+		if(totalSignificance > 0) anySlower = true;
+		printChange("", total, totalSignificance, "ms");
+
+		const JSONValue* basePhases = baseBench->get("physicsBreakdownRunsMsPerTick");
+		const JSONValue* currentPhases = bench.get("physicsBreakdownRunsMsPerTick");
+		if(basePhases == nullptr || currentPhases == nullptr) continue;
+
+		std::vector<Change> phases;
+		double baseTickTime = 0.0;
+		for(const std::pair<std::string, JSONValue>& phase : currentPhases->members) {
+			Change change{phase.first, Samples(basePhases->get(phase.first)), Samples(&phase.second)};
+			baseTickTime += change.baseline.mean;
+			phases.push_back(change);
+		}
+		std::sort(phases.begin(), phases.end(), [](const Change& a, const Change& b) {
+			return std::abs(a.delta()) > std::abs(b.delta());
+		});
+		// a phase must move by threshold of the whole tick, small phases moving a lot relative to themselves don't matter
+		for(const Change& phase : phases) {
+			int significance = phase.significance(threshold * baseTickTime);
+			if(significance > 0) anySlower = true;
+			printChange("  ", phase, significance, "ms");
+		}
+	}
+	// a benchmark that no longer runs can't be let through as if it didn't get slower
+	for(const JSONValue& baseBench : baseline.get("benchmarks")->elements) {
+		const std::string& name = baseBench.get("name")->string;
+		if(findBenchmark(current, name) == nullptr) {
+			Log::setColor(Log::STRONG | Log::RED);
+			Log::print("%s: missing from the results\n", name.c_str());
+			anySlower = true;
+		}
+	}
+	Log::setColor(Log::WHITE);
+	return anySlower;
+}
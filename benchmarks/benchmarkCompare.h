@@ -0,0 +1,13 @@
+#pragma once
+
+#include <istream>
+
+/*
+	Compares benchmark results against a baseline, both in the format written by the runner's --json
+	A benchmark or one of its phases counts as slower when its mean moved by more than thresholdPercent
+	and by more than the noise of the repeated runs of both sides
+	Prints a diff of every benchmark with its phases ranked by how much they moved
+	returns true if anything got significantly slower, or if a benchmark of the baseline is missing from current
+	throws a const char* if either side isn't readable as benchmark results
+*/
+bool compareBenchmarkResults(std::istream& baseline, std::istream& current, double thresholdPercent);
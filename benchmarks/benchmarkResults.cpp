@@ -0,0 +1,56 @@
+#include "benchmarkResults.h"
+
+#include <algorithm>
+#include <cmath>
+
+std::vector<Benchmark*>* knownBenchmarks = nullptr;
+
+Benchmark::Benchmark(const char* name) : name(name) {
+	if(knownBenchmarks == nullptr) { knownBenchmarks = new std::vector<Benchmark*>(); }
+	knownBenchmarks->push_back(this);
+}
+
+RunStatistics computeStatistics(std::vector<double> values) {
+	RunStatistics result;
+	if(values.empty()) return result;
+	std::sort(values.begin(), values.end());
+	size_t count = values.size();
+
+	double total = 0.0;
+	for(double v : values) total += v;
+	result.mean = total / count;
+	result.median = (count % 2 == 1) ? values[count / 2] : (values[count / 2 - 1] + values[count / 2]) / 2;
+	result.min = values.front();
+	result.max = values.back();
+
+	// sample standard deviation, a single run has none
+	if(count > 1) {
+		double squaredDeviations = 0.0;
+		for(double v : values) squaredDeviations += (v - result.mean) * (v - result.mean);
+		result.stddev = std::sqrt(squaredDeviations / (count - 1));
+	}
+	return result;
+}
+
+void writeJSON(std::ostream& ostream, const std::vector<BenchmarkResult>& results, int warmupRuns, int measuredRuns) {
+	std::ios::fmtflags oldFlags = ostream.flags();
+	ostream.precision(6);
+
+	ostream << "{\"warmup\":" << warmupRuns << ",\"repeat\":" << measuredRuns << ",\"benchmarks\":[";
+	for(size_t i = 0; i < results.size(); i++) {
+		const BenchmarkResult& result = results[i];
+		if(i != 0) ostream << ',';
+		ostream << "\n{\"name\":\"" << result.bench->name << "\",\"initMs\":" << result.initMillis << ",\"runsMs\":[";
+		for(size_t r = 0; r < result.runMillis.size(); r++) {
+			if(r != 0) ostream << ',';
+			ostream << result.runMillis[r];
+		}
+		const RunStatistics& stats = result.statistics;
+		ostream << "],\"meanMs\":" << stats.mean << ",\"medianMs\":" << stats.median << ",\"stddevMs\":" << stats.stddev << ",\"minMs\":" << stats.min << ",\"maxMs\":" << stats.max;
+		result.bench->writeJSONResults(ostream);
+		ostream << '}';
+	}
+	ostream << "\n]}\n";
+
+	ostream.flags(oldFlags);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+#include <ostream>
+
+#include "benchmark.h"
+
+// every Benchmark constructed so far, they add themselves
+extern std::vector<Benchmark*>* knownBenchmarks;
+
+struct RunStatistics {
+	double mean = 0.0;
+	double median = 0.0;
+	double stddev = 0.0;
+	double min = 0.0;
+	double max = 0.0;
+};
+
+struct BenchmarkResult {
+	Benchmark* bench;
+	double initMillis;
+	std::vector<double> runMillis;
+	RunStatistics statistics;
+};
+
+RunStatistics computeStatistics(std::vector<double> values);
+
+/*
+	Writes the results in the format read by compareBenchmarkResults,
+	each benchmark adds its own members through Benchmark::writeJSONResults
+*/
+void writeJSON(std::ostream& ostream, const std::vector<BenchmarkResult>& results, int warmupRuns, int measuredRuns);
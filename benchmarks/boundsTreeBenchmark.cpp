@@ -0,0 +1,200 @@
+#include "benchmark.h"
+
+#include <chrono>
+#include <random>
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <cmath>
+
+#include "../util/log.h"
+#include "../physics/datastructures/boundsTree.h"
+#include "../physics/math/ray.h"
+#include "../physics/misc/filters/visibilityFilter.h"
+#include "../physics/misc/filters/rayIntersectsBoundsFilter.h"
+
+#define MAX_IMPROVE_PASSES 10
+#define RAY_COUNT 100
+// removes and moves touch a tenth of the objects, but no more than this, large trees would take minutes otherwise
+#define MAX_CHANGED_OBJECTS 10000
+
+// a box in space, all the BoundsTree needs of an object
+struct TreeObject {
+	Bounds bounds;
+
+	Bounds getStrictBounds() const { return bounds; }
+	std::optional<Bounds> getRigidGroupBounds() const { return std::optional<Bounds>(); }
+	// never used, as there are no rigid groups
+	Bounds getStrictBoundsRelativeTo(const TreeObject& reference) const { return bounds; }
+	Bounds getGlobalBoundsOf(const Bounds& localBounds) const { return localBounds; }
+};
+
+struct BoundsTreeResult {
+	const char* operation;
+	size_t objectCount;
+	double millis;
+	// operation specific, the number of objects touched, found or pairs
+	size_t count;
+	size_t depth;
+	long long totalCost;
+};
+
+// the sum of the cost of every node, lower means a tree that is faster to search
+static long long totalCostOf(const TreeNode& node) {
+	long long total = computeCost(node.bounds);
+	if(!node.isLeafNode()) {
+		for(const TreeNode& subNode : node) total += totalCostOf(subNode);
+	}
+	return total;
+}
+
+static Bounds boxAround(double x, double y, double z, double size) {
+	double h = size / 2;
+	return Bounds(Position(x - h, y - h, z - h), Position(x + h, y + h, z + h));
+}
+
+/*
+	Exercises a BoundsTree directly, at sizes from 1k to 1M objects
+	Objects are unit boxes at random positions, the space grows with the object count so the density stays the same
+	Every operation reports its time, the depth of the tree after it and the total cost of the tree
+*/
+class BoundsTreeBenchmark : public Benchmark {
+	std::vector<size_t> sizes{1000, 10000, 100000, 1000000};
+	std::vector<BoundsTreeResult> results;
+
+	template<typename Func>
+	void measure(const char* operation, BoundsTree<TreeObject>& tree, size_t objectCount, const Func& func) {
+		auto start = std::chrono::high_resolution_clock::now();
+		size_t count = func();
+		auto finish = std::chrono::high_resolution_clock::now();
+		size_t depth = tree.isEmpty() ? 0 : tree.rootNode.getLengthOfLongestBranch();
+		long long cost = tree.isEmpty() ? 0 : totalCostOf(tree.rootNode);
+		results.push_back(BoundsTreeResult{operation, objectCount, (finish - start).count() / 1000000.0, count, depth, cost});
+	}
+
+	void runSize(size_t objectCount) {
+		std::mt19937 generator(1234);
+		double spaceSize = std::cbrt(double(objectCount)) * 2.0;
+		std::uniform_real_distribution<double> coordinate(-spaceSize / 2, spaceSize / 2);
+		std::uniform_int_distribution<size_t> objectIndex(0, objectCount - 1);
+		std::normal_distribution<double> smallMove(0.0, 0.05);
+
+		std::vector<TreeObject> objects(objectCount);
+		for(TreeObject& obj : objects) {
+			obj.bounds = boxAround(coordinate(generator), coordinate(generator), coordinate(generator), 1.0);
+		}
+
+		BoundsTree<TreeObject> bulkTree;
+		measure("bulkInsert", bulkTree, objectCount, [&]() {
+			TreeNode* nodes = new TreeNode[objectCount];
+			for(size_t i = 0; i < objectCount; i++) nodes[i] = TreeNode(&objects[i], objects[i].bounds, true);
+			bulkTree.add(nodes, objectCount);
+			delete[] nodes;
+			return objectCount;
+		});
+
+		BoundsTree<TreeObject> tree;
+		measure("insert", tree, objectCount, [&]() {
+			for(TreeObject& obj : objects) tree.add(&obj, obj.bounds);
+			return objectCount;
+		});
+
+		size_t removeCount = std::min<size_t>(objectCount / 10, MAX_CHANGED_OBJECTS);
+		measure("randomRemove", tree, objectCount, [&]() {
+			std::vector<size_t> order(objectCount);
+			for(size_t i = 0; i < objectCount; i++) order[i] = i;
+			std::shuffle(order.begin(), order.end(), generator);
+			for(size_t i = 0; i < removeCount; i++) tree.remove(&objects[order[i]], objects[order[i]].bounds);
+			// put them back for the next operations
+			for(size_t i = 0; i < removeCount; i++) tree.add(&objects[order[i]], objects[order[i]].bounds);
+			return removeCount;
+		});
+
+		size_t moveCount = std::min<size_t>(objectCount / 10, MAX_CHANGED_OBJECTS);
+		measure("updateSmallMoves", tree, objectCount, [&]() {
+			for(size_t i = 0; i < moveCount; i++) {
+				TreeObject& obj = objects[objectIndex(generator)];
+				Bounds oldBounds = obj.bounds;
+				Position center = oldBounds.getCenter();
+				obj.bounds = boxAround(double(center.x) + smallMove(generator), double(center.y) + smallMove(generator), double(center.z) + smallMove(generator), 1.0);
+				tree.updateObjectBounds(&obj, oldBounds);
+			}
+			return moveCount;
+		});
+
+		measure("updateLargeMoves", tree, objectCount, [&]() {
+			for(size_t i = 0; i < moveCount; i++) {
+				TreeObject& obj = objects[objectIndex(generator)];
+				Bounds oldBounds = obj.bounds;
+				obj.bounds = boxAround(coordinate(generator), coordinate(generator), coordinate(generator), 1.0);
+				tree.updateObjectBounds(&obj, oldBounds);
+			}
+			return moveCount;
+		});
+
+		// passes of improveStructure until the cost improves by less than 1%, count is the number of passes
+		measure("improveStructure", tree, objectCount, [&]() {
+			long long previousCost = totalCostOf(tree.rootNode);
+			size_t passes = 0;
+			while(passes < MAX_IMPROVE_PASSES) {
+				tree.improveStructure();
+				passes++;
+				long long cost = totalCostOf(tree.rootNode);
+				if(previousCost - cost < previousCost / 100) break;
+				previousCost = cost;
+			}
+			return passes;
+		});
+
+		measure("visibilityFilter", tree, objectCount, [&]() {
+			VisibilityFilter filter = VisibilityFilter::forWindow(Position(0.0, 0.0, -spaceSize), Vec3(0.2, 0.1, 1.0), Vec3(0.0, 1.0, 0.0), 1.0, 16.0 / 9.0, spaceSize);
+			size_t found = 0;
+			for(TreeObject& obj : tree.iterFiltered(filter)) found++;
+			return found;
+		});
+
+		measure("rayFilter", tree, objectCount, [&]() {
+			std::normal_distribution<double> normal;
+			size_t found = 0;
+			for(int i = 0; i < RAY_COUNT; i++) {
+				Ray ray{Position(coordinate(generator), coordinate(generator), coordinate(generator)), normalize(Vec3(normal(generator), normal(generator), normal(generator)))};
+				for(TreeObject& obj : tree.iterFiltered(RayIntersectBoundsFilter(ray))) found++;
+			}
+			return found;
+		});
+
+		measure("selfCollisionPairs", tree, objectCount, [&]() {
+			size_t pairs = 0;
+			forEachOverlappingPairInternal<TreeObject>(tree.rootNode, [&pairs](TreeObject*, TreeObject*) {pairs++; });
+			return pairs;
+		});
+	}
+
+public:
+	BoundsTreeBenchmark() : Benchmark("boundsTree") {}
+
+	void run() override {
+		results.clear();
+		for(size_t objectCount : sizes) {
+			runSize(objectCount);
+		}
+	}
+
+	void printResults(double timeTakenMillis) override {
+		Log::print("%-20s %9s %12s %10s %6s %16s\n", "operation", "objects", "time", "count", "depth", "total cost");
+		for(const BoundsTreeResult& result : results) {
+			Log::print("%-20s %9d %10.3fms %10d %6d %16lld\n", result.operation, int(result.objectCount), result.millis, int(result.count), int(result.depth), result.totalCost);
+		}
+	}
+
+	void writeJSONResults(std::ostream& ostream) const override {
+		ostream << ",\"operations\":[";
+		for(size_t i = 0; i < results.size(); i++) {
+			const BoundsTreeResult& result = results[i];
+			if(i != 0) ostream << ',';
+			ostream << "{\"operation\":\"" << result.operation << "\",\"objects\":" << result.objectCount << ",\"ms\":" << result.millis;
+			ostream << ",\"count\":" << result.count << ",\"depth\":" << result.depth << ",\"totalCost\":" << result.totalCost << '}';
+		}
+		ostream << ']';
+	}
+} boundsTreeBenchmark;
@@ -0,0 +1,92 @@
+#include "worldBenchmark.h"
+
+#include <chrono>
+
+#include "../util/log.h"
+#include "../physics/world.h"
+#include "../physics/misc/shapeLibrary.h"
+#include "../physics/broadphase/treeBroadphase.h"
+#include "../physics/broadphase/sweepAndPruneBroadphase.h"
+#include "../physics/broadphase/spatialHashBroadphase.h"
+
+#include <thread>
+
+/*
+	Runs the manyCubes scene, and times all broadphases on the same world every tick
+	The SweepAndPruneBroadphase is kept alive between ticks, so its incremental sort is measured, not a rebuild
+*/
+class BroadphaseBenchmark : public WorldBenchmark {
+	TreeBroadphase treeBroadphase;
+	SweepAndPruneBroadphase sapBroadphase;
+	SpatialHashBroadphase gridBroadphase;
+
+	double treeNanos = 0.0;
+	double sapNanos = 0.0;
+	double gridNanos = 0.0;
+	size_t treePairCount = 0;
+	size_t sapPairCount = 0;
+	size_t gridPairCount = 0;
+
+	std::vector<BroadphasePair> objectPairs;
+	std::vector<BroadphasePair> terrainPairs;
+
+	size_t timeBroadphase(Broadphase& broadphase, double& totalNanos) {
+		objectPairs.clear();
+		terrainPairs.clear();
+		auto start = std::chrono::high_resolution_clock::now();
+		broadphase.findCandidatePairs(world, objectPairs, terrainPairs);
+		auto finish = std::chrono::high_resolution_clock::now();
+		totalNanos += (finish - start).count();
+		return objectPairs.size() + terrainPairs.size();
+	}
+public:
+	BroadphaseBenchmark() : WorldBenchmark("broadphase", 1000), gridBroadphase(1, std::thread::hardware_concurrency()) {}
+
+	void init() {
+		createFloor(50, 50, 10);
+
+		GlobalCFrame ref(0, 15, 0, Rotation::fromEulerAngles(3.1415 / 4, 3.1415 / 4, 0.0));
+
+		for(double x = -10; x < 10; x += 1.01) {
+			for(double y = -5; y < 5; y += 1.01) {
+				for(double z = -10; z < 10; z += 1.01) {
+					world.addPart(new Part(Library::createBox(1.0, 1.0, 1.0), ref.localToGlobal(CFrame(x, y, z)), {1.0, 0.2, 0.5}));
+				}
+			}
+		}
+	}
+
+	void run() override {
+		for(int i = 0; i < tickCount; i++) {
+			treePairCount += timeBroadphase(treeBroadphase, treeNanos);
+			sapPairCount += timeBroadphase(sapBroadphase, sapNanos);
+			gridPairCount += timeBroadphase(gridBroadphase, gridNanos);
+
+			world.tick();
+			measuredTicks++;
+		}
+	}
+
+	// the sorted list of the SweepAndPruneBroadphase refers to the parts of the old world
+	void cleanup() override {
+		WorldBenchmark::cleanup();
+		sapBroadphase = SweepAndPruneBroadphase();
+	}
+
+	void clearResults() override {
+		WorldBenchmark::clearResults();
+		treeNanos = 0.0;
+		sapNanos = 0.0;
+		gridNanos = 0.0;
+		treePairCount = 0;
+		sapPairCount = 0;
+		gridPairCount = 0;
+	}
+
+	void printResults(double timeTakenMillis) override {
+		Log::print("%d parts, %d ticks\n", int(world.getPartCount()), int(measuredTicks));
+		Log::print("TreeBroadphase:          %.4fms per tick, %.1f pairs per tick\n", treeNanos / measuredTicks / 1000000.0, double(treePairCount) / measuredTicks);
+		Log::print("SweepAndPruneBroadphase: %.4fms per tick, %.1f pairs per tick\n", sapNanos / measuredTicks / 1000000.0, double(sapPairCount) / measuredTicks);
+		Log::print("SpatialHashBroadphase:   %.4fms per tick, %.1f pairs per tick, %d threads\n", gridNanos / measuredTicks / 1000000.0, double(gridPairCount) / measuredTicks, int(gridBroadphase.getThreadCount()));
+	}
+} broadphaseBenchmark;
@@ -0,0 +1,82 @@
+#include "worldBenchmark.h"
+
+#include <chrono>
+
+#include "../util/log.h"
+#include "../physics/world.h"
+#include "../physics/misc/shapeLibrary.h"
+
+/*
+	A world of many loose parts where some are deleted and replaced every tick, like debris or projectiles
+	Times the removals, which used to search the list of physicals for every removed part
+*/
+class ChurnBenchmark : public WorldBenchmark {
+	std::vector<Part*> parts;
+	size_t nextVictim = 0;
+	double removeNanos = 0.0;
+	double addNanos = 0.0;
+	int churnPerTick = 200;
+public:
+	ChurnBenchmark() : WorldBenchmark("churn", 200) {}
+
+	void init() {
+		Polyhedron partShape = Library::createBox(0.5f, 0.5f, 0.5f);
+		for(int x = 0; x < 40; x++) {
+			for(int y = 0; y < 25; y++) {
+				for(int z = 0; z < 20; z++) {
+					Part* p = new Part(partShape, GlobalCFrame(x * 1.5, y * 1.5, z * 1.5), basicProperties);
+					world.addPart(p);
+					parts.push_back(p);
+				}
+			}
+		}
+	}
+
+	void run() override {
+		Polyhedron partShape = Library::createBox(0.5f, 0.5f, 0.5f);
+		for(int i = 0; i < tickCount; i++) {
+			world.tick();
+
+			std::vector<GlobalCFrame> freedSpots;
+			auto start = std::chrono::high_resolution_clock::now();
+			for(int j = 0; j < churnPerTick; j++) {
+				// spread the removals over the world, not just the end of the list
+				nextVictim = (nextVictim + 7919) % parts.size();
+				freedSpots.push_back(parts[nextVictim]->getCFrame());
+				delete parts[nextVictim];
+				parts[nextVictim] = nullptr;
+			}
+			auto middle = std::chrono::high_resolution_clock::now();
+			size_t spot = 0;
+			for(Part*& p : parts) {
+				if(p == nullptr) {
+					p = new Part(partShape, freedSpots[spot++], basicProperties);
+					world.addPart(p);
+				}
+			}
+			auto finish = std::chrono::high_resolution_clock::now();
+
+			removeNanos += (middle - start).count();
+			addNanos += (finish - middle).count();
+			measuredTicks++;
+		}
+	}
+
+	void cleanup() override {
+		parts.clear();
+		nextVictim = 0;
+		WorldBenchmark::cleanup();
+	}
+
+	void clearResults() override {
+		WorldBenchmark::clearResults();
+		removeNanos = 0.0;
+		addNanos = 0.0;
+	}
+
+	void printResults(double timeTakenMillis) override {
+		Log::print("%d parts, %d removed and added per tick, %d ticks\n", int(world.getPartCount()), churnPerTick, int(measuredTicks));
+		Log::print("remove: %.4fms per tick\n", removeNanos / measuredTicks / 1000000.0);
+		Log::print("add:    %.4fms per tick\n", addNanos / measuredTicks / 1000000.0);
+	}
+} churnBenchmark;
@@ -0,0 +1,17 @@
+#include "worldBenchmark.h"
+#include "sceneGenerator.h"
+
+// a mixed scene from the scene generator, the same kind of scene a --sweep measures at several sizes
+class GeneratedSceneBenchmark : public WorldBenchmark {
+public:
+	GeneratedSceneBenchmark() : WorldBenchmark("generatedScene", 1000) {}
+
+	void init() override {
+		SceneParameters scene;
+		scene.partCount = 1000;
+		scene.hullWeight = 0.5;
+		scene.chainCount = 10;
+		scene.constraintCount = 20;
+		generateScene(world, scene);
+	}
+} generatedScene;
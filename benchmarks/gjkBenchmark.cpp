@@ -0,0 +1,88 @@
+#include "benchmark.h"
+
+#include <chrono>
+
+#include "../util/log.h"
+#include "../physics/geometry/basicShapes.h"
+#include "../physics/geometry/shape.h"
+#include "../physics/geometry/shapeClass.h"
+#include "../physics/geometry/normalizedPolyhedron.h"
+#include "../physics/geometry/intersection.h"
+#include "../physics/misc/shapeLibrary.h"
+
+#define SHAPE_COUNT 4
+#define OFFSET_COUNT 64
+#define ROUNDS 2000
+
+/*
+	Runs GJK and EPA for every pair of box, sphere, cylinder and convex polyhedron
+	Compares the path specialized for the pair of shape classes to the one going through GenericCollidable
+*/
+class GJKBenchmark : public Benchmark {
+	NormalizedPolyhedron* icosa = nullptr;
+	Shape shapes[SHAPE_COUNT];
+	CFrame offsets[OFFSET_COUNT];
+	double specializedNanos[SHAPE_COUNT][SHAPE_COUNT]{};
+	double genericNanos[SHAPE_COUNT][SHAPE_COUNT]{};
+	int colissionCount = 0;
+public:
+	GJKBenchmark() : Benchmark("gjk") {}
+
+	void init() override {
+		icosa = new NormalizedPolyhedron(Library::icosahedron.normalized());
+		shapes[0] = Box(1.0, 2.0, 0.7);
+		shapes[1] = Sphere(0.6);
+		shapes[2] = Cylinder(0.5, 1.3);
+		shapes[3] = Shape(icosa, 1.1, 0.9, 1.4);
+		// about half of the offsets are close enough to collide
+		for(int i = 0; i < OFFSET_COUNT; i++) {
+			double distance = 0.2 + 2.0 * i / OFFSET_COUNT;
+			Vec3 direction = normalize(Vec3(std::sin(i * 1.3), std::cos(i * 0.7), std::sin(i * 2.9)));
+			offsets[i] = CFrame(direction * distance, Rotation::fromEulerAngles(i * 0.3, i * 0.5, i * 0.11));
+		}
+	}
+
+	void cleanup() override {
+		delete icosa;
+		icosa = nullptr;
+	}
+
+	void clearResults() override {
+		colissionCount = 0;
+	}
+
+	void run() override {
+		for(int a = 0; a < SHAPE_COUNT; a++) {
+			for(int b = 0; b < SHAPE_COUNT; b++) {
+				const Shape& first = shapes[a];
+				const Shape& second = shapes[b];
+				auto start = std::chrono::high_resolution_clock::now();
+				for(int round = 0; round < ROUNDS; round++) {
+					for(const CFrame& offset : offsets) {
+						if(intersectsTransformed(first, second, offset)) colissionCount++;
+					}
+				}
+				auto middle = std::chrono::high_resolution_clock::now();
+				for(int round = 0; round < ROUNDS; round++) {
+					for(const CFrame& offset : offsets) {
+						if(intersectsTransformed(static_cast<const GenericCollidable&>(*first.baseShape), static_cast<const GenericCollidable&>(*second.baseShape), offset, first.scale, second.scale)) colissionCount++;
+					}
+				}
+				auto finish = std::chrono::high_resolution_clock::now();
+				specializedNanos[a][b] = (middle - start).count();
+				genericNanos[a][b] = (finish - middle).count();
+			}
+		}
+	}
+
+	void printResults(double timeTakenMillis) override {
+		const char* names[SHAPE_COUNT]{"box", "sphere", "cylinder", "polyhedron"};
+		double tests = double(ROUNDS) * OFFSET_COUNT;
+		Log::print("%d colissions found\n", colissionCount);
+		for(int a = 0; a < SHAPE_COUNT; a++) {
+			for(int b = 0; b < SHAPE_COUNT; b++) {
+				Log::print("%s-%s: specialized %.1fns, generic %.1fns per test\n", names[a], names[b], specializedNanos[a][b] / tests, genericNanos[a][b] / tests);
+			}
+		}
+	}
+} gjkBenchmark;
@@ -0,0 +1,59 @@
+#include "worldBenchmark.h"
+
+#include <chrono>
+
+#include "../util/log.h"
+#include "../physics/world.h"
+#include "../physics/misc/shapeLibrary.h"
+#include "../physics/constraints/fixedConstraint.h"
+#include "../physics/constraints/motorConstraint.h"
+
+/*
+	Vehicles built out of physicals joined by constraints, most of them fixed and a few turning wheels
+	Times updating the physicals, which includes keeping their mass properties up to date
+*/
+class MassPropertiesBenchmark : public WorldBenchmark {
+	double updateNanos = 0.0;
+public:
+	MassPropertiesBenchmark() : WorldBenchmark("massProperties", 500) {}
+
+	void init() {
+		Polyhedron partShape = Library::createBox(0.9f, 0.9f, 0.9f);
+		for(int v = 0; v < 100; v++) {
+			Part* vehicle = new Part(partShape, GlobalCFrame(v * 30.0, 0.0, 0.0), basicProperties);
+			Part* previous = vehicle;
+			for(int i = 1; i < 40; i++) {
+				Part* segment = new Part(partShape, GlobalCFrame(), basicProperties);
+				previous->attach(segment, new FixedConstraint(), CFrame(0.5, 0.0, 0.0), CFrame(-0.5, 0.0, 0.0));
+				previous = segment;
+			}
+			for(int w = 0; w < 4; w++) {
+				Part* wheel = new Part(partShape, GlobalCFrame(), basicProperties);
+				vehicle->attach(wheel, new MotorConstraint(Vec3(0.0, 0.0, 1.0)), CFrame(w * 1.0, -1.0, 0.0), CFrame());
+			}
+			world.addPart(vehicle);
+		}
+	}
+
+	void run() override {
+		for(int i = 0; i < tickCount; i++) {
+			auto start = std::chrono::high_resolution_clock::now();
+			for(MotorizedPhysical* phys : world.iterPhysicals()) {
+				phys->update(world.deltaT);
+			}
+			auto finish = std::chrono::high_resolution_clock::now();
+			updateNanos += (finish - start).count();
+			measuredTicks++;
+		}
+	}
+
+	void clearResults() override {
+		WorldBenchmark::clearResults();
+		updateNanos = 0.0;
+	}
+
+	void printResults(double timeTakenMillis) override {
+		Log::print("%d parts in %d vehicles, %d ticks\n", int(world.getPartCount()), int(world.physicals.size()), int(measuredTicks));
+		Log::print("update physicals: %.4fms per tick\n", updateNanos / measuredTicks / 1000000.0);
+	}
+} massPropertiesBenchmark;
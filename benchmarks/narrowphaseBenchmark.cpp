@@ -0,0 +1,206 @@
+#include "benchmark.h"
+
+#include <chrono>
+#include <random>
+#include <vector>
+#include <stdexcept>
+
+#include "../util/log.h"
+#include "../physics/geometry/basicShapes.h"
+#include "../physics/geometry/shape.h"
+#include "../physics/geometry/shapeClass.h"
+#include "../physics/geometry/normalizedPolyhedron.h"
+#include "../physics/geometry/intersection.h"
+#include "../physics/misc/shapeLibrary.h"
+#include "../physics/physicsProfiler.h"
+
+#define SAMPLES_PER_CASE 256
+#define ROUNDS 20
+#define BISECTION_STEPS 24
+
+enum class NarrowphaseCase {
+	SEPARATED,
+	TOUCHING,
+	DEEP,
+	COUNT
+};
+
+static const char* caseNames[]{"separated", "touching", "deep"};
+
+struct NarrowphaseResult {
+	size_t first;
+	size_t second;
+	NarrowphaseCase narrowphaseCase;
+	double nanosPerPair;
+	double gjkIterations;
+	double epaIterations;
+	int colissions;
+};
+
+// the average of a tally of IterationTime, the '15+' and 'MAX' buckets count as 15 and 16
+static double averageIterations(const ParallelArray<long long, static_cast<size_t>(IterationTime::COUNT)>& tally, const ParallelArray<long long, static_cast<size_t>(IterationTime::COUNT)>* extraTally = nullptr) {
+	long long total = 0;
+	long long count = 0;
+	for(size_t i = 0; i < static_cast<size_t>(IterationTime::COUNT); i++) {
+		long long amount = tally.values[i] + ((extraTally != nullptr) ? extraTally->values[i] : 0);
+		total += amount * i;
+		count += amount;
+	}
+	return (count != 0) ? double(total) / count : 0.0;
+}
+
+/*
+	intersectsTransformed for every pair of the basic shapes, the icosahedron and two larger convex hulls
+	The relative transforms are random, bucketed by how far the shapes are from just touching:
+	  separated: 1.05 to 1.5 times the touching distance
+	  touching:  0.98 to 0.999 times the touching distance
+	  deep:      0.2 to 0.6 times the touching distance
+*/
+class NarrowphaseBenchmark : public Benchmark {
+	std::vector<NormalizedPolyhedron*> hulls;
+	std::vector<Shape> shapes;
+	std::vector<const char*> shapeNames;
+	// offsets[first][second][case] holds SAMPLES_PER_CASE transforms
+	std::vector<std::vector<std::vector<std::vector<CFrame>>>> offsets;
+	std::vector<NarrowphaseResult> results;
+
+	void addHull(const char* name, const Polyhedron& poly, double width, double height, double depth) {
+		NormalizedPolyhedron* hull = new NormalizedPolyhedron(poly.normalized());
+		hulls.push_back(hull);
+		shapes.push_back(Shape(hull, width, height, depth));
+		shapeNames.push_back(name);
+	}
+
+	// the distance along direction at which second stops touching first, shapes overlap at their centers so this is found by bisection
+	double findTouchingDistance(const Shape& first, const Shape& second, const Vec3& direction, const Rotation& rotation) {
+		double inside = 0.0;
+		double outside = (first.getMaxRadius() + second.getMaxRadius()) * 1.01;
+		for(int i = 0; i < BISECTION_STEPS; i++) {
+			double middle = (inside + outside) / 2;
+			bool overlaps;
+			try {
+				overlaps = intersectsTransformed(first, second, CFrame(direction * middle, rotation)).has_value();
+			} catch(const char*) {
+				// EPA throws on degenerate simplices, GJK already found an overlap by then
+				overlaps = true;
+			} catch(const std::exception&) {
+				overlaps = true;
+			}
+			if(overlaps) {
+				inside = middle;
+			} else {
+				outside = middle;
+			}
+		}
+		return (inside + outside) / 2;
+	}
+
+public:
+	NarrowphaseBenchmark() : Benchmark("narrowphase") {}
+
+	void init() override {
+		shapeNames.clear();
+		shapes.push_back(Box(1.0, 2.0, 0.7)); shapeNames.push_back("box");
+		shapes.push_back(Sphere(0.6)); shapeNames.push_back("sphere");
+		shapes.push_back(Cylinder(0.5, 1.3)); shapeNames.push_back("cylinder");
+		addHull("icosahedron", Library::icosahedron, 1.1, 0.9, 1.4);
+		addHull("sphereHull", Library::createSphere(1.0, 3), 1.2, 1.2, 1.2);
+		addHull("prism64", Library::createPrism(64, 0.5, 1.0), 1.0, 1.5, 1.0);
+
+		std::mt19937 generator(42);
+		std::uniform_real_distribution<double> angle(-3.14159, 3.14159);
+		std::normal_distribution<double> normal;
+		double factorRanges[][2]{{1.05, 1.5}, {0.98, 0.999}, {0.2, 0.6}};
+
+		offsets.resize(shapes.size());
+		for(size_t a = 0; a < shapes.size(); a++) {
+			offsets[a].resize(shapes.size());
+			for(size_t b = 0; b < shapes.size(); b++) {
+				offsets[a][b].resize(static_cast<size_t>(NarrowphaseCase::COUNT));
+				for(size_t c = 0; c < static_cast<size_t>(NarrowphaseCase::COUNT); c++) {
+					std::uniform_real_distribution<double> factor(factorRanges[c][0], factorRanges[c][1]);
+					while(offsets[a][b][c].size() < SAMPLES_PER_CASE) {
+						Rotation rotation = Rotation::fromEulerAngles(angle(generator), angle(generator), angle(generator));
+						Vec3 direction = normalize(Vec3(normal(generator), normal(generator), normal(generator)));
+						double distance = findTouchingDistance(shapes[a], shapes[b], direction, rotation);
+						CFrame offset(direction * (distance * factor(generator)), rotation);
+						// offsets EPA fails on are left out, so the measured loop never throws
+						try {
+							intersectsTransformed(shapes[a], shapes[b], offset);
+						} catch(const char*) {
+							continue;
+						} catch(const std::exception&) {
+							continue;
+						}
+						offsets[a][b][c].push_back(offset);
+					}
+				}
+			}
+		}
+	}
+
+	void run() override {
+		results.clear();
+		for(size_t a = 0; a < shapes.size(); a++) {
+			for(size_t b = 0; b < shapes.size(); b++) {
+				for(size_t c = 0; c < static_cast<size_t>(NarrowphaseCase::COUNT); c++) {
+					const std::vector<CFrame>& caseOffsets = offsets[a][b][c];
+					GJKCollidesIterationStatistics.clearCurrentTally();
+					GJKNoCollidesIterationStatistics.clearCurrentTally();
+					EPAIterationStatistics.clearCurrentTally();
+
+					int colissions = 0;
+					auto start = std::chrono::high_resolution_clock::now();
+					for(int round = 0; round < ROUNDS; round++) {
+						for(const CFrame& offset : caseOffsets) {
+							if(intersectsTransformed(shapes[a], shapes[b], offset)) colissions++;
+						}
+					}
+					auto finish = std::chrono::high_resolution_clock::now();
+
+					GJKCollidesIterationStatistics.nextTally();
+					GJKNoCollidesIterationStatistics.nextTally();
+					EPAIterationStatistics.nextTally();
+
+					NarrowphaseResult result;
+					result.first = a;
+					result.second = b;
+					result.narrowphaseCase = static_cast<NarrowphaseCase>(c);
+					result.nanosPerPair = double((finish - start).count()) / (double(ROUNDS) * caseOffsets.size());
+					result.gjkIterations = averageIterations(GJKCollidesIterationStatistics.history.front(), &GJKNoCollidesIterationStatistics.history.front());
+					result.epaIterations = averageIterations(EPAIterationStatistics.history.front());
+					result.colissions = colissions / ROUNDS;
+					results.push_back(result);
+				}
+			}
+		}
+	}
+
+	// shapeNames stays, the results refer to it
+	void cleanup() override {
+		offsets.clear();
+		shapes.clear();
+		for(NormalizedPolyhedron* hull : hulls) {
+			delete hull;
+		}
+		hulls.clear();
+	}
+
+	void printResults(double timeTakenMillis) override {
+		Log::print("%-12s %-12s %-10s %10s %8s %8s %6s\n", "first", "second", "case", "ns/pair", "GJK it", "EPA it", "hits");
+		for(const NarrowphaseResult& result : results) {
+			Log::print("%-12s %-12s %-10s %10.1f %8.2f %8.2f %3d/%d\n", shapeNames[result.first], shapeNames[result.second], caseNames[static_cast<size_t>(result.narrowphaseCase)], result.nanosPerPair, result.gjkIterations, result.epaIterations, result.colissions, SAMPLES_PER_CASE);
+		}
+	}
+
+	void writeJSONResults(std::ostream& ostream) const override {
+		ostream << ",\"pairs\":[";
+		for(size_t i = 0; i < results.size(); i++) {
+			const NarrowphaseResult& result = results[i];
+			if(i != 0) ostream << ',';
+			ostream << "{\"first\":\"" << shapeNames[result.first] << "\",\"second\":\"" << shapeNames[result.second] << "\",\"case\":\"" << caseNames[static_cast<size_t>(result.narrowphaseCase)] << '"';
+			ostream << ",\"nsPerPair\":" << result.nanosPerPair << ",\"gjkIterations\":" << result.gjkIterations << ",\"epaIterations\":" << result.epaIterations << ",\"colissions\":" << result.colissions << '}';
+		}
+		ostream << ']';
+	}
+} narrowphaseBenchmark;
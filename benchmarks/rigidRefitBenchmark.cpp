@@ -0,0 +1,88 @@
+#include "worldBenchmark.h"
+
+#include <chrono>
+#include <vector>
+
+#include "../util/log.h"
+#include "../physics/world.h"
+#include "../physics/misc/shapeLibrary.h"
+#include "../physics/broadphase/treeBroadphase.h"
+
+/*
+	Vehicles of 500 rigidly attached parts spinning through empty space, and one resting on the ground
+	Times the refit of the object tree against recomputing the bounds of every part, which is what the refit used to do
+	The grounded vehicle overlaps the ground every tick, so the pair search has to look inside its group
+*/
+class RigidRefitBenchmark : public WorldBenchmark {
+	double refitNanos = 0.0;
+	double perPartNanos = 0.0;
+	double pairNanos = 0.0;
+	size_t groundPairs = 0;
+	std::vector<BroadphasePair> objectPairs;
+	std::vector<BroadphasePair> terrainPairs;
+public:
+	RigidRefitBenchmark() : WorldBenchmark("rigidRefit", 1000) {}
+
+	void init() {
+		Polyhedron partShape = Library::createBox(0.9f, 0.9f, 0.9f);
+		for(int v = 0; v < 10; v++) {
+			Part* vehicle = new Part(partShape, GlobalCFrame(v * 30.0, 0.0, 0.0), basicProperties);
+			for(int i = 1; i < 500; i++) {
+				vehicle->attach(new Part(partShape, GlobalCFrame(), basicProperties), CFrame(i % 10 * 1.0, i / 10 % 10 * 1.0, i / 100 * 1.0));
+			}
+			world.addPart(vehicle);
+			vehicle->parent->mainPhysical->motionOfCenterOfMass.rotation.angularVelocity = Vec3(0.3, 1.0, 0.1 * v);
+		}
+
+		// a block of 10 by 5 by 10 parts, far away from the spinning ones
+		world.addTerrainPart(new Part(Library::createBox(40.0, 1.0, 40.0), GlobalCFrame(-100.0, -0.5, 0.0), basicProperties));
+		Part* groundedVehicle = new Part(partShape, GlobalCFrame(-105.0, 0.46, -5.0), basicProperties);
+		for(int i = 1; i < 500; i++) {
+			groundedVehicle->attach(new Part(partShape, GlobalCFrame(), basicProperties), CFrame(i % 10 * 1.0, i / 100 * 1.0, i / 10 % 10 * 1.0));
+		}
+		world.addPart(groundedVehicle);
+	}
+
+	void run() override {
+		Layer& layer = world.getLayer(DEFAULT_LAYER);
+		TreeBroadphase broadphase;
+		for(int i = 0; i < tickCount; i++) {
+			world.tick();
+
+			auto start = std::chrono::high_resolution_clock::now();
+			layer.tree.recalculateBounds();
+			auto refitted = std::chrono::high_resolution_clock::now();
+			// into a separate union, the nodes of the refitted groups keep their own bounds
+			Bounds allParts = static_cast<Part*>((*layer.tree.begin())->object)->getStrictBounds();
+			for(TreeNode* node : layer.tree) {
+				allParts = unionOfBounds(allParts, static_cast<Part*>(node->object)->getStrictBounds());
+			}
+			auto perPart = std::chrono::high_resolution_clock::now();
+			objectPairs.clear();
+			terrainPairs.clear();
+			broadphase.findCandidatePairs(world, objectPairs, terrainPairs);
+			auto paired = std::chrono::high_resolution_clock::now();
+
+			refitNanos += (refitted - start).count();
+			perPartNanos += (perPart - refitted).count();
+			pairNanos += (paired - perPart).count();
+			groundPairs += terrainPairs.size();
+			measuredTicks++;
+		}
+	}
+
+	void clearResults() override {
+		WorldBenchmark::clearResults();
+		refitNanos = 0.0;
+		perPartNanos = 0.0;
+		pairNanos = 0.0;
+		groundPairs = 0;
+	}
+
+	void printResults(double timeTakenMillis) override {
+		Log::print("%d parts in %d physicals, %d ticks\n", int(world.getPartCount()), int(world.physicals.size()), int(measuredTicks));
+		Log::print("recalculateBounds:      %.4fms per tick\n", refitNanos / measuredTicks / 1000000.0);
+		Log::print("bounds of every part:   %.4fms per tick\n", perPartNanos / measuredTicks / 1000000.0);
+		Log::print("pairs with the ground:  %.4fms per tick, %.1f pairs\n", pairNanos / measuredTicks / 1000000.0, double(groundPairs) / measuredTicks);
+	}
+} rigidRefitBenchmark;
@@ -0,0 +1,180 @@
+#include "sceneGenerator.h"
+
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "../physics/geometry/basicShapes.h"
+#include "../physics/geometry/normalizedPolyhedron.h"
+#include "../physics/misc/shapeLibrary.h"
+#include "../physics/constraints/motorConstraint.h"
+#include "../physics/constraintGroup.h"
+
+static const PartProperties sceneProperties{1.0, 0.7, 0.5};
+
+// the furthest any point of a part can be from its center, relative to its largest dimension
+static const double MAX_RADIUS_FACTOR = 0.87;
+
+bool SceneParameters::set(const std::string& name, double value) {
+	if(name == "partCount") partCount = static_cast<size_t>(value);
+	else if(name == "boxWeight") boxWeight = value;
+	else if(name == "sphereWeight") sphereWeight = value;
+	else if(name == "cylinderWeight") cylinderWeight = value;
+	else if(name == "hullWeight") hullWeight = value;
+	else if(name == "minSize") minSize = value;
+	else if(name == "maxSize") maxSize = value;
+	else if(name == "packingDensity") packingDensity = value;
+	else if(name == "terrainFraction") terrainFraction = value;
+	else if(name == "chainCount") chainCount = static_cast<size_t>(value);
+	else if(name == "chainLength") chainLength = static_cast<size_t>(value);
+	else if(name == "constraintCount") constraintCount = static_cast<size_t>(value);
+	else if(name == "seed") seed = static_cast<unsigned int>(value);
+	else return false;
+	return true;
+}
+
+bool SceneParameters::parse(const std::string& list) {
+	size_t start = 0;
+	while(start < list.size()) {
+		size_t end = list.find(',', start);
+		if(end == std::string::npos) end = list.size();
+		std::string entry = list.substr(start, end - start);
+		size_t equals = entry.find('=');
+		if(equals == std::string::npos) return false;
+		const char* valueStart = entry.c_str() + equals + 1;
+		char* valueEnd;
+		double value = std::strtod(valueStart, &valueEnd);
+		if(valueEnd == valueStart || *valueEnd != '\0') return false;
+		if(!set(entry.substr(0, equals), value)) return false;
+		start = end + 1;
+	}
+	return true;
+}
+
+static const NormalizedPolyhedron* getHullClass() {
+	static NormalizedPolyhedron* hullClass = new NormalizedPolyhedron(Library::icosahedron.normalized());
+	return hullClass;
+}
+
+class ShapeGenerator {
+	std::mt19937& generator;
+	std::discrete_distribution<int> shapeKind;
+	std::uniform_real_distribution<double> logSize;
+	std::uniform_real_distribution<double> aspect{0.5, 1.0};
+
+public:
+	ShapeGenerator(std::mt19937& generator, const SceneParameters& parameters) :
+		generator(generator),
+		shapeKind{parameters.boxWeight, parameters.sphereWeight, parameters.cylinderWeight, parameters.hullWeight},
+		logSize(std::log(parameters.minSize), std::log(parameters.maxSize)) {}
+
+	// a random shape with the given largest dimension
+	Shape createShape(double size) {
+		switch(shapeKind(generator)) {
+		case 0: return Box(size, size * aspect(generator), size * aspect(generator));
+		case 1: return Sphere(size / 2);
+		case 2: return Cylinder(size / 2 * aspect(generator), size);
+		default: return Shape(getHullClass(), size, size * aspect(generator), size * aspect(generator));
+		}
+	}
+
+	double randomSize() {
+		return std::exp(logSize(generator));
+	}
+};
+
+void generateScene(World<Part>& world, const SceneParameters& parameters) {
+	std::mt19937 generator(parameters.seed);
+	std::uniform_real_distribution<double> angle(-3.14159, 3.14159);
+	std::uniform_real_distribution<double> unit(-1.0, 1.0);
+	ShapeGenerator shapes(generator, parameters);
+
+	size_t chainLength = std::max<size_t>(parameters.chainLength, 1);
+	size_t chainCount = std::min(parameters.chainCount, parameters.partCount / chainLength);
+	size_t gridPartCount = parameters.partCount - chainCount * chainLength;
+	size_t terrainCount = static_cast<size_t>(std::round(gridPartCount * std::min(std::max(parameters.terrainFraction, 0.0), 1.0)));
+
+	std::vector<double> sizes(gridPartCount);
+	double totalVolume = 0.0;
+	for(double& size : sizes) {
+		size = shapes.randomSize();
+		// roughly the volume of the average shape with this largest dimension
+		totalVolume += size * size * size * 0.5;
+	}
+
+	// cells are large enough that neighbouring parts can't touch, whatever their rotation
+	double minCellSize = 2 * MAX_RADIUS_FACTOR * parameters.maxSize * 1.05;
+	double densityCellSize = (gridPartCount != 0 && parameters.packingDensity > 0.0) ? std::cbrt(totalVolume / gridPartCount / parameters.packingDensity) : minCellSize;
+	double cellSize = std::max(minCellSize, densityCellSize);
+	size_t side = static_cast<size_t>(std::ceil(std::cbrt(double(gridPartCount))));
+	double jitter = (cellSize - minCellSize) / 2;
+
+	double floorHalfWidth = std::max(side * cellSize, 10.0) / 2 + cellSize;
+	world.addTerrainPart(new Part(Box(floorHalfWidth * 2, 1.0, floorHalfWidth * 2), GlobalCFrame(0.0, 0.0, 0.0), sceneProperties));
+
+	// which cells hold terrain is random, the rest of the first gridPartCount cells hold free parts
+	std::vector<bool> isTerrain(gridPartCount, false);
+	for(size_t i = 0; i < terrainCount; i++) isTerrain[i] = true;
+	std::shuffle(isTerrain.begin(), isTerrain.end(), generator);
+
+	std::vector<Part*> cellParts(gridPartCount);
+	std::vector<Part*> freeParts;
+	std::vector<Part*> terrainParts;
+	for(size_t i = 0; i < gridPartCount; i++) {
+		size_t x = i % side;
+		size_t z = (i / side) % side;
+		size_t y = i / (side * side);
+		Position center(
+			(x + 0.5) * cellSize - side * cellSize / 2 + unit(generator) * jitter,
+			0.5 + (y + 0.5) * cellSize + unit(generator) * jitter,
+			(z + 0.5) * cellSize - side * cellSize / 2 + unit(generator) * jitter);
+		GlobalCFrame cframe(center, Rotation::fromEulerAngles(angle(generator), angle(generator), angle(generator)));
+		Part* part = new Part(shapes.createShape(sizes[i]), cframe, sceneProperties);
+		cellParts[i] = part;
+		if(isTerrain[i]) {
+			terrainParts.push_back(part);
+		} else {
+			freeParts.push_back(part);
+		}
+	}
+	world.addTerrainParts(terrainParts);
+	world.addParts(freeParts);
+
+	// ball constraints between free parts in neighbouring cells of the same row, every part in at most one
+	size_t constraintsLeft = parameters.constraintCount;
+	for(size_t i = 0; i + 1 < gridPartCount && constraintsLeft != 0; i++) {
+		if(isTerrain[i] || isTerrain[i + 1] || (i + 1) % side == 0) continue;
+		Part* a = cellParts[i];
+		Part* b = cellParts[i + 1];
+		Position middle = a->getCFrame().getPosition() + Vec3(b->getCFrame().getPosition() - a->getCFrame().getPosition()) / 2;
+		ConstraintGroup group;
+		group.ballConstraints.push_back(BallConstraint{a->parent->getCFrame().globalToLocal(middle), a->parent, b->parent->getCFrame().globalToLocal(middle), b->parent});
+		world.constraints.push_back(std::move(group));
+		constraintsLeft--;
+		i++;
+	}
+
+	// chains float above the grid, links spin around the length of the chain so they never hit each other
+	double linkLength = parameters.minSize * 2;
+	double linkWidth = parameters.minSize * 0.5;
+	double chainSpacing = chainLength * linkLength * 1.2 + cellSize;
+	size_t chainsPerRow = static_cast<size_t>(std::ceil(std::sqrt(double(chainCount))));
+	double chainHeight = 0.5 + ((gridPartCount + side * side - 1) / std::max<size_t>(side * side, 1) + 1) * cellSize;
+	for(size_t c = 0; c < chainCount; c++) {
+		Position start(
+			(c % chainsPerRow) * chainSpacing - chainsPerRow * chainSpacing / 2,
+			chainHeight,
+			(c / chainsPerRow) * cellSize - chainsPerRow * cellSize / 2);
+		Part* root = new Part(Box(linkLength, linkWidth, linkWidth), GlobalCFrame(start), sceneProperties);
+		Part* previous = root;
+		for(size_t l = 1; l < chainLength; l++) {
+			Part* link = new Part(Box(linkLength, linkWidth, linkWidth), GlobalCFrame(), sceneProperties);
+			double speed = (l % 2 == 0) ? 1.0 : -1.0;
+			previous->attach(link, new MotorConstraint(Vec3(speed, 0.0, 0.0)), CFrame(Vec3(linkLength * 0.6, 0.0, 0.0)), CFrame(Vec3(-linkLength * 0.6, 0.0, 0.0)));
+			previous = link;
+		}
+		world.addPart(root);
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+
+#include "../physics/world.h"
+#include "../physics/part.h"
+
+/*
+	Describes a scene by its statistics, so the same kind of scene can be generated at any size
+	Parts are laid out on a jittered grid above a floor, randomly rotated and not touching at the start
+*/
+struct SceneParameters {
+	// the total number of parts, including terrain and chain links
+	size_t partCount = 1000;
+
+	// relative weights of the shapes of free and terrain parts
+	double boxWeight = 1.0;
+	double sphereWeight = 1.0;
+	double cylinderWeight = 1.0;
+	double hullWeight = 0.0;
+
+	// the largest dimension of each part is log-uniform between these
+	double minSize = 0.5;
+	double maxSize = 1.5;
+
+	// fraction of the volume of the grid filled by parts, limited by parts not touching at the start
+	double packingDensity = 0.05;
+
+	// fraction of the parts that are anchored terrain, scattered through the grid as obstacles
+	double terrainFraction = 0.1;
+
+	// chains of chainLength boxes attached by motor constraints, each chain is one MotorizedPhysical
+	size_t chainCount = 0;
+	size_t chainLength = 5;
+
+	// ball constraints between neighbouring free parts, each in its own ConstraintGroup
+	size_t constraintCount = 0;
+
+	unsigned int seed = 1;
+
+	// sets the parameter with the given name, returns false for unknown names
+	bool set(const std::string& name, double value);
+	// parses a list like "partCount=1000,terrainFraction=0.2", returns false if any entry is malformed or unknown
+	bool parse(const std::string& list);
+};
+
+// adds the parts and constraints of a scene to the given world, the world takes ownership of them
+void generateScene(World<Part>& world, const SceneParameters& parameters);
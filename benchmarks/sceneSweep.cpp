@@ -0,0 +1,139 @@
+#include "sceneSweep.h"
+
+#include <chrono>
+#include <array>
+#include <cmath>
+
+#include "../util/log.h"
+#include "../physics/physicsProfiler.h"
+#include "../physics/misc/gravityForce.h"
+
+// a phase growing with an exponent above this is reported as super-linear
+#define SUPERLINEAR_EXPONENT 1.2
+// phases taking less than this fraction of the tick at the largest size are too small to judge
+#define MINIMUM_PHASE_FRACTION 0.01
+
+struct SweepPoint {
+	size_t partCount;
+	double ticksPerSecond;
+	double msPerTick;
+	double p99MsPerTick;
+	std::array<double, static_cast<size_t>(PhysicsProcess::COUNT)> processMsPerTick{};
+};
+
+static SweepPoint measureScene(const SceneParameters& scene, int warmupTicks, int measuredTicks) {
+	World<Part> world(0.005);
+	world.addExternalForce(new DirectionalGravity(Vec3(0, -10, 0)));
+	generateScene(world, scene);
+
+	for(int i = 0; i < warmupTicks; i++) {
+		world.tick();
+	}
+
+	SweepPoint result{scene.partCount};
+	std::array<long long, static_cast<size_t>(PhysicsProcess::COUNT)> processNanos{};
+	physicsMeasure.resetLatency();
+	auto start = std::chrono::high_resolution_clock::now();
+	for(int i = 0; i < measuredTicks; i++) {
+		physicsMeasure.mark(PhysicsProcess::OTHER);
+		world.tick();
+		physicsMeasure.end();
+		for(size_t p = 0; p < physicsMeasure.size(); p++) {
+			processNanos[p] += physicsMeasure.history.front()[p].count();
+		}
+	}
+	double totalMillis = (std::chrono::high_resolution_clock::now() - start).count() / 1000000.0;
+
+	result.msPerTick = totalMillis / measuredTicks;
+	result.ticksPerSecond = 1000.0 / result.msPerTick;
+	result.p99MsPerTick = physicsMeasure.getLatency().tick.getPercentile(99.0) / 1000000.0;
+	for(size_t p = 0; p < physicsMeasure.size(); p++) {
+		result.processMsPerTick[p] = processNanos[p] / 1000000.0 / measuredTicks;
+	}
+	return result;
+}
+
+// least squares slope of log(time) over log(partCount), points with no time are left out
+template<typename GetTime>
+static double fitExponent(const std::vector<SweepPoint>& points, const GetTime& getTime) {
+	double sumX = 0.0, sumY = 0.0, sumXX = 0.0, sumXY = 0.0;
+	int count = 0;
+	for(const SweepPoint& point : points) {
+		double time = getTime(point);
+		if(time <= 0.0 || point.partCount == 0) continue;
+		double x = std::log(double(point.partCount));
+		double y = std::log(time);
+		sumX += x; sumY += y; sumXX += x * x; sumXY += x * y;
+		count++;
+	}
+	double denominator = count * sumXX - sumX * sumX;
+	if(count < 2 || denominator == 0.0) return 0.0;
+	return (count * sumXY - sumX * sumY) / denominator;
+}
+
+void runSceneSweep(const SceneParameters& scene, const std::vector<size_t>& partCounts, int warmupTicks, int measuredTicks, std::ostream* jsonStream) {
+	std::vector<SweepPoint> points;
+	for(size_t partCount : partCounts) {
+		SceneParameters sized = scene;
+		sized.partCount = partCount;
+		Log::setColor(Log::WHITE);
+		Log::print("sweeping %d parts...\n", int(partCount));
+		points.push_back(measureScene(sized, warmupTicks, measuredTicks));
+	}
+
+	const size_t processCount = physicsMeasure.size();
+
+	Log::setColor(Log::WHITE);
+	Log::print("%10s %10s %10s %10s", "parts", "ticks/s", "ms/tick", "p99 ms");
+	for(size_t p = 0; p < processCount; p++) Log::print(" %12.12s", physicsMeasure.labels[p]);
+	Log::print("\n");
+	for(const SweepPoint& point : points) {
+		Log::print("%10d %10.1f %10.4f %10.4f", int(point.partCount), point.ticksPerSecond, point.msPerTick, point.p99MsPerTick);
+		for(size_t p = 0; p < processCount; p++) Log::print(" %12.4f", point.processMsPerTick[p]);
+		Log::print("\n");
+	}
+
+	double tickExponent = fitExponent(points, [](const SweepPoint& point) {return point.msPerTick; });
+	std::array<double, static_cast<size_t>(PhysicsProcess::COUNT)> exponents{};
+	std::array<bool, static_cast<size_t>(PhysicsProcess::COUNT)> superlinear{};
+	Log::print("\ngrowth exponents, time ~ parts^exponent:\n");
+	Log::setColor((tickExponent > SUPERLINEAR_EXPONENT) ? (Log::STRONG | Log::RED) : Log::WHITE);
+	Log::print("  %-24s %6.2f\n", "tick:", tickExponent);
+	for(size_t p = 0; p < processCount; p++) {
+		exponents[p] = fitExponent(points, [p](const SweepPoint& point) {return point.processMsPerTick[p]; });
+		bool significant = !points.empty() && points.back().processMsPerTick[p] >= MINIMUM_PHASE_FRACTION * points.back().msPerTick;
+		superlinear[p] = significant && exponents[p] > SUPERLINEAR_EXPONENT;
+		Log::setColor(superlinear[p] ? (Log::STRONG | Log::RED) : Log::WHITE);
+		Log::print("  %-24s %6.2f%s\n", (std::string(physicsMeasure.labels[p]) + ":").c_str(), exponents[p], superlinear[p] ? "  SUPER-LINEAR" : significant ? "" : "  (negligible)");
+	}
+	Log::setColor(Log::WHITE);
+
+	if(jsonStream != nullptr) {
+		std::ostream& ostream = *jsonStream;
+		ostream << "{\"warmupTicks\":" << warmupTicks << ",\"ticks\":" << measuredTicks << ",\"points\":[";
+		for(size_t i = 0; i < points.size(); i++) {
+			const SweepPoint& point = points[i];
+			if(i != 0) ostream << ',';
+			ostream << "\n{\"parts\":" << point.partCount << ",\"ticksPerSecond\":" << point.ticksPerSecond << ",\"msPerTick\":" << point.msPerTick << ",\"p99MsPerTick\":" << point.p99MsPerTick << ",\"physicsBreakdownMsPerTick\":{";
+			for(size_t p = 0; p < processCount; p++) {
+				if(p != 0) ostream << ',';
+				ostream << '"' << physicsMeasure.labels[p] << "\":" << point.processMsPerTick[p];
+			}
+			ostream << "}}";
+		}
+		ostream << "\n],\"tickExponent\":" << tickExponent << ",\"exponents\":{";
+		for(size_t p = 0; p < processCount; p++) {
+			if(p != 0) ostream << ',';
+			ostream << '"' << physicsMeasure.labels[p] << "\":" << exponents[p];
+		}
+		ostream << "},\"superLinear\":[";
+		bool first = true;
+		for(size_t p = 0; p < processCount; p++) {
+			if(!superlinear[p]) continue;
+			if(!first) ostream << ',';
+			ostream << '"' << physicsMeasure.labels[p] << '"';
+			first = false;
+		}
+		ostream << "]}\n";
+	}
+}
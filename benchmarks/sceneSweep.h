@@ -0,0 +1,14 @@
+#pragma once
+
+#include <vector>
+#include <ostream>
+
+#include "sceneGenerator.h"
+
+/*
+	Generates the scene at each of the given part counts and measures ticks per second and the time of every PhysicsProcess
+	The growth of each phase is fitted as time ~ partCount^exponent on a log-log scale,
+	phases growing faster than linearly are reported as scaling cliffs
+	Writes the curve as JSON to jsonStream if it is not null
+*/
+void runSceneSweep(const SceneParameters& scene, const std::vector<size_t>& partCounts, int warmupTicks, int measuredTicks, std::ostream* jsonStream);
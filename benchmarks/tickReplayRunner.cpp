@@ -0,0 +1,116 @@
+#include "tickReplayRunner.h"
+
+#include <chrono>
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <string>
+
+#include "../util/log.h"
+#include "../util/mappedFile.h"
+#include "../util/serializeBasicTypes.h"
+#include "../physics/physicsProfiler.h"
+#include "../physics/misc/tickCapture.h"
+
+// the number of slowest ticks that are listed
+#define SLOWEST_TICK_COUNT 10
+
+struct ReplayedTick {
+	size_t age;
+	long long nanos;
+	std::array<long long, static_cast<size_t>(PhysicsProcess::COUNT)> processNanos;
+};
+
+int runTickReplay(const char* captureFile, size_t firstAge, size_t lastAge, std::ostream* jsonStream) {
+	std::vector<ReplayedTick> ticks;
+	size_t keyframeCount;
+	size_t captureFirstAge;
+	size_t captureEndAge;
+	try {
+		MappedFile file(captureFile);
+		TickReplay replay(file.getData(), file.getSize());
+		keyframeCount = replay.getKeyframeCount();
+		captureFirstAge = replay.getFirstAge();
+		captureEndAge = replay.getEndAge();
+		Log::print("replaying %s, ticks %d to %d with %d keyframes\n", captureFile, int(captureFirstAge), int(captureEndAge), int(keyframeCount));
+
+		replay.skipTo(firstAge);
+		physicsMeasure.resetLatency();
+		while(!replay.isFinished() && replay.getAge() < lastAge) {
+			size_t age = replay.getAge();
+			replay.prepareTick();
+
+			auto start = std::chrono::high_resolution_clock::now();
+			physicsMeasure.mark(PhysicsProcess::OTHER);
+			replay.getWorld().tick();
+			physicsMeasure.end();
+			long long nanos = (std::chrono::high_resolution_clock::now() - start).count();
+
+			ReplayedTick tick{age, nanos};
+			for(size_t p = 0; p < physicsMeasure.size(); p++) {
+				tick.processNanos[p] = physicsMeasure.history.front()[p].count();
+			}
+			ticks.push_back(tick);
+		}
+	} catch(const SerializationException& e) {
+		Log::error("Could not replay %s: %s", captureFile, e.what());
+		return 1;
+	}
+	if(ticks.empty()) {
+		Log::error("No ticks of the capture are in the range %d-%d", int(firstAge), int(lastAge));
+		return 1;
+	}
+
+	const size_t processCount = physicsMeasure.size();
+	std::array<long long, static_cast<size_t>(PhysicsProcess::COUNT)> totalProcessNanos{};
+	long long totalNanos = 0;
+	for(const ReplayedTick& tick : ticks) {
+		totalNanos += tick.nanos;
+		for(size_t p = 0; p < processCount; p++) totalProcessNanos[p] += tick.processNanos[p];
+	}
+
+	std::vector<const ReplayedTick*> slowest;
+	for(const ReplayedTick& tick : ticks) slowest.push_back(&tick);
+	size_t slowestCount = std::min<size_t>(SLOWEST_TICK_COUNT, slowest.size());
+	std::partial_sort(slowest.begin(), slowest.begin() + slowestCount, slowest.end(), [](const ReplayedTick* a, const ReplayedTick* b) {return a->nanos > b->nanos; });
+	slowest.resize(slowestCount);
+
+	const LatencyHistogram& latency = physicsMeasure.getLatency().tick;
+	Log::setColor(Log::WHITE);
+	Log::print("%d ticks, %.4f ms/tick, p50 %.4fms, p99 %.4fms, max %.4fms\n", int(ticks.size()), totalNanos / 1000000.0 / ticks.size(),
+			   latency.getPercentile(50.0) / 1000000.0, latency.getPercentile(99.0) / 1000000.0, latency.getMax() / 1000000.0);
+	for(size_t p = 0; p < processCount; p++) {
+		Log::print("  %-22s %10.4f ms/tick\n", (std::string(physicsMeasure.labels[p]) + ":").c_str(), totalProcessNanos[p] / 1000000.0 / ticks.size());
+	}
+
+	Log::print("\nslowest ticks:\n%10s %10s", "age", "ms");
+	for(size_t p = 0; p < processCount; p++) Log::print(" %12.12s", physicsMeasure.labels[p]);
+	Log::print("\n");
+	for(const ReplayedTick* tick : slowest) {
+		Log::print("%10d %10.4f", int(tick->age), tick->nanos / 1000000.0);
+		for(size_t p = 0; p < processCount; p++) Log::print(" %12.4f", tick->processNanos[p] / 1000000.0);
+		Log::print("\n");
+	}
+
+	if(jsonStream != nullptr) {
+		std::ostream& ostream = *jsonStream;
+		ostream << "{\"capture\":\"" << captureFile << "\",\"firstAge\":" << captureFirstAge << ",\"endAge\":" << captureEndAge << ",\"keyframes\":" << keyframeCount;
+		ostream << ",\"ticks\":" << ticks.size() << ",\"msPerTick\":" << totalNanos / 1000000.0 / ticks.size() << ",\"physicsBreakdownMsPerTick\":{";
+		for(size_t p = 0; p < processCount; p++) {
+			if(p != 0) ostream << ',';
+			ostream << '"' << physicsMeasure.labels[p] << "\":" << totalProcessNanos[p] / 1000000.0 / ticks.size();
+		}
+		ostream << "},\"tickMs\":[";
+		for(size_t i = 0; i < ticks.size(); i++) {
+			if(i != 0) ostream << ',';
+			ostream << "\n{\"age\":" << ticks[i].age << ",\"ms\":" << ticks[i].nanos / 1000000.0 << '}';
+		}
+		ostream << "\n],\"slowestAges\":[";
+		for(size_t i = 0; i < slowest.size(); i++) {
+			if(i != 0) ostream << ',';
+			ostream << slowest[i]->age;
+		}
+		ostream << "]}\n";
+	}
+	return 0;
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+
+/*
+	Reruns a capture made with TickCapture and profiles every tick, to reproduce latency spikes of a running world offline
+	Ticks before firstAge are run without profiling, so a spike can be bisected by narrowing firstAge..lastAge
+	Reports the latency of the ticks, the time of every PhysicsProcess and the slowest ticks with their age
+	Writes the results as JSON to jsonStream if it is not null, returns the exit code of the runner
+*/
+int runTickReplay(const char* captureFile, size_t firstAge, size_t lastAge, std::ostream* jsonStream);
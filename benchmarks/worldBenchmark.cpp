@@ -4,6 +4,8 @@
 #include "../physics/physicsProfiler.h"
 #include <iostream>
 #include <sstream>
+#include <iterator>
+#include <new>
 #include "../physics/misc/gravityForce.h"
 
 #include "../physics/geometry/basicShapes.h"
@@ -13,26 +15,17 @@
 
 #include "../physics/misc/filters/outOfBoundsFilter.h"
 
+bool WorldBenchmark::sampleMemoryEveryTick = false;
+
 WorldBenchmark::WorldBenchmark(const char* name, int tickCount) : Benchmark(name), world(0.005), tickCount(tickCount) {
 	world.addExternalForce(new DirectionalGravity(Vec3(0, -10, 0)));
 }
 
 void WorldBenchmark::run() {
 	world.isValid();
-	Part& partToTrack = *world.physicals[0]->getMainPart();
+	std::array<long long, static_cast<size_t>(PhysicsProcess::COUNT)> thisRunNanos{};
 	for (int i = 0; i < tickCount; i++) {
-		if (i % (tickCount / 8) == 0) {
-			Log::print("Tick %d\n", i);
-			Position pos = partToTrack.getCFrame().getPosition();
-			Log::print("Location of object: %.5f %.5f %.5f\n", double(pos.x), double(pos.y), double(pos.z));
-
-			size_t partsOutOfBounds = 0;
-			for(const Part& p : world.iterPartsFiltered(OutOfBoundsFilter(Bounds(Position(-100.0, -100.0, -100.0), Position(100.0, 100.0, 100.0))))) {
-				partsOutOfBounds++;
-			}
-
-			Log::print("%d/%d parts out of bounds!\n", partsOutOfBounds, world.getPartCount());
-		}
+		if(sampleMemoryEveryTick) MemoryAccounting::resetTransientPeaks();
 
 		physicsMeasure.mark(PhysicsProcess::OTHER);
 
@@ -40,10 +33,26 @@ void WorldBenchmark::run() {
 
 		physicsMeasure.end();
 
+		if(sampleMemoryEveryTick) memoryPeak.keepMax(world.getMemoryUsage());
+
+		measuredTicks++;
+		for(size_t i = 0; i < physicsMeasure.size(); i++) {
+			thisRunNanos[i] += physicsMeasure.history.front()[i].count();
+		}
+		for(size_t i = 0; i < intersectionStatistics.size(); i++) {
+			intersectionCounts[i] += intersectionStatistics.history.front()[i];
+		}
+
 		GJKCollidesIterationStatistics.nextTally();
 		GJKNoCollidesIterationStatistics.nextTally();
 		EPAIterationStatistics.nextTally();
 	}
+	for(size_t i = 0; i < physicsMeasure.size(); i++) {
+		processNanos[i] += thisRunNanos[i];
+	}
+	runProcessNanos.push_back(thisRunNanos);
+	memoryCurrent = world.getMemoryUsage();
+	memoryPeak.keepMax(memoryCurrent);
 	world.isValid();
 }
 
@@ -143,16 +152,78 @@ void printBreakdown(const T* values, const char** labels, size_t N, std::string
 
 }
 
+static const double latencyPercentiles[]{50.0, 90.0, 99.0, 99.9};
+static const char* latencyPercentileNames[]{"p50", "p90", "p99", "p99.9"};
+
+static void printLatency(const char* label, const LatencyHistogram& histogram) {
+	Log::print("%-22s", (std::string(label) + ":").c_str());
+	for(double percentile : latencyPercentiles) {
+		Log::print(" %10.4fms", histogram.getPercentile(percentile) / 1000000.0);
+	}
+	Log::print(" %10.4fms\n", histogram.getMax() / 1000000.0);
+}
+
+static void writeLatencyJSON(std::ostream& ostream, const LatencyHistogram& histogram) {
+	ostream << '{';
+	for(size_t i = 0; i < std::size(latencyPercentiles); i++) {
+		ostream << '"' << latencyPercentileNames[i] << "\":" << histogram.getPercentile(latencyPercentiles[i]) / 1000000.0 << ',';
+	}
+	ostream << "\"max\":" << histogram.getMax() / 1000000.0 << ",\"mean\":" << histogram.getMean() / 1000000.0 << '}';
+}
+
+// misses per thousand instructions
+static double perKiloInstruction(const HardwareCounterValues& counts, HardwareCounter counter) {
+	uint64_t instructions = counts[HardwareCounter::INSTRUCTIONS];
+	return (instructions != 0) ? counts[counter] * 1000.0 / instructions : 0.0;
+}
+
+static void printHardwareCounters() {
+	Log::print("%-22s %12s %8s %12s %12s %12s\n", "", "Mcycles", "IPC", "L1D/kinstr", "LLC/kinstr", "branch/kinstr");
+	for(size_t i = 0; i < physicsMeasure.size(); i++) {
+		const HardwareCounterValues& counts = physicsMeasure.hardwareCounts[i];
+		uint64_t cycles = counts[HardwareCounter::CYCLES];
+		double ipc = (cycles != 0) ? double(counts[HardwareCounter::INSTRUCTIONS]) / cycles : 0.0;
+		Log::print("%-22s %12.3f %8.3f %12.3f %12.3f %12.3f\n", (std::string(physicsMeasure.labels[i]) + ":").c_str(), cycles / 1000000.0, ipc,
+				   perKiloInstruction(counts, HardwareCounter::L1D_MISSES), perKiloInstruction(counts, HardwareCounter::LLC_MISSES), perKiloInstruction(counts, HardwareCounter::BRANCH_MISSES));
+	}
+	for(size_t c = 0; c < static_cast<size_t>(HardwareCounter::COUNT); c++) {
+		if(!HardwareCounters::isAvailable(static_cast<HardwareCounter>(c))) {
+			Log::print("%s unavailable: %s\n", HardwareCounters::labels[c], HardwareCounters::getUnavailableReason());
+		}
+	}
+}
+
+static void printMemory(const MemoryUsage& current, const MemoryUsage& peak) {
+	Log::print("%-22s %12s %12s\n", "", "current KB", "peak KB");
+	for(size_t i = 0; i < static_cast<size_t>(MemoryCategory::COUNT); i++) {
+		Log::print("%-22s %12.1f %12.1f\n", (std::string(MemoryAccounting::labels[i]) + ":").c_str(), current.bytes[i] / 1024.0, peak.bytes[i] / 1024.0);
+	}
+	Log::print("%-22s %12.1f %12.1f\n", "Total:", current.total() / 1024.0, peak.total() / 1024.0);
+}
+
 void WorldBenchmark::printResults(double timeTakenMillis) {
 	double tickTime = (timeTakenMillis) / tickCount;
 	Log::print("%d ticks at %f ticks per second\n", tickCount, 1000 / tickTime);
 
-	auto physicsBreakdown = physicsMeasure.history.avg();
+	if(!world.physicals.empty()) {
+		Position pos = world.physicals[0]->getMainPart()->getCFrame().getPosition();
+		Log::print("Location of object: %.5f %.5f %.5f\n", double(pos.x), double(pos.y), double(pos.z));
+	}
+	size_t partsOutOfBounds = 0;
+	for(const Part& p : world.iterPartsFiltered(OutOfBoundsFilter(Bounds(Position(-100.0, -100.0, -100.0), Position(100.0, 100.0, 100.0))))) {
+		partsOutOfBounds++;
+	}
+	Log::print("%d/%d parts out of bounds!\n", int(partsOutOfBounds), int(world.getPartCount()));
 
+	// averaged over every measured tick, the same as the JSON results
+	double ticks = (measuredTicks != 0) ? double(measuredTicks) : 1.0;
 	double millis[physicsMeasure.size()];
-
 	for (size_t i = 0; i < physicsMeasure.size(); i++) {
-		millis[i] = physicsBreakdown[i].count() / 1000000.0;
+		millis[i] = processNanos[i] / ticks / 1000000.0;
+	}
+	double intersections[intersectionStatistics.size()];
+	for (size_t i = 0; i < intersectionStatistics.size(); i++) {
+		intersections[i] = intersectionCounts[i] / ticks;
 	}
 
 	Log::setColor(Log::WHITE);
@@ -165,9 +236,126 @@ void WorldBenchmark::printResults(double timeTakenMillis) {
 	std::cout << "\n";
 	Log::setColor(Log::STRONG | Log::MAGENTA);
 	std::cout << "[Intersection Statistics]\n";
-	printBreakdown(intersectionStatistics.history.avg().values, intersectionStatistics.labels, intersectionStatistics.size(), "");
+	printBreakdown(intersections, intersectionStatistics.labels, intersectionStatistics.size(), "");
+
+	const LatencyBreakdown<PhysicsProcess>& latency = physicsMeasure.getLatency();
+	Log::setColor(Log::WHITE);
+	std::cout << "\n";
+	Log::setColor(Log::STRONG | Log::MAGENTA);
+	std::cout << "[Tick Latency]\n";
+	Log::setColor(Log::WHITE);
+	Log::print("%-22s %12s %12s %12s %12s %12s\n", "", "p50", "p90", "p99", "p99.9", "max");
+	printLatency("Tick", latency.tick);
+	for(size_t i = 0; i < physicsMeasure.size(); i++) {
+		printLatency(physicsMeasure.labels[i], latency.processes[i]);
+	}
+
+	Log::setColor(Log::WHITE);
+	std::cout << "\n";
+	Log::setColor(Log::STRONG | Log::MAGENTA);
+	std::cout << (sampleMemoryEveryTick ? "[Memory, peak per tick]\n" : "[Memory, peak per run]\n");
+	Log::setColor(Log::WHITE);
+	printMemory(memoryCurrent, memoryPeak);
+
+	if(HardwareCounters::isEnabled()) {
+		Log::setColor(Log::WHITE);
+		std::cout << "\n";
+		Log::setColor(Log::STRONG | Log::MAGENTA);
+		std::cout << "[Hardware Counters]\n";
+		Log::setColor(Log::WHITE);
+		printHardwareCounters();
+	}
 }
 
+// the world does not own its parts, so they are deleted before it is rebuilt empty, with the same external forces
+void WorldBenchmark::cleanup() {
+	std::vector<Part*> freeParts;
+	std::vector<Part*> terrainParts;
+	for(Part& part : world.iterParts(FREE_PARTS)) freeParts.push_back(&part);
+	for(Part& part : world.iterParts(TERRAIN_PARTS)) terrainParts.push_back(&part);
+	// a physical is deleted along with its last part
+	for(Part* part : freeParts) delete part;
+
+	std::vector<ExternalForce*> externalForces = world.externalForces;
+	double deltaT = world.deltaT;
+	world.~World<Part>();
+	new(&world) World<Part>(deltaT);
+	for(ExternalForce* force : externalForces) world.addExternalForce(force);
+
+	// terrain parts have no physical, only the old world referred to them
+	for(Part* part : terrainParts) delete part;
+}
+
+void WorldBenchmark::clearResults() {
+	measuredTicks = 0;
+	for(long long& nanos : processNanos) nanos = 0;
+	for(long long& count : intersectionCounts) count = 0;
+	runProcessNanos.clear();
+	physicsMeasure.resetLatency();
+	physicsMeasure.resetHardwareCounts();
+	memoryCurrent = MemoryUsage();
+	memoryPeak = MemoryUsage();
+	MemoryAccounting::resetTransientPeaks();
+}
+
+void WorldBenchmark::writeJSONResults(std::ostream& ostream) const {
+	double ticks = (measuredTicks != 0) ? double(measuredTicks) : 1.0;
+	ostream << ",\"ticks\":" << measuredTicks;
+	ostream << ",\"physicsBreakdownMsPerTick\":{";
+	for(size_t i = 0; i < physicsMeasure.size(); i++) {
+		if(i != 0) ostream << ',';
+		ostream << '"' << physicsMeasure.labels[i] << "\":" << processNanos[i] / ticks / 1000000.0;
+	}
+	ostream << "},\"physicsBreakdownRunsMsPerTick\":{";
+	for(size_t i = 0; i < physicsMeasure.size(); i++) {
+		if(i != 0) ostream << ',';
+		ostream << '"' << physicsMeasure.labels[i] << "\":[";
+		for(size_t r = 0; r < runProcessNanos.size(); r++) {
+			if(r != 0) ostream << ',';
+			ostream << runProcessNanos[r][i] / double(tickCount) / 1000000.0;
+		}
+		ostream << ']';
+	}
+	ostream << "},\"intersectionStatistics\":{";
+	for(size_t i = 0; i < intersectionStatistics.size(); i++) {
+		if(i != 0) ostream << ',';
+		ostream << '"' << intersectionStatistics.labels[i] << "\":" << intersectionCounts[i];
+	}
+	const LatencyBreakdown<PhysicsProcess>& latency = physicsMeasure.getLatency();
+	ostream << "},\"tickLatencyMs\":";
+	writeLatencyJSON(ostream, latency.tick);
+	ostream << ",\"processLatencyMs\":{";
+	for(size_t i = 0; i < physicsMeasure.size(); i++) {
+		if(i != 0) ostream << ',';
+		ostream << '"' << physicsMeasure.labels[i] << "\":";
+		writeLatencyJSON(ostream, latency.processes[i]);
+	}
+	ostream << "},\"memoryBytes\":{";
+	for(size_t i = 0; i < static_cast<size_t>(MemoryCategory::COUNT); i++) {
+		if(i != 0) ostream << ',';
+		ostream << '"' << MemoryAccounting::labels[i] << "\":{\"current\":" << memoryCurrent.bytes[i] << ",\"peak\":" << memoryPeak.bytes[i] << '}';
+	}
+	ostream << "},\"memoryPeakPerTick\":" << (sampleMemoryEveryTick ? "true" : "false");
+
+	if(HardwareCounters::isEnabled()) {
+		ostream << ",\"hardwareCounters\":{";
+		for(size_t i = 0; i < physicsMeasure.size(); i++) {
+			if(i != 0) ostream << ',';
+			ostream << '"' << physicsMeasure.labels[i] << "\":{";
+			for(size_t c = 0; c < static_cast<size_t>(HardwareCounter::COUNT); c++) {
+				if(c != 0) ostream << ',';
+				ostream << '"' << HardwareCounters::labels[c] << "\":";
+				if(HardwareCounters::isAvailable(static_cast<HardwareCounter>(c))) {
+					ostream << physicsMeasure.hardwareCounts[i].values[c];
+				} else {
+					ostream << "null";
+				}
+			}
+			ostream << '}';
+		}
+		ostream << '}';
+	}
+}
 
 void WorldBenchmark::createFloor(double w, double h, double wallHeight) {
 	world.addTerrainPart(new Part(Library::createBox(w, 1.0, h), GlobalCFrame(0.0, 0.0, 0.0), basicProperties));
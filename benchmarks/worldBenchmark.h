@@ -1,7 +1,11 @@
 #pragma once
 
+#include <array>
+#include <vector>
+
 #include "benchmark.h"
 #include "../physics/world.h"
+#include "../physics/physicsProfiler.h"
 
 static const PartProperties basicProperties{1.0, 0.7, 0.5};
 class WorldBenchmark : public Benchmark {
@@ -9,11 +13,27 @@ protected:
 	World<Part> world;
 	int tickCount;
 
+	// summed over every tick since the last clearResults, physicsMeasure and intersectionStatistics only keep the last few ticks
+	long long measuredTicks = 0;
+	long long processNanos[static_cast<size_t>(PhysicsProcess::COUNT)]{};
+	long long intersectionCounts[static_cast<size_t>(IntersectionResult::COUNT)]{};
+	// the breakdown of each run separately, so a comparison can tell the noise of each phase
+	std::vector<std::array<long long, static_cast<size_t>(PhysicsProcess::COUNT)>> runProcessNanos;
+	// the memory of the world after the last run, and the most it used at the end of any tick (or run, without sampleMemoryEveryTick)
+	MemoryUsage memoryCurrent;
+	MemoryUsage memoryPeak;
+
 public:
+	// walking the world for its memory usage takes time, so by default it is only done after every run
+	static bool sampleMemoryEveryTick;
+
 	WorldBenchmark(const char* name, int tickCount);
 
 	virtual void run() override;
 	virtual void printResults(double timeTaken) override;
+	virtual void cleanup() override;
+	virtual void clearResults() override;
+	virtual void writeJSONResults(std::ostream& ostream) const override;
 
 	void createFloor(double w, double h, double wallHeight);
 };
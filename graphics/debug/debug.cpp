@@ -10,7 +10,9 @@
 #include "../physics/math/mathUtil.h"
 #include "threePhaseBuffer.h"
 
-#include "../physics/geometry/polyhedron.h"
+#include <vector>
+#include <atomic>
+#include <fstream>
 
 void clearError() {
 	while (glGetError() != GL_NO_ERROR);
@@ -27,60 +29,48 @@ bool logCall(const char* func, const char* file, int line) {
 	return response;
 }
 
+// the last records of the physics engine are kept, about a second of a busy world
+#define DEBUG_RECORD_CAPACITY 65536
+
 namespace AppDebug {
 	
 	ThreePhaseBuffer<ColoredVector> vecBuf(256);
 	ThreePhaseBuffer<ColoredPoint> pointBuf(256);
 
-	namespace Logging {
-		using namespace Debug;
+	// records of the physics engine that were not drawn yet
+	static size_t recordCursor = 0;
+	static std::vector<Debug::Record> newRecords;
+	static std::atomic<const char*> requestedDumpFile(nullptr);
 
-		void logVector(Position origin, Vec3 vec, VectorType type) {
-			vecBuf.add(ColoredVector(origin, vec, type));
-		}
+	void logTickStart() {
 
-		void logPoint(Position point, PointType type) {
-			pointBuf.add(ColoredPoint(point, type));
-		}
+	}
 
-		void logCFrame(CFrame frame, CFrameType type) {
-			switch (type) {
-			case OBJECT_CFRAME: {
-				Vec3 pos = frame.position;
-				Rotation rot = frame.rotation;
-				// buf.add(ColoredVec(frame.position, rot * Vec3(1.0, 0.0, 0.0), 0.0));
-				// buf.add(ColoredVec(frame.position, rot * Vec3(0.0, 1.0, 0.0), 0.3));
-				// buf.add(ColoredVec(frame.position, rot * Vec3(0.0, 0.0, 1.0), 0.6));
-			}
+	void logTickEnd() {
+		newRecords.clear();
+		Debug::readRecords(recordCursor, newRecords);
+		for(const Debug::Record& record : newRecords) {
+			switch(record.kind) {
+			case Debug::RecordKind::VECTOR:
+				vecBuf.add(ColoredVector(record.position, record.vector, static_cast<Debug::VectorType>(record.type)));
 				break;
-			case INERTIAL_CFRAME: {
-				Vec3 pos = frame.position;
-				Rotation rot = frame.rotation;
-				// buf.add(ColoredVec(frame.position, rot * Vec3(1.0, 0.0, 0.0), 0.1));
-				// buf.add(ColoredVec(frame.position, rot * Vec3(0.0, 1.0, 0.0), 0.4));
-				// buf.add(ColoredVec(frame.position, rot * Vec3(0.0, 0.0, 1.0), 0.7));
-			}
+			case Debug::RecordKind::POINT:
+				pointBuf.add(ColoredPoint(record.position, static_cast<Debug::PointType>(record.type)));
+				break;
+			case Debug::RecordKind::CFRAME:
 				break;
 			}
 		}
-
-		void logShape(const Polyhedron& shape, const GlobalCFrame& location) {
-			for(int i = 0; i < shape.triangleCount; i++) {
-				Triangle t = shape.getTriangle(i);
-				for(int j = 0; j < 3; j++) {
-					Debug::logVector(location.localToGlobal(shape[t[j]]), location.localToRelative(shape[t[(j + 1) % 3]] - shape[t[j]]), Debug::INFO_VEC);
-				}
-			}
-		}
-	}
-
-	void logTickStart() {
-
-	}
-
-	void logTickEnd() {
 		vecBuf.pushWriteBuffer();
 		pointBuf.pushWriteBuffer();
+
+		// dumping runs here, as no records are made between ticks
+		const char* dumpFile = requestedDumpFile.exchange(nullptr);
+		if(dumpFile != nullptr) {
+			std::ofstream file(dumpFile, std::ios::binary);
+			Debug::dumpCapture(file);
+			Log::info("Dumped %d debug records to %s", int(Debug::getRecordCount()), dumpFile);
+		}
 	}
 
 	void logFrameStart() {
@@ -93,10 +83,11 @@ namespace AppDebug {
 
 	void setupDebugHooks() {
 		Log::info("Set up debug hooks!");
-		Debug::setVectorLogAction(Logging::logVector);
-		Debug::setPointLogAction(Logging::logPoint);
-		Debug::setCFrameLogAction(Logging::logCFrame);
-		Debug::setShapeLogAction(Logging::logShape);
+		Debug::enableCapture(DEBUG_RECORD_CAPACITY);
+	}
+
+	void dumpDebugCapture(const char* fileName) {
+		requestedDumpFile.store(fileName);
 	}
 
 	/*
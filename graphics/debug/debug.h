@@ -28,6 +28,8 @@ namespace AppDebug {
 	};
 
 	void setupDebugHooks();
+	// writes the debug capture of the physics engine to the given file after the current tick, the name must outlive that
+	void dumpDebugCapture(const char* fileName);
 
 	void logTickStart();
 	void logTickEnd();
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+
+class Part;
+class WorldPrototype;
+
+struct BroadphasePair {
+	Part* p1;
+	Part* p2;
+};
+
+/*
+	A broadphase finds the pairs of parts whose bounds overlap, the narrowphase then only has to test these pairs
+
+	Every world owns one broadphase, it can be swapped with WorldPrototype::setBroadphase
+*/
+class Broadphase {
+public:
+	virtual ~Broadphase() {}
+
+	/*
+		Adds all candidate pairs for the layer pairs that collide in the world's colissionMatrix
+		Pairs of two free parts go into objectPairs, pairs of a free and a terrain part go into terrainPairs with the free part as p1
+		Parts of the same MotorizedPhysical are never paired
+
+		The bounds of free parts are up to date when this is called, the bounds of terrain parts do not change
+	*/
+	virtual void findCandidatePairs(WorldPrototype& world, std::vector<BroadphasePair>& objectPairs, std::vector<BroadphasePair>& terrainPairs) = 0;
+
+	// the world only improves the structure of its trees every tick if the broadphase relies on it
+	virtual bool usesTreeStructure() const { return true; }
+
+	// bytes of the structures kept between ticks, not including the broadphase object itself
+	virtual size_t getMemoryUsage() const { return 0; }
+};
@@ -0,0 +1,204 @@
+#include "spatialHashBroadphase.h"
+
+#include <thread>
+#include <algorithm>
+
+#include "../world.h"
+
+// below this many parts per thread, starting the threads costs more than it saves
+#define MIN_PARTS_PER_THREAD 2048
+
+// the 13 neighbouring cells that come after a cell, together with the cell itself every neighbouring pair of cells is visited once
+static const int forwardNeighbours[13][3]{
+	{1, 0, 0},
+	{-1, 1, 0}, {0, 1, 0}, {1, 1, 0},
+	{-1, -1, 1}, {0, -1, 1}, {1, -1, 1},
+	{-1, 0, 1}, {0, 0, 1}, {1, 0, 1},
+	{-1, 1, 1}, {0, 1, 1}, {1, 1, 1}
+};
+
+// calls func(begin, end, threadIndex) on threadCount consecutive slices of [0, count)
+template<typename Func>
+static void parallelFor(size_t count, size_t threadCount, const Func& func) {
+	if(threadCount <= 1) {
+		func(0, count, 0);
+		return;
+	}
+	std::vector<std::thread> threads;
+	threads.reserve(threadCount - 1);
+	for(size_t t = 1; t < threadCount; t++) {
+		threads.emplace_back(func, count * t / threadCount, count * (t + 1) / threadCount, t);
+	}
+	func(0, count / threadCount, 0);
+	for(std::thread& thread : threads) {
+		thread.join();
+	}
+}
+
+// the nodes below localNode are inside a group with outdated sub bounds, their bounds are in the frame of frameObject
+template<typename Func>
+static void forEachPartInGroup(const Part& frameObject, const TreeNode& localNode, const Bounds& bounds, const Func& func) {
+	if(localNode.isLeafNode()) {
+		Part* part = static_cast<Part*>(localNode.object);
+		Bounds partBounds = part->getStrictBounds();
+		if(intersects(partBounds, bounds)) func(part, partBounds);
+	} else if(intersects(frameObject.getGlobalBoundsOf(localNode.bounds), bounds)) {
+		for(const TreeNode& subNode : localNode) {
+			forEachPartInGroup(frameObject, subNode, bounds, func);
+		}
+	}
+}
+
+// only reads the tree, so several threads can search it at once
+template<typename Func>
+static void forEachPartInBounds(const TreeNode& node, const Bounds& bounds, const Func& func) {
+	if(!intersects(node.bounds, bounds)) return;
+	if(node.isLeafNode()) {
+		func(static_cast<Part*>(node.object), node.bounds);
+	} else if(node.hasOutdatedSubBounds) {
+		const Part& frameObject = BoundsTree<Part>::getGroupFrameObject(node);
+		for(const TreeNode& subNode : node) {
+			forEachPartInGroup(frameObject, subNode, bounds, func);
+		}
+	} else {
+		for(const TreeNode& subNode : node) {
+			forEachPartInBounds(subNode, bounds, func);
+		}
+	}
+}
+
+SpatialHashBroadphase::SpatialHashBroadphase(int cellSizeExponent, size_t threadCount) : cellSizeExponent(cellSizeExponent), threadCount(threadCount) {
+	if(cellSizeExponent <= -32 || cellSizeExponent >= 30) {
+		throw "Cell size out of range of the Position fixed point format!";
+	}
+	if(this->threadCount == 0) {
+		this->threadCount = 1;
+	}
+}
+
+size_t SpatialHashBroadphase::getBucket(int64_t cellX, int64_t cellY, int64_t cellZ) const {
+	uint64_t hash = static_cast<uint64_t>(cellX) * 73856093ULL ^ static_cast<uint64_t>(cellY) * 19349663ULL ^ static_cast<uint64_t>(cellZ) * 83492791ULL;
+	return static_cast<size_t>(hash) & (cellHeadCount - 1);
+}
+
+bool SpatialHashBroadphase::isLarge(const Bounds& bounds) const {
+	int64_t cellSize = int64_t(1) << (32 + cellSizeExponent);
+	return (bounds.max.x.value - bounds.min.x.value) > cellSize || (bounds.max.y.value - bounds.min.y.value) > cellSize || (bounds.max.z.value - bounds.min.z.value) > cellSize;
+}
+
+void SpatialHashBroadphase::insertRange(size_t begin, size_t end) {
+	int shift = 32 + cellSizeExponent;
+	for(size_t i = begin; i < end; i++) {
+		Entry& entry = entries[i];
+		entry.bounds = entry.part->getStrictBounds();
+		entry.isLarge = isLarge(entry.bounds);
+		if(entry.isLarge) continue;
+
+		// arithmetic shift, rounds down for negative positions too
+		entry.cellX = entry.bounds.min.x.value >> shift;
+		entry.cellY = entry.bounds.min.y.value >> shift;
+		entry.cellZ = entry.bounds.min.z.value >> shift;
+
+		std::atomic<int32_t>& head = cellHeads[getBucket(entry.cellX, entry.cellY, entry.cellZ)];
+		nextInCell[i] = head.exchange(static_cast<int32_t>(i), std::memory_order_relaxed);
+	}
+}
+
+void SpatialHashBroadphase::findCandidatePairs(WorldPrototype& world, std::vector<BroadphasePair>& objectPairs, std::vector<BroadphasePair>& terrainPairs) {
+	bool layersCollide[MAX_LAYERS][MAX_LAYERS];
+	size_t layerCount = world.getLayerCount();
+	for(size_t i = 0; i < layerCount; i++) {
+		for(size_t j = 0; j < layerCount; j++) {
+			layersCollide[i][j] = world.doLayersCollide(static_cast<int>(i), static_cast<int>(j));
+		}
+	}
+
+	entries.clear();
+	for(Part& part : world.iterParts(FREE_PARTS)) {
+		entries.push_back(Entry{Bounds(), 0, 0, 0, &part, part.parent->mainPhysical, part.layer, false});
+	}
+	size_t entryCount = entries.size();
+	size_t usedThreads = std::max<size_t>(1, std::min(threadCount, entryCount / MIN_PARTS_PER_THREAD));
+
+	// at least twice as many buckets as parts, kept as a power of two
+	size_t neededHeads = 64;
+	while(neededHeads < entryCount * 2) neededHeads *= 2;
+	if(neededHeads != cellHeadCount) {
+		cellHeads.reset(new std::atomic<int32_t>[neededHeads]);
+		cellHeadCount = neededHeads;
+	}
+	for(size_t i = 0; i < cellHeadCount; i++) {
+		cellHeads[i].store(-1, std::memory_order_relaxed);
+	}
+	nextInCell.resize(entryCount);
+
+	parallelFor(entryCount, usedThreads, [this](size_t begin, size_t end, size_t threadIndex) {
+		insertRange(begin, end);
+	});
+
+	// every thread collects the pairs of its own slice of entries, as indices so they can be sorted into a deterministic order
+	std::vector<std::vector<std::pair<int32_t, int32_t>>> threadObjectPairs(usedThreads);
+	std::vector<std::vector<BroadphasePair>> threadTerrainPairs(usedThreads);
+	parallelFor(entryCount, usedThreads, [&](size_t begin, size_t end, size_t threadIndex) {
+		std::vector<std::pair<int32_t, int32_t>>& foundPairs = threadObjectPairs[threadIndex];
+		std::vector<BroadphasePair>& foundTerrainPairs = threadTerrainPairs[threadIndex];
+		for(size_t i = begin; i < end; i++) {
+			const Entry& a = entries[i];
+
+			for(size_t t = 0; t < layerCount; t++) {
+				const Layer& terrainLayer = world.getLayer(static_cast<int>(t));
+				if(!terrainLayer.isTerrainLayer || !layersCollide[a.layer][t] || terrainLayer.tree.isEmpty()) continue;
+				forEachPartInBounds(terrainLayer.tree.rootNode, a.bounds, [&](Part* terrainPart, const Bounds& terrainBounds) {
+					foundTerrainPairs.push_back(BroadphasePair{a.part, terrainPart});
+				});
+			}
+
+			if(a.isLarge) continue;
+			for(int n = -1; n < 13; n++) {
+				int64_t cellX = a.cellX;
+				int64_t cellY = a.cellY;
+				int64_t cellZ = a.cellZ;
+				if(n >= 0) {
+					cellX += forwardNeighbours[n][0];
+					cellY += forwardNeighbours[n][1];
+					cellZ += forwardNeighbours[n][2];
+				}
+				for(int32_t j = cellHeads[getBucket(cellX, cellY, cellZ)].load(std::memory_order_relaxed); j != -1; j = nextInCell[j]) {
+					const Entry& b = entries[j];
+					if(b.cellX != cellX || b.cellY != cellY || b.cellZ != cellZ) continue; // another cell in the same bucket
+					if(n == -1 && static_cast<size_t>(j) <= i) continue; // pairs within a cell are found from the first part
+					if(!layersCollide[a.layer][b.layer] || a.mainPhysical == b.mainPhysical) continue;
+					if(!intersects(a.bounds, b.bounds)) continue;
+					foundPairs.emplace_back(static_cast<int32_t>(i), j);
+				}
+			}
+		}
+		std::sort(foundPairs.begin(), foundPairs.end());
+	});
+
+	for(size_t t = 0; t < usedThreads; t++) {
+		for(const std::pair<int32_t, int32_t>& pair : threadObjectPairs[t]) {
+			objectPairs.push_back(BroadphasePair{entries[pair.first].part, entries[pair.second].part});
+		}
+		terrainPairs.insert(terrainPairs.end(), threadTerrainPairs[t].begin(), threadTerrainPairs[t].end());
+	}
+
+	// large parts fall back to the trees, a pair of two large parts is only added from the one that comes first
+	for(size_t i = 0; i < entryCount; i++) {
+		const Entry& a = entries[i];
+		if(!a.isLarge) continue;
+		for(size_t l = 0; l < layerCount; l++) {
+			const Layer& otherLayer = world.getLayer(static_cast<int>(l));
+			if(otherLayer.isTerrainLayer || !layersCollide[a.layer][l] || otherLayer.tree.isEmpty()) continue;
+			forEachPartInBounds(otherLayer.tree.rootNode, a.bounds, [&](Part* other, const Bounds& otherBounds) {
+				if(other->parent->mainPhysical == a.mainPhysical) return;
+				if(isLarge(otherBounds) && !(a.part < other)) return;
+				objectPairs.push_back(BroadphasePair{a.part, other});
+			});
+		}
+	}
+}
+
+size_t SpatialHashBroadphase::getMemoryUsage() const {
+	return entries.capacity() * sizeof(Entry) + nextInCell.capacity() * sizeof(int32_t) + cellHeadCount * sizeof(std::atomic<int32_t>);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "broadphase.h"
+
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+#include "../math/bounds.h"
+
+class MotorizedPhysical;
+
+/*
+	Uniform grid broadphase, for dense scenes of many similarly sized small parts
+
+	The grid cells are cubes of 2^cellSizeExponent, indexed directly by the fixed point bits of the Position,
+	the cells are stored in a hash table so the grid is unbounded.
+	A part is inserted into the cell of the min corner of its bounds, as long as it is no larger than a cell,
+	so only that cell and its 13 forward neighbours have to be checked for pairs.
+
+	Parts larger than a cell, and all pairs with terrain, are found by querying the BoundsTrees of the layers instead.
+
+	Insertion and pair generation are split over threadCount threads, the resulting pairs are in the same order for every thread count.
+	The structure of the trees is not used for small parts, so the world skips improveStructure with this broadphase.
+*/
+class SpatialHashBroadphase : public Broadphase {
+	struct Entry {
+		Bounds bounds;
+		int64_t cellX;
+		int64_t cellY;
+		int64_t cellZ;
+		Part* part;
+		MotorizedPhysical* mainPhysical;
+		int layer;
+		bool isLarge;
+	};
+
+	int cellSizeExponent;
+	size_t threadCount;
+
+	std::vector<Entry> entries;
+	std::vector<int32_t> nextInCell;
+	std::unique_ptr<std::atomic<int32_t>[]> cellHeads;
+	size_t cellHeadCount = 0;
+
+	size_t getBucket(int64_t cellX, int64_t cellY, int64_t cellZ) const;
+	bool isLarge(const Bounds& bounds) const;
+	void insertRange(size_t begin, size_t end);
+public:
+	SpatialHashBroadphase(int cellSizeExponent = 0, size_t threadCount = 1);
+
+	virtual void findCandidatePairs(WorldPrototype& world, std::vector<BroadphasePair>& objectPairs, std::vector<BroadphasePair>& terrainPairs) override;
+	virtual bool usesTreeStructure() const override { return false; }
+	virtual size_t getMemoryUsage() const override;
+
+	inline int getCellSizeExponent() const { return cellSizeExponent; }
+	inline size_t getThreadCount() const { return threadCount; }
+};
@@ -0,0 +1,72 @@
+#include "sweepAndPruneBroadphase.h"
+
+#include <algorithm>
+
+#include "../world.h"
+
+void SweepAndPruneBroadphase::rebuild(WorldPrototype& world) {
+	entries.clear();
+	entries.reserve(world.getPartCount());
+	for(Part& part : world.iterParts(ALL_PARTS)) {
+		entries.push_back(Entry{part.getStrictBounds(), &part, part.layer, part.isTerrainPart});
+	}
+	std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {return a.bounds.min.x < b.bounds.min.x; });
+
+	isSynced = true;
+	syncedPartSetVersion = world.getPartSetVersion();
+}
+
+void SweepAndPruneBroadphase::updateBoundsAndSort() {
+	for(Entry& entry : entries) {
+		if(!entry.isTerrain) entry.bounds = entry.part->getStrictBounds();
+	}
+
+	// insertion sort, the order of the last tick is almost correct
+	for(size_t i = 1; i < entries.size(); i++) {
+		if(!(entries[i].bounds.min.x < entries[i - 1].bounds.min.x)) continue;
+		Entry moving = entries[i];
+		size_t j = i;
+		do {
+			entries[j] = entries[j - 1];
+			j--;
+		} while(j > 0 && moving.bounds.min.x < entries[j - 1].bounds.min.x);
+		entries[j] = moving;
+	}
+}
+
+void SweepAndPruneBroadphase::findCandidatePairs(WorldPrototype& world, std::vector<BroadphasePair>& objectPairs, std::vector<BroadphasePair>& terrainPairs) {
+	if(!isSynced || syncedPartSetVersion != world.getPartSetVersion()) {
+		rebuild(world);
+	} else {
+		updateBoundsAndSort();
+	}
+
+	bool layersCollide[MAX_LAYERS][MAX_LAYERS];
+	size_t layerCount = world.getLayerCount();
+	for(size_t i = 0; i < layerCount; i++) {
+		for(size_t j = 0; j < layerCount; j++) {
+			layersCollide[i][j] = world.doLayersCollide(static_cast<int>(i), static_cast<int>(j));
+		}
+	}
+
+	for(size_t i = 0; i < entries.size(); i++) {
+		const Entry& a = entries[i];
+		for(size_t j = i + 1; j < entries.size() && entries[j].bounds.min.x <= a.bounds.max.x; j++) {
+			const Entry& b = entries[j];
+			if(!layersCollide[a.layer][b.layer]) continue;
+			if(!intersects(a.bounds, b.bounds)) continue;
+
+			if(a.isTerrain) {
+				terrainPairs.push_back(BroadphasePair{b.part, a.part});
+			} else if(b.isTerrain) {
+				terrainPairs.push_back(BroadphasePair{a.part, b.part});
+			} else if(a.part->parent->mainPhysical != b.part->parent->mainPhysical) {
+				objectPairs.push_back(BroadphasePair{a.part, b.part});
+			}
+		}
+	}
+}
+
+size_t SweepAndPruneBroadphase::getMemoryUsage() const {
+	return entries.capacity() * sizeof(Entry);
+}
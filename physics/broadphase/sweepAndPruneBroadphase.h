@@ -0,0 +1,35 @@
+#pragma once
+
+#include "broadphase.h"
+
+#include <vector>
+
+#include "../math/bounds.h"
+
+/*
+	Incremental sweep and prune along the x axis
+
+	The parts are kept sorted on the lower x bound of their bounds between ticks. Parts barely move in one tick,
+	so the insertion sort that restores the order is close to linear for coherently moving scenes.
+	The sorted list is only rebuilt when the set of parts of the world changes.
+
+	Works best for scenes of many similarly sized parts, parts that are very long along the x axis are tested against everything they span.
+*/
+class SweepAndPruneBroadphase : public Broadphase {
+	struct Entry {
+		Bounds bounds;
+		Part* part;
+		int layer;
+		bool isTerrain;
+	};
+
+	std::vector<Entry> entries;
+	bool isSynced = false;
+	size_t syncedPartSetVersion = 0;
+
+	void rebuild(WorldPrototype& world);
+	void updateBoundsAndSort();
+public:
+	virtual void findCandidatePairs(WorldPrototype& world, std::vector<BroadphasePair>& objectPairs, std::vector<BroadphasePair>& terrainPairs) override;
+	virtual size_t getMemoryUsage() const override;
+};
@@ -0,0 +1,29 @@
+#include "treeBroadphase.h"
+
+#include "../world.h"
+
+void TreeBroadphase::findCandidatePairs(WorldPrototype& world, std::vector<BroadphasePair>& objectPairs, std::vector<BroadphasePair>& terrainPairs) {
+	auto addObjectPair = [&objectPairs](Part* first, Part* second) {
+		objectPairs.push_back(BroadphasePair{first, second});
+	};
+	auto addTerrainPair = [&terrainPairs](Part* first, Part* second) {
+		terrainPairs.push_back(BroadphasePair{first, second});
+	};
+	size_t layerCount = world.getLayerCount();
+	for(size_t i = 0; i < layerCount; i++) {
+		Layer& a = world.getLayer(static_cast<int>(i));
+		if(a.isTerrainLayer || a.tree.isEmpty()) continue;
+		for(size_t j = 0; j < layerCount; j++) {
+			if(!world.doLayersCollide(static_cast<int>(i), static_cast<int>(j))) continue;
+			Layer& b = world.getLayer(static_cast<int>(j));
+			if(b.tree.isEmpty()) continue;
+			if(i == j) {
+				forEachOverlappingPairInternal<Part>(a.tree.rootNode, addObjectPair);
+			} else if(b.isTerrainLayer) {
+				forEachOverlappingPairBetween<Part>(a.tree.rootNode, b.tree.rootNode, addTerrainPair);
+			} else if(j > i) {
+				forEachOverlappingPairBetween<Part>(a.tree.rootNode, b.tree.rootNode, addObjectPair);
+			}
+		}
+	}
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "broadphase.h"
+
+/*
+	Finds the pairs by traversing the BoundsTrees of the layers against each other
+*/
+class TreeBroadphase : public Broadphase {
+public:
+	virtual void findCandidatePairs(WorldPrototype& world, std::vector<BroadphasePair>& objectPairs, std::vector<BroadphasePair>& terrainPairs) override;
+};
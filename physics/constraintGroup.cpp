@@ -5,6 +5,7 @@
 #include "math/linalg/mat.h"
 
 #include "math/mathUtil.h"
+#include "memoryAccounting.h"
 #include <fstream>
 
 LargeMatrix<double> computeInteractionMatrix(const ConstraintGroup& group) {
@@ -82,6 +83,7 @@ void ConstraintGroup::apply() const {
 
 	LargeMatrix<double> systemCopy(systemToSolve);
 	LargeMatrix<double> systemCopyCopy(systemToSolve);
+	MemoryAccounting::recordTransient(MemoryCategory::CONSTRAINT_MATRICES, (3 * dimension * dimension + 3 * dimension) * sizeof(double));
 
 	size_t matrixIndex;
 
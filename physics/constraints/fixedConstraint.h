@@ -11,5 +11,6 @@ public:
 	virtual void invert() override;
 	
 	virtual CFrame getRelativeCFrame() const override;
+	virtual bool changesRelativeCFrame() const override { return false; }
 	virtual RelativeMotion getRelativeMotion() const override;
 };
@@ -15,6 +15,20 @@ public:
 	virtual RelativeMotion getRelativeMotion() const = 0;
 	
 	virtual CFrame getRelativeCFrame() const;
+
+	/*
+		Returns false if update can't change getRelativeCFrame, for example a motor that isn't turning. 
+		The mass properties of a physical are only recomputed every tick if it has changing constraints
+	*/
+	virtual bool changesRelativeCFrame() const { return true; }
+
+	/*
+		The state of this constraint that changes during simulation, such as the angle of a motor. 
+		Used to take and restore snapshots of a world. getStateSize returns the number of doubles written by saveState
+	*/
+	virtual size_t getStateSize() const { return 0; }
+	virtual void saveState(double* state) const {}
+	virtual void loadState(const double* state) {}
 	
 	virtual ~HardConstraint() {}
 };
@@ -21,5 +21,10 @@ public:
 	virtual void invert() override;
 
 	virtual CFrame getRelativeCFrame() const override;
+	virtual bool changesRelativeCFrame() const override { return speed != 0.0; }
 	virtual RelativeMotion getRelativeMotion() const override;
+
+	virtual size_t getStateSize() const override { return 1; }
+	virtual void saveState(double* state) const override { state[0] = currentAngle; }
+	virtual void loadState(const double* state) override { currentAngle = state[0]; }
 };
@@ -12,4 +12,8 @@ public:
 	virtual void invert() override;
 	virtual CFrame getRelativeCFrame() const override;
 	virtual RelativeMotion getRelativeMotion() const override;
+
+	virtual size_t getStateSize() const override { return 1; }
+	virtual void saveState(double* state) const override { state[0] = currentStepInPeriod; }
+	virtual void loadState(const double* state) override { currentStepInPeriod = state[0]; }
 };
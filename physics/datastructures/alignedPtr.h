@@ -8,13 +8,23 @@ void* createAligned(size_t size, size_t align);
 template<typename T>
 class UniqueAlignedPointer {
 	T* data;
+	bool owning;
 
+	UniqueAlignedPointer(T* data, bool owning) : data(data), owning(owning) {}
 public:
-	UniqueAlignedPointer() : data(nullptr) {}
+	UniqueAlignedPointer() : data(nullptr), owning(true) {}
 	UniqueAlignedPointer(size_t size, size_t align = alignof(T)) : 
-		data(static_cast<T*>(createAligned(sizeof(T)* size, align))) {}
+		data(static_cast<T*>(createAligned(sizeof(T)* size, align))), owning(true) {}
 	~UniqueAlignedPointer() {
-		deleteAligned(static_cast<void*>(data));
+		if(owning) deleteAligned(static_cast<void*>(data));
+	}
+
+	/*
+		Wraps an already aligned buffer that is owned elsewhere, for example memory mapped from a file. 
+		The buffer is not freed when this pointer is destroyed, it must outlive this pointer. 
+	*/
+	static UniqueAlignedPointer borrow(T* externalData) {
+		return UniqueAlignedPointer(externalData, false);
 	}
 
 	inline T* get() const { return data; }
@@ -23,12 +33,15 @@ public:
 	UniqueAlignedPointer(const UniqueAlignedPointer& other) = delete;
 	UniqueAlignedPointer& operator=(const UniqueAlignedPointer& other) = delete;
 
-	UniqueAlignedPointer(UniqueAlignedPointer&& other) noexcept : data(other.data) {
+	UniqueAlignedPointer(UniqueAlignedPointer&& other) noexcept : data(other.data), owning(other.owning) {
 		other.data = nullptr;
+		other.owning = true;
 	}
 	UniqueAlignedPointer& operator=(UniqueAlignedPointer&& other) noexcept {
 		this->data = other.data;
+		this->owning = other.owning;
 		other.data = nullptr;
+		other.owning = true;
 
 		return *this;
 	}
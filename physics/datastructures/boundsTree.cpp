@@ -5,6 +5,9 @@
 #include <utility>
 #include <new>
 #include <limits>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
 
 long long computeCost(const Bounds& bounds) {
 	Vec3Fix d = bounds.getDiagonal();
@@ -41,12 +44,15 @@ TreeNode::TreeNode(TreeNode* subTrees, int nodeCount) :
 	subTrees(subTrees), 
 	nodeCount(nodeCount), 
 	isGroupHead(false), 
-	bounds(computeBoundsOfList(subTrees, nodeCount)) {}
+	bounds(computeBoundsOfList(subTrees, nodeCount)) {
+	relink();
+}
 
 
 TreeNode::TreeNode(const TreeNode& original) :
 	nodeCount(original.nodeCount),
 	isGroupHead(original.isGroupHead),
+	hasOutdatedSubBounds(original.hasOutdatedSubBounds),
 	bounds(original.bounds) {
 
 	if(original.isLeafNode()) {
@@ -56,13 +62,17 @@ TreeNode::TreeNode(const TreeNode& original) :
 		for(size_t i = 0; i < original.nodeCount; i++) {
 			new(this->subTrees + i) TreeNode(original.subTrees[i]);
 		}
+		relink();
 	}
 }
 TreeNode& TreeNode::operator=(const TreeNode& original) {
 	this->~TreeNode();
 
+	// a copy does not take over the objectLink, the object stays linked to the original
+	this->objectLink = nullptr;
 	this->nodeCount = original.nodeCount;
 	this->isGroupHead = original.isGroupHead;
+	this->hasOutdatedSubBounds = original.hasOutdatedSubBounds;
 	this->bounds = original.bounds;
 
 	if(original.isLeafNode()) {
@@ -72,6 +82,7 @@ TreeNode& TreeNode::operator=(const TreeNode& original) {
 		for(size_t i = 0; i < original.nodeCount; i++) {
 			new(this->subTrees + i) TreeNode(original.subTrees[i]);
 		}
+		relink();
 	}
 	return *this;
 }
@@ -84,7 +95,8 @@ TreeNode::~TreeNode() {
 
 inline static void addToSubTrees(TreeNode& node, TreeNode&& newNode) {
 	if (node.nodeCount != MAX_BRANCHES) {
-		new(&node.subTrees[node.nodeCount++]) TreeNode(std::move(newNode));
+		TreeNode* placed = new(&node.subTrees[node.nodeCount++]) TreeNode(std::move(newNode));
+		placed->parent = &node;
 	} else {
 		long long bestCost = computeCombinationCost(newNode.bounds, node.subTrees[0].bounds);
 		int bestIndex = 0;
@@ -108,7 +120,9 @@ void TreeNode::addOutside(TreeNode&& newNode) {
 		TreeNode* newNodes = new TreeNode[MAX_BRANCHES];
 		new(newNodes) TreeNode(std::move(*this));
 		new(newNodes + 1) TreeNode(std::move(newNode));
+		TreeNode* parent = this->parent;
 		new(this) TreeNode(newNodes, 2);
+		this->parent = parent;
 	}
 	this->bounds = unionOfBounds(this->bounds, newNode.bounds);
 }
@@ -123,7 +137,9 @@ void TreeNode::addInside(TreeNode&& newNode) {
 
 		// only the top node of a group is undivisible, restructuring within a group is still allowed
 
+		TreeNode* parent = this->parent;
 		new(this) TreeNode(newNodes, 2);
+		this->parent = parent;
 		this->isGroupHead = newNodes[0].isGroupHead;
 		newNodes[0].isGroupHead = false;
 		newNodes[1].isGroupHead = false;
@@ -148,7 +164,9 @@ TreeNode TreeNode::remove(int index) {
 	if(nodeCount == 1) {
 		TreeNode* buf = subTrees;
 		bool resultIsGroupHead = this->isGroupHead || buf[0].isGroupHead;
+		TreeNode* parent = this->parent;
 		new(this) TreeNode(std::move(buf[0]));
+		this->parent = parent;
 		this->isGroupHead = resultIsGroupHead;
 		delete[] buf;
 	} else {
@@ -191,6 +209,17 @@ size_t TreeNode::getNumberOfObjectsInNode() const {
 	return runningTotal;
 }
 
+size_t TreeNode::getMemoryUsage() const {
+	if(this->isLeafNode() || this->subTrees == nullptr) return 0;
+
+	// subTrees is always allocated with room for MAX_BRANCHES nodes
+	size_t runningTotal = MAX_BRANCHES * sizeof(TreeNode);
+	for(const TreeNode& subNode : *this) {
+		runningTotal += subNode.getMemoryUsage();
+	}
+	return runningTotal;
+}
+
 size_t TreeNode::getLengthOfLongestBranch() const {
 	if(this->isLeafNode()) return 0;
 
@@ -208,7 +237,8 @@ size_t TreeNode::getLengthOfLongestBranch() const {
 
 inline static void transferObject(TreeNode& from, TreeNode& to, size_t index){
 	to.addOutside(std::move(from.subTrees[index]));
-	new(&from.subTrees[index]) TreeNode(std::move(from.subTrees[--from.nodeCount]));
+	TreeNode* placed = new(&from.subTrees[index]) TreeNode(std::move(from.subTrees[--from.nodeCount]));
+	placed->parent = &from;
 }
 
 inline static void exchangeObjects(TreeNode& first, TreeNode& second) {
@@ -266,10 +296,13 @@ NodeStack::NodeStack(TreeNode& rootNode, const void* objToFind, const Bounds& ob
 			throw "Could not find obj in Tree!";
 		}
 	}
+	// the bounds of the nodes inside an outdated group can't be trusted, the whole group is searched
+	int outdatedGroupDepth = -1;
 	while(true) {
 		if(top->index != top->node->nodeCount) {
 			TreeNode* nextNode = top->node->subTrees + top->index;
-			if(nextNode->bounds.contains(objBounds)) {
+			bool isInOutdatedGroup = outdatedGroupDepth >= 0 && top - stack >= outdatedGroupDepth && stack[outdatedGroupDepth].node->hasOutdatedSubBounds;
+			if(isInOutdatedGroup || nextNode->bounds.contains(objBounds)) {
 				if(nextNode->isLeafNode()) {
 					if(nextNode->object == objToFind) {
 						top++;
@@ -281,6 +314,7 @@ NodeStack::NodeStack(TreeNode& rootNode, const void* objToFind, const Bounds& ob
 				} else {
 					top++;
 					*top = TreeStackElement{nextNode, 0};
+					if(nextNode->hasOutdatedSubBounds) outdatedGroupDepth = static_cast<int>(top - stack);
 				}
 			} else {
 				top->index++;
@@ -302,6 +336,27 @@ NodeStack::NodeStack(TreeNode& rootNode, const void* objToFind, const Bounds& ob
 	throw "Could not find obj in Tree!";
 }
 
+NodeStack::NodeStack(TreeNode& rootNode, TreeNode* leaf) : NodeStack(rootNode) {
+	assert(leaf->isLeafNode());
+	int depth = 0;
+	TreeNode* highest = leaf;
+	while(highest->parent != nullptr) {
+		highest = highest->parent;
+		depth++;
+	}
+	if(highest != &rootNode || top + 1 == stack) {
+		throw "Could not find obj in Tree!";
+	}
+	assert(depth < MAX_HEIGHT);
+
+	top = stack + depth;
+	*top = TreeStackElement{leaf, 0};
+	for(TreeStackElement* element = top; element != stack; element--) {
+		TreeNode* node = element->node;
+		*(element - 1) = TreeStackElement{node->parent, static_cast<int>(node - node->parent->subTrees)};
+	}
+}
+
 NodeStack::NodeStack(const NodeStack& other) : stack{}, top(this->stack + (other.top - other.stack)) {
 	for(int i = 0; i < top - stack + 1; i++) {
 		this->stack[i] = other.stack[i];
@@ -538,13 +593,17 @@ inline static void fillNodePairWithPermutation(TreeNode& first, TreeNode& second
 	first.subTrees = availableGroups[0];
 	for (int i = 0; i < bestPermutation.countA; i++) first.subTrees[i] = std::move(nodesCopyA[i]);
 	first.nodeCount = bestPermutation.countA;
+	first.relink();
 
 	if (bestPermutation.countB != 1) {
 		second.subTrees = availableGroups[1];
 		for (int i = 0; i < bestPermutation.countB; i++) second.subTrees[i] = std::move(nodesCopyB[i]);
 		second.nodeCount = bestPermutation.countB;
+		second.relink();
 	} else {
+		TreeNode* parent = second.parent;
 		new(&second) TreeNode(std::move(nodesCopyB[0]));
+		second.parent = parent;
 	}
 
 	first.recalculateBoundsFromSubBounds();
@@ -598,7 +657,8 @@ inline static void optimizeNodePairVertical(TreeNode& node, TreeNode& group) {
 }
 
 void TreeNode::improveStructure() {
-	if (!isLeafNode()) {
+	// the bounds inside outdated groups can't be used, and the parts of a rigid group don't move relative to each other anyway
+	if (!isLeafNode() && !hasOutdatedSubBounds) {
 		for (int i = 0; i < nodeCount; i++) subTrees[i].improveStructure();
 		// horizontal structure improvement
 		for (int i = 0; i < nodeCount - 1; i++) {
@@ -627,3 +687,132 @@ void TreeNode::improveStructure() {
 		}
 	}
 }
+
+
+
+/*
+	Bulk building
+
+	Instead of inserting nodes one at a time, the tree is built top down in one pass:
+	the nodes are split into MAX_BRANCHES groups of equal size, each time along the axis where their centers are spread out furthest.
+	The given nodes themselves are never split, so group heads are preserved.
+*/
+
+struct BuildEntry {
+	TreeNode* node;
+	int64_t center[3];
+};
+
+static int getLongestAxisOfCenters(const BuildEntry* entries, size_t count) {
+	int64_t minCenter[3] = {entries[0].center[0], entries[0].center[1], entries[0].center[2]};
+	int64_t maxCenter[3] = {entries[0].center[0], entries[0].center[1], entries[0].center[2]};
+	for(size_t i = 1; i < count; i++) {
+		for(int axis = 0; axis < 3; axis++) {
+			minCenter[axis] = std::min(minCenter[axis], entries[i].center[axis]);
+			maxCenter[axis] = std::max(maxCenter[axis], entries[i].center[axis]);
+		}
+	}
+	int longestAxis = 0;
+	for(int axis = 1; axis < 3; axis++) {
+		if(maxCenter[axis] - minCenter[axis] > maxCenter[longestAxis] - minCenter[longestAxis]) longestAxis = axis;
+	}
+	return longestAxis;
+}
+
+// partially sorts the entries such that the first splitIndex entries lie before the rest along the longest axis
+static void splitEntries(BuildEntry* entries, size_t count, size_t splitIndex) {
+	int axis = getLongestAxisOfCenters(entries, count);
+	std::nth_element(entries, entries + splitIndex, entries + count, [axis](const BuildEntry& a, const BuildEntry& b) {
+		return a.center[axis] < b.center[axis];
+	});
+}
+
+static TreeNode buildTreeFromEntries(BuildEntry* entries, size_t count) {
+	if(count == 1) {
+		return TreeNode(std::move(*entries[0].node));
+	}
+
+	TreeNode* subTrees = new TreeNode[MAX_BRANCHES];
+	if(count <= MAX_BRANCHES) {
+		for(size_t i = 0; i < count; i++) {
+			new(&subTrees[i]) TreeNode(std::move(*entries[i].node));
+		}
+		return TreeNode(subTrees, static_cast<int>(count));
+	}
+
+	// split in half twice, giving MAX_BRANCHES groups that are each split along their own longest axis
+	static_assert(MAX_BRANCHES == 4, "bulk building splits into 4 groups");
+	size_t half = count / 2;
+	splitEntries(entries, count, half);
+	splitEntries(entries, half, half / 2);
+	splitEntries(entries + half, count - half, (count - half) / 2);
+
+	size_t groupStarts[MAX_BRANCHES + 1]{0, half / 2, half, half + (count - half) / 2, count};
+	for(int i = 0; i < MAX_BRANCHES; i++) {
+		new(&subTrees[i]) TreeNode(buildTreeFromEntries(entries + groupStarts[i], groupStarts[i + 1] - groupStarts[i]));
+	}
+	return TreeNode(subTrees, MAX_BRANCHES);
+}
+
+// moves every group and every loose object out of the given subtree
+static void collectGroups(TreeNode& node, std::vector<TreeNode>& groups) {
+	if(node.isGroupHead || node.isLeafNode()) {
+		groups.push_back(std::move(node));
+	} else {
+		for(TreeNode& subNode : node) {
+			collectGroups(subNode, groups);
+		}
+	}
+}
+
+void rebuildTreeWithNodes(TreeNode& rootNode, TreeNode* newNodes, size_t count) {
+	std::vector<TreeNode> groups;
+	if(rootNode.nodeCount != 0) {
+		groups.reserve(rootNode.getNumberOfObjectsInNode() + count);
+		collectGroups(rootNode, groups);
+	} else {
+		groups.reserve(count);
+	}
+	for(size_t i = 0; i < count; i++) {
+		groups.push_back(std::move(newNodes[i]));
+	}
+	if(groups.empty()) return;
+
+	std::vector<BuildEntry> entries(groups.size());
+	for(size_t i = 0; i < groups.size(); i++) {
+		const Bounds& bounds = groups[i].bounds;
+		entries[i].node = &groups[i];
+		// halve before adding to avoid overflow
+		entries[i].center[0] = (bounds.min.x.value >> 1) + (bounds.max.x.value >> 1);
+		entries[i].center[1] = (bounds.min.y.value >> 1) + (bounds.max.y.value >> 1);
+		entries[i].center[2] = (bounds.min.z.value >> 1) + (bounds.max.z.value >> 1);
+	}
+
+	rootNode = buildTreeFromEntries(entries.data(), entries.size());
+}
+
+// counts the objects below the given node, but stops counting once there are more than limit
+static size_t countObjectsUpTo(const TreeNode& node, size_t limit) {
+	if(node.isLeafNode()) return 1;
+
+	size_t runningTotal = 0;
+	for(const TreeNode& subNode : node) {
+		runningTotal += countObjectsUpTo(subNode, limit - runningTotal);
+		if(runningTotal > limit) break;
+	}
+	return runningTotal;
+}
+
+void addNodesToTree(TreeNode& rootNode, TreeNode* newNodes, size_t count) {
+	if(count == 0) return;
+
+	// rebuilding costs O((N+count) log(N+count)), so it only pays off when the tree does not grow by a small fraction
+	size_t rebuildLimit = count * BULK_REBUILD_FACTOR;
+	if(rootNode.nodeCount == 0 || countObjectsUpTo(rootNode, rebuildLimit) <= rebuildLimit) {
+		rebuildTreeWithNodes(rootNode, newNodes, count);
+	} else {
+		for(size_t i = 0; i < count; i++) {
+			rootNode.addOutside(std::move(newNodes[i]));
+		}
+	}
+}
@@ -9,6 +9,7 @@
 
 #include <utility>
 #include <new>
+#include <optional>
 #include <assert.h>
 
 
@@ -28,6 +29,21 @@ struct TreeNode {
 	If false, then no subnodes are allowed to be exchanged with the rest of the tree. This node must be viewed as a black box. 
 	*/
 	bool isGroupHead = false;
+	/* only set on group heads, means that the bounds of the group head are up to date, but those of the nodes within it are not global bounds.
+	Rigid groups are refitted from the bounds of the whole group, their nodes keep their bounds in the frame of the first object of the group, see BoundsTree::getGroupFrameObject. 
+	These don't change while the group moves, the nodes are only brought back to global bounds when the group is modified
+	*/
+	bool hasOutdatedSubBounds = false;
+	// only set while BoundsTree::updateObjectGroupBounds refits many groups at once, means that the bounds of this node still have to be refitted
+	bool needsRefit = false;
+	/* the node whose subTrees this node is in, nullptr for the root of a tree. 
+	This belongs to the place of the node, it is not moved along with the rest of the node
+	*/
+	TreeNode* parent = nullptr;
+	/* only used by leaf nodes, if not nullptr it is kept pointing at this node wherever the node is moved, 
+	so the node of an object can be found from the object without searching the tree
+	*/
+	TreeNode** objectLink = nullptr;
 
 	inline bool isLeafNode() const { return nodeCount == LEAF_NODE_SIGNIFIER; }
 
@@ -35,22 +51,49 @@ struct TreeNode {
 	TreeNode(TreeNode* subTrees, int nodeCount);
 	inline TreeNode(void* object, const Bounds& bounds) : nodeCount(LEAF_NODE_SIGNIFIER), object(object), bounds(bounds) {}
 	inline TreeNode(void* object, const Bounds& bounds, bool isGroupHead) : nodeCount(LEAF_NODE_SIGNIFIER), object(object), bounds(bounds), isGroupHead(isGroupHead) {}
-	inline TreeNode(const Bounds& bounds, TreeNode* subTrees, int nodeCount) : bounds(bounds), subTrees(subTrees), nodeCount(nodeCount) {}
+	inline TreeNode(void* object, const Bounds& bounds, bool isGroupHead, TreeNode** objectLink) : nodeCount(LEAF_NODE_SIGNIFIER), object(object), bounds(bounds), isGroupHead(isGroupHead), objectLink(objectLink) {
+		relink();
+	}
+	inline TreeNode(const Bounds& bounds, TreeNode* subTrees, int nodeCount) : bounds(bounds), subTrees(subTrees), nodeCount(nodeCount) {
+		relink();
+	}
 
 	explicit TreeNode(const TreeNode& original);
 	TreeNode& operator=(const TreeNode& original);
 
-	inline TreeNode(TreeNode&& other) noexcept : nodeCount(other.nodeCount), subTrees(other.subTrees), bounds(other.bounds), isGroupHead(other.isGroupHead) {
+	inline TreeNode(TreeNode&& other) noexcept : nodeCount(other.nodeCount), subTrees(other.subTrees), bounds(other.bounds), isGroupHead(other.isGroupHead), hasOutdatedSubBounds(other.hasOutdatedSubBounds), objectLink(other.objectLink) {
 		other.subTrees = nullptr;
 		other.nodeCount = LEAF_NODE_SIGNIFIER;
+		other.objectLink = nullptr;
+		relink();
 	}
 	inline TreeNode& operator=(TreeNode&& other) noexcept {
 		std::swap(this->nodeCount, other.nodeCount);
 		std::swap(this->subTrees, other.subTrees);
 		std::swap(this->bounds, other.bounds);
 		std::swap(this->isGroupHead, other.isGroupHead);
+		std::swap(this->hasOutdatedSubBounds, other.hasOutdatedSubBounds);
+		std::swap(this->objectLink, other.objectLink);
+		this->relink();
+		other.relink();
 		return *this;
 	}
+
+	// points the subTrees of this node back at it, or the objectLink of a leaf at this node. Needed whenever the node is moved or its subTrees change
+	inline void relink() {
+		if(isLeafNode()) {
+			if(objectLink != nullptr) *objectLink = this;
+		} else {
+			for(int i = 0; i < nodeCount; i++) subTrees[i].parent = this;
+		}
+	}
+	// changes the object of this leaf, and the link that is kept pointing at this node
+	inline void setObject(void* newObject, TreeNode** newObjectLink) {
+		assert(isLeafNode());
+		this->object = newObject;
+		this->objectLink = newObjectLink;
+		relink();
+	}
 	
 	inline TreeNode* begin() const { return subTrees; }
 	inline TreeNode* end() const { return subTrees+nodeCount; }
@@ -73,6 +116,8 @@ struct TreeNode {
 
 	size_t getNumberOfObjectsInNode() const;
 	size_t getLengthOfLongestBranch() const;
+	// bytes of the node arrays below this node, not including the node itself
+	size_t getMemoryUsage() const;
 };
 
 long long computeCost(const Bounds& bounds);
@@ -81,6 +126,22 @@ Bounds computeBoundsOfList(const TreeNode* const* list, size_t count);
 
 Bounds computeBoundsOfList(const TreeNode* list, size_t count);
 
+/*
+	Rebuilds the whole tree below rootNode in one pass, out of the groups already in it and the given new nodes, which are moved from. 
+	Much faster than adding the nodes one by one, and results in a better balanced tree. 
+*/
+void rebuildTreeWithNodes(TreeNode& rootNode, TreeNode* newNodes, size_t count);
+
+// trees are only rebuilt when they have at most this many times the number of objects being added
+#define BULK_REBUILD_FACTOR 4
+
+/*
+	Adds the given nodes to the tree below rootNode, moving from them. 
+	If the tree is small compared to the number of new nodes, it is rebuilt with rebuildTreeWithNodes, 
+	otherwise the nodes are added one by one, so adding a few nodes to a big tree does not cost a full rebuild. 
+*/
+void addNodesToTree(TreeNode& rootNode, TreeNode* newNodes, size_t count);
+
 struct TreeStackElement {
 	TreeNode* node;
 	int index;
@@ -94,6 +155,8 @@ struct NodeStack {
 	NodeStack(TreeNode& rootNode);
 	// a find function, returning the stack of all nodes leading up to the requested object
 	NodeStack(TreeNode& rootNode, const void* objToFind, const Bounds& objBounds);
+	// the stack of all nodes leading up to the given leaf, found by following the parents of the leaf, without searching the tree
+	NodeStack(TreeNode& rootNode, TreeNode* leaf);
 
 	NodeStack(const NodeStack& other);
 	NodeStack(NodeStack&& other) noexcept;
@@ -185,10 +248,14 @@ struct TreeIterator : public ConstTreeIterator {
 	- BoundsContainedIn
 		If a given bound is contained in another bound2, that does not mean that it's parent must also be contained in this bound2
 		However, BoundsNotContainedIn IS a correct filter
+
+	The bounds inside groups with outdated sub bounds can't be trusted, every object in such a group that passes the filter for the group itself is given. 
 */
 template<typename Filter>
 struct FilteredTreeIterator : public NodeStack {
 	Filter filter;
+	// depth of the last outdated group that was entered, it is only still inside it if the node at that depth is still outdated
+	int outdatedGroupDepth = -1;
 	FilteredTreeIterator(TreeNode& rootNode, const Filter& filter) : NodeStack(rootNode), filter(filter) {
 		// the very first element is a dummy, in order to detect when the tree is done
 		if (rootNode.nodeCount == 0) return;
@@ -201,14 +268,16 @@ struct FilteredTreeIterator : public NodeStack {
 		while (true) {
 			// go down
 			TreeNode* nextNode = &top->node->subTrees[top->index];
+			bool isInOutdatedGroup = outdatedGroupDepth >= 0 && top - stack >= outdatedGroupDepth && stack[outdatedGroupDepth].node->hasOutdatedSubBounds;
 			top++;
 			top->node = nextNode;
 
-			if (filter(*nextNode)) {
+			if (isInOutdatedGroup || filter(*nextNode)) {
 				if (nextNode->isLeafNode()) {
 					return;
 				} else {
 					top->index = 0;
+					if(nextNode->hasOutdatedSubBounds) outdatedGroupDepth = static_cast<int>(top - stack);
 				}
 			} else {
 				top--;
@@ -297,108 +366,160 @@ struct BoundsTree {
 	void add(Boundable* obj, const Bounds& bounds) {
 		this->add(TreeNode(obj, bounds, true));
 	}
+
+	// adds all given nodes at once, see addNodesToTree
+	void add(TreeNode* newNodes, size_t count) {
+		addNodesToTree(this->rootNode, newNodes, count);
+	}
 	
 	void addToExistingGroup(Boundable* obj, const Bounds& bounds, TreeNode& groupNode) {
 		groupNode.addInside(TreeNode(obj, bounds, false));
 	}
 
+	/*
+		The functions below that take a leaf find the object through the parents of its node instead of searching the tree by bounds.
+		The leaf can be kept track of by giving the node an objectLink, see TreeNode
+	*/
+
+	// the nodes on the returned stack may be in an outdated group, their bounds must not be used
 	NodeStack find(const Boundable* obj, const Bounds& objBounds) {
 		return NodeStack(rootNode, obj, objBounds);
 	}
+	NodeStack find(TreeNode* leaf) {
+		return NodeStack(rootNode, leaf);
+	}
 
 	NodeStack findGroupFor(const Boundable* obj, const Bounds& objBounds) {
 		NodeStack iter(rootNode, obj, objBounds);
-		iter.riseUntilGroupHeadWhile();
+		riseToGroupOn(iter);
+		return iter;
+	}
+	NodeStack findGroupFor(TreeNode* leaf) {
+		NodeStack iter(rootNode, leaf);
+		riseToGroupOn(iter);
 		return iter;
 	}
 
 	void addToExistingGroup(Boundable* obj, const Bounds& bounds, const Boundable* objInGroup, const Bounds& objInGroupBounds) {
 		NodeStack iter(rootNode, objInGroup, objInGroupBounds);
-		iter.riseUntilGroupHeadWhile();
-		addToExistingGroup(obj, bounds, **iter);
-		iter.expandBoundsAllTheWayToTop();
+		addToExistingGroupOn(iter, TreeNode(obj, bounds, false));
+	}
+	// newNode is added to the group of leafInGroup
+	void addToExistingGroup(TreeNode&& newNode, TreeNode* leafInGroup) {
+		NodeStack iter(rootNode, leafInGroup);
+		addToExistingGroupOn(iter, std::move(newNode));
 	}
 
 	void remove(const Boundable* obj, const Bounds& strictBounds) {
-		if (rootNode.isLeafNode()) {
-			if (rootNode.object == obj) {
-				rootNode.nodeCount = 0;
-				rootNode.bounds = Bounds();
-				rootNode.object = nullptr;
-			} else {
-				throw "Attempting to remove nonexistent object!";
-			}
-		} else {
-			NodeStack stack(rootNode, obj, strictBounds);
-			stack.remove();
-		}
+		if(rootNode.isLeafNode() && rootNode.object != obj) throw "Attempting to remove nonexistent object!";
+		NodeStack stack(rootNode, obj, strictBounds);
+		grabOn(stack);
 	}
 	void remove(const Boundable* obj) {
 		this->remove(obj, obj->getStrictBounds());
 	}
+	void remove(TreeNode* leaf) {
+		NodeStack stack(rootNode, leaf);
+		grabOn(stack);
+	}
 
 	// removes and returns the node for the given object
 	inline TreeNode grab(const Boundable* obj, const Bounds& objBounds) {
-		if(this->rootNode.isLeafNode()) {
-			if(this->rootNode.object == obj) {
-				TreeNode result(std::move(this->rootNode));
-				this->rootNode.object = nullptr;
-				this->rootNode.nodeCount = 0;
-				return result;
-			} else {
-				throw "Attempting to remove nonexistent object!";
-			}
-		}
+		if(rootNode.isLeafNode() && rootNode.object != obj) throw "Attempting to remove nonexistent object!";
 		NodeStack iter(rootNode, obj, objBounds);
-		return iter.remove();
+		return grabOn(iter);
+	}
+	inline TreeNode grab(TreeNode* leaf) {
+		NodeStack iter(rootNode, leaf);
+		return grabOn(iter);
 	}
 
 	// removes and returns the group node for the given object
 	inline TreeNode grabGroupFor(const Boundable* obj, const Bounds& objBounds) {
-		if(this->rootNode.isLeafNode()) {
-			if(this->rootNode.object == obj) {
-				TreeNode result(std::move(this->rootNode));
-				this->rootNode.object = nullptr;
-				this->rootNode.nodeCount = 0;
-				return result;
-			} else {
-				throw "Attempting to remove nonexistent object!";
-			}
-		}
+		if(rootNode.isLeafNode() && rootNode.object != obj) throw "Attempting to remove nonexistent object!";
 		NodeStack iter(rootNode, obj, objBounds);
-		iter.riseUntilGroupHeadWhile();
-		return iter.remove();
+		return grabGroupOn(iter);
+	}
+	inline TreeNode grabGroupFor(TreeNode* leaf) {
+		NodeStack iter(rootNode, leaf);
+		return grabGroupOn(iter);
 	}
 
+	/*
+		Refits the whole tree to the current bounds of the objects
+
+		Groups for which Boundable::getRigidGroupBounds gives bounds are refitted in constant time,
+		the nodes inside them are marked outdated, their bounds are moved into the frame of the group once and then stay the same while it moves
+	*/
 	inline void recalculateBounds() {
 		if(isEmpty()) return;
-		for (TreeNode* currentNode : *this) {
-			Boundable* obj = static_cast<Boundable*>(currentNode->object);
-			currentNode->bounds = obj->getStrictBounds();
+		recalculateBoundsOf(rootNode);
+	}
+
+	// the nodes inside a group with outdated sub bounds keep their bounds in the frame of this object
+	static const Boundable& getGroupFrameObject(const TreeNode& groupHead) {
+		const TreeNode* objectNode = &groupHead;
+		while(!objectNode->isLeafNode()) objectNode = &objectNode->subTrees[0];
+		return *static_cast<const Boundable*>(objectNode->object);
+	}
+
+	// brings the nodes inside the given group back to global bounds, the bounds of the group head itself are kept as they still contain them
+	static void refreshGroupBounds(TreeNode& groupHead) {
+		if(groupHead.isLeafNode()) return;
+		for(TreeNode& subNode : groupHead) {
+			refreshBoundsRecursive(subNode);
 		}
+		groupHead.hasOutdatedSubBounds = false;
+	}
 
-		rootNode.recalculateBoundsRecursive();
+	// refreshes every outdated group, after this the bounds of all nodes are up to date and the tree can be searched without modifying it
+	inline void refreshOutdatedGroups() {
+		if(isEmpty()) return;
+		refreshOutdatedGroupsBelow(rootNode);
 	}
 	
 	void updateObjectBounds(const Boundable* obj, const Bounds& oldBounds) {
 		assert(!isEmpty());
 		NodeStack stack(rootNode, obj, oldBounds);
-		stack.top->node->bounds = obj->getStrictBounds();
-		stack.top--;
-		stack.updateBoundsAllTheWayToTop();
+		updateObjectBoundsOn(stack);
+	}
+	void updateObjectBounds(TreeNode* leaf) {
+		assert(!isEmpty());
+		NodeStack stack(rootNode, leaf);
+		updateObjectBoundsOn(stack);
 	}
 	void updateObjectGroupBounds(const Boundable* objInGroup, const Bounds& objOldBounds) {
 		assert(!isEmpty());
 		NodeStack stack(rootNode, objInGroup, objOldBounds);
-		stack.riseUntilGroupHeadWhile(); // find group obj belongs to
-
-		for (TreeIterator iter(*stack.top->node); iter != IteratorEnd(); ++iter) {
-			TreeNode* node = *iter;
-			node->bounds = static_cast<Boundable*>(node->object)->getStrictBounds();
+		updateObjectGroupBoundsOn(stack);
+	}
+	void updateObjectGroupBounds(TreeNode* leafInGroup) {
+		assert(!isEmpty());
+		NodeStack stack(rootNode, leafInGroup);
+		updateObjectGroupBoundsOn(stack);
+	}
+	/*
+		Updates the groups of many objects at once, like updateObjectGroupBounds for each of the given leaves
+		The nodes above the groups are marked and then refitted in a single pass from the bottom up, 
+		so a node shared by several of the groups is only refitted once
+	*/
+	void updateObjectGroupBounds(TreeNode* const* leavesInGroups, size_t count) {
+		assert(!isEmpty());
+		for(size_t i = 0; i < count; i++) {
+			TreeNode* group = leavesInGroups[i];
+			while(!group->isGroupHead) {
+				group = group->parent;
+				assert(group != nullptr);
+			}
+			if(group->needsRefit) continue;
+			refreshBoundsRecursive(*group);
+			group->hasOutdatedSubBounds = false;
+			group->needsRefit = true;
+			for(TreeNode* node = group->parent; node != nullptr && !node->needsRefit; node = node->parent) {
+				node->needsRefit = true;
+			}
 		}
-		stack.top->node->recalculateBoundsRecursive(); // refresh group bounds
-		stack.top--;
-		stack.updateBoundsAllTheWayToTop(); // refresh rest of tree to accommodate
+		refitMarked(rootNode);
 	}
 
 	inline void improveStructure() { if(!isEmpty()) rootNode.improveStructure(); }
@@ -407,7 +528,7 @@ struct BoundsTree {
 		if(isEmpty()) {
 			return 0;
 		} else {
-			return getNumberOfObjectsInNode(this->rootNode);
+			return this->rootNode.getNumberOfObjectsInNode();
 		}
 	}
 
@@ -420,8 +541,231 @@ struct BoundsTree {
 
 	template<typename Filter>
 	inline TreeIterFactory<const Boundable, Filter> iterFiltered(const Filter& filter) const;
+
+private:
+	void riseToGroupOn(NodeStack& stack) {
+		refreshOutdatedGroupsOn(stack);
+		stack.riseUntilGroupHeadWhile();
+	}
+
+	void addToExistingGroupOn(NodeStack& stack, TreeNode&& newNode) {
+		riseToGroupOn(stack);
+		(*stack)->addInside(std::move(newNode));
+		stack.expandBoundsAllTheWayToTop();
+	}
+
+	// removes the object the stack points to, which may be the root itself
+	TreeNode grabOn(NodeStack& stack) {
+		if(stack.top == stack.stack) {
+			TreeNode result(std::move(this->rootNode));
+			this->rootNode.object = nullptr;
+			this->rootNode.nodeCount = 0;
+			this->rootNode.bounds = Bounds();
+			return result;
+		}
+		refreshOutdatedGroupsOn(stack);
+		return stack.remove();
+	}
+
+	TreeNode grabGroupOn(NodeStack& stack) {
+		if(stack.top == stack.stack) return grabOn(stack);
+		// the group may be added to another group, where it can't stay outdated
+		riseToGroupOn(stack);
+		return stack.remove();
+	}
+
+	void updateObjectBoundsOn(NodeStack& stack) {
+		refreshOutdatedGroupsOn(stack);
+		TreeNode* leaf = stack.top->node;
+		leaf->bounds = static_cast<const Boundable*>(leaf->object)->getStrictBounds();
+		stack.top--;
+		stack.updateBoundsAllTheWayToTop();
+	}
+
+	void updateObjectGroupBoundsOn(NodeStack& stack) {
+		stack.riseUntilGroupHeadWhile(); // find group obj belongs to
+
+		for (TreeIterator iter(*stack.top->node); iter != IteratorEnd(); ++iter) {
+			TreeNode* node = *iter;
+			node->bounds = static_cast<Boundable*>(node->object)->getStrictBounds();
+		}
+		stack.top->node->recalculateBoundsRecursive(); // refresh group bounds
+		stack.top->node->hasOutdatedSubBounds = false;
+		stack.top--;
+		stack.updateBoundsAllTheWayToTop(); // refresh rest of tree to accommodate
+	}
+
+	static void refreshBoundsRecursive(TreeNode& node) {
+		if(node.isLeafNode()) {
+			node.bounds = static_cast<Boundable*>(node.object)->getStrictBounds();
+		} else {
+			for(TreeNode& subNode : node) {
+				refreshBoundsRecursive(subNode);
+			}
+			node.recalculateBoundsFromSubBounds();
+		}
+	}
+
+	// refits the marked nodes below node, the subTrees of a node before the node itself. Groups are already up to date when they are marked
+	static void refitMarked(TreeNode& node) {
+		if(!node.needsRefit) return;
+		node.needsRefit = false;
+		if(node.isLeafNode() || node.isGroupHead) return;
+		for(TreeNode& subNode : node) {
+			refitMarked(subNode);
+		}
+		node.recalculateBoundsFromSubBounds();
+	}
+
+	static void localizeBoundsRecursive(TreeNode& node, const Boundable& frameObject) {
+		if(node.isLeafNode()) {
+			node.bounds = static_cast<Boundable*>(node.object)->getStrictBoundsRelativeTo(frameObject);
+		} else {
+			for(TreeNode& subNode : node) {
+				localizeBoundsRecursive(subNode, frameObject);
+			}
+			node.recalculateBoundsFromSubBounds();
+		}
+	}
+
+	static void refreshOutdatedGroupsBelow(TreeNode& node) {
+		if(node.isLeafNode()) return;
+		if(node.isGroupHead) {
+			if(node.hasOutdatedSubBounds) refreshGroupBounds(node);
+			return;
+		}
+		for(TreeNode& subNode : node) {
+			refreshOutdatedGroupsBelow(subNode);
+		}
+	}
+
+	static void recalculateBoundsOf(TreeNode& node) {
+		if(node.isLeafNode()) {
+			node.bounds = static_cast<Boundable*>(node.object)->getStrictBounds();
+			return;
+		}
+		if(node.isGroupHead) {
+			// any object in the group can give the bounds of the whole group
+			const Boundable& frameObject = getGroupFrameObject(node);
+			std::optional<Bounds> groupBounds = frameObject.getRigidGroupBounds();
+			if(groupBounds) {
+				// the local bounds of the nodes are computed once, they stay valid for as long as the group isn't modified
+				if(!node.hasOutdatedSubBounds) {
+					for(TreeNode& subNode : node) {
+						localizeBoundsRecursive(subNode, frameObject);
+					}
+				}
+				node.bounds = groupBounds.value();
+				node.hasOutdatedSubBounds = true;
+				return;
+			}
+		}
+		for(TreeNode& subNode : node) {
+			recalculateBoundsOf(subNode);
+		}
+		node.recalculateBoundsFromSubBounds();
+		node.hasOutdatedSubBounds = false;
+	}
+
+	// the stack is about to be used to modify the tree, which uses the bounds of the nodes on it
+	static void refreshOutdatedGroupsOn(NodeStack& stack) {
+		for(TreeStackElement* element = stack.stack; element <= stack.top; element++) {
+			if(element->node->hasOutdatedSubBounds) refreshGroupBounds(*element->node);
+		}
+	}
 };
 
+/*
+	Calls onPair(Boundable*, Boundable*) for every two objects with overlapping bounds in different groups
+	Between finds the pairs with one object in first and the other in second, Internal finds the pairs within one tree
+*/
+template<typename Boundable, typename Func>
+void forEachOverlappingPairBetween(TreeNode& first, TreeNode& second, const Func& onPair);
+
+/*
+	The pairs between the objects below localNode, which is inside a group with outdated sub bounds, and those below other
+	The local bounds of the nodes in the group are moved to the global frame one node at a time as the search descends, 
+	so the pairs are exactly those of the global bounds of the objects, without refreshing the whole group
+*/
+template<typename Boundable, typename Func>
+void forEachOverlappingPairInGroup(const Boundable& frameObject, TreeNode& localNode, TreeNode& other, bool groupIsFirst, const Func& onPair) {
+	if(localNode.isLeafNode()) {
+		TreeNode globalLeaf(localNode.object, static_cast<Boundable*>(localNode.object)->getStrictBounds());
+		if(groupIsFirst) {
+			forEachOverlappingPairBetween<Boundable>(globalLeaf, other, onPair);
+		} else {
+			forEachOverlappingPairBetween<Boundable>(other, globalLeaf, onPair);
+		}
+		return;
+	}
+	Bounds globalBounds = frameObject.getGlobalBoundsOf(localNode.bounds);
+	if(!intersects(globalBounds, other.bounds)) return;
+
+	if(!other.isLeafNode() && !other.hasOutdatedSubBounds && computeCost(other.bounds) > computeCost(globalBounds)) {
+		for(TreeNode& node : other) {
+			forEachOverlappingPairInGroup<Boundable>(frameObject, localNode, node, groupIsFirst, onPair);
+		}
+	} else {
+		for(TreeNode& node : localNode) {
+			forEachOverlappingPairInGroup<Boundable>(frameObject, node, other, groupIsFirst, onPair);
+		}
+	}
+}
+
+template<typename Boundable, typename Func>
+void forEachOverlappingPairBetween(TreeNode& first, TreeNode& second, const Func& onPair) {
+	if(!intersects(first.bounds, second.bounds)) return;
+
+	if(first.isLeafNode() && second.isLeafNode()) {
+		onPair(static_cast<Boundable*>(first.object), static_cast<Boundable*>(second.object));
+	} else {
+		bool preferFirst = computeCost(first.bounds) <= computeCost(second.bounds);
+		if(preferFirst && !first.isLeafNode() || second.isLeafNode()) {
+			// split first
+			if(first.hasOutdatedSubBounds) {
+				const Boundable& frameObject = BoundsTree<Boundable>::getGroupFrameObject(first);
+				for(TreeNode& node : first) {
+					forEachOverlappingPairInGroup<Boundable>(frameObject, node, second, true, onPair);
+				}
+				return;
+			}
+
+			for(TreeNode& node : first) {
+				forEachOverlappingPairBetween<Boundable>(node, second, onPair);
+			}
+		} else {
+			// split second
+			if(second.hasOutdatedSubBounds) {
+				const Boundable& frameObject = BoundsTree<Boundable>::getGroupFrameObject(second);
+				for(TreeNode& node : second) {
+					forEachOverlappingPairInGroup<Boundable>(frameObject, node, first, false, onPair);
+				}
+				return;
+			}
+
+			for(TreeNode& node : second) {
+				forEachOverlappingPairBetween<Boundable>(first, node, onPair);
+			}
+		}
+	}
+}
+
+template<typename Boundable, typename Func>
+void forEachOverlappingPairInternal(TreeNode& trunkNode, const Func& onPair) {
+	// within the same node
+	if(trunkNode.isLeafNode() || trunkNode.isGroupHead)
+		return;
+
+	for(int i = 0; i < trunkNode.nodeCount; i++) {
+		TreeNode& A = trunkNode[i];
+		forEachOverlappingPairInternal<Boundable>(A, onPair);
+		for(int j = i + 1; j < trunkNode.nodeCount; j++) {
+			TreeNode& B = trunkNode[j];
+			forEachOverlappingPairBetween<Boundable>(A, B, onPair);
+		}
+	}
+}
+
 template<typename Boundable, typename Filter>
 struct TreeIterFactory {
 	TreeNode* rootNode;
@@ -1,29 +1,171 @@
 #include "debug.h"
 
 #include "geometry/shape.h"
+#include "geometry/polyhedron.h"
 #include "part.h"
 #include "misc/serialization.h"
+#include "../util/serializeBasicTypes.h"
 
 #include <fstream>
 #include <chrono>
 #include <sstream>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+#define DEBUG_CAPTURE_VERSION_ID 1
 
 namespace Debug {
-	void(*logVecAction)(Position, Vec3, VectorType) = [](Position, Vec3, VectorType) {};
-	void(*logPointAction)(Position, PointType) = [](Position, PointType) {};
-	void(*logCFrameAction)(CFrame, CFrameType) = [](CFrame, CFrameType) {};
-	void(*logShapeAction)(const Polyhedron&, const GlobalCFrame&) = [](const Polyhedron&, const GlobalCFrame&) {};
-	
-	void logVector(Position origin, Vec3 vec, VectorType type) { logVecAction(origin, vec, type); };
-	void logPoint(Position point, PointType type) { logPointAction(point, type); }
-	void logCFrame(CFrame frame, CFrameType type) { logCFrameAction(frame, type); };
-	void logShape(const Polyhedron& shape, const GlobalCFrame& location) { logShapeAction(shape, location); };
-
-	void setVectorLogAction(void(*logger)(Position origin, Vec3 vec, VectorType type)) { logVecAction = logger; };
-	void setPointLogAction(void(*logger)(Position point, PointType type)) { logPointAction = logger; }
-	void setCFrameLogAction(void(*logger)(CFrame frame, CFrameType type)) { logCFrameAction = logger; };
-	void setShapeLogAction(void(*logger)(const Polyhedron& shape, const GlobalCFrame& location)) { logShapeAction = logger; }
+	static_assert(std::is_trivially_copyable<Record>::value, "Debug records are written as they are");
+
+	struct CaptureFileHeader {
+		char magic[8];
+		uint32_t versionID;
+		uint32_t recordSize;
+		uint64_t recordCount;
+		uint64_t droppedRecordCount;
+	};
+
+	static const char debugCaptureMagic[8]{'P', '3', 'D', 'D', 'E', 'B', 'U', 'G'};
+
+	bool captureEnabled = false;
+
+	static std::vector<Record> records;
+	// the total number of records made since the last clear, the next record goes to writeCount % capacity
+	static std::atomic<size_t> writeCount(0);
+	/*
+		For every slot, one more than the number of the record that was completely written to it, 0 while it is being written.
+		writeCount is increased before a record is written, only the records committed here can be read
+
+		This does not exclude two writers that wrapped onto the same slot, records index and index + capacity.
+		The first can commit while the second is still writing, a reader then copies a mix of both records
+		that passes the committed check. It takes a whole lap of the ring during one write, so the capacity
+		should be well above the number of records made while a record is written.
+	*/
+	static std::unique_ptr<std::atomic<size_t>[]> committed;
+	static uint64_t currentTick = 0;
+
+	static void resetCommitted() {
+		for(size_t i = 0; i < records.size(); i++) committed[i].store(0, std::memory_order_relaxed);
+	}
+
+	void enableCapture(size_t capacity) {
+		records.assign(std::max<size_t>(capacity, 1), Record{});
+		committed.reset(new std::atomic<size_t>[records.size()]);
+		resetCommitted();
+		writeCount.store(0, std::memory_order_relaxed);
+		captureEnabled = true;
+	}
+	void disableCapture() {
+		captureEnabled = false;
+		records.clear();
+		records.shrink_to_fit();
+		committed.reset();
+		writeCount.store(0, std::memory_order_relaxed);
+	}
+	void clearCapture() {
+		resetCommitted();
+		writeCount.store(0, std::memory_order_relaxed);
+	}
+	void setCaptureTick(uint64_t tick) {
+		currentTick = tick;
+	}
+
+	size_t getCaptureCapacity() {
+		return records.size();
+	}
+	size_t getRecordCount() {
+		return std::min(writeCount.load(std::memory_order_relaxed), records.size());
+	}
+	size_t getDroppedRecordCount() {
+		size_t written = writeCount.load(std::memory_order_relaxed);
+		return (written > records.size()) ? written - records.size() : 0;
+	}
+
+	// the record is only written to its slot once it is complete, and then committed
+	static void writeRecord(const Record& record) {
+		size_t index = writeCount.fetch_add(1, std::memory_order_relaxed);
+		size_t slot = index % records.size();
+		committed[slot].store(0, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		records[slot] = record;
+		committed[slot].store(index + 1, std::memory_order_release);
+	}
 
+	void recordVector(Position origin, Vec3 vec, VectorType type) {
+		Record record{};
+		record.tick = currentTick;
+		record.kind = RecordKind::VECTOR;
+		record.type = static_cast<uint32_t>(type);
+		record.position = origin;
+		record.vector = vec;
+		writeRecord(record);
+	}
+	void recordPoint(Position point, PointType type) {
+		Record record{};
+		record.tick = currentTick;
+		record.kind = RecordKind::POINT;
+		record.type = static_cast<uint32_t>(type);
+		record.position = point;
+		writeRecord(record);
+	}
+	void recordCFrame(CFrame frame, CFrameType type) {
+		Record record{};
+		record.tick = currentTick;
+		record.kind = RecordKind::CFRAME;
+		record.type = static_cast<uint32_t>(type);
+		record.vector = frame.position;
+		record.rotation = frame.rotation;
+		writeRecord(record);
+	}
+	void recordShape(const Polyhedron& shape, const GlobalCFrame& location) {
+		for(int i = 0; i < shape.triangleCount; i++) {
+			Triangle t = shape.getTriangle(i);
+			for(int j = 0; j < 3; j++) {
+				recordVector(location.localToGlobal(shape[t[j]]), location.localToRelative(shape[t[(j + 1) % 3]] - shape[t[j]]), INFO_VEC);
+			}
+		}
+	}
+
+	void readRecords(size_t& cursor, std::vector<Record>& output) {
+		size_t written = writeCount.load(std::memory_order_relaxed);
+		if(cursor > written) cursor = 0; // the capture was cleared
+		size_t oldest = (written > records.size()) ? written - records.size() : 0;
+		size_t i = std::max(cursor, oldest);
+		for(; i < written; i++) {
+			std::atomic<size_t>& slotCommitted = committed[i % records.size()];
+			size_t before = slotCommitted.load(std::memory_order_acquire);
+			// a later record already overwrote this one
+			if(before > i + 1) continue;
+			// still being written, it and the records after it are read next time
+			if(before != i + 1) break;
+
+			Record record = records[i % records.size()];
+			std::atomic_thread_fence(std::memory_order_acquire);
+			// overwritten while it was copied
+			if(slotCommitted.load(std::memory_order_relaxed) != before) continue;
+			output.push_back(record);
+		}
+		cursor = i;
+	}
+
+	void dumpCapture(std::ostream& ostream) {
+		std::vector<Record> output;
+		size_t cursor = 0;
+		readRecords(cursor, output);
+
+		CaptureFileHeader header{};
+		std::memcpy(header.magic, debugCaptureMagic, sizeof(debugCaptureMagic));
+		header.versionID = DEBUG_CAPTURE_VERSION_ID;
+		header.recordSize = sizeof(Record);
+		header.recordCount = output.size();
+		header.droppedRecordCount = getDroppedRecordCount();
+		::serialize(header, ostream);
+
+		::serialize(reinterpret_cast<const char*>(output.data()), output.size() * sizeof(Record), ostream);
+	}
 
 	void saveIntersectionError(const Part* first, const Part* second, const char* reason) {
 		std::ofstream file;
@@ -1,16 +1,37 @@
 #pragma once
 
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <iostream>
+
 #include "math/linalg/vec.h"
 #include "math/position.h"
 #include "math/cframe.h"
 #include "math/globalCFrame.h"
+#include "math/rotation.h"
 
 class Part;
 
 class Polyhedron;
 
+/*
+	Debug capture
+
+	logVector, logPoint and logCFrame record into a ring buffer that is allocated by enableCapture, every record is tagged
+	with the tick it was made in. Once full the oldest records are overwritten, so the last ticks can always be looked at.
+	The records can be read back with readRecords, or dumped to a file with dumpCapture for offline visualization,
+	see fileStructure.md for its layout.
+
+	While capture is disabled, the default, logging costs a single branch. When DISABLE_DEBUG_CAPTURE is defined
+	the log functions are empty and compile out entirely.
+
+	Records may be made from any thread. readRecords and dumpCapture may run while other threads are logging,
+	they only give records that were completely written. The functions changing the capture
+	must only be called while no thread is logging, such as between ticks.
+*/
 namespace Debug {
-	
+
 	enum VectorType {
 		INFO_VEC,
 		FORCE,
@@ -34,15 +55,70 @@ namespace Debug {
 		INERTIAL_CFRAME
 	};
 
-	void logVector(Position origin, Vec3 vec, VectorType type);
-	void logPoint(Position point, PointType type);
-	void logCFrame(CFrame frame, CFrameType type);
-	void logShape(const Polyhedron& shape);
+	enum class RecordKind : uint32_t {
+		VECTOR = 1,
+		POINT = 2,
+		CFRAME = 3
+	};
+
+	struct Record {
+		uint64_t tick;
+		RecordKind kind;
+		// VectorType, PointType or CFrameType depending on kind
+		uint32_t type;
+		// origin of vectors and points
+		Position position;
+		// the vector itself, or the position of a CFrame
+		Vec3 vector;
+		// rotation of a CFrame
+		Rotation rotation;
+	};
+
+	extern bool captureEnabled;
+
+	// allocates room for the given number of records, and starts recording
+	void enableCapture(size_t capacity);
+	// stops recording and frees the records
+	void disableCapture();
+	// forgets all records, keeping the capacity
+	void clearCapture();
+	// records made after this are tagged with the given tick
+	void setCaptureTick(uint64_t tick);
+
+	size_t getCaptureCapacity();
+	// the number of records that are still in the buffer
+	size_t getRecordCount();
+	// the number of records that were overwritten since the last clear
+	size_t getDroppedRecordCount();
+
+	/*
+		Appends the records made since the given cursor to output, oldest first, and moves the cursor past them.
+		Start with a cursor of 0, records that were overwritten in the meantime are skipped.
+		The cursor stops at the first record that is still being written, it is read by the next call.
+	*/
+	void readRecords(size_t& cursor, std::vector<Record>& output);
+	// writes all records in the buffer
+	void dumpCapture(std::ostream& ostream);
+
+	void recordVector(Position origin, Vec3 vec, VectorType type);
+	void recordPoint(Position point, PointType type);
+	void recordCFrame(CFrame frame, CFrameType type);
+	void recordShape(const Polyhedron& shape, const GlobalCFrame& location);
 
-	void setVectorLogAction(void(*logger)(Position origin, Vec3 vec, VectorType type));
-	void setPointLogAction(void(*logger)(Position point, PointType type));
-	void setCFrameLogAction(void(*logger)(CFrame frame, CFrameType type));
-	void setShapeLogAction(void(*logger)(const Polyhedron& shape, const GlobalCFrame& location));
+#ifndef DISABLE_DEBUG_CAPTURE
+	inline void logVector(Position origin, Vec3 vec, VectorType type) { if(captureEnabled) recordVector(origin, vec, type); }
+	inline void logPoint(Position point, PointType type) { if(captureEnabled) recordPoint(point, type); }
+	inline void logCFrame(CFrame frame, CFrameType type) { if(captureEnabled) recordCFrame(frame, type); }
+	// logs the edges of the shape as vectors
+	inline void logShape(const Polyhedron& shape, const GlobalCFrame& location) { if(captureEnabled) recordShape(shape, location); }
+	inline void logTick(uint64_t tick) { if(captureEnabled) setCaptureTick(tick); }
+#else
+	inline void logVector(Position origin, Vec3 vec, VectorType type) {}
+	inline void logPoint(Position point, PointType type) {}
+	inline void logCFrame(CFrame frame, CFrameType type) {}
+	inline void logShape(const Polyhedron& shape, const GlobalCFrame& location) {}
+	inline void logTick(uint64_t tick) {}
+#endif
 
 	void saveIntersectionError(const Part* first, const Part* second, const char* reason);
 }
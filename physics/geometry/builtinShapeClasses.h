@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cmath>
+
+#include "shapeClass.h"
+#include "polyhedron.h"
+
+/*
+	The shape classes for the basic shapes.
+	They are final and their furthestInDirection is defined here, so the templated GJK and EPA can inline it
+*/
+
+struct CubeClass final : public ShapeClass {
+	CubeClass();
+
+	virtual bool containsPoint(Vec3 point) const override;
+	virtual double getIntersectionDistance(Vec3 origin, Vec3 direction) const override;
+	virtual BoundingBox getBounds(const Rotation& rotation, const DiagonalMat3& scale) const override;
+	virtual double getScaledMaxRadiusSq(DiagonalMat3 scale) const override;
+
+	// picks the corner the same way the cube polyhedron does, near ties are resolved by the rounded dot products
+	// just taking the signs of direction makes EPA flip between the corners of a face and run out of iterations
+	virtual Vec3f furthestInDirection(const Vec3f& direction) const override {
+		Vec3f best(-1.0f, -1.0f, -1.0f);
+		float bestDot = best * direction;
+		for(int i = 1; i < 8; i++) {
+			Vec3f corner(((i + 1) & 2) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f);
+			float dot = corner * direction;
+			if(dot > bestDot) {
+				best = corner;
+				bestDot = dot;
+			}
+		}
+		return best;
+	}
+
+	virtual Polyhedron asPolyhedron() const override;
+};
+
+struct SphereClass final : public ShapeClass {
+	SphereClass();
+
+	virtual bool containsPoint(Vec3 point) const override;
+	virtual double getIntersectionDistance(Vec3 origin, Vec3 direction) const override;
+	virtual BoundingBox getBounds(const Rotation& rotation, const DiagonalMat3& scale) const override;
+	virtual double getScaledMaxRadiusSq(DiagonalMat3 scale) const override;
+	virtual double getScaledMaxRadius(DiagonalMat3 scale) const override;
+
+	virtual Vec3f furthestInDirection(const Vec3f& direction) const override {
+		return normalize(direction);
+	}
+
+	virtual Polyhedron asPolyhedron() const override;
+
+	void setScaleX(double newX, DiagonalMat3& scale) const override;
+	void setScaleY(double newY, DiagonalMat3& scale) const override;
+	void setScaleZ(double newZ, DiagonalMat3& scale) const override;
+};
+
+struct CylinderClass final : public ShapeClass {
+	CylinderClass();
+
+	virtual bool containsPoint(Vec3 point) const override;
+	virtual double getIntersectionDistance(Vec3 origin, Vec3 direction) const override;
+	virtual BoundingBox getBounds(const Rotation& rotation, const DiagonalMat3& scale) const override;
+	virtual double getScaledMaxRadiusSq(DiagonalMat3 scale) const override;
+
+	virtual Vec3f furthestInDirection(const Vec3f& direction) const override {
+		float normalizer = std::sqrt(direction.x * direction.x + direction.y * direction.y);
+		return Vec3f(direction.x / normalizer, direction.y / normalizer, (direction.z >= 0.0f) ? 1.0f : -1.0f);
+	}
+
+	virtual Polyhedron asPolyhedron() const override;
+
+	void setScaleX(double newX, DiagonalMat3& scale) const override;
+	void setScaleY(double newY, DiagonalMat3& scale) const override;
+};
@@ -22,6 +22,11 @@ void ComputationBuffers::ensureCapacity(int vertCapacity, int triangleCapacity)
 	}
 }
 
+size_t ComputationBuffers::getMemoryUsage() const {
+	return size_t(vertexCapacity) * (sizeof(Vec3f) + sizeof(MinkowskiPointIndices)) +
+		size_t(triangleCapacity) * (sizeof(Triangle) + sizeof(TriangleNeighbors) + sizeof(EdgePiece) + sizeof(int));
+}
+
 ComputationBuffers::~ComputationBuffers() {
 	deleteVertexBuffers();
 	deleteTriangleBuffers();
@@ -20,6 +20,7 @@ struct ComputationBuffers {
 
 	ComputationBuffers(int initialVertCount, int initialTriangleCount);
 	void ensureCapacity(int vertCapacity, int triangleCapacity);
+	size_t getMemoryUsage() const;
 
 	~ComputationBuffers();
 
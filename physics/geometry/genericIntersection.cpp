@@ -10,6 +10,8 @@
 #include "../profiling.h"
 #include "../constants.h"
 #include "polyhedron.h"
+#include "normalizedPolyhedron.h"
+#include "builtinShapeClasses.h"
 
 #include "../misc/validityHelper.h"
 
@@ -73,7 +75,8 @@ static int furthestIndexInDirection(Vec3* vertices, int vertexCount, Vec3 direct
 	return bestVertexIndex;
 }
 
-static MinkPoint getSupport(const ColissionPair& info, const Vec3f& searchDirection) {
+template<typename First, typename Second>
+static MinkPoint getSupport(const ColissionPairOf<First, Second>& info, const Vec3f& searchDirection) {
 	Vec3f furthest1 = info.scaleFirst * info.first.furthestInDirection(info.scaleFirst * searchDirection);  // in local space of first
 	Vec3f transformedSearchDirection = -info.transform.relativeToLocal(searchDirection);
 	Vec3f furthest2 = info.scaleSecond * info.second.furthestInDirection(info.scaleSecond * transformedSearchDirection);  // in local space of second
@@ -81,7 +84,8 @@ static MinkPoint getSupport(const ColissionPair& info, const Vec3f& searchDirect
 	return MinkPoint{ furthest1 - secondVertex, furthest1, secondVertex };  // local to first
 }
 
-std::optional<Tetrahedron> runGJKTransformed(const ColissionPair& info, Vec3f searchDirection) {
+template<typename First, typename Second>
+std::optional<Tetrahedron> runGJKTransformed(const ColissionPairOf<First, Second>& info, Vec3f searchDirection) {
 	MinkPoint A(getSupport(info, searchDirection));
 	MinkPoint B, C, D;
 
@@ -224,7 +228,8 @@ void initializeBuffer(const Tetrahedron& s, ComputationBuffers& b) {
 	b.knownVecs[3] = MinkowskiPointIndices{s.D.originFirst, s.D.originSecond};
 }
 
-bool runEPATransformed(const ColissionPair& info, const Tetrahedron& s, Vec3f& intersection, Vec3f& exitVector, ComputationBuffers& bufs) {
+template<typename First, typename Second>
+bool runEPATransformed(const ColissionPairOf<First, Second>& info, const Tetrahedron& s, Vec3f& intersection, Vec3f& exitVector, ComputationBuffers& bufs) {
 	initializeBuffer(s, bufs);
 
 	ConvexShapeBuilder builder(bufs.vertBuf, bufs.triangleBuf, 4, 4, bufs.neighborBuf, bufs.removalBuf, bufs.edgeBuf);
@@ -295,3 +300,20 @@ bool runEPATransformed(const ColissionPair& info, const Tetrahedron& s, Vec3f& i
 	incDebugTally(EPAIterationStatistics, EPA_MAX_ITER);
 	return false;
 }
+
+#define INSTANTIATE_COLISSION_PAIR(First, Second) \
+	template std::optional<Tetrahedron> runGJKTransformed<First, Second>(const ColissionPairOf<First, Second>&, Vec3f); \
+	template bool runEPATransformed<First, Second>(const ColissionPairOf<First, Second>&, const Tetrahedron&, Vec3f&, Vec3f&, ComputationBuffers&);
+
+#define INSTANTIATE_COLISSION_PAIRS_WITH(First) \
+	INSTANTIATE_COLISSION_PAIR(First, GenericCollidable) \
+	INSTANTIATE_COLISSION_PAIR(First, CubeClass) \
+	INSTANTIATE_COLISSION_PAIR(First, SphereClass) \
+	INSTANTIATE_COLISSION_PAIR(First, CylinderClass) \
+	INSTANTIATE_COLISSION_PAIR(First, NormalizedPolyhedron)
+
+INSTANTIATE_COLISSION_PAIRS_WITH(GenericCollidable)
+INSTANTIATE_COLISSION_PAIRS_WITH(CubeClass)
+INSTANTIATE_COLISSION_PAIRS_WITH(SphereClass)
+INSTANTIATE_COLISSION_PAIRS_WITH(CylinderClass)
+INSTANTIATE_COLISSION_PAIRS_WITH(NormalizedPolyhedron)
@@ -47,13 +47,26 @@ struct Tetrahedron {
 	MinkPoint A, B, C, D;
 };
 
-struct ColissionPair {
-	const GenericCollidable& first;
-	const GenericCollidable& second;
+/*
+	The two shapes to run GJK and EPA on, First and Second must have a furthestInDirection(const Vec3f&) function
+	When they are final shape classes, such as CubeClass, the support queries don't go through a virtual call
+*/
+template<typename First, typename Second>
+struct ColissionPairOf {
+	const First& first;
+	const Second& second;
 	CFramef transform;
 	DiagonalMat3f scaleFirst;
 	DiagonalMat3f scaleSecond;
 };
 
-std::optional<Tetrahedron> runGJKTransformed(const ColissionPair& colissionPair, Vec3f initialSearchDirection);
-bool runEPATransformed(const ColissionPair& colissionPair, const Tetrahedron& s, Vec3f& intersection, Vec3f& exitVector, ComputationBuffers& bufs);
+typedef ColissionPairOf<GenericCollidable, GenericCollidable> ColissionPair;
+
+/*
+	These are explicitly instantiated in genericIntersection.cpp for every combination of 
+	GenericCollidable, CubeClass, SphereClass, CylinderClass and NormalizedPolyhedron
+*/
+template<typename First, typename Second>
+std::optional<Tetrahedron> runGJKTransformed(const ColissionPairOf<First, Second>& colissionPair, Vec3f initialSearchDirection);
+template<typename First, typename Second>
+bool runEPATransformed(const ColissionPairOf<First, Second>& colissionPair, const Tetrahedron& s, Vec3f& intersection, Vec3f& exitVector, ComputationBuffers& bufs);
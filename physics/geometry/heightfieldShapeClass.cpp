@@ -0,0 +1,281 @@
+#include "heightfieldShapeClass.h"
+
+#include <cmath>
+#include <algorithm>
+
+#include "shape.h"
+#include "polyhedron.h"
+#include "genericIntersection.h"
+
+// the triangular column under one triangle of a cell, from the surface down to the bottom of the heightfield
+struct HeightfieldColumn : public GenericCollidable {
+	Vec3f points[6];
+
+	HeightfieldColumn(Vec3f a, Vec3f b, Vec3f c) : points{a, b, c, Vec3f(a.x, -1.0f, a.z), Vec3f(b.x, -1.0f, b.z), Vec3f(c.x, -1.0f, c.z)} {}
+
+	virtual Vec3f furthestInDirection(const Vec3f& direction) const override {
+		int best = 0;
+		float bestDot = points[0] * direction;
+		for(int i = 1; i < 6; i++) {
+			float dot = points[i] * direction;
+			if(dot > bestDot) {
+				best = i;
+				bestDot = dot;
+			}
+		}
+		return points[best];
+	}
+};
+
+static uint16_t quantizeHeight(float height) {
+	float clamped = std::min(1.0f, std::max(-1.0f, height));
+	return static_cast<uint16_t>(std::lround((clamped + 1.0f) * (65535.0f / 2.0f)));
+}
+
+static uint16_t computeMaxHeight(const std::vector<uint16_t>& heights) {
+	return heights.empty() ? 0 : *std::max_element(heights.begin(), heights.end());
+}
+
+HeightfieldShapeClass::HeightfieldShapeClass(int samplesX, int samplesZ, const float* heights) :
+	ShapeClass(8, Vec3(0, 0, 0), ScalableInertialMatrix(Vec3(8.0 / 3.0, 8.0 / 3.0, 8.0 / 3.0), Vec3(0, 0, 0)), HEIGHTFIELD_CLASS_ID),
+	samplesX(samplesX),
+	samplesZ(samplesZ),
+	heights(size_t(samplesX) * samplesZ) {
+	if(samplesX < 2 || samplesZ < 2) throw "A heightfield needs at least 2x2 samples!";
+
+	for(size_t i = 0; i < this->heights.size(); i++) {
+		this->heights[i] = quantizeHeight(heights[i]);
+	}
+	this->maxHeight = computeMaxHeight(this->heights);
+}
+
+HeightfieldShapeClass::HeightfieldShapeClass(int samplesX, int samplesZ, std::vector<uint16_t>&& quantizedHeights) :
+	ShapeClass(8, Vec3(0, 0, 0), ScalableInertialMatrix(Vec3(8.0 / 3.0, 8.0 / 3.0, 8.0 / 3.0), Vec3(0, 0, 0)), HEIGHTFIELD_CLASS_ID),
+	samplesX(samplesX),
+	samplesZ(samplesZ),
+	heights(std::move(quantizedHeights)) {
+	if(samplesX < 2 || samplesZ < 2) throw "A heightfield needs at least 2x2 samples!";
+	if(this->heights.size() != size_t(samplesX) * samplesZ) throw "Heightfield sample count does not match its size!";
+
+	this->maxHeight = computeMaxHeight(this->heights);
+}
+
+double HeightfieldShapeClass::getHeightAt(double x, double z) const {
+	double u = (x + 1.0) / 2.0 * (samplesX - 1);
+	double v = (z + 1.0) / 2.0 * (samplesZ - 1);
+	int i = std::min(std::max(static_cast<int>(std::floor(u)), 0), samplesX - 2);
+	int k = std::min(std::max(static_cast<int>(std::floor(v)), 0), samplesZ - 2);
+	double fu = u - i;
+	double fv = v - k;
+
+	double h00 = getSample(i, k);
+	double h11 = getSample(i + 1, k + 1);
+	if(fu >= fv) {
+		double h10 = getSample(i + 1, k);
+		return h00 + fu * (h10 - h00) + fv * (h11 - h10);
+	} else {
+		double h01 = getSample(i, k + 1);
+		return h00 + fv * (h01 - h00) + fu * (h11 - h01);
+	}
+}
+
+bool HeightfieldShapeClass::containsPoint(Vec3 point) const {
+	if(std::abs(point.x) > 1.0 || std::abs(point.z) > 1.0 || point.y < -1.0) return false;
+	return point.y <= getHeightAt(point.x, point.z);
+}
+
+// Möller-Trumbore, returns INFINITY if the ray misses
+static double rayTriangleDistance(const Vec3& origin, const Vec3& direction, const Vec3& a, const Vec3& b, const Vec3& c) {
+	Vec3 edge1 = b - a;
+	Vec3 edge2 = c - a;
+	Vec3 p = direction % edge2;
+	double det = edge1 * p;
+	if(std::abs(det) < 1E-15) return INFINITY;
+	double invDet = 1.0 / det;
+	Vec3 s = origin - a;
+	double u = (s * p) * invDet;
+	if(u < 0.0 || u > 1.0) return INFINITY;
+	Vec3 q = s % edge1;
+	double v = (direction * q) * invDet;
+	if(v < 0.0 || u + v > 1.0) return INFINITY;
+	double t = (edge2 * q) * invDet;
+	return t >= 0.0 ? t : INFINITY;
+}
+
+double HeightfieldShapeClass::getIntersectionDistance(Vec3 origin, Vec3 direction) const {
+	// clip the ray to the x and z range of the heightfield
+	double tMin = 0.0;
+	double tMax = INFINITY;
+	for(int axis : {0, 2}) {
+		if(std::abs(direction[axis]) < 1E-15) {
+			if(std::abs(origin[axis]) > 1.0) return INFINITY;
+			continue;
+		}
+		double t1 = (-1.0 - origin[axis]) / direction[axis];
+		double t2 = (1.0 - origin[axis]) / direction[axis];
+		tMin = std::max(tMin, std::min(t1, t2));
+		tMax = std::min(tMax, std::max(t1, t2));
+	}
+	if(tMin > tMax) return INFINITY;
+
+	// walk the cells along the ray in cell coordinates
+	double cellScaleX = (samplesX - 1) / 2.0;
+	double cellScaleZ = (samplesZ - 1) / 2.0;
+	Vec3 start = origin + direction * tMin;
+	double u = (start.x + 1.0) * cellScaleX;
+	double v = (start.z + 1.0) * cellScaleZ;
+	double du = direction.x * cellScaleX;
+	double dv = direction.z * cellScaleZ;
+	int i = std::min(std::max(static_cast<int>(std::floor(u)), 0), samplesX - 2);
+	int k = std::min(std::max(static_cast<int>(std::floor(v)), 0), samplesZ - 2);
+	int stepI = du > 0 ? 1 : -1;
+	int stepK = dv > 0 ? 1 : -1;
+	double tNextI = (du != 0.0) ? tMin + ((du > 0 ? i + 1 : i) - u) / du : INFINITY;
+	double tNextK = (dv != 0.0) ? tMin + ((dv > 0 ? k + 1 : k) - v) / dv : INFINITY;
+	double tDeltaI = (du != 0.0) ? std::abs(1.0 / du) : INFINITY;
+	double tDeltaK = (dv != 0.0) ? std::abs(1.0 / dv) : INFINITY;
+
+	while(true) {
+		double x0 = i / cellScaleX - 1.0;
+		double x1 = (i + 1) / cellScaleX - 1.0;
+		double z0 = k / cellScaleZ - 1.0;
+		double z1 = (k + 1) / cellScaleZ - 1.0;
+		Vec3 p00(x0, getSample(i, k), z0);
+		Vec3 p10(x1, getSample(i + 1, k), z0);
+		Vec3 p01(x0, getSample(i, k + 1), z1);
+		Vec3 p11(x1, getSample(i + 1, k + 1), z1);
+		double t = std::min(rayTriangleDistance(origin, direction, p00, p10, p11), rayTriangleDistance(origin, direction, p00, p11, p01));
+		if(t != INFINITY) return t;
+
+		if(tNextI < tNextK) {
+			if(tNextI > tMax) return INFINITY;
+			i += stepI;
+			tNextI += tDeltaI;
+			if(i < 0 || i > samplesX - 2) return INFINITY;
+		} else {
+			if(tNextK > tMax) return INFINITY;
+			k += stepK;
+			tNextK += tDeltaK;
+			if(k < 0 || k > samplesZ - 2) return INFINITY;
+		}
+	}
+}
+
+BoundingBox HeightfieldShapeClass::getBounds(const Rotation& rotation, const DiagonalMat3& scale) const {
+	Mat3 referenceFrame = rotation.asRotationMatrix() * scale;
+	double x = std::abs(referenceFrame[0][0]) + std::abs(referenceFrame[0][1]) + std::abs(referenceFrame[0][2]);
+	double y = std::abs(referenceFrame[1][0]) + std::abs(referenceFrame[1][1]) + std::abs(referenceFrame[1][2]);
+	double z = std::abs(referenceFrame[2][0]) + std::abs(referenceFrame[2][1]) + std::abs(referenceFrame[2][2]);
+	return BoundingBox{-x, -y, -z, x, y, z};
+}
+
+double HeightfieldShapeClass::getScaledMaxRadiusSq(DiagonalMat3 scale) const {
+	return scale[0] * scale[0] + scale[1] * scale[1] + scale[2] * scale[2];
+}
+
+Vec3f HeightfieldShapeClass::furthestInDirection(const Vec3f& direction) const {
+	return Vec3f(direction.x < 0 ? -1.0f : 1.0f, direction.y < 0 ? -1.0f : 1.0f, direction.z < 0 ? -1.0f : 1.0f);
+}
+
+size_t HeightfieldShapeClass::getMemoryUsage() const {
+	return heights.capacity() * sizeof(uint16_t);
+}
+
+Polyhedron HeightfieldShapeClass::asPolyhedron() const {
+	int stepX = (samplesX + 126) / 127;
+	int stepZ = (samplesZ + 126) / 127;
+	int vertsX = (samplesX - 1 + stepX - 1) / stepX + 1;
+	int vertsZ = (samplesZ - 1 + stepZ - 1) / stepZ + 1;
+
+	std::vector<Vec3f> vertices;
+	vertices.reserve(vertsX * vertsZ);
+	for(int vk = 0; vk < vertsZ; vk++) {
+		int k = std::min(vk * stepZ, samplesZ - 1);
+		for(int vi = 0; vi < vertsX; vi++) {
+			int i = std::min(vi * stepX, samplesX - 1);
+			vertices.push_back(Vec3f(float(i * 2.0 / (samplesX - 1) - 1.0), float(getSample(i, k)), float(k * 2.0 / (samplesZ - 1) - 1.0)));
+		}
+	}
+	std::vector<Triangle> triangles;
+	triangles.reserve((vertsX - 1) * (vertsZ - 1) * 2);
+	for(int vk = 0; vk < vertsZ - 1; vk++) {
+		for(int vi = 0; vi < vertsX - 1; vi++) {
+			int v00 = vk * vertsX + vi;
+			int v10 = v00 + 1;
+			int v01 = v00 + vertsX;
+			int v11 = v01 + 1;
+			// counterclockwise seen from above
+			triangles.push_back(Triangle{v00, v11, v10});
+			triangles.push_back(Triangle{v00, v01, v11});
+		}
+	}
+	return Polyhedron(vertices.data(), triangles.data(), static_cast<int>(vertices.size()), static_cast<int>(triangles.size()));
+}
+
+std::optional<Intersection> HeightfieldShapeClass::intersectsTransformed(const DiagonalMat3& scale, const Shape& other, const CFrame& relativeTransform) const {
+	BoundingBox otherBounds = other.getBounds(relativeTransform.getRotation());
+	Vec3 otherPos = relativeTransform.getPosition();
+	Vec3 minCorner = ~scale * (otherBounds.min + otherPos);
+	Vec3 maxCorner = ~scale * (otherBounds.max + otherPos);
+
+	if(maxCorner.x < -1.0 || minCorner.x > 1.0 || maxCorner.z < -1.0 || minCorner.z > 1.0 || maxCorner.y < -1.0) return std::optional<Intersection>();
+	if(minCorner.y > maxHeight * (2.0 / 65535.0) - 1.0) return std::optional<Intersection>();
+
+	double cellScaleX = (samplesX - 1) / 2.0;
+	double cellScaleZ = (samplesZ - 1) / 2.0;
+	int iMin = std::max(static_cast<int>(std::floor((minCorner.x + 1.0) * cellScaleX)), 0);
+	int iMax = std::min(static_cast<int>(std::floor((maxCorner.x + 1.0) * cellScaleX)), samplesX - 2);
+	int kMin = std::max(static_cast<int>(std::floor((minCorner.z + 1.0) * cellScaleZ)), 0);
+	int kMax = std::min(static_cast<int>(std::floor((maxCorner.z + 1.0) * cellScaleZ)), samplesZ - 2);
+
+	Rotation otherRotation = relativeTransform.getRotation();
+
+	// the deepest colission of all columns is used
+	std::optional<Intersection> deepest;
+	double deepestDepth = 0.0;
+	for(int k = kMin; k <= kMax; k++) {
+		float z0 = float(k / cellScaleZ - 1.0);
+		float z1 = float((k + 1) / cellScaleZ - 1.0);
+		for(int i = iMin; i <= iMax; i++) {
+			float x0 = float(i / cellScaleX - 1.0);
+			float x1 = float((i + 1) / cellScaleX - 1.0);
+			Vec3f p00(x0, float(getSample(i, k)), z0);
+			Vec3f p10(x1, float(getSample(i + 1, k)), z0);
+			Vec3f p01(x0, float(getSample(i, k + 1)), z1);
+			Vec3f p11(x1, float(getSample(i + 1, k + 1)), z1);
+
+			HeightfieldColumn columns[2]{HeightfieldColumn(p00, p11, p10), HeightfieldColumn(p00, p01, p11)};
+			for(const HeightfieldColumn& column : columns) {
+				if(minCorner.y > std::max(column.points[0].y, std::max(column.points[1].y, column.points[2].y))) continue;
+
+				ColissionPair info{column, *other.baseShape, relativeTransform, scale, other.scale};
+				if(!runGJKTransformed(info, -relativeTransform.getPosition())) continue;
+
+				/*
+					EPA would push the other shape out through the walls of the thin column,
+					the surface is what matters, so the other shape is pushed out along the normal of the triangle
+				*/
+				Vec3 a = scale * Vec3(column.points[0]);
+				Vec3 b = scale * Vec3(column.points[1]);
+				Vec3 c = scale * Vec3(column.points[2]);
+				Vec3 normal = normalize((b - a) % (c - a));
+
+				// the deepest point of the other shape below the surface
+				Vec3 localDown = otherRotation.globalToLocal(-normal);
+				Vec3 deepestPoint = other.scale * Vec3(other.baseShape->furthestInDirection(Vec3f(other.scale * localDown)));
+				Vec3 deepestPointHere = relativeTransform.localToGlobal(deepestPoint);
+				double depth = (a - deepestPointHere) * normal;
+
+				if(depth > deepestDepth) {
+					deepestDepth = depth;
+					deepest = Intersection(deepestPointHere + normal * (depth / 2), normal * depth);
+				}
+			}
+		}
+	}
+	return deepest;
+}
+
+Shape Heightfield(const HeightfieldShapeClass* heightfield, double width, double height, double depth) {
+	return Shape(heightfield, width, height, depth);
+}
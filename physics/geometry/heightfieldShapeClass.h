@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+#include <optional>
+#include <cstdint>
+
+#include "shapeClass.h"
+#include "intersection.h"
+
+class Shape;
+
+/*
+	A terrain surface defined by a grid of heights, solid from the surface down to the bottom of the shape
+
+	The samples are spread evenly over -1..1 in x and z, heights are stored as 16 bit fractions of the -1..1 y range,
+	so a 4096x4096 heightfield takes 32MB. Every cell is split into two triangles along its (i, k)-(i+1, k+1) diagonal.
+
+	The heightfield is not convex, colissions are found by only testing the triangular columns of the cells under the bounds of the other shape.
+	It is meant for terrain parts, the mass properties are those of the bounding box.
+*/
+class HeightfieldShapeClass : public ShapeClass {
+	int samplesX;
+	int samplesZ;
+	std::vector<uint16_t> heights;
+	uint16_t maxHeight;
+public:
+	// heights is a row major samplesZ x samplesX grid of values in -1..1, heights[k * samplesX + i] is the sample at x index i and z index k
+	HeightfieldShapeClass(int samplesX, int samplesZ, const float* heights);
+	// quantizedHeights map 0..65535 to -1..1
+	HeightfieldShapeClass(int samplesX, int samplesZ, std::vector<uint16_t>&& quantizedHeights);
+
+	inline int getSamplesX() const { return samplesX; }
+	inline int getSamplesZ() const { return samplesZ; }
+	inline const std::vector<uint16_t>& getQuantizedHeights() const { return heights; }
+
+	inline double getSample(int i, int k) const {
+		return heights[k * samplesX + i] * (2.0 / 65535.0) - 1.0;
+	}
+	// the height of the surface at the given x, z, both in -1..1
+	double getHeightAt(double x, double z) const;
+
+	virtual bool containsPoint(Vec3 point) const override;
+	// only the top surface can be hit
+	virtual double getIntersectionDistance(Vec3 origin, Vec3 direction) const override;
+
+	virtual BoundingBox getBounds(const Rotation& referenceFrame, const DiagonalMat3& scale) const override;
+	virtual double getScaledMaxRadiusSq(DiagonalMat3 scale) const override;
+
+	// the heightfield is not convex, this gives the furthest corner of its box, which GJK should never be run on
+	virtual Vec3f furthestInDirection(const Vec3f& direction) const override;
+
+	// a surface mesh of at most 128x128 samples, for visualization
+	virtual Polyhedron asPolyhedron() const override;
+	virtual size_t getMemoryUsage() const override;
+
+	/*
+		Narrowphase between a heightfield and any convex shape
+		relativeTransform is the transform of other relative to the heightfield, the result is local to the heightfield, like intersectsTransformed
+	*/
+	std::optional<Intersection> intersectsTransformed(const DiagonalMat3& scale, const Shape& other, const CFrame& relativeTransform) const;
+};
+
+Shape Heightfield(const HeightfieldShapeClass* heightfield, double width, double height, double depth);
@@ -10,18 +10,35 @@
 
 #include "../misc/validityHelper.h"
 #include "shapeClass.h"
+#include "builtinShapeClasses.h"
+#include "normalizedPolyhedron.h"
+#include "heightfieldShapeClass.h"
+#include "triangleMeshShapeClass.h"
 
 #include <algorithm>
 
-std::optional<Intersection> intersectsTransformed(const Shape& first, const Shape& second, const CFrame& relativeTransform) {
-	return intersectsTransformed(*first.baseShape, *second.baseShape, relativeTransform, first.scale, second.scale);
+// heightfields and triangle meshes are not convex, they test their parts themselves
+static bool isConcave(const Shape& shape) {
+	return shape.baseShape->intersectionClassID == HEIGHTFIELD_CLASS_ID || shape.baseShape->intersectionClassID == TRIANGLE_MESH_CLASS_ID;
 }
 
+static std::optional<Intersection> concaveIntersectsTransformed(const Shape& concave, const Shape& other, const CFrame& relativeTransform) {
+	if(concave.baseShape->intersectionClassID == HEIGHTFIELD_CLASS_ID) {
+		return static_cast<const HeightfieldShapeClass*>(concave.baseShape)->intersectsTransformed(concave.scale, other, relativeTransform);
+	} else {
+		return static_cast<const TriangleMeshShapeClass*>(concave.baseShape)->intersectsTransformed(concave.scale, other, relativeTransform);
+	}
+}
 
 ComputationBuffers buffers(1000, 2000);
 
-std::optional<Intersection> intersectsTransformed(const GenericCollidable& first, const GenericCollidable& second, const CFrame& relativeTransform, const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond) {
-	ColissionPair info{first, second, relativeTransform, scaleFirst, scaleSecond};
+size_t getComputationBufferMemoryUsage() {
+	return buffers.getMemoryUsage();
+}
+
+template<typename First, typename Second>
+static std::optional<Intersection> intersectsTransformedTyped(const First& first, const Second& second, const CFrame& relativeTransform, const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond) {
+	ColissionPairOf<First, Second> info{first, second, relativeTransform, scaleFirst, scaleSecond};
 	physicsMeasure.mark(PhysicsProcess::GJK_COL);
 	std::optional collides = runGJKTransformed(info, -relativeTransform.position);
 
@@ -66,3 +83,53 @@ std::optional<Intersection> intersectsTransformed(const GenericCollidable& first
 		return std::optional<Intersection>();
 	}
 }
+
+std::optional<Intersection> intersectsTransformed(const GenericCollidable& first, const GenericCollidable& second, const CFrame& relativeTransform, const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond) {
+	return intersectsTransformedTyped(first, second, relativeTransform, scaleFirst, scaleSecond);
+}
+
+// picks the GJK and EPA specialized for the class of second, any other ShapeClass uses the virtual furthestInDirection
+template<typename First>
+static std::optional<Intersection> intersectsBuiltinSecond(const First& first, const ShapeClass& second, const CFrame& relativeTransform, const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond) {
+	switch(second.intersectionClassID) {
+	case CUBE_CLASS_ID:
+		return intersectsTransformedTyped(first, static_cast<const CubeClass&>(second), relativeTransform, scaleFirst, scaleSecond);
+	case SPHERE_CLASS_ID:
+		return intersectsTransformedTyped(first, static_cast<const SphereClass&>(second), relativeTransform, scaleFirst, scaleSecond);
+	case CYLINDER_CLASS_ID:
+		return intersectsTransformedTyped(first, static_cast<const CylinderClass&>(second), relativeTransform, scaleFirst, scaleSecond);
+	case CONVEX_POLYHEDRON_CLASS_ID:
+		return intersectsTransformedTyped(first, static_cast<const NormalizedPolyhedron&>(second), relativeTransform, scaleFirst, scaleSecond);
+	default:
+		return intersectsTransformedTyped(first, static_cast<const GenericCollidable&>(second), relativeTransform, scaleFirst, scaleSecond);
+	}
+}
+
+static std::optional<Intersection> intersectsBuiltinClasses(const ShapeClass& first, const ShapeClass& second, const CFrame& relativeTransform, const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond) {
+	switch(first.intersectionClassID) {
+	case CUBE_CLASS_ID:
+		return intersectsBuiltinSecond(static_cast<const CubeClass&>(first), second, relativeTransform, scaleFirst, scaleSecond);
+	case SPHERE_CLASS_ID:
+		return intersectsBuiltinSecond(static_cast<const SphereClass&>(first), second, relativeTransform, scaleFirst, scaleSecond);
+	case CYLINDER_CLASS_ID:
+		return intersectsBuiltinSecond(static_cast<const CylinderClass&>(first), second, relativeTransform, scaleFirst, scaleSecond);
+	case CONVEX_POLYHEDRON_CLASS_ID:
+		return intersectsBuiltinSecond(static_cast<const NormalizedPolyhedron&>(first), second, relativeTransform, scaleFirst, scaleSecond);
+	default:
+		return intersectsBuiltinSecond(static_cast<const GenericCollidable&>(first), second, relativeTransform, scaleFirst, scaleSecond);
+	}
+}
+
+std::optional<Intersection> intersectsTransformed(const Shape& first, const Shape& second, const CFrame& relativeTransform) {
+	if(isConcave(first)) {
+		if(isConcave(second)) return std::optional<Intersection>();
+		return concaveIntersectsTransformed(first, second, relativeTransform);
+	}
+	if(isConcave(second)) {
+		std::optional<Intersection> result = concaveIntersectsTransformed(second, first, ~relativeTransform);
+		if(!result) return result;
+		// the exitVector of the swapped test moves first, second must move the other way
+		return Intersection(relativeTransform.localToGlobal(result.value().intersection), -relativeTransform.localToRelative(result.value().exitVector));
+	}
+	return intersectsBuiltinClasses(*first.baseShape, *second.baseShape, relativeTransform, first.scale, second.scale);
+}
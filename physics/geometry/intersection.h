@@ -23,4 +23,7 @@ struct Intersection {
 std::optional<Intersection> intersectsTransformed(const Shape& first, const Shape& second, const CFrame& relativeTransform);
 std::optional<Intersection> intersectsTransformed(const GenericCollidable& first, const GenericCollidable& second, const CFrame& relativeTransform, const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond);
 
+// bytes held by the scratch buffers of EPA, these grow to the largest shapes seen and are never shrunk
+size_t getComputationBufferMemoryUsage();
+
 
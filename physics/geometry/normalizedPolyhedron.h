@@ -3,8 +3,9 @@
 #include "polyhedron.h"
 #include "shapeClass.h"
 
-class NormalizedPolyhedron : public ShapeClass, public Polyhedron {
+class NormalizedPolyhedron final : public ShapeClass, public Polyhedron {
 	friend class Polyhedron;
+	friend class ChunkedDeSerializationSession;
 	NormalizedPolyhedron(Polyhedron&& poly, Vec3 originalCenter, DiagonalMat3 originalScale, double volume, Vec3 localCenterOfMass, ScalableInertialMatrix inertia) : 
 		Polyhedron(std::move(poly)), ShapeClass(volume, localCenterOfMass, inertia, CONVEX_POLYHEDRON_CLASS_ID), originalCenter(originalCenter), originalScale(originalScale) {}
 public:
@@ -33,4 +34,8 @@ public:
 	virtual Polyhedron asPolyhedron() const override {
 		return static_cast<Polyhedron>(*this);
 	}
+
+	virtual size_t getMemoryUsage() const override {
+		return Polyhedron::getMemoryUsage();
+	}
 };
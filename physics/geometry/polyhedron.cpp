@@ -50,7 +50,7 @@ Triangle Triangle::leftShift() const {
 	return Triangle { secondIndex, thirdIndex, firstIndex };
 }
 
-inline Polyhedron::Polyhedron(UniqueAlignedPointer<float>&& vertices, UniqueAlignedPointer<int>&& triangles, int vertexCount, int triangleCount) :
+Polyhedron::Polyhedron(UniqueAlignedPointer<float>&& vertices, UniqueAlignedPointer<int>&& triangles, int vertexCount, int triangleCount) :
 	vertices(std::move(vertices)), triangles(std::move(triangles)), vertexCount(vertexCount), triangleCount(triangleCount) {
 }
 
@@ -592,6 +592,10 @@ BoundingBox Polyhedron::getBounds(const Mat3f& referenceFrame) const {
 
 #endif
 
+size_t Polyhedron::getMemoryUsage() const {
+	return getOffset(vertexCount) * 3 * sizeof(float) + getOffset(triangleCount) * 3 * sizeof(int);
+}
+
 double Polyhedron::getVolume() const {
 	double total = 0;
 	for (Triangle triangle : iterTriangles()) {
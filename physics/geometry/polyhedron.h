@@ -74,6 +74,8 @@ class NormalizedPolyhedron;
 class Shape;
 
 class Polyhedron : public GenericCollidable {
+	friend class ChunkedDeSerializationSession;
+
 	UniqueAlignedPointer<float> vertices;
 	UniqueAlignedPointer<int> triangles;
 	Polyhedron(UniqueAlignedPointer<float>&& vertices, UniqueAlignedPointer<int>&& triangles, int vertexCount, int triangleCount);
@@ -103,6 +105,8 @@ public:
 	bool containsPoint(Vec3f point) const;
 	float getIntersectionDistance(Vec3f origin, Vec3f direction) const;
 	double getVolume() const;
+	// bytes of the vertex and triangle buffers, not including the Polyhedron itself
+	size_t getMemoryUsage() const;
 
 	BoundingBox getBounds() const;
 	BoundingBox getBounds(const Mat3f& referenceFrame) const;
@@ -11,6 +11,8 @@
 #define SPHERE_CLASS_ID 1
 #define CYLINDER_CLASS_ID 2
 #define CONVEX_POLYHEDRON_CLASS_ID 10
+#define HEIGHTFIELD_CLASS_ID 20
+#define TRIANGLE_MESH_CLASS_ID 21
 class Polyhedron;
 
 // a ShapeClass is defined as a shape with dimentions -1..1 in all axes. All functions work on scaled versions of the shape. 
@@ -26,6 +28,7 @@ public:
 	const int intersectionClassID;
 
 	ShapeClass(double volume, Vec3 centerOfMass, ScalableInertialMatrix inertia, int intersectionClassID);
+	virtual ~ShapeClass() {}
 
 	virtual bool containsPoint(Vec3 point) const = 0;
 	virtual double getIntersectionDistance(Vec3 origin, Vec3 direction) const = 0;
@@ -39,6 +42,9 @@ public:
 
 	virtual Polyhedron asPolyhedron() const = 0;
 
+	// bytes of the data owned by this shape class, such as vertex buffers, not including the object itself
+	virtual size_t getMemoryUsage() const { return 0; }
+
 	// these functions determine the relations between the axes, for example, for Sphere, all axes must be equal
 	virtual void setScaleX(double newX, DiagonalMat3& scale) const;
 	virtual void setScaleY(double newY, DiagonalMat3& scale) const;
@@ -0,0 +1,238 @@
+#include "triangleMeshShapeClass.h"
+
+#include <cmath>
+#include <algorithm>
+
+#include "shape.h"
+#include "genericIntersection.h"
+#include "../math/utils.h"
+
+#define MAX_TRIANGLES_PER_LEAF 4
+
+// a triangle extruded behind its face
+struct TrianglePrism : public GenericCollidable {
+	Vec3f points[6];
+
+	TrianglePrism(Vec3f a, Vec3f b, Vec3f c, Vec3f back) : points{a, b, c, a - back, b - back, c - back} {}
+
+	virtual Vec3f furthestInDirection(const Vec3f& direction) const override {
+		int best = 0;
+		float bestDot = points[0] * direction;
+		for(int i = 1; i < 6; i++) {
+			float dot = points[i] * direction;
+			if(dot > bestDot) {
+				best = i;
+				bestDot = dot;
+			}
+		}
+		return points[best];
+	}
+};
+
+static Vec3f centroidOf(const std::vector<Vec3f>& vertices, const Triangle& triangle) {
+	return (vertices[triangle.firstIndex] + vertices[triangle.secondIndex] + vertices[triangle.thirdIndex]) * (1.0f / 3.0f);
+}
+
+static void includeInBounds(Vec3f& min, Vec3f& max, const Vec3f& point) {
+	for(int axis = 0; axis < 3; axis++) {
+		min[axis] = std::min(min[axis], point[axis]);
+		max[axis] = std::max(max[axis], point[axis]);
+	}
+}
+
+// builds the subtree for the count triangles starting at start, nodes are stored depth first
+static void buildNode(std::vector<TriangleMeshNode>& nodes, std::vector<Triangle>& triangles, const std::vector<Vec3f>& vertices, int start, int count) {
+	Vec3f min(INFINITY, INFINITY, INFINITY);
+	Vec3f max(-INFINITY, -INFINITY, -INFINITY);
+	Vec3f centroidMin(INFINITY, INFINITY, INFINITY);
+	Vec3f centroidMax(-INFINITY, -INFINITY, -INFINITY);
+	for(int i = start; i < start + count; i++) {
+		const Triangle& triangle = triangles[i];
+		for(int index : triangle.indexes) {
+			includeInBounds(min, max, vertices[index]);
+		}
+		includeInBounds(centroidMin, centroidMax, centroidOf(vertices, triangle));
+	}
+
+	int nodeIndex = static_cast<int>(nodes.size());
+	nodes.push_back(TriangleMeshNode{min, max, start, count});
+	if(count <= MAX_TRIANGLES_PER_LEAF) return;
+
+	// median split along the longest axis of the centroids
+	Vec3f extent = centroidMax - centroidMin;
+	int axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : (extent.y >= extent.z ? 1 : 2);
+	int half = count / 2;
+	std::nth_element(triangles.begin() + start, triangles.begin() + start + half, triangles.begin() + start + count, [&vertices, axis](const Triangle& first, const Triangle& second) {
+		return centroidOf(vertices, first)[axis] < centroidOf(vertices, second)[axis];
+	});
+
+	buildNode(nodes, triangles, vertices, start, half);
+	int secondChild = static_cast<int>(nodes.size());
+	buildNode(nodes, triangles, vertices, start + half, count - half);
+	nodes[nodeIndex].start = secondChild;
+	nodes[nodeIndex].count = 0;
+}
+
+TriangleMeshShapeClass::TriangleMeshShapeClass(std::vector<Vec3f>&& vertices, std::vector<Triangle>&& triangles) :
+	ShapeClass(8, Vec3(0, 0, 0), ScalableInertialMatrix(Vec3(8.0 / 3.0, 8.0 / 3.0, 8.0 / 3.0), Vec3(0, 0, 0)), TRIANGLE_MESH_CLASS_ID),
+	vertices(std::move(vertices)),
+	triangles(std::move(triangles)) {
+	if(this->triangles.empty()) throw "A triangle mesh needs at least one triangle!";
+	for(const Triangle& triangle : this->triangles) {
+		for(int index : triangle.indexes) {
+			if(index < 0 || index >= static_cast<int>(this->vertices.size())) throw "Triangle mesh vertex index out of range!";
+		}
+	}
+
+	buildTree();
+}
+
+void TriangleMeshShapeClass::buildTree() {
+	nodes.clear();
+	nodes.reserve(2 * (triangles.size() / MAX_TRIANGLES_PER_LEAF) + 1);
+	buildNode(nodes, triangles, vertices, 0, static_cast<int>(triangles.size()));
+}
+
+// calls func(const Triangle&) for every triangle in a leaf hit by the ray
+template<typename Func>
+static void forEachTriangleAlongRay(const std::vector<TriangleMeshNode>& nodes, const std::vector<Triangle>& triangles, const Vec3& origin, const Vec3& direction, const Func& func) {
+	int stack[64];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while(stackSize > 0) {
+		int nodeIndex = stack[--stackSize];
+		const TriangleMeshNode& node = nodes[nodeIndex];
+
+		double tMin = 0.0;
+		double tMax = INFINITY;
+		for(int axis = 0; axis < 3; axis++) {
+			if(std::abs(direction[axis]) < 1E-15) {
+				if(origin[axis] < node.min[axis] || origin[axis] > node.max[axis]) tMin = INFINITY;
+				continue;
+			}
+			double t1 = (node.min[axis] - origin[axis]) / direction[axis];
+			double t2 = (node.max[axis] - origin[axis]) / direction[axis];
+			tMin = std::max(tMin, std::min(t1, t2));
+			tMax = std::min(tMax, std::max(t1, t2));
+		}
+		if(tMin > tMax) continue;
+
+		if(node.isLeaf()) {
+			for(int i = node.start; i < node.start + node.count; i++) {
+				func(triangles[i]);
+			}
+		} else {
+			stack[stackSize++] = node.start;
+			stack[stackSize++] = nodeIndex + 1;
+		}
+	}
+}
+
+bool TriangleMeshShapeClass::containsPoint(Vec3 point) const {
+	// a point is inside if a ray from it crosses the mesh an odd number of times
+	Vec3 direction(1.0, 0.0, 0.0);
+	int crossings = 0;
+	forEachTriangleAlongRay(nodes, triangles, point, direction, [&](const Triangle& triangle) {
+		RayIntersection<double> hit = rayTriangleIntersection(point, direction, Vec3(vertices[triangle.firstIndex]), Vec3(vertices[triangle.secondIndex]), Vec3(vertices[triangle.thirdIndex]));
+		if(hit.rayIntersectsTriangle()) crossings++;
+	});
+	return crossings % 2 == 1;
+}
+
+double TriangleMeshShapeClass::getIntersectionDistance(Vec3 origin, Vec3 direction) const {
+	double closest = INFINITY;
+	forEachTriangleAlongRay(nodes, triangles, origin, direction, [&](const Triangle& triangle) {
+		RayIntersection<double> hit = rayTriangleIntersection(origin, direction, Vec3(vertices[triangle.firstIndex]), Vec3(vertices[triangle.secondIndex]), Vec3(vertices[triangle.thirdIndex]));
+		if(hit.rayIntersectsTriangle() && hit.d < closest) closest = hit.d;
+	});
+	return closest;
+}
+
+BoundingBox TriangleMeshShapeClass::getBounds(const Rotation& rotation, const DiagonalMat3& scale) const {
+	Mat3 referenceFrame = rotation.asRotationMatrix() * scale;
+	double x = std::abs(referenceFrame[0][0]) + std::abs(referenceFrame[0][1]) + std::abs(referenceFrame[0][2]);
+	double y = std::abs(referenceFrame[1][0]) + std::abs(referenceFrame[1][1]) + std::abs(referenceFrame[1][2]);
+	double z = std::abs(referenceFrame[2][0]) + std::abs(referenceFrame[2][1]) + std::abs(referenceFrame[2][2]);
+	return BoundingBox{-x, -y, -z, x, y, z};
+}
+
+double TriangleMeshShapeClass::getScaledMaxRadiusSq(DiagonalMat3 scale) const {
+	return scale[0] * scale[0] + scale[1] * scale[1] + scale[2] * scale[2];
+}
+
+Vec3f TriangleMeshShapeClass::furthestInDirection(const Vec3f& direction) const {
+	return Vec3f(direction.x < 0 ? -1.0f : 1.0f, direction.y < 0 ? -1.0f : 1.0f, direction.z < 0 ? -1.0f : 1.0f);
+}
+
+size_t TriangleMeshShapeClass::getMemoryUsage() const {
+	return vertices.capacity() * sizeof(Vec3f) + triangles.capacity() * sizeof(Triangle) + nodes.capacity() * sizeof(TriangleMeshNode);
+}
+
+Polyhedron TriangleMeshShapeClass::asPolyhedron() const {
+	return Polyhedron(vertices.data(), triangles.data(), static_cast<int>(vertices.size()), static_cast<int>(triangles.size()));
+}
+
+std::optional<Intersection> TriangleMeshShapeClass::intersectsTransformed(const DiagonalMat3& scale, const Shape& other, const CFrame& relativeTransform) const {
+	BoundingBox otherBounds = other.getBounds(relativeTransform.getRotation());
+	Vec3 otherPos = relativeTransform.getPosition();
+	Vec3 minCorner = ~scale * (otherBounds.min + otherPos);
+	Vec3 maxCorner = ~scale * (otherBounds.max + otherPos);
+
+	Rotation otherRotation = relativeTransform.getRotation();
+	// the prisms reach as deep as the other shape is large, so it can't be behind a prism while its center is in front of it
+	double thickness = other.getMaxRadius();
+
+	// the deepest colission of all triangles is used
+	std::optional<Intersection> deepest;
+	double deepestDepth = 0.0;
+	forEachTriangleInBounds(Vec3f(minCorner), Vec3f(maxCorner), [&](const Triangle& triangle) {
+		Vec3 a = scale * Vec3(vertices[triangle.firstIndex]);
+		Vec3 b = scale * Vec3(vertices[triangle.secondIndex]);
+		Vec3 c = scale * Vec3(vertices[triangle.thirdIndex]);
+		Vec3 normalVec = (b - a) % (c - a);
+		double normalLengthSq = lengthSquared(normalVec);
+		if(normalLengthSq == 0.0) return;
+		Vec3 normal = normalVec / std::sqrt(normalLengthSq);
+
+		// only pushed out of the front of the triangle
+		if((otherPos - a) * normal <= 0.0) return;
+
+		TrianglePrism prism(Vec3f(a), Vec3f(b), Vec3f(c), Vec3f(normal * thickness));
+		ColissionPair info{prism, *other.baseShape, relativeTransform, DiagonalMat3f{1.0f, 1.0f, 1.0f}, other.scale};
+		if(!runGJKTransformed(info, -otherPos)) return;
+
+		// the deepest point of the other shape behind the triangle
+		Vec3 localBack = otherRotation.globalToLocal(-normal);
+		Vec3 deepestPoint = other.scale * Vec3(other.baseShape->furthestInDirection(Vec3f(other.scale * localBack)));
+		Vec3 deepestPointHere = relativeTransform.localToGlobal(deepestPoint);
+		double depth = (a - deepestPointHere) * normal;
+
+		if(depth > deepestDepth) {
+			deepestDepth = depth;
+			deepest = Intersection(deepestPointHere + normal * (depth / 2), normal * depth);
+		}
+	});
+	return deepest;
+}
+
+Shape TriangleMesh(const TriangleMeshShapeClass* mesh, double width, double height, double depth) {
+	return Shape(mesh, width, height, depth);
+}
+
+Shape TriangleMesh(const Polyhedron& mesh) {
+	BoundingBox bounds = mesh.getBounds();
+	Vec3 center = bounds.getCenter();
+	// flat meshes like floors get a small thickness to keep the scale invertible
+	double minSize = std::max(bounds.getWidth(), std::max(bounds.getHeight(), bounds.getDepth())) * 1E-3;
+	double width = std::max(bounds.getWidth(), minSize);
+	double height = std::max(bounds.getHeight(), minSize);
+	double depth = std::max(bounds.getDepth(), minSize);
+
+	Polyhedron normalized = mesh.translatedAndScaled(-center, DiagonalMat3f{float(2 / width), float(2 / height), float(2 / depth)});
+	std::vector<Vec3f> vertices(normalized.vertexCount);
+	std::vector<Triangle> triangles(normalized.triangleCount);
+	normalized.getVertices(vertices.data());
+	normalized.getTriangles(triangles.data());
+
+	return Shape(new TriangleMeshShapeClass(std::move(vertices), std::move(triangles)), width, height, depth);
+}
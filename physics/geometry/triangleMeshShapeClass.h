@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+#include <optional>
+
+#include "shapeClass.h"
+#include "polyhedron.h"
+#include "intersection.h"
+
+class Shape;
+
+struct TriangleMeshNode {
+	Vec3f min;
+	Vec3f max;
+	// leaves hold count triangles starting at start, for inner nodes count is 0, the first child follows the node and start is the second child
+	int start;
+	int count;
+
+	inline bool isLeaf() const { return count != 0; }
+};
+
+/*
+	A static, non-convex mesh of triangles, for level geometry that can't be split into convex polyhedra
+
+	The triangles are kept in a bounding volume hierarchy, the narrowphase only tests the triangles overlapping the bounds of the other shape.
+	Each triangle is tested as a thin prism extruded behind its face, the other shape is pushed out along the normal of the triangle.
+	Triangles are facing outward when counterclockwise, as in Polyhedron. Shapes whose center is behind a triangle are not pushed out of it,
+	so open meshes like floors and walls can be touched from their front side only.
+
+	It is meant for terrain parts, the mass properties are those of the bounding box.
+*/
+class TriangleMeshShapeClass : public ShapeClass {
+	std::vector<Vec3f> vertices;
+	std::vector<Triangle> triangles;
+	std::vector<TriangleMeshNode> nodes;
+
+	void buildTree();
+public:
+	// vertices must be within -1..1, use TriangleMesh(const Polyhedron&) to normalize an arbitrary mesh
+	TriangleMeshShapeClass(std::vector<Vec3f>&& vertices, std::vector<Triangle>&& triangles);
+
+	inline const std::vector<Vec3f>& getVertices() const { return vertices; }
+	inline const std::vector<Triangle>& getTriangles() const { return triangles; }
+	inline const std::vector<TriangleMeshNode>& getNodes() const { return nodes; }
+
+	// calls func(const Triangle&) for every triangle whose bounds overlap min..max
+	template<typename Func>
+	void forEachTriangleInBounds(const Vec3f& min, const Vec3f& max, const Func& func) const {
+		int stack[64];
+		int stackSize = 0;
+		stack[stackSize++] = 0;
+		while(stackSize > 0) {
+			const TriangleMeshNode& node = nodes[stack[--stackSize]];
+			if(node.max.x < min.x || node.min.x > max.x || node.max.y < min.y || node.min.y > max.y || node.max.z < min.z || node.min.z > max.z) continue;
+			if(node.isLeaf()) {
+				for(int i = node.start; i < node.start + node.count; i++) {
+					func(triangles[i]);
+				}
+			} else {
+				stack[stackSize++] = node.start;
+				stack[stackSize++] = static_cast<int>(&node - nodes.data()) + 1;
+			}
+		}
+	}
+
+	// only meaningful for closed meshes
+	virtual bool containsPoint(Vec3 point) const override;
+	virtual double getIntersectionDistance(Vec3 origin, Vec3 direction) const override;
+
+	virtual BoundingBox getBounds(const Rotation& referenceFrame, const DiagonalMat3& scale) const override;
+	virtual double getScaledMaxRadiusSq(DiagonalMat3 scale) const override;
+
+	// the mesh is not convex, this gives the furthest corner of its box, which GJK should never be run on
+	virtual Vec3f furthestInDirection(const Vec3f& direction) const override;
+
+	virtual Polyhedron asPolyhedron() const override;
+	virtual size_t getMemoryUsage() const override;
+
+	/*
+		Narrowphase between a triangle mesh and any convex shape
+		relativeTransform is the transform of other relative to the mesh, the result is local to the mesh, like intersectsTransformed
+	*/
+	std::optional<Intersection> intersectsTransformed(const DiagonalMat3& scale, const Shape& other, const CFrame& relativeTransform) const;
+};
+
+Shape TriangleMesh(const TriangleMeshShapeClass* mesh, double width, double height, double depth);
+// normalizes the mesh into a new TriangleMeshShapeClass, the resulting shape has the size of the original mesh
+Shape TriangleMesh(const Polyhedron& mesh);
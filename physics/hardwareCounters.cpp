@@ -0,0 +1,159 @@
+#include "hardwareCounters.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace HardwareCounters {
+const char* labels[]{
+	"Cycles",
+	"Instructions",
+	"L1D Misses",
+	"LLC Misses",
+	"Branch Misses"
+};
+
+bool enabled = false;
+static const char* unavailableReason = "Hardware counters are not enabled";
+
+#ifdef __linux__
+static int counterFds[static_cast<size_t>(HardwareCounter::COUNT)];
+// the position of each counter in a read of the group, -1 if it could not be opened
+static int groupIndices[static_cast<size_t>(HardwareCounter::COUNT)];
+static int groupFd = -1;
+static size_t openedCount = 0;
+
+static void setEventType(HardwareCounter counter, perf_event_attr& attr) {
+	switch(counter) {
+	case HardwareCounter::CYCLES:
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = PERF_COUNT_HW_CPU_CYCLES;
+		break;
+	case HardwareCounter::INSTRUCTIONS:
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+		break;
+	case HardwareCounter::L1D_MISSES:
+		attr.type = PERF_TYPE_HW_CACHE;
+		attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+		break;
+	case HardwareCounter::LLC_MISSES:
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = PERF_COUNT_HW_CACHE_MISSES;
+		break;
+	case HardwareCounter::BRANCH_MISSES:
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+		break;
+	default:
+		break;
+	}
+}
+
+static const char* reasonFor(int error) {
+	switch(error) {
+	case EACCES:
+	case EPERM:
+		return "Not permitted to open hardware counters, see /proc/sys/kernel/perf_event_paranoid";
+	case ENOENT:
+	case EOPNOTSUPP:
+		return "The CPU or hypervisor does not expose this hardware counter";
+	case ENOSYS:
+		return "The kernel does not support perf_event_open";
+	default:
+		return "perf_event_open failed";
+	}
+}
+
+bool enable() {
+	if(enabled) return true;
+	groupFd = -1;
+	openedCount = 0;
+	unavailableReason = nullptr;
+	for(size_t i = 0; i < static_cast<size_t>(HardwareCounter::COUNT); i++) {
+		perf_event_attr attr{};
+		attr.size = sizeof(perf_event_attr);
+		setEventType(static_cast<HardwareCounter>(i), attr);
+		// the whole group is started at once through the leader
+		attr.disabled = (groupFd == -1) ? 1 : 0;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		int fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, groupFd, 0));
+		counterFds[i] = fd;
+		if(fd == -1) {
+			groupIndices[i] = -1;
+			if(unavailableReason == nullptr) unavailableReason = reasonFor(errno);
+			continue;
+		}
+		if(groupFd == -1) groupFd = fd;
+		groupIndices[i] = static_cast<int>(openedCount++);
+	}
+	if(groupFd == -1) return false;
+
+	ioctl(groupFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	ioctl(groupFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	enabled = true;
+	return true;
+}
+
+void disable() {
+	if(!enabled) return;
+	for(size_t i = 0; i < static_cast<size_t>(HardwareCounter::COUNT); i++) {
+		if(counterFds[i] != -1) close(counterFds[i]);
+		counterFds[i] = -1;
+		groupIndices[i] = -1;
+	}
+	groupFd = -1;
+	enabled = false;
+	unavailableReason = "Hardware counters are not enabled";
+}
+
+bool isAvailable(HardwareCounter counter) {
+	return enabled && groupIndices[static_cast<size_t>(counter)] != -1;
+}
+
+HardwareCounterReading read() {
+	HardwareCounterReading result;
+	if(!enabled) return result;
+
+	// the number of counters, the time enabled and the time running, then the value of each counter
+	uint64_t buffer[3 + static_cast<size_t>(HardwareCounter::COUNT)];
+	if(::read(groupFd, buffer, sizeof(buffer)) < static_cast<ssize_t>(3 * sizeof(uint64_t))) return result;
+	uint64_t count = buffer[0];
+	result.timeEnabled = buffer[1];
+	result.timeRunning = buffer[2];
+
+	for(size_t i = 0; i < static_cast<size_t>(HardwareCounter::COUNT); i++) {
+		int index = groupIndices[i];
+		if(index == -1 || static_cast<uint64_t>(index) >= count) continue;
+		result.counts.values[i] = buffer[3 + index];
+	}
+	return result;
+}
+#else
+bool enable() {
+	unavailableReason = "Hardware counters are only supported on Linux";
+	return false;
+}
+
+void disable() {}
+
+bool isAvailable(HardwareCounter counter) {
+	return false;
+}
+
+HardwareCounterReading read() {
+	return HardwareCounterReading();
+}
+#endif
+
+const char* getUnavailableReason() {
+	return unavailableReason;
+}
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+enum class HardwareCounter {
+	CYCLES,
+	INSTRUCTIONS,
+	L1D_MISSES,
+	LLC_MISSES,
+	BRANCH_MISSES,
+	COUNT
+};
+
+struct HardwareCounterValues {
+	uint64_t values[static_cast<size_t>(HardwareCounter::COUNT)]{};
+
+	inline uint64_t& operator[](HardwareCounter counter) { return values[static_cast<size_t>(counter)]; }
+	inline uint64_t operator[](HardwareCounter counter) const { return values[static_cast<size_t>(counter)]; }
+
+	inline HardwareCounterValues& operator+=(const HardwareCounterValues& other) {
+		for(size_t i = 0; i < static_cast<size_t>(HardwareCounter::COUNT); i++) values[i] += other.values[i];
+		return *this;
+	}
+};
+
+// the raw counts as the kernel gives them, with the times needed to scale them when the counters were multiplexed
+struct HardwareCounterReading {
+	HardwareCounterValues counts;
+	// nanoseconds the counters were enabled and actually running, running is less than enabled while multiplexed
+	uint64_t timeEnabled = 0;
+	uint64_t timeRunning = 0;
+};
+
+/*
+	The counts between two readings, scaled to the time the counters were enabled in between
+	Only the raw counts are cumulative, scaled totals can drop when the scale changes, so the difference is scaled instead. 
+	Counts that did not grow give 0
+*/
+inline HardwareCounterValues countsBetween(const HardwareCounterReading& earlier, const HardwareCounterReading& later) {
+	HardwareCounterValues result;
+	uint64_t timeEnabled = (later.timeEnabled > earlier.timeEnabled) ? later.timeEnabled - earlier.timeEnabled : 0;
+	uint64_t timeRunning = (later.timeRunning > earlier.timeRunning) ? later.timeRunning - earlier.timeRunning : 0;
+	double scale = (timeRunning != 0 && timeRunning < timeEnabled) ? double(timeEnabled) / timeRunning : 1.0;
+	for(size_t i = 0; i < static_cast<size_t>(HardwareCounter::COUNT); i++) {
+		if(later.counts.values[i] <= earlier.counts.values[i]) continue;
+		uint64_t difference = later.counts.values[i] - earlier.counts.values[i];
+		result.values[i] = (scale == 1.0) ? difference : static_cast<uint64_t>(difference * scale);
+	}
+	return result;
+}
+
+/*
+	CPU performance counters of the calling thread, through perf_event_open on Linux
+	Counting is off until enable is called, and enable fails without side effects when the counters can't be opened:
+	on other platforms, without a PMU (most virtual machines) or when perf_event_paranoid doesn't allow it
+	Only user space is counted, so perf_event_paranoid 2 is enough
+	When the CPU has fewer counters than requested the kernel multiplexes them, countsBetween scales the counts of an interval to its full time
+*/
+namespace HardwareCounters {
+extern const char* labels[static_cast<size_t>(HardwareCounter::COUNT)];
+// use isEnabled
+extern bool enabled;
+
+// opens the counters for the calling thread, only that thread is counted. Returns false if no counter could be opened
+bool enable();
+void disable();
+
+inline bool isEnabled() { return enabled; }
+// some counters may be missing while others work, such as cache misses on CPUs without generic cache events
+bool isAvailable(HardwareCounter counter);
+// why enable failed, or why a counter is missing, nullptr if every counter works
+const char* getUnavailableReason();
+
+// the raw counts since enable, counters that are not available stay 0. Use countsBetween for the counts of an interval
+HardwareCounterReading read();
+};
@@ -0,0 +1,49 @@
+#include "latencyHistogram.h"
+
+#include <limits>
+#include <cmath>
+
+LatencyHistogram::LatencyHistogram() {
+	reset();
+}
+
+uint64_t LatencyHistogram::highestValueIn(size_t bucket) {
+	if(bucket < SUB_BUCKET_COUNT) return bucket;
+	size_t shift = bucket / SUB_BUCKET_COUNT - 1;
+	uint64_t subBucket = bucket % SUB_BUCKET_COUNT + SUB_BUCKET_COUNT;
+	return ((subBucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::reset() {
+	for(uint64_t& count : counts) count = 0;
+	totalCount = 0;
+	totalValue = 0;
+	minValue = std::numeric_limits<uint64_t>::max();
+	maxValue = 0;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+	for(size_t i = 0; i < BUCKET_COUNT; i++) counts[i] += other.counts[i];
+	totalCount += other.totalCount;
+	totalValue += other.totalValue;
+	if(other.minValue < minValue) minValue = other.minValue;
+	if(other.maxValue > maxValue) maxValue = other.maxValue;
+}
+
+uint64_t LatencyHistogram::getPercentile(double percentile) const {
+	if(totalCount == 0) return 0;
+	if(percentile <= 0.0) return getMin();
+	uint64_t rank = static_cast<uint64_t>(std::ceil(percentile / 100.0 * totalCount));
+	if(rank < 1) rank = 1;
+	if(rank >= totalCount) return maxValue;
+
+	uint64_t seen = 0;
+	for(size_t i = 0; i < BUCKET_COUNT; i++) {
+		seen += counts[i];
+		if(seen >= rank) {
+			uint64_t value = highestValueIn(i);
+			return (value < maxValue) ? value : maxValue;
+		}
+	}
+	return maxValue;
+}
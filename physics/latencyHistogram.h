@@ -0,0 +1,78 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/*
+	A histogram of durations in nanoseconds with logarithmic buckets, like an HDR histogram
+	Values below 2^SUB_BUCKET_BITS are counted exactly, larger values fall into one of 2^SUB_BUCKET_BITS buckets per power of two,
+	so any percentile is within about 3% of the true value
+	Recording a value is a couple of bit operations and an increment, no allocation or search
+	Histograms are plain values, copy one to take a snapshot and merge snapshots to combine them
+*/
+class LatencyHistogram {
+public:
+	static constexpr int SUB_BUCKET_BITS = 5;
+	static constexpr uint64_t SUB_BUCKET_COUNT = uint64_t(1) << SUB_BUCKET_BITS;
+	// values of 2^MAX_VALUE_BITS nanoseconds (about 18 minutes) or more are counted in the last bucket
+	static constexpr int MAX_VALUE_BITS = 40;
+	static constexpr size_t BUCKET_COUNT = SUB_BUCKET_COUNT + (MAX_VALUE_BITS - SUB_BUCKET_BITS) * SUB_BUCKET_COUNT;
+
+private:
+	uint64_t counts[BUCKET_COUNT];
+	uint64_t totalCount;
+	uint64_t totalValue;
+	uint64_t minValue;
+	uint64_t maxValue;
+
+	static inline int highestBit(uint64_t value) {
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanReverse64(&index, value);
+		return static_cast<int>(index);
+#else
+		return 63 - __builtin_clzll(value);
+#endif
+	}
+
+	static inline size_t bucketOf(uint64_t value) {
+		if(value < SUB_BUCKET_COUNT) return static_cast<size_t>(value);
+		int shift = highestBit(value) - SUB_BUCKET_BITS;
+		if(shift >= MAX_VALUE_BITS - SUB_BUCKET_BITS) return BUCKET_COUNT - 1;
+		return static_cast<size_t>(SUB_BUCKET_COUNT * (shift + 1) + ((value >> shift) - SUB_BUCKET_COUNT));
+	}
+
+	// the largest value that is counted in the given bucket
+	static uint64_t highestValueIn(size_t bucket);
+
+public:
+	LatencyHistogram();
+
+	inline void record(uint64_t nanos) {
+		counts[bucketOf(nanos)]++;
+		totalCount++;
+		totalValue += nanos;
+		if(nanos < minValue) minValue = nanos;
+		if(nanos > maxValue) maxValue = nanos;
+	}
+	inline void record(std::chrono::nanoseconds duration) {
+		record(static_cast<uint64_t>(duration.count() > 0 ? duration.count() : 0));
+	}
+
+	void reset();
+	// adds all values recorded in other to this histogram
+	void merge(const LatencyHistogram& other);
+
+	// the value below which the given percentage of the recorded values lie, percentile is between 0 and 100
+	uint64_t getPercentile(double percentile) const;
+
+	inline uint64_t getCount() const { return totalCount; }
+	inline uint64_t getMin() const { return (totalCount != 0) ? minValue : 0; }
+	inline uint64_t getMax() const { return maxValue; }
+	inline double getMean() const { return (totalCount != 0) ? double(totalValue) / totalCount : 0.0; }
+};
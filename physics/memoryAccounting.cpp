@@ -0,0 +1,42 @@
+#include "memoryAccounting.h"
+
+#include <atomic>
+
+namespace MemoryAccounting {
+const char* labels[]{
+	"Object Trees",
+	"Terrain Trees",
+	"Shared Shapes",
+	"Unique Shapes",
+	"Parts",
+	"Physicals",
+	"Constraints",
+	"Broadphase",
+	"Colissions",
+	"Computation Buffers",
+	"Constraint Matrices",
+	"Serialization"
+};
+
+static std::atomic<size_t> transientPeaks[static_cast<size_t>(MemoryCategory::COUNT)];
+
+void recordTransient(MemoryCategory category, size_t bytes) {
+	std::atomic<size_t>& peak = transientPeaks[static_cast<size_t>(category)];
+	size_t current = peak.load(std::memory_order_relaxed);
+	while(bytes > current && !peak.compare_exchange_weak(current, bytes, std::memory_order_relaxed));
+}
+
+MemoryUsage getTransientPeaks() {
+	MemoryUsage result;
+	for(size_t i = 0; i < static_cast<size_t>(MemoryCategory::COUNT); i++) {
+		result.bytes[i] = transientPeaks[i].load(std::memory_order_relaxed);
+	}
+	return result;
+}
+
+void resetTransientPeaks() {
+	for(std::atomic<size_t>& peak : transientPeaks) {
+		peak.store(0, std::memory_order_relaxed);
+	}
+}
+};
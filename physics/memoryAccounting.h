@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+
+enum class MemoryCategory {
+	OBJECT_TREES,
+	TERRAIN_TREES,
+	SHARED_SHAPES,
+	UNIQUE_SHAPES,
+	PARTS,
+	PHYSICALS,
+	CONSTRAINTS,
+	BROADPHASE,
+	COLISSIONS,
+	COMPUTATION_BUFFERS,
+	// transient, only the peak since the last resetTransientPeaks is known
+	CONSTRAINT_MATRICES,
+	SERIALIZATION,
+	COUNT
+};
+
+struct MemoryUsage {
+	size_t bytes[static_cast<size_t>(MemoryCategory::COUNT)]{};
+
+	inline size_t& operator[](MemoryCategory category) { return bytes[static_cast<size_t>(category)]; }
+	inline size_t operator[](MemoryCategory category) const { return bytes[static_cast<size_t>(category)]; }
+
+	inline size_t total() const {
+		size_t result = 0;
+		for(size_t b : bytes) result += b;
+		return result;
+	}
+
+	// keeps the largest of each category, to track high-water marks
+	inline void keepMax(const MemoryUsage& other) {
+		for(size_t i = 0; i < static_cast<size_t>(MemoryCategory::COUNT); i++) {
+			if(other.bytes[i] > bytes[i]) bytes[i] = other.bytes[i];
+		}
+	}
+};
+
+/*
+	Byte accounting of the physics engine, to find where the memory of a big world goes
+
+	Long lived structures are counted by walking them, see WorldPrototype::getMemoryUsage.
+	Scratch memory only exists while it is used, so the code using it reports its size with recordTransient,
+	and the largest size since the last resetTransientPeaks is kept. Reset every tick to get per tick high-water marks.
+*/
+namespace MemoryAccounting {
+extern const char* labels[static_cast<size_t>(MemoryCategory::COUNT)];
+
+// may be called from any thread
+void recordTransient(MemoryCategory category, size_t bytes);
+MemoryUsage getTransientPeaks();
+void resetTransientPeaks();
+};
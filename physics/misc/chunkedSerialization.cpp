@@ -0,0 +1,664 @@
+#include "chunkedSerialization.h"
+
+#include <sstream>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <algorithm>
+
+#include "serialization.h"
+#include "../geometry/polyhedron.h"
+#include "../geometry/normalizedPolyhedron.h"
+#include "../geometry/polyhedronInternals.h"
+#include "../geometry/shape.h"
+#include "../constraints/hardConstraint.h"
+#include "../constraints/hardPhysicalConnection.h"
+#include "../memoryAccounting.h"
+
+static_assert(std::is_trivially_copyable<ChunkedFileHeader>::value, "Chunk records must be trivially copyable");
+static_assert(std::is_trivially_copyable<ChunkDirectoryEntry>::value, "Chunk records must be trivially copyable");
+static_assert(std::is_trivially_copyable<ShapeTableEntry>::value, "Chunk records must be trivially copyable");
+static_assert(std::is_trivially_copyable<ChunkedPartRecord>::value, "Chunk records must be trivially copyable");
+static_assert(std::is_trivially_copyable<ChunkedTerrainPartRecord>::value, "Chunk records must be trivially copyable");
+static_assert(std::is_trivially_copyable<ChunkedPhysicalRecord>::value, "Chunk records must be trivially copyable");
+static_assert(std::is_trivially_copyable<PhysicalsChunkHeader>::value, "Chunk records must be trivially copyable");
+
+static const char chunkedFormatMagic[8]{'P', '3', 'D', 'W', 'O', 'R', 'L', 'D'};
+static const ShapeClass* builtinKnownShapeClasses[]{boxClass, sphereClass, cylinderClass};
+
+#define POLYHEDRON_DATA_ALIGNMENT 32
+#define RECORD_ALIGNMENT 16
+
+#pragma region buffer helpers
+
+static size_t alignUp(size_t value, size_t alignment) {
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+static void padTo(std::vector<char>& buf, size_t alignment) {
+	buf.resize(alignUp(buf.size(), alignment), 0);
+}
+
+static void appendBytes(std::vector<char>& buf, const void* data, size_t size) {
+	const char* bytes = static_cast<const char*>(data);
+	buf.insert(buf.end(), bytes, bytes + size);
+}
+
+template<typename T>
+static void appendRecords(std::vector<char>& buf, const T* records, size_t count) {
+	appendBytes(buf, records, sizeof(T) * count);
+}
+
+// writes the vectors in the same parallel layout as createAndFillParallelVecBuf, including the padding of the final block
+template<typename T, typename Item, typename Getter>
+static void appendParallelBuffer(std::vector<char>& buf, size_t count, const Getter& get) {
+	size_t offset = getOffset(count);
+	std::vector<T> parallel(offset * 3);
+	for(size_t i = 0; i < count; i++) {
+		Item item = get(i);
+		parallel[i] = item[0];
+		parallel[i + offset] = item[1];
+		parallel[i + 2 * offset] = item[2];
+	}
+	fixFinalBlock(parallel.data(), count);
+	appendRecords(buf, parallel.data(), parallel.size());
+}
+
+#pragma endregion
+
+#pragma region serialization
+
+ChunkedSerializationSession::ChunkedSerializationSession(const std::vector<const ShapeClass*>& knownShapeClasses, size_t itemsPerChunk) :
+	knownShapeClasses(std::begin(builtinKnownShapeClasses), std::end(builtinKnownShapeClasses)), itemsPerChunk(itemsPerChunk) {
+	this->knownShapeClasses.insert(this->knownShapeClasses.end(), knownShapeClasses.begin(), knownShapeClasses.end());
+}
+
+uint32_t ChunkedSerializationSession::getShapeIndex(const ShapeClass* shapeClass) {
+	auto found = shapeIndices.find(shapeClass);
+	if(found != shapeIndices.end()) return (*found).second;
+
+	uint32_t newIndex = static_cast<uint32_t>(shapeTable.size());
+	shapeTable.push_back(shapeClass);
+	shapeIndices.emplace(shapeClass, newIndex);
+	return newIndex;
+}
+
+ChunkedPartRecord ChunkedSerializationSession::makePartRecord(const Part& part, const CFrame& attachment) {
+	ChunkedPartRecord record{};
+	record.attachment = attachment;
+	record.dimensions = Vec3(part.hitbox.getWidth(), part.hitbox.getHeight(), part.hitbox.getDepth());
+	record.properties = part.properties;
+	record.shapeIndex = getShapeIndex(part.hitbox.baseShape);
+	record.layer = static_cast<uint32_t>(part.layer);
+	return record;
+}
+
+std::vector<char> ChunkedSerializationSession::buildShapeTableChunk() const {
+	std::vector<ShapeTableEntry> entries;
+	entries.reserve(shapeTable.size());
+	std::vector<char> payload;
+
+	size_t payloadStart = alignUp(sizeof(ShapeTableEntry) * shapeTable.size(), POLYHEDRON_DATA_ALIGNMENT);
+
+	for(const ShapeClass* shapeClass : shapeTable) {
+		ShapeTableEntry entry{ShapeTableEntryKind::KNOWN, 0, 0, 0, 0, 0, Vec3(0.0, 0.0, 0.0), DiagonalMat3::IDENTITY(), 0.0, Vec3(0.0, 0.0, 0.0), ScalableInertialMatrix(Vec3(0.0, 0.0, 0.0), Vec3(0.0, 0.0, 0.0))};
+
+		auto known = std::find(knownShapeClasses.begin(), knownShapeClasses.end(), shapeClass);
+		if(known != knownShapeClasses.end()) {
+			entry.builtinIndex = static_cast<uint32_t>(known - knownShapeClasses.begin());
+			entries.push_back(entry);
+			continue;
+		}
+
+		if(const NormalizedPolyhedron* poly = dynamic_cast<const NormalizedPolyhedron*>(shapeClass)) {
+			padTo(payload, POLYHEDRON_DATA_ALIGNMENT);
+			size_t start = payload.size();
+			appendParallelBuffer<float, Vec3f>(payload, poly->vertexCount, [poly](size_t i) {return (*poly)[static_cast<int>(i)]; });
+			appendParallelBuffer<int, Triangle>(payload, poly->triangleCount, [poly](size_t i) {return poly->getTriangle(static_cast<int>(i)); });
+
+			ShapeTableEntry polyEntry{ShapeTableEntryKind::POLYHEDRON, 0, poly->vertexCount, poly->triangleCount, payloadStart + start, payload.size() - start,
+				poly->originalCenter, poly->originalScale, poly->volume, poly->centerOfMass, poly->inertia};
+			entries.push_back(polyEntry);
+		} else {
+			std::ostringstream stream;
+			dynamicShapeClassSerializer.serialize(*shapeClass, stream);
+			std::string serialized = stream.str();
+
+			entry.kind = ShapeTableEntryKind::DYNAMIC;
+			entry.dataOffset = payloadStart + payload.size();
+			entry.dataSize = serialized.size();
+			appendBytes(payload, serialized.data(), serialized.size());
+			entries.push_back(entry);
+		}
+	}
+
+	std::vector<char> chunk;
+	chunk.reserve(payloadStart + payload.size());
+	appendRecords(chunk, entries.data(), entries.size());
+	padTo(chunk, POLYHEDRON_DATA_ALIGNMENT);
+	appendBytes(chunk, payload.data(), payload.size());
+	return chunk;
+}
+
+std::vector<char> ChunkedSerializationSession::buildExternalForcesChunk(const WorldPrototype& world) const {
+	std::ostringstream stream;
+	for(ExternalForce* force : world.externalForces) {
+		dynamicExternalForceSerializer.serialize(*force, stream);
+	}
+	std::string serialized = stream.str();
+	return std::vector<char>(serialized.begin(), serialized.end());
+}
+
+std::vector<char> ChunkedSerializationSession::buildLayersChunk(const WorldPrototype& world) const {
+	std::vector<uint8_t> description = describeLayers(world);
+	return std::vector<char>(description.begin(), description.end());
+}
+
+struct PhysicalsChunkBuilder {
+	std::vector<ChunkedPhysicalRecord> physicals;
+	std::vector<ChunkedPartRecord> parts;
+	std::ostringstream constraintData;
+};
+
+std::vector<char> ChunkedSerializationSession::buildPhysicalsChunk(const MotorizedPhysical* const* motorizedPhysicals, size_t count) {
+	PhysicalsChunkBuilder builder;
+
+	struct Recursor {
+		ChunkedSerializationSession& session;
+		PhysicalsChunkBuilder& builder;
+
+		size_t addPhysical(const Physical& phys, uint32_t parentIndex) {
+			size_t index = builder.physicals.size();
+			ChunkedPhysicalRecord record{};
+			record.parentIndex = parentIndex;
+			record.childCount = static_cast<uint32_t>(phys.childPhysicals.size());
+			record.firstPartIndex = static_cast<uint32_t>(builder.parts.size());
+			record.partCount = static_cast<uint32_t>(phys.rigidBody.getPartCount());
+
+			builder.parts.push_back(session.makePartRecord(*phys.rigidBody.mainPart, CFrame()));
+			for(const AttachedPart& atPart : phys.rigidBody.parts) {
+				builder.parts.push_back(session.makePartRecord(*atPart.part, atPart.attachment));
+			}
+			builder.physicals.push_back(record);
+
+			for(const ConnectedPhysical& child : phys.childPhysicals) {
+				size_t childIndex = addPhysical(child, static_cast<uint32_t>(index));
+				ChunkedPhysicalRecord& childRecord = builder.physicals[childIndex];
+				const HardPhysicalConnection& connection = child.connectionToParent;
+				childRecord.attachOnChild = connection.attachOnChild;
+				childRecord.attachOnParent = connection.attachOnParent;
+
+				std::streamoff start = builder.constraintData.tellp();
+				dynamicHardConstraintSerializer.serialize(*connection.constraintWithParent, builder.constraintData);
+				childRecord.constraintOffset = static_cast<uint64_t>(start);
+				childRecord.constraintSize = static_cast<uint64_t>(builder.constraintData.tellp() - start);
+			}
+			return index;
+		}
+	};
+	Recursor recursor{*this, builder};
+
+	for(size_t i = 0; i < count; i++) {
+		const MotorizedPhysical& phys = *motorizedPhysicals[i];
+		size_t index = recursor.addPhysical(phys, CHUNK_NO_PARENT);
+		builder.physicals[index].motionOfCenterOfMass = phys.motionOfCenterOfMass;
+		builder.physicals[index].cframe = phys.getMainPart()->getCFrame();
+	}
+
+	std::string constraintData = builder.constraintData.str();
+
+	PhysicalsChunkHeader chunkHeader{};
+	chunkHeader.motorizedPhysicalCount = static_cast<uint32_t>(count);
+	chunkHeader.physicalCount = static_cast<uint32_t>(builder.physicals.size());
+	chunkHeader.partCount = static_cast<uint32_t>(builder.parts.size());
+	chunkHeader.physicalsOffset = alignUp(sizeof(PhysicalsChunkHeader), RECORD_ALIGNMENT);
+	chunkHeader.partsOffset = alignUp(chunkHeader.physicalsOffset + sizeof(ChunkedPhysicalRecord) * builder.physicals.size(), RECORD_ALIGNMENT);
+	chunkHeader.constraintDataOffset = alignUp(chunkHeader.partsOffset + sizeof(ChunkedPartRecord) * builder.parts.size(), RECORD_ALIGNMENT);
+	chunkHeader.constraintDataSize = constraintData.size();
+
+	std::vector<char> chunk;
+	chunk.reserve(chunkHeader.constraintDataOffset + constraintData.size());
+	appendRecords(chunk, &chunkHeader, 1);
+	padTo(chunk, RECORD_ALIGNMENT);
+	appendRecords(chunk, builder.physicals.data(), builder.physicals.size());
+	padTo(chunk, RECORD_ALIGNMENT);
+	appendRecords(chunk, builder.parts.data(), builder.parts.size());
+	padTo(chunk, RECORD_ALIGNMENT);
+	appendBytes(chunk, constraintData.data(), constraintData.size());
+	return chunk;
+}
+
+std::vector<char> ChunkedSerializationSession::buildTerrainChunk(const Part* const* parts, size_t count) {
+	std::vector<ChunkedTerrainPartRecord> records(count);
+	for(size_t i = 0; i < count; i++) {
+		records[i].cframe = parts[i]->getCFrame();
+		records[i].part = makePartRecord(*parts[i], CFrame());
+	}
+	std::vector<char> chunk;
+	appendRecords(chunk, records.data(), records.size());
+	return chunk;
+}
+
+void ChunkedSerializationSession::serializeWorld(const WorldPrototype& world, std::ostream& ostream) {
+	shapeTable.clear();
+	shapeIndices.clear();
+
+	std::vector<ChunkDirectoryEntry> directory;
+	std::vector<std::vector<char>> chunks;
+
+	// the shape table is filled while building the other chunks, but must come first in the file
+	directory.push_back(ChunkDirectoryEntry{ChunkType::SHAPE_TABLE, 0, 0, 0});
+	chunks.emplace_back();
+
+	directory.push_back(ChunkDirectoryEntry{ChunkType::EXTERNAL_FORCES, static_cast<uint32_t>(world.externalForces.size()), 0, 0});
+	chunks.push_back(buildExternalForcesChunk(world));
+
+	directory.push_back(ChunkDirectoryEntry{ChunkType::LAYERS, static_cast<uint32_t>(world.getLayerCount()), 0, 0});
+	chunks.push_back(buildLayersChunk(world));
+
+	for(size_t start = 0; start < world.physicals.size(); start += itemsPerChunk) {
+		size_t count = std::min(itemsPerChunk, world.physicals.size() - start);
+		directory.push_back(ChunkDirectoryEntry{ChunkType::PHYSICALS, static_cast<uint32_t>(count), 0, 0});
+		chunks.push_back(buildPhysicalsChunk(world.physicals.data() + start, count));
+	}
+
+	std::vector<const Part*> terrainParts;
+	for(const Part& p : world.iterParts(TERRAIN_PARTS)) {
+		terrainParts.push_back(&p);
+	}
+	for(size_t start = 0; start < terrainParts.size(); start += itemsPerChunk) {
+		size_t count = std::min(itemsPerChunk, terrainParts.size() - start);
+		directory.push_back(ChunkDirectoryEntry{ChunkType::TERRAIN, static_cast<uint32_t>(count), 0, 0});
+		chunks.push_back(buildTerrainChunk(terrainParts.data() + start, count));
+	}
+
+	directory[0].itemCount = static_cast<uint32_t>(shapeTable.size());
+	chunks[0] = buildShapeTableChunk();
+
+	ChunkedFileHeader fileHeader{};
+	std::memcpy(fileHeader.magic, chunkedFormatMagic, sizeof(chunkedFormatMagic));
+	fileHeader.versionID = CHUNKED_FORMAT_VERSION_ID;
+	fileHeader.chunkCount = static_cast<uint32_t>(chunks.size());
+	fileHeader.age = world.age;
+	fileHeader.physicalCount = world.physicals.size();
+	fileHeader.terrainPartCount = terrainParts.size();
+
+	size_t curOffset = alignUp(sizeof(ChunkedFileHeader) + sizeof(ChunkDirectoryEntry) * directory.size(), CHUNK_ALIGNMENT);
+	for(size_t i = 0; i < chunks.size(); i++) {
+		directory[i].offset = curOffset;
+		directory[i].size = chunks[i].size();
+		curOffset = alignUp(curOffset + chunks[i].size(), CHUNK_ALIGNMENT);
+	}
+
+	std::vector<char> prefix;
+	appendRecords(prefix, &fileHeader, 1);
+	appendRecords(prefix, directory.data(), directory.size());
+	padTo(prefix, CHUNK_ALIGNMENT);
+	::serialize(prefix.data(), prefix.size(), ostream);
+
+	size_t scratchBytes = prefix.capacity() + chunks.capacity() * sizeof(std::vector<char>) + terrainParts.capacity() * sizeof(const Part*);
+	for(std::vector<char>& chunk : chunks) {
+		padTo(chunk, CHUNK_ALIGNMENT);
+		::serialize(chunk.data(), chunk.size(), ostream);
+		scratchBytes += chunk.capacity();
+	}
+	MemoryAccounting::recordTransient(MemoryCategory::SERIALIZATION, scratchBytes);
+}
+
+#pragma endregion
+
+#pragma region deserialization
+
+// offset and size come from the file, so the check must not overflow
+static bool isInRange(uint64_t offset, uint64_t size, uint64_t available) {
+	return offset <= available && size <= available - offset;
+}
+
+static void checkInChunk(size_t chunkIndex, uint64_t chunkSize, uint64_t offset, uint64_t size, const char* what) {
+	if(!isInRange(offset, size, chunkSize)) {
+		throw SerializationException(std::string(what) + " in chunk " + std::to_string(chunkIndex) + " lies outside of the chunk!");
+	}
+}
+
+ChunkedDeSerializationSession::ChunkedDeSerializationSession(const char* data, size_t size, const std::vector<const ShapeClass*>& knownShapeClasses) :
+	data(data), size(size), header(reinterpret_cast<const ChunkedFileHeader*>(data)), directory(reinterpret_cast<const ChunkDirectoryEntry*>(data + sizeof(ChunkedFileHeader))),
+	knownShapeClasses(std::begin(builtinKnownShapeClasses), std::end(builtinKnownShapeClasses)) {
+
+	this->knownShapeClasses.insert(this->knownShapeClasses.end(), knownShapeClasses.begin(), knownShapeClasses.end());
+
+	if(size < sizeof(ChunkedFileHeader) || std::memcmp(header->magic, chunkedFormatMagic, sizeof(chunkedFormatMagic)) != 0) {
+		throw SerializationException("This is not a chunked world file!");
+	}
+	if(header->versionID != CHUNKED_FORMAT_VERSION_ID) {
+		throw SerializationException(
+			"This chunked world format version is not supported! Current " +
+			std::to_string(CHUNKED_FORMAT_VERSION_ID) +
+			" version from file: " +
+			std::to_string(header->versionID)
+		);
+	}
+	if(sizeof(ChunkedFileHeader) + sizeof(ChunkDirectoryEntry) * header->chunkCount > size) {
+		throw SerializationException("Chunk directory is truncated!");
+	}
+	for(size_t i = 0; i < header->chunkCount; i++) {
+		if(!isInRange(directory[i].offset, directory[i].size, size)) {
+			throw SerializationException("Chunk " + std::to_string(i) + " is truncated!");
+		}
+	}
+
+	for(size_t i = 0; i < header->chunkCount; i++) {
+		if(directory[i].type == ChunkType::SHAPE_TABLE) {
+			decodeShapeTable(i);
+		}
+	}
+}
+
+const char* ChunkedDeSerializationSession::getChunkData(size_t chunkIndex, ChunkType expectedType) const {
+	if(chunkIndex >= header->chunkCount || directory[chunkIndex].type != expectedType) {
+		throw SerializationException("Chunk " + std::to_string(chunkIndex) + " does not exist or is not of the requested type!");
+	}
+	return data + directory[chunkIndex].offset;
+}
+
+void ChunkedDeSerializationSession::decodeShapeTable(size_t chunkIndex) {
+	const char* chunk = getChunkData(chunkIndex, ChunkType::SHAPE_TABLE);
+	const ShapeTableEntry* entries = reinterpret_cast<const ShapeTableEntry*>(chunk);
+	size_t entryCount = directory[chunkIndex].itemCount;
+	uint64_t chunkSize = directory[chunkIndex].size;
+	checkInChunk(chunkIndex, chunkSize, 0, sizeof(ShapeTableEntry) * entryCount, "Shape table");
+
+	shapeTable.reserve(shapeTable.size() + entryCount);
+	for(size_t i = 0; i < entryCount; i++) {
+		const ShapeTableEntry& entry = entries[i];
+		switch(entry.kind) {
+		case ShapeTableEntryKind::KNOWN:
+			if(entry.builtinIndex >= knownShapeClasses.size()) {
+				throw SerializationException("There is no known ShapeClass with index " + std::to_string(entry.builtinIndex));
+			}
+			shapeTable.push_back(knownShapeClasses[entry.builtinIndex]);
+			break;
+		case ShapeTableEntryKind::POLYHEDRON: {
+			if(entry.vertexCount < 0 || entry.triangleCount < 0) {
+				throw SerializationException("Polyhedron " + std::to_string(i) + " has a negative vertex or triangle count!");
+			}
+			size_t vertexBufSize = getOffset(entry.vertexCount) * 3;
+			size_t triangleBufSize = getOffset(entry.triangleCount) * 3;
+			checkInChunk(chunkIndex, chunkSize, entry.dataOffset, vertexBufSize * sizeof(float) + triangleBufSize * sizeof(int), "Polyhedron data");
+			const char* vertexData = chunk + entry.dataOffset;
+			const char* triangleData = vertexData + vertexBufSize * sizeof(float);
+
+			UniqueAlignedPointer<float> vertices;
+			UniqueAlignedPointer<int> triangles;
+			if(reinterpret_cast<uintptr_t>(vertexData) % POLYHEDRON_DATA_ALIGNMENT == 0) {
+				// zero copy, the polyhedron reads straight from the given memory
+				vertices = UniqueAlignedPointer<float>::borrow(const_cast<float*>(reinterpret_cast<const float*>(vertexData)));
+				triangles = UniqueAlignedPointer<int>::borrow(const_cast<int*>(reinterpret_cast<const int*>(triangleData)));
+			} else {
+				vertices = UniqueAlignedPointer<float>(vertexBufSize, POLYHEDRON_DATA_ALIGNMENT);
+				triangles = UniqueAlignedPointer<int>(triangleBufSize, POLYHEDRON_DATA_ALIGNMENT);
+				std::memcpy(vertices.get(), vertexData, vertexBufSize * sizeof(float));
+				std::memcpy(triangles.get(), triangleData, triangleBufSize * sizeof(int));
+			}
+
+			Polyhedron poly(std::move(vertices), std::move(triangles), entry.vertexCount, entry.triangleCount);
+			NormalizedPolyhedron* normalized = new NormalizedPolyhedron(std::move(poly), entry.originalCenter, entry.originalScale, entry.volume, entry.centerOfMass, entry.inertia);
+			ownedShapeClasses.emplace_back(normalized);
+			shapeTable.push_back(normalized);
+			break;
+		}
+		case ShapeTableEntryKind::DYNAMIC: {
+			checkInChunk(chunkIndex, chunkSize, entry.dataOffset, entry.dataSize, "ShapeClass data");
+			std::istringstream stream(std::string(chunk + entry.dataOffset, entry.dataSize));
+			ShapeClass* shapeClass = dynamicShapeClassSerializer.deserialize(stream);
+			ownedShapeClasses.emplace_back(shapeClass);
+			shapeTable.push_back(shapeClass);
+			break;
+		}
+		default:
+			throw SerializationException("Invalid shape table entry kind " + std::to_string(static_cast<uint32_t>(entry.kind)));
+		}
+	}
+}
+
+Part* ChunkedDeSerializationSession::createPart(Part&& partPhysicalData) const {
+	return new Part(std::move(partPhysicalData));
+}
+
+Part* ChunkedDeSerializationSession::decodePart(const ChunkedPartRecord& record, const GlobalCFrame& cframe) const {
+	if(record.shapeIndex >= shapeTable.size()) {
+		throw SerializationException("Invalid shape index " + std::to_string(record.shapeIndex));
+	}
+	Shape shape(shapeTable[record.shapeIndex], record.dimensions.x, record.dimensions.y, record.dimensions.z);
+	Part* result = createPart(Part(shape, cframe, record.properties));
+	// the cframe is not carried over by Part's move constructor
+	result->setCFrame(cframe);
+	result->layer = static_cast<int>(record.layer);
+	return result;
+}
+
+// a decoding error leaves parts and physicals behind that no world owns yet, these free them before the error is passed on
+static void deleteDetachedParts(Physical& phys) {
+	for(Part& part : phys.rigidBody) {
+		// the physical is deleted along with its parts, so they don't need to detach from it
+		part.parent = nullptr;
+		delete &part;
+	}
+	for(ConnectedPhysical& child : phys.childPhysicals) {
+		deleteDetachedParts(child);
+	}
+}
+
+static void deleteDecodedPhysical(MotorizedPhysical* phys) {
+	deleteDetachedParts(*phys);
+	delete phys;
+}
+
+RigidBody ChunkedDeSerializationSession::decodeRigidBody(const ChunkedPartRecord* parts, const ChunkedPhysicalRecord& record) const {
+	RigidBody result(decodePart(parts[record.firstPartIndex], GlobalCFrame()));
+	try {
+		result.parts.reserve(record.partCount - 1);
+		for(uint32_t i = 1; i < record.partCount; i++) {
+			const ChunkedPartRecord& partRecord = parts[record.firstPartIndex + i];
+			result.parts.push_back(AttachedPart{partRecord.attachment, decodePart(partRecord, GlobalCFrame())});
+		}
+	} catch(...) {
+		for(Part& part : result) {
+			delete &part;
+		}
+		throw;
+	}
+	result.refreshWithNewParts();
+	return result;
+}
+
+size_t ChunkedDeSerializationSession::decodeChildPhysicals(Physical& parent, const char* chunk, const PhysicalsChunkHeader& chunkHeader, size_t parentIndex) const {
+	const ChunkedPhysicalRecord* physicals = reinterpret_cast<const ChunkedPhysicalRecord*>(chunk + chunkHeader.physicalsOffset);
+	const ChunkedPartRecord* parts = reinterpret_cast<const ChunkedPartRecord*>(chunk + chunkHeader.partsOffset);
+	const char* constraintData = chunk + chunkHeader.constraintDataOffset;
+
+	uint32_t childCount = physicals[parentIndex].childCount;
+	size_t nextIndex = parentIndex + 1;
+	parent.childPhysicals.reserve(childCount);
+	for(uint32_t i = 0; i < childCount; i++) {
+		if(nextIndex >= chunkHeader.physicalCount) {
+			throw SerializationException("Physical " + std::to_string(parentIndex) + " has more children than there are physicals!");
+		}
+		const ChunkedPhysicalRecord& record = physicals[nextIndex];
+		if(record.parentIndex != parentIndex) {
+			throw SerializationException("Physical " + std::to_string(nextIndex) + " is not stored after its parent!");
+		}
+
+		std::istringstream constraintStream(std::string(constraintData + record.constraintOffset, record.constraintSize));
+		HardConstraint* constraint = dynamicHardConstraintSerializer.deserialize(constraintStream);
+		HardPhysicalConnection connection(std::unique_ptr<HardConstraint>(constraint), record.attachOnChild, record.attachOnParent);
+
+		parent.childPhysicals.push_back(ConnectedPhysical(decodeRigidBody(parts, record), &parent, std::move(connection)));
+		nextIndex = decodeChildPhysicals(parent.childPhysicals.back(), chunk, chunkHeader, nextIndex);
+	}
+	return nextIndex;
+}
+
+std::vector<ExternalForce*> ChunkedDeSerializationSession::decodeExternalForcesChunk(size_t chunkIndex) const {
+	const char* chunk = getChunkData(chunkIndex, ChunkType::EXTERNAL_FORCES);
+	std::istringstream stream(std::string(chunk, directory[chunkIndex].size));
+
+	std::vector<ExternalForce*> result;
+	result.reserve(directory[chunkIndex].itemCount);
+	for(uint32_t i = 0; i < directory[chunkIndex].itemCount; i++) {
+		result.push_back(dynamicExternalForceSerializer.deserialize(stream));
+	}
+	return result;
+}
+
+void ChunkedDeSerializationSession::decodeLayersChunk(size_t chunkIndex, WorldPrototype& world) const {
+	const char* chunk = getChunkData(chunkIndex, ChunkType::LAYERS);
+	size_t layerCount = directory[chunkIndex].itemCount;
+	if(layerCount > MAX_LAYERS) {
+		throw SerializationException("A world can have at most " + std::to_string(MAX_LAYERS) + " layers, not " + std::to_string(layerCount));
+	}
+	checkInChunk(chunkIndex, directory[chunkIndex].size, 0, getLayerDescriptionSize(layerCount), "Layer description");
+	restoreLayers(world, reinterpret_cast<const uint8_t*>(chunk), layerCount);
+}
+
+std::vector<MotorizedPhysical*> ChunkedDeSerializationSession::decodePhysicalsChunk(size_t chunkIndex) const {
+	const char* chunk = getChunkData(chunkIndex, ChunkType::PHYSICALS);
+	uint64_t chunkSize = directory[chunkIndex].size;
+	checkInChunk(chunkIndex, chunkSize, 0, sizeof(PhysicalsChunkHeader), "Physicals chunk header");
+	const PhysicalsChunkHeader& chunkHeader = *reinterpret_cast<const PhysicalsChunkHeader*>(chunk);
+	checkInChunk(chunkIndex, chunkSize, chunkHeader.physicalsOffset, sizeof(ChunkedPhysicalRecord) * uint64_t(chunkHeader.physicalCount), "Physical records");
+	checkInChunk(chunkIndex, chunkSize, chunkHeader.partsOffset, sizeof(ChunkedPartRecord) * uint64_t(chunkHeader.partCount), "Part records");
+	checkInChunk(chunkIndex, chunkSize, chunkHeader.constraintDataOffset, chunkHeader.constraintDataSize, "Constraint data");
+	const ChunkedPhysicalRecord* physicals = reinterpret_cast<const ChunkedPhysicalRecord*>(chunk + chunkHeader.physicalsOffset);
+	const ChunkedPartRecord* parts = reinterpret_cast<const ChunkedPartRecord*>(chunk + chunkHeader.partsOffset);
+
+	// every index used while decoding is checked up front
+	for(uint32_t i = 0; i < chunkHeader.physicalCount; i++) {
+		const ChunkedPhysicalRecord& record = physicals[i];
+		if(record.partCount == 0 || !isInRange(record.firstPartIndex, record.partCount, chunkHeader.partCount)) {
+			throw SerializationException("Physical " + std::to_string(i) + " in chunk " + std::to_string(chunkIndex) + " refers to parts outside of the chunk!");
+		}
+		if(record.parentIndex != CHUNK_NO_PARENT && !isInRange(record.constraintOffset, record.constraintSize, chunkHeader.constraintDataSize)) {
+			throw SerializationException("Physical " + std::to_string(i) + " in chunk " + std::to_string(chunkIndex) + " refers to constraint data outside of the chunk!");
+		}
+	}
+
+	std::vector<MotorizedPhysical*> result;
+	result.reserve(std::min(chunkHeader.motorizedPhysicalCount, chunkHeader.physicalCount));
+
+	size_t index = 0;
+	try {
+		while(index < chunkHeader.physicalCount) {
+			const ChunkedPhysicalRecord& record = physicals[index];
+			if(record.parentIndex != CHUNK_NO_PARENT) {
+				throw SerializationException("Expected a MotorizedPhysical at index " + std::to_string(index));
+			}
+			RigidBody rigidBody = decodeRigidBody(parts, record);
+			rigidBody.setCFrame(record.cframe);
+			MotorizedPhysical* mainPhys = new MotorizedPhysical(std::move(rigidBody));
+			result.push_back(mainPhys);
+			mainPhys->motionOfCenterOfMass = record.motionOfCenterOfMass;
+
+			index = decodeChildPhysicals(*mainPhys, chunk, chunkHeader, index);
+
+			mainPhys->fullRefreshOfConnectedPhysicals();
+			mainPhys->refreshPhysicalProperties();
+		}
+	} catch(...) {
+		for(MotorizedPhysical* phys : result) {
+			deleteDecodedPhysical(phys);
+		}
+		throw;
+	}
+	return result;
+}
+
+std::vector<Part*> ChunkedDeSerializationSession::decodeTerrainChunk(size_t chunkIndex) const {
+	const char* chunk = getChunkData(chunkIndex, ChunkType::TERRAIN);
+	checkInChunk(chunkIndex, directory[chunkIndex].size, 0, sizeof(ChunkedTerrainPartRecord) * uint64_t(directory[chunkIndex].itemCount), "Terrain part records");
+	const ChunkedTerrainPartRecord* records = reinterpret_cast<const ChunkedTerrainPartRecord*>(chunk);
+
+	std::vector<Part*> result;
+	result.reserve(directory[chunkIndex].itemCount);
+	try {
+		for(uint32_t i = 0; i < directory[chunkIndex].itemCount; i++) {
+			result.push_back(decodePart(records[i].part, records[i].cframe));
+		}
+	} catch(...) {
+		for(Part* part : result) {
+			delete part;
+		}
+		throw;
+	}
+	return result;
+}
+
+void ChunkedDeSerializationSession::deserializeWorld(WorldPrototype& world) const {
+	world.age = static_cast<size_t>(header->age);
+	// the counts in the header are only hints, a file can't hold more records than fit in it
+	size_t physicalCount = static_cast<size_t>(std::min<uint64_t>(header->physicalCount, size / sizeof(ChunkedPhysicalRecord)));
+	world.physicals.reserve(world.physicals.size() + physicalCount);
+
+	// parts can only be put in their layers once the layers exist
+	for(size_t i = 0; i < header->chunkCount; i++) {
+		if(directory[i].type == ChunkType::LAYERS) {
+			decodeLayersChunk(i, world);
+		}
+	}
+
+	// the decoded parts only belong to the world once they are added to it, until then they are freed on an error
+	std::vector<MotorizedPhysical*> decodedPhysicals;
+	std::vector<Part*> decodedTerrain;
+	std::vector<std::vector<Part*>> partsPerLayer(world.getLayerCount());
+	try {
+		for(size_t i = 0; i < header->chunkCount; i++) {
+			switch(directory[i].type) {
+			case ChunkType::EXTERNAL_FORCES:
+				for(ExternalForce* force : decodeExternalForcesChunk(i)) {
+					world.externalForces.push_back(force);
+				}
+				break;
+			case ChunkType::PHYSICALS: {
+				std::vector<MotorizedPhysical*> chunkPhysicals = decodePhysicalsChunk(i);
+				decodedPhysicals.insert(decodedPhysicals.end(), chunkPhysicals.begin(), chunkPhysicals.end());
+				break;
+			}
+			case ChunkType::TERRAIN: {
+				std::vector<Part*> chunkTerrain = decodeTerrainChunk(i);
+				decodedTerrain.insert(decodedTerrain.end(), chunkTerrain.begin(), chunkTerrain.end());
+				break;
+			}
+			default:
+				break;
+			}
+		}
+
+		for(MotorizedPhysical* phys : decodedPhysicals) {
+			Part* mainPart = phys->getMainPart();
+			checkPartLayer(world, static_cast<uint32_t>(mainPart->layer), false);
+			partsPerLayer[mainPart->layer].push_back(mainPart);
+		}
+		for(Part* part : decodedTerrain) {
+			checkPartLayer(world, static_cast<uint32_t>(part->layer), true);
+			partsPerLayer[part->layer].push_back(part);
+		}
+	} catch(...) {
+		for(MotorizedPhysical* phys : decodedPhysicals) {
+			deleteDecodedPhysical(phys);
+		}
+		for(Part* part : decodedTerrain) {
+			delete part;
+		}
+		throw;
+	}
+
+	// the trees are built once for all chunks
+	for(size_t layer = 0; layer < partsPerLayer.size(); layer++) {
+		if(world.getLayer(static_cast<int>(layer)).isTerrainLayer) {
+			world.addTerrainParts(partsPerLayer[layer], static_cast<int>(layer));
+		} else {
+			world.addParts(partsPerLayer[layer], static_cast<int>(layer));
+		}
+	}
+}
+
+#pragma endregion
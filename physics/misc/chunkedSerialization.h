@@ -0,0 +1,207 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <iostream>
+
+#include "../math/linalg/vec.h"
+#include "../math/linalg/mat.h"
+#include "../math/cframe.h"
+#include "../math/globalCFrame.h"
+#include "../geometry/shapeClass.h"
+#include "../geometry/scalableInertialMatrix.h"
+#include "../motion.h"
+#include "../part.h"
+#include "../physical.h"
+#include "../world.h"
+
+/*
+	Chunked world format
+
+	Unlike the stream format in serialization.h, which must be parsed front to back, this format consists of a small header,
+	a chunk directory and a number of independently decodable chunks. All records in a chunk have a fixed size and are
+	aligned, so they can be read in place from a memory mapped file. Polyhedron vertex and triangle data is stored in the
+	exact parallel layout used by Polyhedron, so it is used directly from the mapped memory without copying.
+
+	Every chunk only depends on the shape table, so after the shape table is decoded, chunks can be decoded lazily or in parallel.
+	See fileStructure.md for the exact layout.
+*/
+
+#define CHUNKED_FORMAT_VERSION_ID 2
+#define CHUNK_ALIGNMENT 64
+#define CHUNK_NO_PARENT 0xFFFFFFFF
+
+enum class ChunkType : uint32_t {
+	SHAPE_TABLE = 1,
+	EXTERNAL_FORCES = 2,
+	PHYSICALS = 3,
+	TERRAIN = 4,
+	LAYERS = 5
+};
+
+struct ChunkedFileHeader {
+	char magic[8];
+	uint32_t versionID;
+	uint32_t chunkCount;
+	uint64_t age;
+	uint64_t physicalCount;
+	uint64_t terrainPartCount;
+};
+
+struct ChunkDirectoryEntry {
+	ChunkType type;
+	// number of shapes, forces, motorized physicals, terrain parts or layers in this chunk
+	uint32_t itemCount;
+	// offset from the start of the file, always a multiple of CHUNK_ALIGNMENT
+	uint64_t offset;
+	uint64_t size;
+};
+
+enum class ShapeTableEntryKind : uint32_t {
+	// one of the ShapeClasses known to both writer and reader, builtinIndex indexes the list of known ShapeClasses
+	KNOWN = 0,
+	// a NormalizedPolyhedron, data points to its parallel vertex and triangle buffers
+	POLYHEDRON = 1,
+	// any other ShapeClass, data points to its dynamicShapeClassSerializer representation
+	DYNAMIC = 2
+};
+
+struct ShapeTableEntry {
+	ShapeTableEntryKind kind;
+	uint32_t builtinIndex;
+	int32_t vertexCount;
+	int32_t triangleCount;
+	// relative to the start of the shape table chunk, 32 byte aligned for polyhedra
+	uint64_t dataOffset;
+	uint64_t dataSize;
+
+	// the precomputed properties of the NormalizedPolyhedron, so they do not need to be recomputed at load time
+	Vec3 originalCenter;
+	DiagonalMat3 originalScale;
+	double volume;
+	Vec3 centerOfMass;
+	ScalableInertialMatrix inertia;
+};
+
+struct ChunkedPartRecord {
+	// attachment to the main part of the rigidBody, identity for the main part itself
+	CFrame attachment;
+	Vec3 dimensions;
+	PartProperties properties;
+	uint32_t shapeIndex;
+	// index of the layer of the world the part is in
+	uint32_t layer;
+};
+
+struct ChunkedTerrainPartRecord {
+	GlobalCFrame cframe;
+	ChunkedPartRecord part;
+};
+
+/*
+	Physicals are stored depth first, every MotorizedPhysical is followed by all of its ConnectedPhysicals
+*/
+struct ChunkedPhysicalRecord {
+	// only used for MotorizedPhysicals
+	Motion motionOfCenterOfMass;
+	GlobalCFrame cframe;
+
+	// only used for ConnectedPhysicals
+	CFrame attachOnChild;
+	CFrame attachOnParent;
+	// relative to the constraint data of the chunk, the constraint is stored with dynamicHardConstraintSerializer
+	uint64_t constraintOffset;
+	uint64_t constraintSize;
+
+	// index of the parent in this chunk, or CHUNK_NO_PARENT for MotorizedPhysicals
+	uint32_t parentIndex;
+	uint32_t childCount;
+	// index of the first part in this chunk, this is the main part of the rigidBody, the rest are attached parts
+	uint32_t firstPartIndex;
+	uint32_t partCount;
+};
+
+struct PhysicalsChunkHeader {
+	uint32_t motorizedPhysicalCount;
+	uint32_t physicalCount;
+	uint32_t partCount;
+	uint32_t padding;
+	// all relative to the start of the chunk
+	uint64_t physicalsOffset;
+	uint64_t partsOffset;
+	uint64_t constraintDataOffset;
+	uint64_t constraintDataSize;
+};
+
+class ChunkedSerializationSession {
+	std::vector<const ShapeClass*> knownShapeClasses;
+	std::vector<const ShapeClass*> shapeTable;
+	std::unordered_map<const ShapeClass*, uint32_t> shapeIndices;
+	size_t itemsPerChunk;
+
+	uint32_t getShapeIndex(const ShapeClass* shapeClass);
+	ChunkedPartRecord makePartRecord(const Part& part, const CFrame& attachment);
+
+	std::vector<char> buildShapeTableChunk() const;
+	std::vector<char> buildExternalForcesChunk(const WorldPrototype& world) const;
+	std::vector<char> buildLayersChunk(const WorldPrototype& world) const;
+	std::vector<char> buildPhysicalsChunk(const MotorizedPhysical* const* physicals, size_t count);
+	std::vector<char> buildTerrainChunk(const Part* const* parts, size_t count);
+public:
+	/*
+		The given ShapeClasses must also be passed to the ChunkedDeSerializationSession reading the file, in the same order
+		Implicitly the builtin ShapeClasses from the physics engine, such as cubeClass and sphereClass are also included in this list
+	*/
+	ChunkedSerializationSession(const std::vector<const ShapeClass*>& knownShapeClasses = std::vector<const ShapeClass*>(), size_t itemsPerChunk = 4096);
+
+	void serializeWorld(const WorldPrototype& world, std::ostream& ostream);
+};
+
+/*
+	Reads the chunked world format directly from memory, such as a MappedFile.
+
+	The shape table is decoded on construction, all other chunks are decoded on request.
+	The decodeXChunk functions are const and do not share any state, so different chunks may be decoded on different threads.
+
+	Polyhedra reference the given memory, and are owned by this session.
+	Both the memory and the session must therefore outlive any parts created from it.
+*/
+class ChunkedDeSerializationSession {
+	const char* data;
+	size_t size;
+	const ChunkedFileHeader* header;
+	const ChunkDirectoryEntry* directory;
+
+	std::vector<const ShapeClass*> knownShapeClasses;
+	std::vector<const ShapeClass*> shapeTable;
+	std::vector<std::unique_ptr<ShapeClass>> ownedShapeClasses;
+
+	const char* getChunkData(size_t chunkIndex, ChunkType expectedType) const;
+	void decodeShapeTable(size_t chunkIndex);
+	Part* decodePart(const ChunkedPartRecord& record, const GlobalCFrame& cframe) const;
+	RigidBody decodeRigidBody(const ChunkedPartRecord* parts, const ChunkedPhysicalRecord& record) const;
+	size_t decodeChildPhysicals(Physical& parent, const char* chunk, const PhysicalsChunkHeader& chunkHeader, size_t parentIndex) const;
+
+protected:
+	virtual Part* createPart(Part&& partPhysicalData) const;
+
+public:
+	ChunkedDeSerializationSession(const char* data, size_t size, const std::vector<const ShapeClass*>& knownShapeClasses = std::vector<const ShapeClass*>());
+	virtual ~ChunkedDeSerializationSession() = default;
+
+	inline size_t getChunkCount() const { return header->chunkCount; }
+	inline ChunkType getChunkType(size_t chunkIndex) const { return directory[chunkIndex].type; }
+	inline size_t getChunkItemCount(size_t chunkIndex) const { return directory[chunkIndex].itemCount; }
+	inline size_t getAge() const { return static_cast<size_t>(header->age); }
+
+	std::vector<ExternalForce*> decodeExternalForcesChunk(size_t chunkIndex) const;
+	// creates the layers the world does not have yet, and sets which layers collide
+	void decodeLayersChunk(size_t chunkIndex, WorldPrototype& world) const;
+	std::vector<MotorizedPhysical*> decodePhysicalsChunk(size_t chunkIndex) const;
+	std::vector<Part*> decodeTerrainChunk(size_t chunkIndex) const;
+
+	// decodes all chunks in order and adds their contents to the given world, the layers are restored before any parts are added
+	void deserializeWorld(WorldPrototype& world) const;
+};
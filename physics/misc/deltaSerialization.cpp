@@ -0,0 +1,369 @@
+#include "deltaSerialization.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include "../physical.h"
+#include "../math/globalCFrame.h"
+#include "../memoryAccounting.h"
+#include "../../util/serializeBasicTypes.h"
+
+#define DELTA_HAS_POSITION 0x1
+#define DELTA_HAS_ROTATION 0x2
+#define DELTA_HAS_VELOCITY 0x4
+#define DELTA_HAS_ANGULAR_VELOCITY 0x8
+
+#define MAX_VARINT_SIZE 10
+
+#pragma region encoding helpers
+
+static uint64_t zigzag(int64_t value) {
+	return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+static int64_t unzigzag(uint64_t value) {
+	return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+static size_t varintSize(uint64_t value) {
+	size_t size = 1;
+	while(value >= 0x80) {
+		value >>= 7;
+		size++;
+	}
+	return size;
+}
+
+static void writeVarint(std::vector<char>& buf, uint64_t value) {
+	while(value >= 0x80) {
+		buf.push_back(static_cast<char>((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+	buf.push_back(static_cast<char>(value));
+}
+
+static void writeInt16(std::vector<char>& buf, int32_t value) {
+	uint16_t v = static_cast<uint16_t>(static_cast<int16_t>(value));
+	buf.push_back(static_cast<char>(v & 0xFF));
+	buf.push_back(static_cast<char>(v >> 8));
+}
+
+struct DeltaReader {
+	const char* cur;
+	const char* end;
+
+	uint8_t readByte() {
+		if(cur >= end) throw SerializationException("Delta is truncated!");
+		return static_cast<uint8_t>(*cur++);
+	}
+	uint64_t readVarint() {
+		uint64_t result = 0;
+		for(int shift = 0; shift < 64; shift += 7) {
+			uint8_t b = readByte();
+			result |= static_cast<uint64_t>(b & 0x7F) << shift;
+			if((b & 0x80) == 0) return result;
+		}
+		throw SerializationException("Invalid varint in delta!");
+	}
+	int32_t readInt16() {
+		uint16_t low = readByte();
+		uint16_t high = readByte();
+		return static_cast<int16_t>(static_cast<uint16_t>(low | (high << 8)));
+	}
+};
+
+#pragma endregion
+
+#pragma region quantization
+
+static int32_t quantizeValue(double value, double quantum) {
+	double q = std::round(value / quantum);
+	if(q > INT32_MAX) return INT32_MAX;
+	if(q < INT32_MIN) return INT32_MIN;
+	return static_cast<int32_t>(q);
+}
+
+static double getRotationScale(const DeltaQuantization& quantization) {
+	// the three smallest components of a unit quaternion lie within [-1/sqrt(2), 1/sqrt(2)]
+	return ((1 << (quantization.rotationBits - 1)) - 1) * std::sqrt(2.0);
+}
+
+static void quantizeRotation(const Rotation& rotation, const DeltaQuantization& quantization, QuantizedPhysicalState& result) {
+	Mat3 m = rotation.asRotationMatrix();
+	double q[4]; // x, y, z, w
+	double trace = m[0][0] + m[1][1] + m[2][2];
+	if(trace > 0) {
+		double s = std::sqrt(trace + 1.0) * 2;
+		q[3] = s / 4;
+		q[0] = (m[2][1] - m[1][2]) / s;
+		q[1] = (m[0][2] - m[2][0]) / s;
+		q[2] = (m[1][0] - m[0][1]) / s;
+	} else if(m[0][0] > m[1][1] && m[0][0] > m[2][2]) {
+		double s = std::sqrt(1.0 + m[0][0] - m[1][1] - m[2][2]) * 2;
+		q[3] = (m[2][1] - m[1][2]) / s;
+		q[0] = s / 4;
+		q[1] = (m[0][1] + m[1][0]) / s;
+		q[2] = (m[0][2] + m[2][0]) / s;
+	} else if(m[1][1] > m[2][2]) {
+		double s = std::sqrt(1.0 + m[1][1] - m[0][0] - m[2][2]) * 2;
+		q[3] = (m[0][2] - m[2][0]) / s;
+		q[0] = (m[0][1] + m[1][0]) / s;
+		q[1] = s / 4;
+		q[2] = (m[1][2] + m[2][1]) / s;
+	} else {
+		double s = std::sqrt(1.0 + m[2][2] - m[0][0] - m[1][1]) * 2;
+		q[3] = (m[1][0] - m[0][1]) / s;
+		q[0] = (m[0][2] + m[2][0]) / s;
+		q[1] = (m[1][2] + m[2][1]) / s;
+		q[2] = s / 4;
+	}
+
+	int largest = 0;
+	for(int i = 1; i < 4; i++) {
+		if(std::abs(q[i]) > std::abs(q[largest])) largest = i;
+	}
+	// q and -q are the same rotation, make the omitted component positive
+	double sign = (q[largest] < 0) ? -1.0 : 1.0;
+	double scale = getRotationScale(quantization);
+
+	result.rotationLargestIndex = largest;
+	for(int i = 0, j = 0; i < 4; i++) {
+		if(i == largest) continue;
+		result.rotation[j++] = static_cast<int32_t>(std::round(q[i] * sign * scale));
+	}
+}
+
+static Rotation dequantizeRotation(const QuantizedPhysicalState& state, const DeltaQuantization& quantization) {
+	double scale = getRotationScale(quantization);
+	double q[4];
+	double sumSq = 0;
+	for(int i = 0, j = 0; i < 4; i++) {
+		if(i == state.rotationLargestIndex) continue;
+		q[i] = state.rotation[j++] / scale;
+		sumSq += q[i] * q[i];
+	}
+	q[state.rotationLargestIndex] = std::sqrt(std::max(0.0, 1.0 - sumSq));
+
+	double length = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+	double x = q[0] / length, y = q[1] / length, z = q[2] / length, w = q[3] / length;
+
+	return Rotation::fromRotationMatrix(Mat3{
+		1 - 2 * (y * y + z * z), 2 * (x * y - w * z), 2 * (x * z + w * y),
+		2 * (x * y + w * z), 1 - 2 * (x * x + z * z), 2 * (y * z - w * x),
+		2 * (x * z - w * y), 2 * (y * z + w * x), 1 - 2 * (x * x + y * y)
+	});
+}
+
+// the value of a Fix<32> is the position scaled by 2^32, the quantized position is scaled by 2^positionFractionBits
+static int64_t quantizePosition(int64_t fixValue, int shift) {
+	if(shift == 0) return fixValue;
+	// round to nearest, the arithmetic shift rounds towards negative infinity
+	return (fixValue + (int64_t(1) << (shift - 1))) >> shift;
+}
+
+static int64_t dequantizePosition(int64_t quantized, int shift) {
+	// a left shift of a negative value is undefined
+	return quantized * (int64_t(1) << shift);
+}
+
+static void checkQuantization(const DeltaQuantization& quantization) {
+	if(quantization.rotationBits < 2 || quantization.rotationBits > 16) throw std::logic_error("rotationBits must be between 2 and 16");
+	if(quantization.positionFractionBits < 1 || quantization.positionFractionBits > 32) throw std::logic_error("positionFractionBits must be between 1 and 32");
+	if(!(quantization.velocityQuantum > 0.0) || !(quantization.angularVelocityQuantum > 0.0)) throw std::logic_error("velocityQuantum and angularVelocityQuantum must be positive");
+}
+
+static QuantizedPhysicalState quantize(const MotorizedPhysical& phys, const DeltaQuantization& quantization) {
+	QuantizedPhysicalState result;
+	const GlobalCFrame& cframe = phys.getCFrame();
+	int shift = 32 - quantization.positionFractionBits;
+	for(int i = 0; i < 3; i++) {
+		result.position[i] = quantizePosition(cframe.position[i].value, shift);
+	}
+	quantizeRotation(cframe.rotation, quantization, result);
+	for(int i = 0; i < 3; i++) {
+		result.velocity[i] = quantizeValue(phys.motionOfCenterOfMass.translation.velocity[i], quantization.velocityQuantum);
+		result.angularVelocity[i] = quantizeValue(phys.motionOfCenterOfMass.rotation.angularVelocity[i], quantization.angularVelocityQuantum);
+	}
+	return result;
+}
+
+static GlobalCFrame dequantizeCFrame(const QuantizedPhysicalState& state, const DeltaQuantization& quantization) {
+	int shift = 32 - quantization.positionFractionBits;
+	Position position(Fix<32>(static_cast<__int64>(dequantizePosition(state.position[0], shift))), Fix<32>(static_cast<__int64>(dequantizePosition(state.position[1], shift))), Fix<32>(static_cast<__int64>(dequantizePosition(state.position[2], shift))));
+	return GlobalCFrame(position, dequantizeRotation(state, quantization));
+}
+
+static std::vector<QuantizedPhysicalState> quantizeWorld(const WorldPrototype& world, const DeltaQuantization& quantization) {
+	std::vector<QuantizedPhysicalState> result;
+	result.reserve(world.physicals.size());
+	for(const MotorizedPhysical* phys : world.physicals) {
+		result.push_back(quantize(*phys, quantization));
+	}
+	return result;
+}
+
+#pragma endregion
+
+#pragma region encoder
+
+DeltaEncoder::DeltaEncoder(const DeltaQuantization& quantization) : quantization(quantization) {
+	checkQuantization(quantization);
+}
+
+void DeltaEncoder::setBase(const WorldPrototype& world) {
+	base = quantizeWorld(world, quantization);
+}
+
+struct DeltaCandidate {
+	size_t physicalIndex;
+	int64_t priority;
+	size_t bodyStart;
+	size_t bodySize;
+};
+
+static int64_t maxAbsDifference(const int32_t* a, const int32_t* b) {
+	int64_t result = 0;
+	for(int i = 0; i < 3; i++) {
+		result = std::max(result, std::abs(static_cast<int64_t>(a[i]) - b[i]));
+	}
+	return result;
+}
+
+size_t DeltaEncoder::encodeDelta(const WorldPrototype& world, std::vector<char>& output, size_t maxBytes) {
+	size_t physicalCount = world.physicals.size();
+	if(base.size() != physicalCount) {
+		throw SerializationException("The physicals of the world changed since the base snapshot, call setBase again!");
+	}
+
+	std::vector<QuantizedPhysicalState> current = quantizeWorld(world, quantization);
+
+	std::vector<DeltaCandidate> candidates;
+	std::vector<char> bodies;
+	for(size_t i = 0; i < physicalCount; i++) {
+		const QuantizedPhysicalState& cur = current[i];
+		const QuantizedPhysicalState& old = base[i];
+
+		int64_t positionDelta = 0;
+		for(int j = 0; j < 3; j++) positionDelta = std::max(positionDelta, std::abs(cur.position[j] - old.position[j]));
+		int64_t rotationDelta = (cur.rotationLargestIndex != old.rotationLargestIndex) ? INT32_MAX : maxAbsDifference(cur.rotation, old.rotation);
+		int64_t velocityDelta = maxAbsDifference(cur.velocity, old.velocity);
+		int64_t angularVelocityDelta = maxAbsDifference(cur.angularVelocity, old.angularVelocity);
+
+		uint8_t flags = (positionDelta != 0 ? DELTA_HAS_POSITION : 0) | (rotationDelta != 0 ? DELTA_HAS_ROTATION : 0) |
+			(velocityDelta != 0 ? DELTA_HAS_VELOCITY : 0) | (angularVelocityDelta != 0 ? DELTA_HAS_ANGULAR_VELOCITY : 0);
+		if(flags == 0) continue;
+
+		size_t bodyStart = bodies.size();
+		bodies.push_back(static_cast<char>(flags));
+		if(flags & DELTA_HAS_POSITION) {
+			for(int j = 0; j < 3; j++) writeVarint(bodies, zigzag(cur.position[j] - old.position[j]));
+		}
+		if(flags & DELTA_HAS_ROTATION) {
+			bodies.push_back(static_cast<char>(cur.rotationLargestIndex));
+			for(int j = 0; j < 3; j++) writeInt16(bodies, cur.rotation[j]);
+		}
+		if(flags & DELTA_HAS_VELOCITY) {
+			for(int j = 0; j < 3; j++) writeVarint(bodies, zigzag(static_cast<int64_t>(cur.velocity[j]) - old.velocity[j]));
+		}
+		if(flags & DELTA_HAS_ANGULAR_VELOCITY) {
+			for(int j = 0; j < 3; j++) writeVarint(bodies, zigzag(static_cast<int64_t>(cur.angularVelocity[j]) - old.angularVelocity[j]));
+		}
+
+		int64_t priority = std::max(std::max(positionDelta, rotationDelta), std::max(velocityDelta, angularVelocityDelta));
+		candidates.push_back(DeltaCandidate{i, priority, bodyStart, bodies.size() - bodyStart});
+	}
+
+	// the physicals that drifted furthest from what the receiver has get the budget first
+	std::sort(candidates.begin(), candidates.end(), [](const DeltaCandidate& a, const DeltaCandidate& b) {
+		return a.priority > b.priority || (a.priority == b.priority && a.physicalIndex < b.physicalIndex);
+	});
+
+	size_t headerSize = varintSize(world.age) + varintSize(physicalCount) + varintSize(candidates.size());
+	size_t usedBytes = headerSize;
+	std::vector<DeltaCandidate> accepted;
+	for(const DeltaCandidate& candidate : candidates) {
+		// the index is delta coded after sorting, so the full index is an upper bound for its size
+		size_t recordSize = varintSize(candidate.physicalIndex) + candidate.bodySize;
+		if(usedBytes + recordSize > maxBytes) continue;
+		usedBytes += recordSize;
+		accepted.push_back(candidate);
+	}
+
+	std::sort(accepted.begin(), accepted.end(), [](const DeltaCandidate& a, const DeltaCandidate& b) {return a.physicalIndex < b.physicalIndex; });
+
+	output.reserve(output.size() + usedBytes);
+	writeVarint(output, world.age);
+	writeVarint(output, physicalCount);
+	writeVarint(output, accepted.size());
+	size_t nextIndex = 0;
+	for(const DeltaCandidate& candidate : accepted) {
+		writeVarint(output, candidate.physicalIndex - nextIndex);
+		output.insert(output.end(), bodies.begin() + candidate.bodyStart, bodies.begin() + candidate.bodyStart + candidate.bodySize);
+		nextIndex = candidate.physicalIndex + 1;
+
+		base[candidate.physicalIndex] = current[candidate.physicalIndex];
+	}
+	MemoryAccounting::recordTransient(MemoryCategory::SERIALIZATION, current.capacity() * sizeof(QuantizedPhysicalState) + bodies.capacity() +
+		(candidates.capacity() + accepted.capacity()) * sizeof(DeltaCandidate));
+	return accepted.size();
+}
+
+#pragma endregion
+
+#pragma region decoder
+
+DeltaDecoder::DeltaDecoder(const DeltaQuantization& quantization) : quantization(quantization) {
+	checkQuantization(quantization);
+}
+
+void DeltaDecoder::setBase(const WorldPrototype& world) {
+	base = quantizeWorld(world, quantization);
+}
+
+void DeltaDecoder::applyDelta(WorldPrototype& world, const char* data, size_t size) {
+	DeltaReader reader{data, data + size};
+
+	reader.readVarint(); // age of the sending world, informational
+	uint64_t physicalCount = reader.readVarint();
+	if(physicalCount != world.physicals.size() || physicalCount != base.size()) {
+		throw SerializationException("Delta was made for a world with " + std::to_string(physicalCount) + " physicals, this world has " + std::to_string(world.physicals.size()));
+	}
+
+	uint64_t recordCount = reader.readVarint();
+	uint64_t nextIndex = 0;
+	for(uint64_t r = 0; r < recordCount; r++) {
+		uint64_t index = nextIndex + reader.readVarint();
+		if(index >= physicalCount) throw SerializationException("Invalid physical index in delta!");
+		nextIndex = index + 1;
+
+		QuantizedPhysicalState& state = base[index];
+		uint8_t flags = reader.readByte();
+		if(flags & DELTA_HAS_POSITION) {
+			for(int j = 0; j < 3; j++) state.position[j] += unzigzag(reader.readVarint());
+		}
+		if(flags & DELTA_HAS_ROTATION) {
+			state.rotationLargestIndex = reader.readByte();
+			if(state.rotationLargestIndex > 3) throw SerializationException("Invalid rotation in delta!");
+			for(int j = 0; j < 3; j++) state.rotation[j] = reader.readInt16();
+		}
+		if(flags & DELTA_HAS_VELOCITY) {
+			for(int j = 0; j < 3; j++) state.velocity[j] = static_cast<int32_t>(state.velocity[j] + unzigzag(reader.readVarint()));
+		}
+		if(flags & DELTA_HAS_ANGULAR_VELOCITY) {
+			for(int j = 0; j < 3; j++) state.angularVelocity[j] = static_cast<int32_t>(state.angularVelocity[j] + unzigzag(reader.readVarint()));
+		}
+
+		MotorizedPhysical* phys = world.physicals[index];
+		if(flags & (DELTA_HAS_POSITION | DELTA_HAS_ROTATION)) {
+			phys->setCFrame(dequantizeCFrame(state, quantization));
+		}
+		if(flags & DELTA_HAS_VELOCITY) {
+			phys->motionOfCenterOfMass.translation.velocity = Vec3(state.velocity[0], state.velocity[1], state.velocity[2]) * quantization.velocityQuantum;
+		}
+		if(flags & DELTA_HAS_ANGULAR_VELOCITY) {
+			phys->motionOfCenterOfMass.rotation.angularVelocity = Vec3(state.angularVelocity[0], state.angularVelocity[1], state.angularVelocity[2]) * quantization.angularVelocityQuantum;
+		}
+	}
+}
+
+#pragma endregion
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "../world.h"
+
+/*
+	Delta snapshots
+
+	Encodes the changes in the state of all MotorizedPhysicals of a world relative to a base snapshot,
+	used for frequent checkpoints and for replicating a world to another process.
+
+	Both sides start from the same world, for example loaded from the same serializeWorld stream, and call setBase on it.
+	Afterwards the encoder emits per tick only the physicals whose quantized CFrame, velocity or angular velocity changed.
+	Both encoder and decoder keep the last transmitted quantized state, so quantization errors never accumulate.
+
+	Physicals are identified by their index in world.physicals, so both worlds must contain the same physicals in the same order.
+	Accelerations are not transmitted, the receiving world recomputes them on its next tick.
+*/
+
+struct DeltaQuantization {
+	// positions are rounded to 2^-positionFractionBits, this uses the fixed point representation of Position directly
+	int positionFractionBits = 10;
+	// rotations are stored as the three smallest components of the quaternion, each with this many bits
+	int rotationBits = 15;
+	double velocityQuantum = 1.0 / 512;
+	double angularVelocityQuantum = 1.0 / 1024;
+};
+
+struct QuantizedPhysicalState {
+	int64_t position[3];
+	int32_t rotation[3];
+	int32_t rotationLargestIndex;
+	int32_t velocity[3];
+	int32_t angularVelocity[3];
+};
+
+class DeltaEncoder {
+	DeltaQuantization quantization;
+	std::vector<QuantizedPhysicalState> base;
+public:
+	DeltaEncoder(const DeltaQuantization& quantization = DeltaQuantization());
+
+	// makes the current state of the world the base snapshot, the receiver must call DeltaDecoder::setBase on an identical world
+	void setBase(const WorldPrototype& world);
+
+	/*
+		Appends the delta since the base snapshot to output, and makes the transmitted state the new base.
+		The delta never exceeds maxBytes, if not all changed physicals fit, the ones that changed most are sent first,
+		and the rest will be sent in a later delta.
+
+		Returns the number of physicals that were included
+	*/
+	size_t encodeDelta(const WorldPrototype& world, std::vector<char>& output, size_t maxBytes = SIZE_MAX);
+};
+
+class DeltaDecoder {
+	DeltaQuantization quantization;
+	std::vector<QuantizedPhysicalState> base;
+public:
+	DeltaDecoder(const DeltaQuantization& quantization = DeltaQuantization());
+
+	void setBase(const WorldPrototype& world);
+
+	/*
+		Patches the physicals in the given world in place with a delta made by DeltaEncoder::encodeDelta
+		throws SerializationException if the delta does not match the world
+	*/
+	void applyDelta(WorldPrototype& world, const char* data, size_t size);
+};
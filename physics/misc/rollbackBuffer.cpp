@@ -0,0 +1,145 @@
+#include "rollbackBuffer.h"
+
+#include <assert.h>
+
+#include "../physical.h"
+#include "../constraints/hardConstraint.h"
+
+static size_t getConstraintStateSizeRecursive(const Physical& phys) {
+	size_t total = 0;
+	for(const ConnectedPhysical& child : phys.childPhysicals) {
+		total += child.connectionToParent.constraintWithParent->getStateSize();
+		total += getConstraintStateSizeRecursive(child);
+	}
+	return total;
+}
+
+static double* saveConstraintStateRecursive(const Physical& phys, double* state) {
+	for(const ConnectedPhysical& child : phys.childPhysicals) {
+		const HardConstraint* constraint = child.connectionToParent.constraintWithParent.get();
+		constraint->saveState(state);
+		state += constraint->getStateSize();
+		state = saveConstraintStateRecursive(child, state);
+	}
+	return state;
+}
+
+static const double* loadConstraintStateRecursive(Physical& phys, const double* state) {
+	for(ConnectedPhysical& child : phys.childPhysicals) {
+		HardConstraint* constraint = child.connectionToParent.constraintWithParent.get();
+		constraint->loadState(state);
+		state += constraint->getStateSize();
+		state = loadConstraintStateRecursive(child, state);
+	}
+	return state;
+}
+
+static size_t getConstraintStateSize(const WorldPrototype& world) {
+	size_t total = 0;
+	for(const MotorizedPhysical* phys : world.physicals) {
+		total += getConstraintStateSizeRecursive(*phys);
+	}
+	return total;
+}
+
+RollbackBuffer::RollbackBuffer(size_t capacity) : snapshots(capacity) {
+	assert(capacity > 0);
+}
+
+const RollbackBuffer::Snapshot& RollbackBuffer::getSnapshot(size_t ticksBack) const {
+	assert(ticksBack < snapshotCount);
+	size_t capacity = snapshots.size();
+	return snapshots[(nextSlot + capacity - 1 - ticksBack) % capacity];
+}
+
+size_t RollbackBuffer::findSnapshot(size_t age) const {
+	for(size_t i = 0; i < snapshotCount; i++) {
+		if(getSnapshot(i).age == age) return i;
+	}
+	return snapshotCount;
+}
+
+void RollbackBuffer::reserve(const WorldPrototype& world) {
+	size_t constraintStateSize = getConstraintStateSize(world);
+	for(Snapshot& snapshot : snapshots) {
+		snapshot.physicals.reserve(world.physicals.size());
+		snapshot.constraintState.reserve(constraintStateSize);
+	}
+}
+
+void RollbackBuffer::capture(const WorldPrototype& world) {
+	Snapshot& snapshot = snapshots[nextSlot];
+	nextSlot = (nextSlot + 1) % snapshots.size();
+	if(snapshotCount < snapshots.size()) snapshotCount++;
+
+	snapshot.age = world.age;
+
+	snapshot.physicals.resize(world.physicals.size());
+	PhysicalState* physState = snapshot.physicals.data();
+	for(const MotorizedPhysical* phys : world.physicals) {
+		physState->cframe = phys->getCFrame();
+		physState->motionOfCenterOfMass = phys->motionOfCenterOfMass;
+		physState->totalForce = phys->totalForce;
+		physState->totalMoment = phys->totalMoment;
+		physState->totalMass = phys->totalMass;
+		physState->totalCenterOfMass = phys->totalCenterOfMass;
+		physState->forceResponse = phys->forceResponse;
+		physState->momentResponse = phys->momentResponse;
+		physState++;
+	}
+
+	snapshot.constraintState.resize(getConstraintStateSize(world));
+	double* constraintState = snapshot.constraintState.data();
+	for(const MotorizedPhysical* phys : world.physicals) {
+		constraintState = saveConstraintStateRecursive(*phys, constraintState);
+	}
+}
+
+void RollbackBuffer::restore(WorldPrototype& world, size_t age) {
+	size_t ticksBack = findSnapshot(age);
+	if(ticksBack == snapshotCount) {
+		throw "No snapshot for this age in the rollback buffer!";
+	}
+	const Snapshot& snapshot = getSnapshot(ticksBack);
+	if(snapshot.physicals.size() != world.physicals.size()) {
+		throw "The physicals of the world changed since this snapshot was captured!";
+	}
+
+	// constraints first, the CFrames of the ConnectedPhysicals depend on them
+	const double* constraintState = snapshot.constraintState.data();
+	for(MotorizedPhysical* phys : world.physicals) {
+		constraintState = loadConstraintStateRecursive(*phys, constraintState);
+	}
+	assert(constraintState == snapshot.constraintState.data() + snapshot.constraintState.size());
+
+	const PhysicalState* physState = snapshot.physicals.data();
+	for(MotorizedPhysical* phys : world.physicals) {
+		// rebuilds the cached mass properties of the attached physicals for the restored constraints
+		phys->refreshPhysicalProperties();
+		phys->motionOfCenterOfMass = physState->motionOfCenterOfMass;
+		phys->totalForce = physState->totalForce;
+		phys->totalMoment = physState->totalMoment;
+		phys->totalMass = physState->totalMass;
+		phys->totalCenterOfMass = physState->totalCenterOfMass;
+		phys->forceResponse = physState->forceResponse;
+		phys->momentResponse = physState->momentResponse;
+		phys->setCFrameUnsafe(physState->cframe);
+		physState++;
+	}
+
+	// one refit of the trees instead of an update per physical
+	for(size_t i = 0; i < world.getLayerCount(); i++) {
+		Layer& layer = world.getLayer(static_cast<int>(i));
+		if(!layer.isTerrainLayer) layer.tree.recalculateBounds();
+	}
+	world.age = snapshot.age;
+
+	// the newer snapshots are no longer valid, resimulating will capture them again
+	nextSlot = (nextSlot + snapshots.size() - ticksBack) % snapshots.size();
+	snapshotCount -= ticksBack;
+}
+
+void RollbackBuffer::clear() {
+	nextSlot = 0;
+	snapshotCount = 0;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <vector>
+
+#include "../math/globalCFrame.h"
+#include "../math/linalg/vec.h"
+#include "../math/linalg/mat.h"
+#include "../motion.h"
+#include "../world.h"
+
+/*
+	Rollback buffer
+
+	Keeps the dynamic state of the last few ticks of a world in a ring buffer, so the world can be rewound and resimulated.
+	Only the state that changes during simulation is copied: the CFrames and motion of all MotorizedPhysicals,
+	their accumulated forces and derived physical properties, and the internal state of all HardConstraints.
+	ConnectedPhysicals are not stored, their CFrames follow from their parent and the restored constraint.
+
+	The structure of the world, which parts and physicals exist and how they are attached, is not stored.
+	It must not change between capturing a snapshot and restoring it.
+
+	All slots are reused, after the first few captures no more memory is allocated.
+*/
+class RollbackBuffer {
+	struct PhysicalState {
+		GlobalCFrame cframe;
+		Motion motionOfCenterOfMass;
+		Vec3 totalForce;
+		Vec3 totalMoment;
+		double totalMass;
+		Vec3 totalCenterOfMass;
+		SymmetricMat3 forceResponse;
+		SymmetricMat3 momentResponse;
+	};
+
+	struct Snapshot {
+		size_t age;
+		std::vector<PhysicalState> physicals;
+		std::vector<double> constraintState;
+	};
+
+	std::vector<Snapshot> snapshots;
+	// index of the slot the next capture is written to
+	size_t nextSlot = 0;
+	size_t snapshotCount = 0;
+
+	const Snapshot& getSnapshot(size_t ticksBack) const;
+	// returns how many snapshots back the snapshot for the given age is, or snapshotCount if there is none
+	size_t findSnapshot(size_t age) const;
+public:
+	// capacity is the number of snapshots kept, capturing every tick allows rewinding capacity-1 ticks
+	RollbackBuffer(size_t capacity = 10);
+
+	// preallocates all slots for the given world, so capturing never allocates
+	void reserve(const WorldPrototype& world);
+
+	// stores the current state of the world, overwriting the oldest snapshot if the buffer is full
+	void capture(const WorldPrototype& world);
+
+	/*
+		Rewinds the world to the snapshot taken at the given age, snapshots taken after it are discarded.
+		The bounds of the parts are not updated per physical, the trees of the free layers are refit once afterwards.
+
+		throws if there is no snapshot for the given age
+	*/
+	void restore(WorldPrototype& world, size_t age);
+
+	inline size_t getCapacity() const { return snapshots.size(); }
+	inline size_t getSnapshotCount() const { return snapshotCount; }
+	inline bool hasSnapshot(size_t age) const { return findSnapshot(age) != snapshotCount; }
+	inline size_t getNewestAge() const { return getSnapshot(0).age; }
+	inline size_t getOldestAge() const { return getSnapshot(snapshotCount - 1).age; }
+
+	void clear();
+};
@@ -10,6 +10,8 @@
 #include "../geometry/polyhedronInternals.h"
 #include "../geometry/shape.h"
 #include "../geometry/shapeClass.h"
+#include "../geometry/heightfieldShapeClass.h"
+#include "../geometry/triangleMeshShapeClass.h"
 #include "../part.h"
 #include "../world.h"
 #include "../constraints/hardConstraint.h"
@@ -18,7 +20,7 @@
 #include "../misc/gravityForce.h"
 
 
-#define CURRENT_VERSION_ID 0
+#define CURRENT_VERSION_ID 1
 
 #pragma region serializeComponents
 
@@ -95,6 +97,50 @@ NormalizedPolyhedron* deserializeNormalizedPolyhedron(std::istream& istream) {
 	return result;
 }
 
+void serializeHeightfield(const HeightfieldShapeClass& heightfield, std::ostream& ostream) {
+	::serialize<int>(heightfield.getSamplesX(), ostream);
+	::serialize<int>(heightfield.getSamplesZ(), ostream);
+	const std::vector<uint16_t>& heights = heightfield.getQuantizedHeights();
+	::serialize(reinterpret_cast<const char*>(heights.data()), heights.size() * sizeof(uint16_t), ostream);
+}
+HeightfieldShapeClass* deserializeHeightfield(std::istream& istream) {
+	int samplesX = ::deserialize<int>(istream);
+	int samplesZ = ::deserialize<int>(istream);
+	if(samplesX < 2 || samplesZ < 2) {
+		throw SerializationException("Invalid heightfield size " + std::to_string(samplesX) + "x" + std::to_string(samplesZ));
+	}
+	std::vector<uint16_t> heights(size_t(samplesX) * samplesZ);
+	::deserialize(reinterpret_cast<char*>(heights.data()), heights.size() * sizeof(uint16_t), istream);
+	return new HeightfieldShapeClass(samplesX, samplesZ, std::move(heights));
+}
+
+void serializeTriangleMesh(const TriangleMeshShapeClass& mesh, std::ostream& ostream) {
+	const std::vector<Vec3f>& vertices = mesh.getVertices();
+	const std::vector<Triangle>& triangles = mesh.getTriangles();
+	::serialize<int>(static_cast<int>(vertices.size()), ostream);
+	::serialize<int>(static_cast<int>(triangles.size()), ostream);
+	::serialize(reinterpret_cast<const char*>(vertices.data()), vertices.size() * sizeof(Vec3f), ostream);
+	::serialize(reinterpret_cast<const char*>(triangles.data()), triangles.size() * sizeof(Triangle), ostream);
+}
+TriangleMeshShapeClass* deserializeTriangleMesh(std::istream& istream) {
+	int vertexCount = ::deserialize<int>(istream);
+	int triangleCount = ::deserialize<int>(istream);
+	if(vertexCount < 3 || triangleCount < 1) {
+		throw SerializationException("Invalid triangle mesh with " + std::to_string(vertexCount) + " vertices and " + std::to_string(triangleCount) + " triangles");
+	}
+	std::vector<Vec3f> vertices(vertexCount);
+	std::vector<Triangle> triangles(triangleCount);
+	::deserialize(reinterpret_cast<char*>(vertices.data()), vertices.size() * sizeof(Vec3f), istream);
+	::deserialize(reinterpret_cast<char*>(triangles.data()), triangles.size() * sizeof(Triangle), istream);
+	for(const Triangle& triangle : triangles) {
+		for(int index : triangle.indexes) {
+			if(index < 0 || index >= vertexCount) throw SerializationException("Triangle mesh vertex index " + std::to_string(index) + " out of range");
+		}
+	}
+	// the tree is rebuilt on load
+	return new TriangleMeshShapeClass(std::move(vertices), std::move(triangles));
+}
+
 void serializeDirectionalGravity(const DirectionalGravity& gravity, std::ostream& ostream) {
 	::serialize<Vec3>(gravity.gravity, ostream);
 }
@@ -219,6 +265,67 @@ MotorizedPhysical* DeSerializationSessionPrototype::deserializeMotorizedPhysical
 
 #pragma endregion
 
+#pragma region layers
+
+std::vector<uint8_t> describeLayers(const WorldPrototype& world) {
+	size_t layerCount = world.getLayerCount();
+	std::vector<uint8_t> result;
+	result.reserve(getLayerDescriptionSize(layerCount));
+	for(size_t i = 0; i < layerCount; i++) {
+		result.push_back(world.getLayer(static_cast<int>(i)).isTerrainLayer ? 1 : 0);
+	}
+	for(size_t i = 0; i < layerCount; i++) {
+		for(size_t j = 0; j <= i; j++) {
+			result.push_back(world.doLayersCollide(static_cast<int>(i), static_cast<int>(j)) ? 1 : 0);
+		}
+	}
+	return result;
+}
+
+void restoreLayers(WorldPrototype& world, const uint8_t* description, size_t layerCount) {
+	if(layerCount > MAX_LAYERS) {
+		throw SerializationException("A world can have at most " + std::to_string(MAX_LAYERS) + " layers, not " + std::to_string(layerCount));
+	}
+	const uint8_t* isTerrainLayer = description;
+	const uint8_t* colissions = description + layerCount;
+
+	// everything is checked before the world is changed
+	for(size_t i = 0; i < world.getLayerCount() && i < layerCount; i++) {
+		if(world.getLayer(static_cast<int>(i)).isTerrainLayer != (isTerrainLayer[i] != 0)) {
+			throw SerializationException("Layer " + std::to_string(i) + " of the world is not of the serialized kind!");
+		}
+	}
+	const uint8_t* cur = colissions;
+	for(size_t i = 0; i < layerCount; i++) {
+		for(size_t j = 0; j <= i; j++) {
+			if(*cur++ != 0 && isTerrainLayer[i] != 0 && isTerrainLayer[j] != 0) {
+				throw SerializationException("Terrain layers " + std::to_string(j) + " and " + std::to_string(i) + " can not collide with each other!");
+			}
+		}
+	}
+
+	while(world.getLayerCount() < layerCount) {
+		world.createLayer(isTerrainLayer[world.getLayerCount()] != 0);
+	}
+	cur = colissions;
+	for(size_t i = 0; i < layerCount; i++) {
+		for(size_t j = 0; j <= i; j++) {
+			world.setLayersCollide(static_cast<int>(i), static_cast<int>(j), *cur++ != 0);
+		}
+	}
+}
+
+void checkPartLayer(const WorldPrototype& world, uint32_t layer, bool isTerrainPart) {
+	if(layer >= world.getLayerCount()) {
+		throw SerializationException("Invalid layer index " + std::to_string(layer));
+	}
+	if(world.getLayer(static_cast<int>(layer)).isTerrainLayer != isTerrainPart) {
+		throw SerializationException("Layer " + std::to_string(layer) + (isTerrainPart ? " can not hold terrain parts!" : " can only hold terrain parts!"));
+	}
+}
+
+#pragma endregion
+
 #pragma region serializeWorld
 
 #pragma region information collection
@@ -263,6 +370,9 @@ void SerializationSessionPrototype::serializeWorld(const WorldPrototype& world,
 
 	serializeCollectedHeaderInformation(ostream);
 
+	std::vector<uint8_t> layers = describeLayers(world);
+	::serialize<uint32_t>(static_cast<uint32_t>(world.getLayerCount()), ostream);
+	::serialize(reinterpret_cast<const char*>(layers.data()), layers.size(), ostream);
 
 	// actually serialize the world
 	size_t physicalCount = world.physicals.size();
@@ -276,10 +386,12 @@ void SerializationSessionPrototype::serializeWorld(const WorldPrototype& world,
 	::serialize<uint64_t>(partCount, ostream);
 
 	for(const MotorizedPhysical* p : world.physicals) {
+		::serialize<uint32_t>(static_cast<uint32_t>(p->getMainPart()->layer), ostream);
 		serializeMotorizedPhysicalInContext(*p, ostream);
 	}
 
 	for(const Part& p : world.iterParts(TERRAIN_PARTS)) {
+		::serialize<uint32_t>(static_cast<uint32_t>(p.layer), ostream);
 		::serialize<GlobalCFrame>(p.getCFrame(), ostream);
 		virtualSerializePart(p, ostream);
 	}
@@ -295,20 +407,41 @@ void DeSerializationSessionPrototype::deserializeWorld(WorldPrototype& world, st
 
 	this->deserializeAndCollectHeaderInformation(istream);
 
+	// the layers must exist before any parts are added to them
+	uint32_t layerCount = ::deserialize<uint32_t>(istream);
+	if(layerCount > MAX_LAYERS) {
+		throw SerializationException("A world can have at most " + std::to_string(MAX_LAYERS) + " layers, not " + std::to_string(layerCount));
+	}
+	std::vector<uint8_t> layers(getLayerDescriptionSize(layerCount));
+	::deserialize(reinterpret_cast<char*>(layers.data()), layers.size(), istream);
+	restoreLayers(world, layers.data(), layerCount);
+
 	uint64_t numberOfPhysicals = ::deserialize<uint64_t>(istream);
 	uint64_t numberOfTerrainParts = ::deserialize<uint64_t>(istream);
 	world.physicals.reserve(numberOfPhysicals);
 
+	std::vector<std::vector<Part*>> partsPerLayer(world.getLayerCount());
 	for(uint64_t i = 0; i < numberOfPhysicals; i++) {
+		uint32_t layer = ::deserialize<uint32_t>(istream);
+		checkPartLayer(world, layer, false);
 		MotorizedPhysical* p = deserializeMotorizedPhysicalWithContext(istream);
-		world.addPart(p->getMainPart());
+		partsPerLayer[layer].push_back(p->getMainPart());
 	}
-
 	for(uint64_t i = 0; i < numberOfTerrainParts; i++) {
+		uint32_t layer = ::deserialize<uint32_t>(istream);
+		checkPartLayer(world, layer, true);
 		GlobalCFrame cf = ::deserialize<GlobalCFrame>(istream);
 		Part* p = virtualDeserializePart(deserializeRawPart(GlobalCFrame(), istream), istream);
 		p->setCFrame(cf);
-		world.addTerrainPart(p);
+		partsPerLayer[layer].push_back(p);
+	}
+
+	for(size_t layer = 0; layer < partsPerLayer.size(); layer++) {
+		if(world.getLayer(static_cast<int>(layer)).isTerrainLayer) {
+			world.addTerrainParts(partsPerLayer[layer], static_cast<int>(layer));
+		} else {
+			world.addParts(partsPerLayer[layer], static_cast<int>(layer));
+		}
 	}
 }
 
@@ -379,6 +512,10 @@ static DynamicSerializerRegistry<HardConstraint>::ConcreteDynamicSerializer<Moto
 
 static DynamicSerializerRegistry<ShapeClass>::ConcreteDynamicSerializer<NormalizedPolyhedron> polyhedronSerializer
 (serializeNormalizedPolyhedron, deserializeNormalizedPolyhedron, 0);
+static DynamicSerializerRegistry<ShapeClass>::ConcreteDynamicSerializer<HeightfieldShapeClass> heightfieldSerializer
+(serializeHeightfield, deserializeHeightfield, 1);
+static DynamicSerializerRegistry<ShapeClass>::ConcreteDynamicSerializer<TriangleMeshShapeClass> triangleMeshSerializer
+(serializeTriangleMesh, deserializeTriangleMesh, 2);
 
 static DynamicSerializerRegistry<ExternalForce>::ConcreteDynamicSerializer<DirectionalGravity> gravitySerializer
 (serializeDirectionalGravity, deserializeDirectionalGravity, 0);
@@ -391,6 +528,8 @@ DynamicSerializerRegistry<HardConstraint> dynamicHardConstraintSerializer{
 };
 DynamicSerializerRegistry<ShapeClass> dynamicShapeClassSerializer{
 	{typeid(NormalizedPolyhedron), &polyhedronSerializer},
+	{typeid(HeightfieldShapeClass), &heightfieldSerializer},
+	{typeid(TriangleMeshShapeClass), &triangleMeshSerializer},
 };
 DynamicSerializerRegistry<ExternalForce> dynamicExternalForceSerializer{
 	{typeid(DirectionalGravity), &gravitySerializer},
@@ -42,6 +42,20 @@ MotorConstraint* deserializeMotorConstraint(std::istream& istream);
 void serializeDirectionalGravity(const DirectionalGravity& gravity, std::ostream& ostream);
 DirectionalGravity* deserializeDirectionalGravity(std::istream& istream);
 
+/*
+	The layers of a world are described by one byte per layer that is 1 for terrain layers,
+	followed by one byte per pair of layers i, j with j <= i, row by row, that is 1 if the layers collide
+*/
+inline size_t getLayerDescriptionSize(size_t layerCount) { return layerCount + layerCount * (layerCount + 1) / 2; }
+std::vector<uint8_t> describeLayers(const WorldPrototype& world);
+/*
+	Creates the described layers the world does not have yet and sets which layers collide.
+	Throws a SerializationException if a layer the world already has is of a different kind, or if the description is invalid
+*/
+void restoreLayers(WorldPrototype& world, const uint8_t* description, size_t layerCount);
+// throws a SerializationException if the given layer of the world does not exist or can't hold the part
+void checkPartLayer(const WorldPrototype& world, uint32_t layer, bool isTerrainPart);
+
 
 class ShapeSerializer {
 public:
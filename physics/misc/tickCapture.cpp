@@ -0,0 +1,251 @@
+#include "tickCapture.h"
+
+#include <sstream>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#include "../physical.h"
+#include "../../util/serializeBasicTypes.h"
+
+static_assert(std::is_trivially_copyable<TickCaptureHeader>::value, "Capture records must be trivially copyable");
+static_assert(std::is_trivially_copyable<TickCaptureRecordHeader>::value, "Capture records must be trivially copyable");
+static_assert(std::is_trivially_copyable<CapturedForce>::value, "Capture records must be trivially copyable");
+
+static const char tickCaptureMagic[8]{'P', '3', 'D', 'T', 'I', 'C', 'K', 'S'};
+
+static size_t alignUp(size_t value, size_t alignment) {
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+#pragma region capture
+
+TickCapture::TickCapture(std::ostream& ostream, double deltaT, const std::vector<const ShapeClass*>& knownShapeClasses) :
+	ostream(ostream), session(knownShapeClasses) {
+	TickCaptureHeader header{};
+	std::memcpy(header.magic, tickCaptureMagic, sizeof(tickCaptureMagic));
+	header.versionID = TICK_CAPTURE_VERSION_ID;
+	header.deltaT = deltaT;
+	::serialize(header, ostream);
+	bytesWritten = sizeof(TickCaptureHeader);
+}
+
+void TickCapture::writeKeyframe(const WorldPrototype& world) {
+	std::ostringstream worldStream;
+	session.serializeWorld(world, worldStream);
+	std::string worldBytes = worldStream.str();
+
+	// the world is read in place, so it starts at CHUNK_ALIGNMENT from the start of the capture
+	size_t dataStart = bytesWritten + sizeof(TickCaptureRecordHeader);
+	size_t padding = alignUp(dataStart, CHUNK_ALIGNMENT) - dataStart;
+	size_t paddedSize = alignUp(padding + worldBytes.size(), alignof(CapturedForce));
+
+	TickCaptureRecordHeader record{TickCaptureRecordType::KEYFRAME, 0, world.age, paddedSize};
+	::serialize(record, ostream);
+	std::vector<char> zeros(CHUNK_ALIGNMENT, 0);
+	::serialize(zeros.data(), padding, ostream);
+	::serialize(worldBytes.data(), worldBytes.size(), ostream);
+	::serialize(zeros.data(), paddedSize - padding - worldBytes.size(), ostream);
+	bytesWritten += sizeof(TickCaptureRecordHeader) + paddedSize;
+	keyframeCount++;
+}
+
+void TickCapture::beforeTick(const WorldPrototype& world) {
+	if(worldModified || world.getPartSetVersion() != lastPartSetVersion) {
+		writeKeyframe(world);
+		worldModified = false;
+		lastPartSetVersion = world.getPartSetVersion();
+	}
+
+	motionsBeforeTick.clear();
+	for(const MotorizedPhysical* phys : world.physicals) {
+		motionsBeforeTick.push_back(phys->motionOfCenterOfMass);
+	}
+}
+
+void TickCapture::afterExternalForces(WorldPrototype& world) {
+	// apply only the ExternalForces of the world again from zero, what differs from that must be recorded
+	appliedForces.clear();
+	for(MotorizedPhysical* phys : world.physicals) {
+		appliedForces.push_back(std::make_pair(phys->totalForce, phys->totalMoment));
+		phys->totalForce = Vec3(0.0, 0.0, 0.0);
+		phys->totalMoment = Vec3(0.0, 0.0, 0.0);
+	}
+	for(ExternalForce* force : world.externalForces) {
+		force->apply(&world);
+	}
+
+	forces.clear();
+	for(size_t i = 0; i < world.physicals.size(); i++) {
+		MotorizedPhysical* phys = world.physicals[i];
+		bool forceChanged = appliedForces[i].first != phys->totalForce || appliedForces[i].second != phys->totalMoment;
+		bool motionChanged = std::memcmp(&motionsBeforeTick[i], &phys->motionOfCenterOfMass, sizeof(Motion)) != 0;
+		phys->totalForce = appliedForces[i].first;
+		phys->totalMoment = appliedForces[i].second;
+		if(!forceChanged && !motionChanged) continue;
+		forces.push_back(CapturedForce{static_cast<uint32_t>(i), 0, phys->totalForce, phys->totalMoment, phys->motionOfCenterOfMass});
+	}
+	if(!forces.empty()) {
+		TickCaptureRecordHeader record{TickCaptureRecordType::FORCES, static_cast<uint32_t>(forces.size()), world.age, forces.size() * sizeof(CapturedForce)};
+		::serialize(record, ostream);
+		::serialize(reinterpret_cast<const char*>(forces.data()), forces.size() * sizeof(CapturedForce), ostream);
+		bytesWritten += sizeof(TickCaptureRecordHeader) + forces.size() * sizeof(CapturedForce);
+	}
+	tickCount++;
+}
+
+void TickCapture::finish(const WorldPrototype& world) {
+	TickCaptureRecordHeader record{TickCaptureRecordType::END, 0, world.age, 0};
+	::serialize(record, ostream);
+	bytesWritten += sizeof(TickCaptureRecordHeader);
+	ostream.flush();
+}
+
+#pragma endregion
+
+#pragma region replay
+
+class ReplayWorld : public World<Part> {
+public:
+	const CapturedForce* forces = nullptr;
+	size_t forceCount = 0;
+
+	ReplayWorld(double deltaT) : World<Part>(deltaT) {}
+
+	virtual void applyExternalForces() override {
+		World<Part>::applyExternalForces();
+		for(size_t i = 0; i < forceCount; i++) {
+			const CapturedForce& captured = forces[i];
+			MotorizedPhysical* phys = physicals[captured.physicalIndex];
+			phys->totalForce = captured.force;
+			phys->totalMoment = captured.moment;
+			phys->motionOfCenterOfMass = captured.motionOfCenterOfMass;
+		}
+		forces = nullptr;
+		forceCount = 0;
+	}
+};
+
+TickReplay::TickReplay(const char* data, size_t size, const std::vector<const ShapeClass*>& knownShapeClasses) : knownShapeClasses(knownShapeClasses) {
+	if(size < sizeof(TickCaptureHeader) || std::memcmp(data, tickCaptureMagic, sizeof(tickCaptureMagic)) != 0) {
+		throw SerializationException("This is not a tick capture!");
+	}
+	const TickCaptureHeader* header = reinterpret_cast<const TickCaptureHeader*>(data);
+	if(header->versionID != TICK_CAPTURE_VERSION_ID) {
+		throw SerializationException("Tick capture version " + std::to_string(header->versionID) + " is not supported, current version " + std::to_string(TICK_CAPTURE_VERSION_ID));
+	}
+	deltaT = header->deltaT;
+
+	bool ended = false;
+	size_t offset = sizeof(TickCaptureHeader);
+	while(!ended) {
+		if(offset + sizeof(TickCaptureRecordHeader) > size) {
+			throw SerializationException("Tick capture is truncated, it was not finished!");
+		}
+		const TickCaptureRecordHeader* record = reinterpret_cast<const TickCaptureRecordHeader*>(data + offset);
+		size_t dataStart = offset + sizeof(TickCaptureRecordHeader);
+		// compared this way around, a corrupt size can't overflow
+		if(record->size > size - dataStart) {
+			throw SerializationException("Tick capture record at " + std::to_string(offset) + " is truncated!");
+		}
+		switch(record->type) {
+		case TickCaptureRecordType::KEYFRAME: {
+			size_t padding = alignUp(dataStart, CHUNK_ALIGNMENT) - dataStart;
+			if(record->size < padding) {
+				throw SerializationException("Tick capture keyframe record at " + std::to_string(offset) + " is smaller than its padding!");
+			}
+			keyframes.push_back(Keyframe{static_cast<size_t>(record->age), data + dataStart + padding, static_cast<size_t>(record->size) - padding});
+			break;
+		}
+		case TickCaptureRecordType::FORCES:
+			if(record->size % sizeof(CapturedForce) != 0 || record->size / sizeof(CapturedForce) != record->itemCount) {
+				throw SerializationException("Tick capture force record at " + std::to_string(offset) + " has the wrong size!");
+			}
+			tickForces.push_back(TickForces{static_cast<size_t>(record->age), reinterpret_cast<const CapturedForce*>(data + dataStart), record->itemCount});
+			break;
+		case TickCaptureRecordType::END:
+			endAge = static_cast<size_t>(record->age);
+			ended = true;
+			break;
+		default:
+			throw SerializationException("Unknown tick capture record type " + std::to_string(static_cast<uint32_t>(record->type)));
+		}
+		offset = dataStart + static_cast<size_t>(record->size);
+	}
+	if(keyframes.empty()) {
+		throw SerializationException("Tick capture has no keyframe!");
+	}
+
+	loadKeyframe(keyframes[0]);
+	nextKeyframe = 1;
+}
+
+TickReplay::~TickReplay() {
+	destroyWorld();
+}
+
+void TickReplay::destroyWorld() {
+	if(world == nullptr) return;
+
+	// free parts remove themselves from the world, terrain parts are only referenced by their tree
+	std::vector<Part*> freeParts;
+	std::vector<Part*> terrainParts;
+	for(Part& part : world->iterParts(FREE_PARTS)) freeParts.push_back(&part);
+	for(Part& part : world->iterParts(TERRAIN_PARTS)) terrainParts.push_back(&part);
+	for(Part* part : freeParts) delete part;
+	for(ExternalForce* force : world->externalForces) delete force;
+	world.reset();
+	for(Part* part : terrainParts) delete part;
+	session.reset();
+}
+
+void TickReplay::loadKeyframe(const Keyframe& keyframe) {
+	destroyWorld();
+	session = std::make_unique<ChunkedDeSerializationSession>(keyframe.data, keyframe.size, knownShapeClasses);
+	world = std::make_unique<ReplayWorld>(deltaT);
+	session->deserializeWorld(*world);
+}
+
+void TickReplay::prepareTick() {
+	size_t age = world->age;
+	if(nextKeyframe < keyframes.size() && keyframes[nextKeyframe].age == age) {
+		loadKeyframe(keyframes[nextKeyframe]);
+		nextKeyframe++;
+	}
+	// the forces of ticks skipped over by a keyframe are not needed
+	while(nextForces < tickForces.size() && tickForces[nextForces].age < age) {
+		nextForces++;
+	}
+	if(nextForces < tickForces.size() && tickForces[nextForces].age == age) {
+		const TickForces& recorded = tickForces[nextForces];
+		for(size_t i = 0; i < recorded.count; i++) {
+			if(recorded.forces[i].physicalIndex >= world->physicals.size()) {
+				throw SerializationException("Captured force for physical " + std::to_string(recorded.forces[i].physicalIndex) + ", the world only has " + std::to_string(world->physicals.size()));
+			}
+		}
+		world->forces = recorded.forces;
+		world->forceCount = recorded.count;
+		nextForces++;
+	}
+}
+
+World<Part>& TickReplay::getWorld() {
+	return *world;
+}
+
+size_t TickReplay::getAge() const {
+	return world->age;
+}
+
+void TickReplay::tick() {
+	prepareTick();
+	world->tick();
+}
+
+void TickReplay::skipTo(size_t age) {
+	while(world->age < age && !isFinished()) {
+		tick();
+	}
+}
+
+#pragma endregion
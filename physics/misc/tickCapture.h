@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <iostream>
+
+#include "../math/linalg/vec.h"
+#include "../motion.h"
+#include "../world.h"
+#include "chunkedSerialization.h"
+
+/*
+	Tick capture
+
+	Records a running world so the same sequence of ticks can be rerun offline, to reproduce and profile latency spikes.
+
+	The capture starts with a keyframe, the whole world stored in the chunked world format. Modifications made from outside
+	the physics engine, such as those pushed through SynchronizedWorld::asyncModification, are arbitrary functions and can't be
+	stored. Instead the world is stored again as a keyframe before the first tick after any modification, or after parts were
+	added or removed.
+
+	Forces are recorded after the external forces phase of every tick. Only the physicals whose totalForce and totalMoment differ
+	from what the ExternalForces of the world give, or whose motion was changed, are recorded. This covers forces applied
+	between ticks as well as those applied by an overridden applyExternalForces, such as the picker of the application.
+	To find the difference the ExternalForces are applied a second time, so they must not keep state.
+
+	Replaying loads the keyframes at the ticks they were taken, applies the ExternalForces and then the recorded forces.
+	A keyframe rebuilds the trees of the world, so the ticks right after one are not timed exactly as in the captured run.
+	Keyframes store the layers and colission matrix of the world, changing which layers collide between keyframes is not captured.
+	The broadphase of the world is not captured, the replay uses the default.
+
+	See fileStructure.md for the layout of a capture.
+*/
+
+#define TICK_CAPTURE_VERSION_ID 1
+
+enum class TickCaptureRecordType : uint32_t {
+	KEYFRAME = 1,
+	FORCES = 2,
+	END = 3
+};
+
+struct TickCaptureHeader {
+	char magic[8];
+	uint32_t versionID;
+	uint32_t padding;
+	double deltaT;
+};
+
+struct TickCaptureRecordHeader {
+	TickCaptureRecordType type;
+	// the number of forces for FORCES records
+	uint32_t itemCount;
+	// the age of the world at the start of the tick this record belongs to
+	uint64_t age;
+	// the number of bytes following this header
+	uint64_t size;
+};
+
+struct CapturedForce {
+	// index in world.physicals
+	uint32_t physicalIndex;
+	uint32_t padding;
+	Vec3 force;
+	Vec3 moment;
+	Motion motionOfCenterOfMass;
+};
+
+class TickCapture {
+	std::ostream& ostream;
+	ChunkedSerializationSession session;
+	std::vector<CapturedForce> forces;
+	std::vector<Motion> motionsBeforeTick;
+	std::vector<std::pair<Vec3, Vec3>> appliedForces;
+	// keyframes are aligned relative to the start of the capture
+	size_t bytesWritten = 0;
+	// the first tick always writes a keyframe
+	bool worldModified = true;
+	size_t lastPartSetVersion = 0;
+	size_t keyframeCount = 0;
+	size_t tickCount = 0;
+
+	void writeKeyframe(const WorldPrototype& world);
+public:
+	// knownShapeClasses are passed on to the ChunkedSerializationSession writing the keyframes
+	TickCapture(std::ostream& ostream, double deltaT, const std::vector<const ShapeClass*>& knownShapeClasses = std::vector<const ShapeClass*>());
+
+	// the world was changed in a way that is not recorded otherwise, the next tick writes a keyframe
+	inline void markModified() { worldModified = true; }
+
+	// must be called at the start of every tick, before the world computes anything
+	void beforeTick(const WorldPrototype& world);
+	// must be called right after the world applied its external forces
+	void afterExternalForces(WorldPrototype& world);
+	// writes the end of the capture, the world must not be ticked again afterwards
+	void finish(const WorldPrototype& world);
+
+	inline size_t getKeyframeCount() const { return keyframeCount; }
+	inline size_t getTickCount() const { return tickCount; }
+};
+
+class ReplayWorld;
+
+/*
+	Reruns a capture from memory, such as a MappedFile, which must outlive the replay.
+	The world is owned by the replay, and replaced at every keyframe.
+*/
+class TickReplay {
+	struct Keyframe {
+		size_t age;
+		const char* data;
+		size_t size;
+	};
+	struct TickForces {
+		size_t age;
+		const CapturedForce* forces;
+		size_t count;
+	};
+
+	double deltaT;
+	std::vector<const ShapeClass*> knownShapeClasses;
+	std::vector<Keyframe> keyframes;
+	std::vector<TickForces> tickForces;
+	size_t endAge = 0;
+	size_t nextKeyframe = 0;
+	size_t nextForces = 0;
+
+	// the session owns the polyhedra of the parts in the world, so it is destroyed after the world
+	std::unique_ptr<ChunkedDeSerializationSession> session;
+	std::unique_ptr<ReplayWorld> world;
+
+	void loadKeyframe(const Keyframe& keyframe);
+	void destroyWorld();
+public:
+	// throws SerializationException if the capture is malformed
+	TickReplay(const char* data, size_t size, const std::vector<const ShapeClass*>& knownShapeClasses = std::vector<const ShapeClass*>());
+	~TickReplay();
+
+	TickReplay(const TickReplay&) = delete;
+	TickReplay& operator=(const TickReplay&) = delete;
+
+	World<Part>& getWorld();
+	size_t getAge() const;
+	inline size_t getFirstAge() const { return keyframes.front().age; }
+	inline size_t getEndAge() const { return endAge; }
+	inline size_t getKeyframeCount() const { return keyframes.size(); }
+	inline bool isFinished() const { return getAge() >= endAge; }
+
+	// loads the keyframe and selects the forces of the next tick, so only world.tick() is left to profile
+	void prepareTick();
+	// prepareTick followed by world.tick()
+	void tick();
+	// ticks until the world reaches the given age, or the end of the capture
+	void skipTo(size_t age);
+};
@@ -1,5 +1,7 @@
 #include "part.h"
 
+#include <cmath>
+
 #include "physical.h"
 
 #include "geometry/intersection.h"
@@ -38,6 +40,8 @@ Part::~Part() {
 
 Part::Part(Part&& other) :
 	isTerrainPart(other.isTerrainPart),
+	layer(other.layer),
+	treeNode(other.treeNode),
 	parent(other.parent), 
 	hitbox(std::move(other.hitbox)), 
 	maxRadius(other.maxRadius), 
@@ -45,10 +49,13 @@ Part::Part(Part&& other) :
 
 	if(parent != nullptr) parent->notifyPartStdMoved(&other, this);
 
+	other.treeNode = nullptr;
 	other.parent = nullptr;
 }
 Part& Part::operator=(Part&& other) {
 	this->isTerrainPart = other.isTerrainPart;
+	this->layer = other.layer;
+	this->treeNode = other.treeNode;
 	this->parent = other.parent;
 	this->hitbox = std::move(other.hitbox);
 	this->maxRadius = other.maxRadius;
@@ -56,6 +63,7 @@ Part& Part::operator=(Part&& other) {
 
 	if(parent != nullptr) parent->notifyPartStdMoved(&other, this);
 
+	other.treeNode = nullptr;
 	other.parent = nullptr;
 
 	return *this;
@@ -91,6 +99,29 @@ Bounds Part::getStrictBounds() const {
 	return boundsOfHitbox + getPosition();
 }
 
+std::optional<Bounds> Part::getRigidGroupBounds() const {
+	const MotorizedPhysical* mainPhysical = this->parent->mainPhysical;
+	if(!mainPhysical->childPhysicals.empty()) return std::optional<Bounds>();
+	return mainPhysical->rigidBody.getLooseBounds();
+}
+
+Bounds Part::getStrictBoundsRelativeTo(const Part& reference) const {
+	CFrame relativeCFrame = reference.cframe.globalToLocal(this->cframe);
+	BoundingBox boundsOfHitbox = this->hitbox.getBounds(relativeCFrame.getRotation());
+	return boundsOfHitbox + (Position() + relativeCFrame.getPosition());
+}
+
+Bounds Part::getGlobalBoundsOf(const Bounds& localBounds) const {
+	Mat3 rotation = this->cframe.getRotation().asRotationMatrix();
+	Vec3 localHalfSize = Vec3(localBounds.max - localBounds.min) / 2;
+	Vec3 halfSize;
+	for(int axis = 0; axis < 3; axis++) {
+		// a small margin, so the bounds of the parts are always contained despite rounding
+		halfSize[axis] = std::abs(rotation[axis][0]) * localHalfSize.x + std::abs(rotation[axis][1]) * localHalfSize.y + std::abs(rotation[axis][2]) * localHalfSize.z + 1E-6;
+	}
+	return BoundingBox(-halfSize, halfSize) + this->cframe.localToGlobal(Vec3(localBounds.getCenter() - Position()));
+}
+
 void Part::scale(double scaleX, double scaleY, double scaleZ) {
 	Bounds oldBounds = this->getStrictBounds();
 	this->hitbox = this->hitbox.scaled(scaleX, scaleY, scaleZ);
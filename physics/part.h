@@ -7,6 +7,9 @@ class Physical;
 class ConnectedPhysical;
 class MotorizedPhysical;
 class WorldPrototype;
+struct TreeNode;
+#include <optional>
+
 #include "geometry/shape.h"
 #include "math/linalg/mat.h"
 #include "math/position.h"
@@ -52,6 +55,10 @@ class Part {
 
 public:
 	bool isTerrainPart = false;
+	// index of the layer of the world this part is in
+	int layer = 0;
+	// the node of this part in the tree of its layer, kept up to date by the tree so the part never has to be searched for. nullptr while not in a world
+	TreeNode* treeNode = nullptr;
 	Physical* parent = nullptr;
 	Shape hitbox;
 	double maxRadius;
@@ -72,6 +79,12 @@ public:
 	void scale(double scaleX, double scaleY, double scaleZ);
 
 	Bounds getStrictBounds() const;
+	// bounds of all parts of the MotorizedPhysical of this part in constant time, only available if none of them can move relative to each other
+	std::optional<Bounds> getRigidGroupBounds() const;
+	// bounds of this part in the frame of reference, the BoundsTree keeps the nodes inside rigid groups in the frame of one of their parts
+	Bounds getStrictBoundsRelativeTo(const Part& reference) const;
+	// global bounds containing the given bounds, which are in the frame of this part
+	Bounds getGlobalBoundsOf(const Bounds& localBounds) const;
 
 	BoundingBox getLocalBounds() const;
 
@@ -40,7 +40,10 @@ Physical::Physical(RigidBody&& rigidBody, MotorizedPhysical* mainPhysical) : rig
 Physical::Physical(Physical&& other) noexcept :
 	rigidBody(std::move(other.rigidBody)), 
 	mainPhysical(other.mainPhysical),
-	childPhysicals(std::move(other.childPhysicals)) {
+	childPhysicals(std::move(other.childPhysicals)),
+	subtreeMass(other.subtreeMass),
+	subtreeCenterOfMass(other.subtreeCenterOfMass),
+	subtreeInertia(other.subtreeInertia) {
 	for(Part& p : this->rigidBody) {
 		p.parent = this;
 	}
@@ -53,6 +56,9 @@ Physical& Physical::operator=(Physical&& other) noexcept {
 	this->rigidBody = std::move(other.rigidBody);
 	this->mainPhysical = other.mainPhysical;
 	this->childPhysicals = std::move(other.childPhysicals);
+	this->subtreeMass = other.subtreeMass;
+	this->subtreeCenterOfMass = other.subtreeCenterOfMass;
+	this->subtreeInertia = other.subtreeInertia;
 	for(Part& p : this->rigidBody) {
 		p.parent = this;
 	}
@@ -71,6 +77,8 @@ void Physical::makeMainPart(Part* newMainPart) {
 	AttachedPart& atPart = rigidBody.getAttachFor(newMainPart);
 	
 	makeMainPart(atPart);
+	// the cached mass properties are local to the main part
+	this->mainPhysical->refreshPhysicalProperties();
 }
 
 void Physical::makeMainPart(AttachedPart& newMainPart) {
@@ -430,7 +438,7 @@ void Physical::detachPart(Part* part, bool partStaysInWorld) {
 
 		WorldPrototype* world = this->mainPhysical->world;
 		if(world != nullptr) {
-			world->addPart(part);
+			world->addPart(part, part->layer);
 		}
 	} else {
 		part->parent = nullptr;
@@ -439,6 +447,7 @@ void Physical::detachPart(Part* part, bool partStaysInWorld) {
 
 void Physical::notifyPartPropertiesChanged(Part* part) {
 	rigidBody.refreshWithNewParts();
+	this->mainPhysical->refreshPhysicalProperties();
 }
 void Physical::notifyPartPropertiesAndBoundsChanged(Part* part, const Bounds& oldBounds) {
 	notifyPartPropertiesChanged(part);
@@ -491,17 +500,18 @@ void MotorizedPhysical::setCFrame(const GlobalCFrame& newCFrame) {
 	if(this->mainPhysical->world != nullptr) {
 		Bounds oldMainPartBounds = this->rigidBody.mainPart->getStrictBounds();
 
-		rigidBody.setCFrame(newCFrame);
-		for(ConnectedPhysical& conPhys : childPhysicals) {
-			conPhys.refreshCFrameRecursive();
-		}
+		setCFrameUnsafe(newCFrame);
 
 		this->mainPhysical->world->updatePartGroupBounds(this->rigidBody.mainPart, oldMainPartBounds);
 	} else {
-		rigidBody.setCFrame(newCFrame);
-		for(ConnectedPhysical& conPhys : childPhysicals) {
-			conPhys.refreshCFrameRecursive();
-		}
+		setCFrameUnsafe(newCFrame);
+	}
+}
+
+void MotorizedPhysical::setCFrameUnsafe(const GlobalCFrame& newCFrame) {
+	rigidBody.setCFrame(newCFrame);
+	for(ConnectedPhysical& conPhys : childPhysicals) {
+		conPhys.refreshCFrameRecursive();
 	}
 }
 
@@ -544,40 +554,58 @@ void MotorizedPhysical::translate(const Vec3& translation) {
 	mainPhysical->world->updatePartGroupBounds(this->rigidBody.mainPart, oldBounds);
 }
 
-static std::pair<Vec3, double> getRecursiveCenterOfMass(const Physical& phys) {
-	Vec3 totalCOM = phys.rigidBody.mass * phys.rigidBody.localCenterOfMass;
-	double totalMass = phys.rigidBody.mass;
-	for(const ConnectedPhysical& conPhys : phys.childPhysicals) {
+void Physical::combineSubtreeProperties() {
+	Vec3 totalCOM = rigidBody.mass * rigidBody.localCenterOfMass;
+	double totalMass = rigidBody.mass;
+	for(const ConnectedPhysical& conPhys : childPhysicals) {
 		CFrame relFrame = conPhys.getRelativeCFrameToParent();
-		std::pair<Vec3, double> localCOM = getRecursiveCenterOfMass(conPhys);
-		totalCOM += localCOM.second * relFrame.localToGlobal(localCOM.first);
-		totalMass += localCOM.second;
+		totalCOM += conPhys.subtreeMass * relFrame.localToGlobal(conPhys.subtreeCenterOfMass);
+		totalMass += conPhys.subtreeMass;
 	}
-	return std::pair<Vec3, double>(totalCOM / totalMass, totalMass);
-}
-
-static SymmetricMat3 getRecursiveInertia(const Physical& phys, const CFrame& offsetCFrame, const Vec3& localCOMOfMain) {
-	SymmetricMat3 totalInertia = getTransformedInertiaAroundCenterOfMass(phys.rigidBody.inertia, phys.rigidBody.localCenterOfMass, offsetCFrame, localCOMOfMain, phys.rigidBody.mass);
+	subtreeMass = totalMass;
+	subtreeCenterOfMass = totalCOM / totalMass;
 
-	for(const ConnectedPhysical& conPhys : phys.childPhysicals) {
-		CFrame cframeToConPhys = conPhys.getRelativeCFrameToParent();
-
-		CFrame offsetOfConPhys = offsetCFrame.localToGlobal(cframeToConPhys);
+	SymmetricMat3 totalInertia = getTranslatedInertiaAroundCenterOfMass(rigidBody.inertia, rigidBody.localCenterOfMass, subtreeCenterOfMass, rigidBody.mass);
+	for(const ConnectedPhysical& conPhys : childPhysicals) {
+		CFrame relFrame = conPhys.getRelativeCFrameToParent();
+		totalInertia += getTransformedInertiaAroundCenterOfMass(conPhys.subtreeInertia, conPhys.subtreeCenterOfMass, relFrame, subtreeCenterOfMass, conPhys.subtreeMass);
+	}
+	subtreeInertia = totalInertia;
+}
 
-		totalInertia += getRecursiveInertia(conPhys, offsetOfConPhys, localCOMOfMain);
+void Physical::refreshSubtreeProperties() {
+	for(ConnectedPhysical& conPhys : childPhysicals) {
+		conPhys.refreshSubtreeProperties();
 	}
-	return totalInertia;
+	combineSubtreeProperties();
 }
 
-void MotorizedPhysical::refreshPhysicalProperties() {
-	std::pair<Vec3, double> result = getRecursiveCenterOfMass(*this);
-	totalCenterOfMass = result.first;
-	totalMass = result.second;
+bool Physical::refreshChangedSubtreeProperties() {
+	bool changed = false;
+	for(ConnectedPhysical& conPhys : childPhysicals) {
+		// every child must be visited, a changed subtree further down the list also has to be refreshed
+		bool childChanged = conPhys.refreshChangedSubtreeProperties();
+		if(childChanged || conPhys.connectionToParent.constraintWithParent->changesRelativeCFrame()) {
+			changed = true;
+		}
+	}
+	if(changed) {
+		combineSubtreeProperties();
+	}
+	return changed;
+}
 
-	SymmetricMat3 totalInertia = getRecursiveInertia(*this, CFrame(0, 0, 0), totalCenterOfMass);
+void MotorizedPhysical::applySubtreeProperties() {
+	totalCenterOfMass = subtreeCenterOfMass;
+	totalMass = subtreeMass;
 
 	forceResponse = SymmetricMat3::IDENTITY() * (1 / totalMass);
-	momentResponse = ~totalInertia;
+	momentResponse = ~subtreeInertia;
+}
+
+void MotorizedPhysical::refreshPhysicalProperties() {
+	refreshSubtreeProperties();
+	applySubtreeProperties();
 }
 
 void ConnectedPhysical::refreshCFrame() {
@@ -625,7 +653,10 @@ void MotorizedPhysical::update(double deltaT) {
 	updateConstraints(deltaT);
 
 	Vec3 oldCenterOfMass = this->totalCenterOfMass;
-	refreshPhysicalProperties();
+	// physicals without moving constraints keep their mass properties
+	if(refreshChangedSubtreeProperties()) {
+		applySubtreeProperties();
+	}
 	Vec3 deltaCOM = this->totalCenterOfMass - oldCenterOfMass;
 
 
@@ -32,6 +32,13 @@ protected:
 
 	void setMainPhysicalRecursive(MotorizedPhysical* newMainPhysical);
 
+	// recomputes the subtree mass properties of this physical and all physicals attached below it
+	void refreshSubtreeProperties();
+	// only recomputes the subtrees below constraints that change, returns true if the subtree properties of this physical changed
+	bool refreshChangedSubtreeProperties();
+	// computes the subtree mass properties of this physical from those of its children
+	void combineSubtreeProperties();
+
 	// deletes the given physical
 	void attachPhysical(Physical* phys, const CFrame& attachment);
 	// deletes the given physical
@@ -61,6 +68,15 @@ public:
 	MotorizedPhysical* mainPhysical;
 	UnorderedVector<ConnectedPhysical> childPhysicals;
 
+	/*
+		The mass properties of this physical and all physicals attached below it, local to this physical. 
+		subtreeInertia is around subtreeCenterOfMass. 
+		These are cached, so rigid subtrees don't have to be recomputed every tick
+	*/
+	double subtreeMass = 0.0;
+	Vec3 subtreeCenterOfMass = Vec3(0.0, 0.0, 0.0);
+	SymmetricMat3 subtreeInertia;
+
 	Physical() = default;
 	Physical(Part* mainPart, MotorizedPhysical* mainPhysical);
 	Physical(RigidBody&& rigidBody, MotorizedPhysical* mainPhysical);
@@ -172,7 +188,10 @@ class MotorizedPhysical : public Physical {
 	friend class Physical;
 	friend class ConnectedPhysical;
 	void rotateAroundCenterOfMassUnsafe(const Rotation& rotation);
+	// copies the cached subtree properties of this physical to the total mass properties
+	void applySubtreeProperties();
 public:
+	// recomputes all mass properties, must be called when parts are attached, detached or resized
 	void refreshPhysicalProperties();
 	Vec3 totalForce = Vec3(0.0, 0.0, 0.0);
 	Vec3 totalMoment = Vec3(0.0, 0.0, 0.0);
@@ -181,6 +200,10 @@ public:
 	Vec3 totalCenterOfMass;
 
 	WorldPrototype* world = nullptr;
+	// index of this physical in world->physicals, so it can be removed without searching
+	size_t indexInWorld = 0;
+	// set while this physical has edits in the current batch edit of its world
+	bool hasBatchEdit = false;
 	
 	SymmetricMat3 forceResponse;
 	SymmetricMat3 momentResponse;
@@ -215,6 +238,8 @@ public:
 	void update(double deltaT);
 
 	void setCFrame(const GlobalCFrame& newCFrame);
+	// does not update the bounds of the world, the caller is responsible for recalculating the bounds of the objectTree
+	void setCFrameUnsafe(const GlobalCFrame& newCFrame);
 	void rotateAroundCenterOfMass(const Rotation& rotation);
 	void translate(const Vec3& translation);
 
@@ -5,6 +5,8 @@
 
 #include "datastructures/buffers.h"
 #include "parallelArray.h"
+#include "latencyHistogram.h"
+#include "hardwareCounters.h"
 
 class TimerMeasure {
 	std::chrono::time_point<std::chrono::steady_clock> lastClock = std::chrono::high_resolution_clock::now();
@@ -60,18 +62,68 @@ public:
 	}
 };
 
+/*
+	Latency histograms of whole ticks and of the time each process took within a tick
+	A tick is the time from the first mark to end()
+*/
+template<typename ProcessType>
+struct LatencyBreakdown {
+	LatencyHistogram tick;
+	LatencyHistogram processes[static_cast<size_t>(ProcessType::COUNT)];
+
+	inline void record(const ParallelArray<std::chrono::nanoseconds, static_cast<size_t>(ProcessType::COUNT)>& tally) {
+		std::chrono::nanoseconds tickTime(0);
+		for(size_t i = 0; i < static_cast<size_t>(ProcessType::COUNT); i++) {
+			processes[i].record(tally.values[i]);
+			tickTime += tally.values[i];
+		}
+		tick.record(tickTime);
+	}
+
+	void merge(const LatencyBreakdown& other) {
+		tick.merge(other.tick);
+		for(size_t i = 0; i < static_cast<size_t>(ProcessType::COUNT); i++) {
+			processes[i].merge(other.processes[i]);
+		}
+	}
+
+	void reset() {
+		tick.reset();
+		for(LatencyHistogram& process : processes) process.reset();
+	}
+};
+
 template<typename ProcessType>
 class BreakdownAverageProfiler : public HistoricTally<std::chrono::nanoseconds, ProcessType> {
 	std::chrono::time_point<std::chrono::steady_clock> startTime = std::chrono::high_resolution_clock::now();
 	ProcessType currentProcess = static_cast<ProcessType>(-1);
 
+	// every tick since the last reset, or since the start of the current window
+	LatencyBreakdown<ProcessType> currentLatency;
+	LatencyBreakdown<ProcessType> lastWindowLatency;
+	std::chrono::nanoseconds latencyWindow{0};
+	std::chrono::time_point<std::chrono::steady_clock> windowStart = std::chrono::high_resolution_clock::now();
+
+	HardwareCounterReading lastCounterReading;
+
+	// gives the counts since the last mark to the given process, only while HardwareCounters are enabled
+	inline void countHardware(ProcessType process) {
+		HardwareCounterReading reading = HardwareCounters::read();
+		if(process != static_cast<ProcessType>(-1)) {
+			hardwareCounts[static_cast<size_t>(process)] += countsBetween(lastCounterReading, reading);
+		}
+		lastCounterReading = reading;
+	}
 
 public:
 	CircularBuffer<std::chrono::time_point<std::chrono::steady_clock>> tickHistory;
+	// hardware counts of each process since the last resetHardwareCounts, stays 0 unless HardwareCounters are enabled
+	HardwareCounterValues hardwareCounts[static_cast<size_t>(ProcessType::COUNT)];
 
 	inline BreakdownAverageProfiler(char const * const labels[static_cast<size_t>(ProcessType::COUNT)], size_t capacity) : HistoricTally<std::chrono::nanoseconds, ProcessType>(labels, capacity), tickHistory(capacity) {}
 
 	inline void mark(ProcessType process) {
+		if(HardwareCounters::isEnabled()) countHardware(currentProcess);
 		std::chrono::time_point<std::chrono::steady_clock> curTime = std::chrono::high_resolution_clock::now();
 		if(currentProcess != static_cast<ProcessType>(-1)) {
 			HistoricTally<std::chrono::nanoseconds, ProcessType>::addToTally(currentProcess, curTime - startTime);
@@ -81,6 +133,7 @@ public:
 	}
 
 	inline void mark(ProcessType process, ProcessType overrideOldProcess) {
+		if(HardwareCounters::isEnabled()) countHardware((currentProcess != static_cast<ProcessType>(-1)) ? overrideOldProcess : currentProcess);
 		std::chrono::time_point<std::chrono::steady_clock> curTime = std::chrono::high_resolution_clock::now();
 		if (currentProcess != static_cast<ProcessType>(-1)) {
 			HistoricTally<std::chrono::nanoseconds, ProcessType>::addToTally(overrideOldProcess, curTime - startTime);
@@ -90,12 +143,44 @@ public:
 	}
 
 	inline void end() {
+		if(HardwareCounters::isEnabled()) countHardware(currentProcess);
 		std::chrono::time_point<std::chrono::steady_clock> curTime = std::chrono::high_resolution_clock::now();
 		this->addToTally(currentProcess, curTime - startTime);
 		tickHistory.add(curTime);
 
 		currentProcess = static_cast<ProcessType>(-1);
 		this->nextTally();
+
+		currentLatency.record(this->history.front());
+		if(latencyWindow.count() != 0 && curTime - windowStart >= latencyWindow) {
+			lastWindowLatency = currentLatency;
+			currentLatency.reset();
+			windowStart = curTime;
+		}
+	}
+
+	/*
+		With a window of zero, the default, the latency histograms cover every tick since the last resetLatency
+		Otherwise getLatency gives the last complete window, and the histograms restart every window
+	*/
+	inline void setLatencyWindow(std::chrono::nanoseconds window) {
+		latencyWindow = window;
+		resetLatency();
+	}
+
+	inline void resetLatency() {
+		currentLatency.reset();
+		lastWindowLatency.reset();
+		windowStart = std::chrono::high_resolution_clock::now();
+	}
+
+	inline void resetHardwareCounts() {
+		for(HardwareCounterValues& counts : hardwareCounts) counts = HardwareCounterValues();
+		lastCounterReading = HardwareCounters::read();
+	}
+
+	inline const LatencyBreakdown<ProcessType>& getLatency() const {
+		return (latencyWindow.count() != 0) ? lastWindowLatency : currentLatency;
 	}
 
 	inline double getAvgTPS() {
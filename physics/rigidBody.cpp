@@ -1,5 +1,8 @@
 #include "rigidBody.h"
 
+#include <algorithm>
+#include <cmath>
+
 #include "inertia.h"
 
 #include "../util/log.h"
@@ -10,7 +13,8 @@ RigidBody::RigidBody(Part* mainPart) :
 	mainPart(mainPart), 
 	mass(mainPart->getMass()),
 	localCenterOfMass(mainPart->getLocalCenterOfMass()),
-	inertia(mainPart->getInertia()) {}
+	inertia(mainPart->getInertia()),
+	localBounds(mainPart->hitbox.getBounds(Rotation())) {}
 
 void RigidBody::attach(RigidBody&& otherBody, const CFrame& attachment) {
 	size_t originalAttachCount = this->parts.size();
@@ -23,6 +27,8 @@ void RigidBody::attach(RigidBody&& otherBody, const CFrame& attachment) {
 		this->parts.push_back(AttachedPart{globalAttach, ap.part});
 		ap.part->cframe = cf.localToGlobal(globalAttach);
 	}
+
+	refreshWithNewParts();
 }
 void RigidBody::attach(Part* part, const CFrame& attachment) {
 	parts.push_back(AttachedPart{attachment, part});
@@ -119,6 +125,29 @@ void RigidBody::refreshWithNewParts() {
 	this->mass = totalMass;
 	this->localCenterOfMass = totalCenterOfMass;
 	this->inertia = totalInertia;
+
+	BoundingBox totalBounds = mainPart->hitbox.getBounds(Rotation());
+	for(const AttachedPart& p : parts) {
+		BoundingBox partBounds = p.part->hitbox.getBounds(p.attachment.getRotation());
+		Vec3 offset = p.attachment.getPosition();
+		for(int axis = 0; axis < 3; axis++) {
+			totalBounds.min[axis] = std::min(totalBounds.min[axis], partBounds.min[axis] + offset[axis]);
+			totalBounds.max[axis] = std::max(totalBounds.max[axis], partBounds.max[axis] + offset[axis]);
+		}
+	}
+	this->localBounds = totalBounds;
+}
+
+Bounds RigidBody::getLooseBounds() const {
+	const GlobalCFrame& cframe = getCFrame();
+	Mat3 rotation = cframe.getRotation().asRotationMatrix();
+	Vec3 localHalfSize = (localBounds.max - localBounds.min) / 2;
+	Vec3 halfSize;
+	for(int axis = 0; axis < 3; axis++) {
+		// a small margin, so the bounds of the parts are always contained despite rounding
+		halfSize[axis] = std::abs(rotation[axis][0]) * localHalfSize.x + std::abs(rotation[axis][1]) * localHalfSize.y + std::abs(rotation[axis][2]) * localHalfSize.z + 1E-6;
+	}
+	return BoundingBox(-halfSize, halfSize) + cframe.localToGlobal(localBounds.getCenter());
 }
 
 void RigidBody::setCFrame(const GlobalCFrame& newCFrame) {
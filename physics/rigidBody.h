@@ -53,6 +53,7 @@ public:
 	double mass;            // not part of official state, updated at every tick
 	Vec3 localCenterOfMass; // not part of official state, updated at every tick
 	SymmetricMat3 inertia;  // not part of official state, updated at every tick
+	BoundingBox localBounds; // not part of official state, bounds of all parts in the frame of the mainPart, updated when the parts change
 
 
 	RigidBody() = default;
@@ -108,6 +109,9 @@ public:
 		return GlobalCFrame(getCFrame().localToGlobal(localCenterOfMass), getCFrame().getRotation());
 	}
 
+	// bounds of all parts together in constant time, looser than the union of the bounds of the parts
+	Bounds getLooseBounds() const;
+
 	bool isValid() const;
 
 	void refreshWithNewParts();
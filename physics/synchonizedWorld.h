@@ -8,6 +8,9 @@
 #include "world.h"
 #include "sharedLockGuard.h"
 #include "physicsProfiler.h"
+#include "debug.h"
+#include "zoneProfiler.h"
+#include "misc/tickCapture.h"
 
 template<typename T = Part>
 class SynchronizedWorld : public World<T> {
@@ -18,6 +21,8 @@ class SynchronizedWorld : public World<T> {
 	std::queue<std::function<void()>> waitingOperations;
 	mutable std::queue<std::function<void()>> waitingReadOnlyOperations;
 
+	TickCapture* capture = nullptr;
+
 	void pushOperation(const std::function<void()>& func) {
 		std::lock_guard<std::mutex> lg(queueLock);
 		waitingOperations.push(func);
@@ -30,6 +35,7 @@ class SynchronizedWorld : public World<T> {
 	void processQueue() {
 		std::lock_guard<std::mutex> lg(queueLock);
 
+		if(capture != nullptr && !waitingOperations.empty()) capture->markModified();
 		while (!waitingOperations.empty()) {
 			std::function<void()>& operation = waitingOperations.front();
 			operation();
@@ -47,17 +53,33 @@ class SynchronizedWorld : public World<T> {
 		}
 	}
 
+protected:
+	virtual void onExternalForcesApplied() override {
+		if(capture != nullptr) capture->afterExternalForces(*this);
+	}
+
 public:
 
 	SynchronizedWorld<T>(double deltaT) : World<T>(deltaT) {}
 
+	/*
+		Records every following tick into the given capture, modifications mark the world as changed, so the capture
+		stores a keyframe before the next tick. Pass nullptr to stop capturing, the capture must then still be finished.
+	*/
+	void setCapture(TickCapture* newCapture) {
+		std::lock_guard<std::shared_mutex> lg(lock);
+		capture = newCapture;
+	}
+
 	void syncModification(const std::function<void()>& function) {
 		std::lock_guard<std::shared_mutex> lg(lock);
+		if(capture != nullptr) capture->markModified();
 		function();
 	}
 	void asyncModification(const std::function<void()>& function) {
 		if (lock.try_lock()) {
 			UnlockOnDestroy lg(lock);
+			if(capture != nullptr) capture->markModified();
 			function();
 		} else {
 			pushOperation(function);
@@ -77,18 +99,14 @@ public:
 	}
 
 	virtual void tick() override {
+		PROFILE_FRAME("tick");
+		assert(!this->isInBatchEdit());
 		SharedLockGuard mutLock(lock);
-		
-		this->findColissions();
-		
-		physicsMeasure.mark(PhysicsProcess::EXTERNALS);
-		this->applyExternalForces();
-
-		this->handleColissions();
+		Debug::logTick(this->age);
 
-		intersectionStatistics.nextTally();
-
-		this->handleConstraints();
+		if(capture != nullptr) capture->beforeTick(*this);
+		
+		this->computeForces();
 
 		physicsMeasure.mark(PhysicsProcess::WAIT_FOR_LOCK);
 		mutLock.upgrade();
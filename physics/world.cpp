@@ -1,7 +1,11 @@
 #include "world.h"
 
 #include <algorithm>
+#include <unordered_map>
 #include "../util/log.h"
+#include "broadphase/treeBroadphase.h"
+#include "geometry/intersection.h"
+#include "geometry/shapeClass.h"
 
 #ifndef NDEBUG
 #define ASSERT_VALID if (!isValid()) throw "World not valid!";
@@ -16,18 +20,31 @@ void recursiveTreeValidCheck(const TreeNode & node, bool hasAlreadyPassedGroupHe
 	if(hasAlreadyPassedGroupHead && node.isGroupHead) {
 		throw "Another group head found below one!";
 	}
+	if(node.needsRefit) {
+		throw "A node in the tree is still marked to be refitted!";
+	}
 	if(node.isLeafNode()) {
 		if(!hasAlreadyPassedGroupHead && !node.isGroupHead) {
 			throw "No group head found in this subtree!";
 		}
+		if(static_cast<const Part*>(node.object)->treeNode != &node) {
+			throw "A part does not link to its node in the tree!";
+		}
 	} else {
+		for(const TreeNode& n : node) {
+			if(n.parent != &node) {
+				throw "A node in the tree does not link to its parent!";
+			}
+		}
 		Bounds bounds = node[0].bounds;
 		for(int i = 1; i < node.nodeCount; i++) {
 			bounds = unionOfBounds(bounds, node[i].bounds);
 		}
-		if(bounds != node.bounds) {
+		// rigid groups are refitted as a whole, their bounds may be larger than those of their nodes
+		if(node.isGroupHead ? !node.bounds.contains(bounds) && !node.hasOutdatedSubBounds : bounds != node.bounds) {
 			throw "A node in the tree does not have valid bounds!";
 		}
+		if(node.hasOutdatedSubBounds) return;
 
 		for(TreeNode& n : node) {
 			recursiveTreeValidCheck(n, node.isGroupHead || hasAlreadyPassedGroupHead);
@@ -66,12 +83,18 @@ inline static void treeValidCheck(const BoundsTree<Part>& tree) {
 }
 
 bool WorldPrototype::isValid() const {
-	for(const MotorizedPhysical* phys : iterPhysicals()) {
+	for(size_t i = 0; i < physicals.size(); i++) {
+		const MotorizedPhysical* phys = physicals[i];
 		if(phys->world != this) {
 			Log::error("physicals's world is not correct!");
 			__debugbreak();
 			return false;
 		}
+		if(phys->indexInWorld != i) {
+			Log::error("physicals's indexInWorld is not correct!");
+			__debugbreak();
+			return false;
+		}
 
 		if(!isPhysicalValid(phys, phys)) {
 			Log::error("Physical invalid!");
@@ -80,45 +103,97 @@ bool WorldPrototype::isValid() const {
 		}
 	}
 
-	treeValidCheck(objectTree);
-	treeValidCheck(terrainTree);
+	for(const std::unique_ptr<Layer>& layer : layers) {
+		treeValidCheck(layer->tree);
+	}
 
 	return true;
 }
 #pragma endregion
 
-class Layer {
-	BoundsTree<Part>& tree;
-public:
-	Layer(BoundsTree<Part>& tree) : tree(tree) {}
-};
-
+static std::vector<std::unique_ptr<Layer>> createDefaultLayers() {
+	std::vector<std::unique_ptr<Layer>> result;
+	result.reserve(MAX_LAYERS);
+	result.emplace_back(new Layer(false));
+	result.emplace_back(new Layer(true));
+	return result;
+}
 
 WorldPrototype::WorldPrototype(double deltaT) : 
 	deltaT(deltaT), 
-	layers{Layer{objectTree}, Layer{terrainTree}},
-	colissionMatrix(2) {
+	broadphase(new TreeBroadphase()),
+	layers(createDefaultLayers()),
+	colissionMatrix(2),
+	objectTree(layers[DEFAULT_LAYER]->tree),
+	terrainTree(layers[DEFAULT_TERRAIN_LAYER]->tree) {
 	colissionMatrix.get(0, 0) = true; // free-free
 	colissionMatrix.get(1, 0) = true; // free-terrain
 	colissionMatrix.get(1, 1) = false; // terrain-terrain
 }
 
+void WorldPrototype::setBroadphase(Broadphase* newBroadphase) {
+	broadphase.reset(newBroadphase);
+}
+
+int WorldPrototype::createLayer(bool isTerrainLayer) {
+	if(layers.size() >= MAX_LAYERS) throw "Too many layers!";
+
+	LargeSymmetricMatrix<bool> newMatrix(layers.size() + 1);
+	for(size_t i = 0; i < layers.size(); i++) {
+		for(size_t j = 0; j <= i; j++) {
+			newMatrix.get(i, j) = colissionMatrix.get(i, j);
+		}
+		newMatrix.get(layers.size(), i) = false;
+	}
+	newMatrix.get(layers.size(), layers.size()) = false;
+	colissionMatrix = std::move(newMatrix);
+
+	layers.emplace_back(new Layer(isTerrainLayer));
+	return static_cast<int>(layers.size() - 1);
+}
+
+void WorldPrototype::setLayersCollide(int layerA, int layerB, bool collide) {
+	if(collide && layers[layerA]->isTerrainLayer && layers[layerB]->isTerrainLayer) {
+		throw "Terrain layers can not collide with each other!";
+	}
+	colissionMatrix.get(layerA, layerB) = collide;
+}
+
+bool WorldPrototype::doLayersCollide(int layerA, int layerB) const {
+	return const_cast<LargeSymmetricMatrix<bool>&>(colissionMatrix).get(layerA, layerB);
+}
+
 WorldPrototype::~WorldPrototype() {
 
 }
 
 BoundsTree<Part>& WorldPrototype::getTreeForPart(const Part* part) {
-	return (part->isTerrainPart) ? this->terrainTree : this->objectTree;
+	return layers[part->layer]->tree;
 }
 
 const BoundsTree<Part>& WorldPrototype::getTreeForPart(const Part* part) const {
-	return (part->isTerrainPart) ? this->terrainTree : this->objectTree;
+	return layers[part->layer]->tree;
+}
+
+static void setLayerRecursive(const Physical* phys, int layer) {
+	phys->rigidBody.mainPart->layer = layer;
+	for(const AttachedPart& p : phys->rigidBody.parts) {
+		p.part->layer = layer;
+	}
+	for(const ConnectedPhysical& conPhys : phys->childPhysicals) {
+		setLayerRecursive(&conPhys, layer);
+	}
+}
+
+// the node of a part keeps part->treeNode pointing at it
+static TreeNode createLeafFor(Part* part, bool isGroupHead) {
+	return TreeNode(part, part->getStrictBounds(), isGroupHead, &part->treeNode);
 }
 
 static void addToNode(TreeNode& nodeToAddTo, const Physical* physicalToAdd) {
-	nodeToAddTo.addInside(TreeNode(physicalToAdd->rigidBody.mainPart, physicalToAdd->rigidBody.mainPart->getStrictBounds(), false));
+	nodeToAddTo.addInside(createLeafFor(physicalToAdd->rigidBody.mainPart, false));
 	for(const AttachedPart& p : physicalToAdd->rigidBody.parts) {
-		nodeToAddTo.addInside(TreeNode(p.part, p.part->getStrictBounds(), false));
+		nodeToAddTo.addInside(createLeafFor(p.part, false));
 	}
 	for(const ConnectedPhysical& conPhys : physicalToAdd->childPhysicals) {
 		addToNode(nodeToAddTo, &conPhys);
@@ -126,9 +201,9 @@ static void addToNode(TreeNode& nodeToAddTo, const Physical* physicalToAdd) {
 }
 
 static TreeNode createNodeFor(const MotorizedPhysical* phys) {
-	TreeNode newNode(phys->rigidBody.mainPart, phys->rigidBody.mainPart->getStrictBounds(), true);
+	TreeNode newNode = createLeafFor(phys->rigidBody.mainPart, true);
 	for(const AttachedPart& p : phys->rigidBody.parts) {
-		newNode.addInside(TreeNode(p.part, p.part->getStrictBounds(), false));
+		newNode.addInside(createLeafFor(p.part, false));
 	}
 	for(const ConnectedPhysical& conPhys : phys->childPhysicals) {
 		addToNode(newNode, &conPhys);
@@ -136,8 +211,9 @@ static TreeNode createNodeFor(const MotorizedPhysical* phys) {
 	return newNode;
 }
 
-void WorldPrototype::addPart(Part* part) {
+void WorldPrototype::addPart(Part* part, int layer) {
 	ASSERT_VALID;
+	assert(!layers[layer]->isTerrainLayer);
 	part->ensureHasParent();
 	if (part->parent->mainPhysical->world == this) {
 		Log::warn("Attempting to readd part to world");
@@ -145,12 +221,39 @@ void WorldPrototype::addPart(Part* part) {
 		return;
 	}
 	
-	objectTree.add(std::move(createNodeFor(part->parent->mainPhysical)));
-	physicals.push_back(part->parent->mainPhysical);
+	setLayerRecursive(part->parent->mainPhysical, layer);
+	layers[layer]->tree.add(std::move(createNodeFor(part->parent->mainPhysical)));
+	addToPhysicals(part->parent->mainPhysical);
 
 	objectCount += part->parent->mainPhysical->getNumberOfPartsInThisAndChildren();
 	
 	part->parent->mainPhysical->world = this;
+	partSetVersion++;
+
+	ASSERT_VALID;
+}
+void WorldPrototype::addParts(Part* const* parts, size_t count, int layer) {
+	ASSERT_VALID;
+	assert(!layers[layer]->isTerrainLayer);
+	std::vector<TreeNode> newNodes;
+	newNodes.reserve(count);
+	for(size_t i = 0; i < count; i++) {
+		Part* part = parts[i];
+		part->ensureHasParent();
+		MotorizedPhysical* mainPhys = part->parent->mainPhysical;
+		// several of the given parts may belong to the same physical
+		if(mainPhys->world == this) continue;
+
+		setLayerRecursive(mainPhys, layer);
+		newNodes.push_back(createNodeFor(mainPhys));
+		addToPhysicals(mainPhys);
+
+		objectCount += mainPhys->getNumberOfPartsInThisAndChildren();
+
+		mainPhys->world = this;
+	}
+	layers[layer]->tree.add(newNodes.data(), newNodes.size());
+	partSetVersion++;
 
 	ASSERT_VALID;
 }
@@ -162,21 +265,56 @@ void WorldPrototype::removePart(Part* part) {
 	ASSERT_VALID;
 }
 void WorldPrototype::removeMainPhysical(MotorizedPhysical* motorPhys) {
-	physicals.erase(std::remove(physicals.begin(), physicals.end(), motorPhys));
+	applyBatchEdits();
+	removeFromPhysicals(motorPhys);
 
 	ASSERT_VALID;
 }
-void WorldPrototype::addTerrainPart(Part* part) {
+void WorldPrototype::addToPhysicals(MotorizedPhysical* phys) {
+	phys->indexInWorld = physicals.size();
+	physicals.push_back(phys);
+}
+void WorldPrototype::removeFromPhysicals(const MotorizedPhysical* phys) {
+	size_t index = phys->indexInWorld;
+	assert(index < physicals.size() && physicals[index] == phys);
+	MotorizedPhysical* last = physicals.back();
+	physicals[index] = last;
+	last->indexInWorld = index;
+	physicals.pop_back();
+}
+void WorldPrototype::addTerrainPart(Part* part, int layer) {
+	assert(layers[layer]->isTerrainLayer);
 	objectCount++;
 
-	terrainTree.add(part, part->getStrictBounds());
 	part->isTerrainPart = true;
+	part->layer = layer;
+	layers[layer]->tree.add(createLeafFor(part, true));
+	partSetVersion++;
+
+	ASSERT_VALID;
+}
+void WorldPrototype::addTerrainParts(Part* const* parts, size_t count, int layer) {
+	assert(layers[layer]->isTerrainLayer);
+	std::vector<TreeNode> newNodes;
+	newNodes.reserve(count);
+	for(size_t i = 0; i < count; i++) {
+		Part* part = parts[i];
+		newNodes.push_back(createLeafFor(part, true));
+		part->isTerrainPart = true;
+		part->layer = layer;
+	}
+	objectCount += count;
+	layers[layer]->tree.add(newNodes.data(), newNodes.size());
+	partSetVersion++;
 
 	ASSERT_VALID;
 }
 void WorldPrototype::optimizeTerrain() {
-	for(int i = 0; i < 5; i++) {
-		terrainTree.improveStructure();
+	for(std::unique_ptr<Layer>& layer : layers) {
+		if(!layer->isTerrainLayer) continue;
+		for(int i = 0; i < 5; i++) {
+			layer->tree.improveStructure();
+		}
 	}
 	ASSERT_VALID;
 }
@@ -184,46 +322,104 @@ void WorldPrototype::optimizeTerrain() {
 
 
 
-void WorldPrototype::setPartCFrame(Part* part, const GlobalCFrame& newCFrame) {
-	Bounds oldBounds = part->getStrictBounds();
+void WorldPrototype::beginBatchEdit() {
+	batchEditDepth++;
+}
 
+void WorldPrototype::commitBatchEdit() {
+	assert(batchEditDepth > 0);
+	batchEditDepth--;
+	if(batchEditDepth != 0) return;
+
+	applyBatchEdits();
+	ASSERT_VALID;
+}
+
+void WorldPrototype::addBatchEdit(const Part* part) {
+	// the group of the physical is refreshed as a whole, one edit per physical is enough
+	MotorizedPhysical* mainPhys = part->parent->mainPhysical;
+	if(mainPhys->hasBatchEdit) return;
+	mainPhys->hasBatchEdit = true;
+	batchEditedPhysicals.push_back(part);
+}
+
+void WorldPrototype::applyBatchEdits() {
+	if(batchEditedPhysicals.empty()) return;
+
+	// every physical is one group, each tree refits the nodes above its edited groups once, however many groups share them
+	int editedLayers = 0;
+	for(const Part* edit : batchEditedPhysicals) {
+		edit->parent->mainPhysical->hasBatchEdit = false;
+		editedLayers |= 1 << edit->layer;
+	}
+	std::vector<TreeNode*> editedLeaves;
+	editedLeaves.reserve(batchEditedPhysicals.size());
+	for(size_t layer = 0; layer < layers.size(); layer++) {
+		if(!(editedLayers & (1 << layer))) continue;
+		editedLeaves.clear();
+		for(const Part* edit : batchEditedPhysicals) {
+			if(edit->layer == static_cast<int>(layer)) editedLeaves.push_back(edit->treeNode);
+		}
+		layers[layer]->tree.updateObjectGroupBounds(editedLeaves.data(), editedLeaves.size());
+	}
+	batchEditedPhysicals.clear();
+}
+
+void WorldPrototype::setPartCFrame(Part* part, const GlobalCFrame& newCFrame) {
 	part->parent->setPartCFrame(part, newCFrame);
 
-	objectTree.updateObjectGroupBounds(part, oldBounds);
+	if(isInBatchEdit()) {
+		addBatchEdit(part);
+		return;
+	}
+	getTreeForPart(part).updateObjectGroupBounds(part->treeNode);
 	ASSERT_VALID;
 }
 
 void WorldPrototype::updatePartBounds(const Part* updatedPart, const Bounds& oldBounds) {
-	objectTree.updateObjectBounds(updatedPart, oldBounds);
+	if(isInBatchEdit()) {
+		addBatchEdit(updatedPart);
+		return;
+	}
+	getTreeForPart(updatedPart).updateObjectBounds(updatedPart->treeNode);
 	ASSERT_VALID;
 }
 
 void WorldPrototype::updatePartGroupBounds(const Part* mainPart, const Bounds& oldMainPartBounds) {
-	objectTree.updateObjectGroupBounds(mainPart, oldMainPartBounds);
+	if(isInBatchEdit()) {
+		addBatchEdit(mainPart);
+		return;
+	}
+	getTreeForPart(mainPart).updateObjectGroupBounds(mainPart->treeNode);
 	ASSERT_VALID;
 }
 
-void WorldPrototype::removePartFromTrees(const Part* part) {
+void WorldPrototype::removePartFromTrees(Part* part) {
+	applyBatchEdits();
 	BoundsTree<Part>& tree = getTreeForPart(part);
-	tree.remove(part);
+	tree.remove(part->treeNode);
+	part->treeNode = nullptr;
+	partSetVersion++;
 	ASSERT_TREE_VALID(tree);
 }
 
 void WorldPrototype::splitPhysical(const MotorizedPhysical* mainPhysical, MotorizedPhysical* newlySplitPhysical) {
+	applyBatchEdits();
 	assert(mainPhysical->world == this);
 	assert(newlySplitPhysical->world == nullptr);
-	physicals.push_back(newlySplitPhysical);
+	addToPhysicals(newlySplitPhysical);
 	newlySplitPhysical->world = this;
 
-	ASSERT_TREE_VALID(objectTree);
+	BoundsTree<Part>& tree = getTreeForPart(mainPhysical->getMainPart());
+	ASSERT_TREE_VALID(tree);
 
 	// split object tree
 	// TODO: The findGroupFor and grap calls can be merged as an optimization
-	NodeStack stack = objectTree.findGroupFor(newlySplitPhysical->getMainPart(), newlySplitPhysical->getMainPart()->getStrictBounds());
+	NodeStack stack = tree.findGroupFor(newlySplitPhysical->getMainPart()->treeNode);
 
 	TreeNode* node = *stack;
 
-	TreeNode newNode = objectTree.grab(newlySplitPhysical->getMainPart(), newlySplitPhysical->getMainPart()->getStrictBounds());
+	TreeNode newNode = tree.grab(newlySplitPhysical->getMainPart()->treeNode);
 	if(!newNode.isGroupHead) {
 		newNode.isGroupHead = true;
 
@@ -241,66 +437,73 @@ void WorldPrototype::splitPhysical(const MotorizedPhysical* mainPhysical, Motori
 		stack.updateBoundsAllTheWayToTop();
 	}
 
-	objectTree.add(std::move(newNode));
+	tree.add(std::move(newNode));
 
-	ASSERT_TREE_VALID(objectTree);
+	ASSERT_TREE_VALID(tree);
 }
 
 void WorldPrototype::mergePhysicals(const MotorizedPhysical* firstPhysical, const MotorizedPhysical* secondPhysical) {
+	applyBatchEdits();
 	assert(firstPhysical->world == this);
 
 	if(secondPhysical->world != nullptr) {
 		assert(secondPhysical->world == this);
-		for(MotorizedPhysical*& item : physicals) {
-			if(item == secondPhysical) {
-				item = std::move(physicals.back());
-				physicals.pop_back();
-
-				goto physicalFound;
-			}
-		}
-
-		throw "No physical found to remove!";
+		removeFromPhysicals(secondPhysical);
 
-		physicalFound:;
-		TreeNode groupNode = objectTree.grabGroupFor(secondPhysical->getMainPart(), secondPhysical->getMainPart()->getStrictBounds());
+		TreeNode groupNode = getTreeForPart(secondPhysical->getMainPart()).grabGroupFor(secondPhysical->getMainPart()->treeNode);
+		setLayerRecursive(secondPhysical, firstPhysical->getMainPart()->layer);
 
 		const Part* main = firstPhysical->getMainPart();
-		NodeStack stack = objectTree.findGroupFor(main, main->getStrictBounds());
+		BoundsTree<Part>& tree = getTreeForPart(main);
+		NodeStack stack = tree.findGroupFor(main->treeNode);
 		TreeNode& group = **stack;
 		group.addInside(std::move(groupNode));
 		stack.expandBoundsAllTheWayToTop();
 	} else {
+		setLayerRecursive(secondPhysical, firstPhysical->getMainPart()->layer);
 		const Part* main = firstPhysical->getMainPart();
-		NodeStack stack = objectTree.findGroupFor(main, main->getStrictBounds());
+		BoundsTree<Part>& tree = getTreeForPart(main);
+		NodeStack stack = tree.findGroupFor(main->treeNode);
 		TreeNode& group = **stack;
 		group.addInside(createNodeFor(secondPhysical));
 
 		stack.expandBoundsAllTheWayToTop();
 	}
 
-	ASSERT_TREE_VALID(objectTree);
+	partSetVersion++;
+	ASSERT_TREE_VALID(getTreeForPart(firstPhysical->getMainPart()));
 
 	// TODO
 	assert(false);
 }
 
 void WorldPrototype::mergePartAndPhysical(const MotorizedPhysical* physical, Part* newPart) {
+	applyBatchEdits();
 	assert(physical->world == this);
 
-	this->objectTree.addToExistingGroup(newPart, newPart->getStrictBounds(), physical->getMainPart(), physical->getMainPart()->getStrictBounds());
-	ASSERT_TREE_VALID(objectTree);
+	newPart->layer = physical->getMainPart()->layer;
+	BoundsTree<Part>& tree = getTreeForPart(newPart);
+	tree.addToExistingGroup(createLeafFor(newPart, false), physical->getMainPart()->treeNode);
+	partSetVersion++;
+	ASSERT_TREE_VALID(tree);
 }
 
 void WorldPrototype::notifyPartStdMoved(Part* oldPartPtr, Part* newPartPtr) {
-	(*getTreeForPart(oldPartPtr).find(oldPartPtr, newPartPtr->getStrictBounds()))->object = newPartPtr;
-	ASSERT_TREE_VALID(objectTree);
+	applyBatchEdits();
+	// the node moved along with the part, it only has to be told about the new part
+	assert(newPartPtr->treeNode != nullptr && newPartPtr->treeNode->object == oldPartPtr);
+	newPartPtr->treeNode->setObject(newPartPtr, &newPartPtr->treeNode);
+	partSetVersion++;
+	ASSERT_TREE_VALID(getTreeForPart(newPartPtr));
 }
 
 void WorldPrototype::notifyPartRemovedFromGroup(Part* part) {
-	objectTree.remove(part);
+	applyBatchEdits();
+	getTreeForPart(part).remove(part->treeNode);
+	part->treeNode = nullptr;
 	objectCount--;
-	ASSERT_TREE_VALID(objectTree);
+	partSetVersion++;
+	ASSERT_TREE_VALID(getTreeForPart(part));
 }
 
 
@@ -312,17 +515,60 @@ void WorldPrototype::removeExternalForce(ExternalForce* force) {
 	externalForces.erase(std::remove(externalForces.begin(), externalForces.end(), force));
 }
 
-//using WorldPartIter = IteratorGroup<IteratorFactory<BoundsTreeIter<TreeIterator, Part>, IteratorEnd>, 2>;
+// the child physicals are stored inline in their parent, only the MotorizedPhysical is allocated on its own
+static size_t getPhysicalMemoryUsage(const Physical& phys) {
+	size_t total = phys.rigidBody.parts.capacity() * sizeof(AttachedPart) + phys.childPhysicals.capacity() * sizeof(ConnectedPhysical);
+	for(const ConnectedPhysical& child : phys.childPhysicals) {
+		total += getPhysicalMemoryUsage(child);
+	}
+	return total;
+}
+
+MemoryUsage WorldPrototype::getMemoryUsage() const {
+	MemoryUsage result;
+	for(const std::unique_ptr<Layer>& layer : layers) {
+		size_t treeBytes = sizeof(Layer) + layer->tree.rootNode.getMemoryUsage();
+		result[layer->isTerrainLayer ? MemoryCategory::TERRAIN_TREES : MemoryCategory::OBJECT_TREES] += treeBytes;
+	}
+
+	// a shape class is shared if more than one part of the world uses it
+	std::unordered_map<const ShapeClass*, size_t> shapeUsers;
+	for(const Part& part : iterParts()) {
+		result[MemoryCategory::PARTS] += sizeof(Part);
+		shapeUsers[part.hitbox.baseShape]++;
+	}
+	for(const std::pair<const ShapeClass* const, size_t>& shape : shapeUsers) {
+		result[(shape.second > 1) ? MemoryCategory::SHARED_SHAPES : MemoryCategory::UNIQUE_SHAPES] += shape.first->getMemoryUsage();
+	}
+
+	result[MemoryCategory::PHYSICALS] += physicals.capacity() * sizeof(MotorizedPhysical*);
+	for(const MotorizedPhysical* phys : physicals) {
+		result[MemoryCategory::PHYSICALS] += sizeof(MotorizedPhysical) + getPhysicalMemoryUsage(*phys);
+	}
+
+	result[MemoryCategory::CONSTRAINTS] += constraints.capacity() * sizeof(ConstraintGroup);
+	for(const ConstraintGroup& group : constraints) {
+		result[MemoryCategory::CONSTRAINTS] += group.ballConstraints.capacity() * sizeof(BallConstraint);
+	}
+
+	result[MemoryCategory::BROADPHASE] += broadphase->getMemoryUsage() + batchEditedPhysicals.capacity() * sizeof(const Part*);
+	result[MemoryCategory::COLISSIONS] += (currentObjectPairs.capacity() + currentTerrainPairs.capacity()) * sizeof(BroadphasePair) +
+		(currentObjectColissions.capacity() + currentTerrainColissions.capacity()) * sizeof(Colission);
+	result[MemoryCategory::COMPUTATION_BUFFERS] += getComputationBufferMemoryUsage();
+
+	MemoryUsage transientPeaks = MemoryAccounting::getTransientPeaks();
+	result[MemoryCategory::CONSTRAINT_MATRICES] = transientPeaks[MemoryCategory::CONSTRAINT_MATRICES];
+	result[MemoryCategory::SERIALIZATION] = transientPeaks[MemoryCategory::SERIALIZATION];
+	return result;
+}
+
 IteratorFactoryWithEnd<WorldPartIter> WorldPrototype::iterParts(int partsMask) {
 	size_t size = 0;
-	IteratorFactoryWithEnd<BoundsTreeIter<TreeIterator, Part>> iters[2]{};
-	if(partsMask & FREE_PARTS) {
-		BoundsTreeIter<TreeIterator, Part> i(objectTree.begin());
-		iters[size++] = IteratorFactoryWithEnd<BoundsTreeIter<TreeIterator, Part>>(i);
-	}
-	if(partsMask & TERRAIN_PARTS) {
-		BoundsTreeIter<TreeIterator, Part> i(terrainTree.begin());
-		iters[size++] = IteratorFactoryWithEnd<BoundsTreeIter<TreeIterator, Part>>(i);
+	BoundsTreeIterFactory<TreeIterator, Part, BoundsTree<Part>> iters[MAX_LAYERS]{};
+	for(std::unique_ptr<Layer>& layer : layers) {
+		if(partsMask & (layer->isTerrainLayer ? TERRAIN_PARTS : FREE_PARTS)) {
+			iters[size++] = BoundsTreeIterFactory<TreeIterator, Part, BoundsTree<Part>>(&layer->tree);
+		}
 	}
 
 	WorldPartIter group(iters, size);
@@ -331,20 +577,14 @@ IteratorFactoryWithEnd<WorldPartIter> WorldPrototype::iterParts(int partsMask) {
 }
 IteratorFactoryWithEnd<ConstWorldPartIter> WorldPrototype::iterParts(int partsMask) const {
 	size_t size = 0;
-	IteratorFactoryWithEnd<BoundsTreeIter<ConstTreeIterator, const Part>> iters[2]{};
-	if(partsMask & FREE_PARTS) {
-		BoundsTreeIter<ConstTreeIterator, const Part> i(objectTree.begin());
-		iters[size++] = IteratorFactoryWithEnd<BoundsTreeIter<ConstTreeIterator, const Part>>(i);
-	}
-	if(partsMask & TERRAIN_PARTS) {
-		BoundsTreeIter<ConstTreeIterator, const Part> i(terrainTree.begin());
-		iters[size++] = IteratorFactoryWithEnd<BoundsTreeIter<ConstTreeIterator, const Part>>(i);
+	BoundsTreeIterFactory<ConstTreeIterator, const Part, const BoundsTree<Part>> iters[MAX_LAYERS]{};
+	for(const std::unique_ptr<Layer>& layer : layers) {
+		if(partsMask & (layer->isTerrainLayer ? TERRAIN_PARTS : FREE_PARTS)) {
+			iters[size++] = BoundsTreeIterFactory<ConstTreeIterator, const Part, const BoundsTree<Part>>(&layer->tree);
+		}
 	}
 
 	ConstWorldPartIter group(iters, size);
 
 	return IteratorFactoryWithEnd<ConstWorldPartIter>(std::move(group));
 }
-
-
-
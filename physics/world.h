@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <memory>
 
 #include "part.h"
 #include "physical.h"
@@ -9,11 +10,17 @@
 #include "datastructures/iteratorEnd.h"
 #include "datastructures/boundsTree.h"
 #include "math/linalg/largeMatrix.h"
+#include "broadphase/broadphase.h"
+#include "memoryAccounting.h"
 
 #define FREE_PARTS 0x1
 #define TERRAIN_PARTS 0x2
 #define ALL_PARTS FREE_PARTS | TERRAIN_PARTS
 
+#define MAX_LAYERS 16
+#define DEFAULT_LAYER 0
+#define DEFAULT_TERRAIN_LAYER 1
+
 struct Colission {
 	Part* p1;
 	Part* p2;
@@ -24,15 +31,36 @@ struct Colission {
 class ExternalForce;
 
 template<typename Filter>
-using DoubleFilterIter = FilteredIterator<IteratorGroup<TreeIterFactory<Part, Filter>, 2>, IteratorEnd, Filter>;
+using DoubleFilterIter = FilteredIterator<IteratorGroup<TreeIterFactory<Part, Filter>, MAX_LAYERS>, IteratorEnd, Filter>;
 
 template<typename Filter>
-using ConstDoubleFilterIter = FilteredIterator<IteratorGroup<TreeIterFactory<const Part, Filter>, 2>, IteratorEnd, Filter>;
+using ConstDoubleFilterIter = FilteredIterator<IteratorGroup<TreeIterFactory<const Part, Filter>, MAX_LAYERS>, IteratorEnd, Filter>;
+
+// only stores the tree, so a group of these stays small
+template<typename Iter, typename Boundable, typename Tree>
+struct BoundsTreeIterFactory {
+	Tree* tree;
+	BoundsTreeIterFactory() = default;
+	BoundsTreeIterFactory(Tree* tree) : tree(tree) {}
+	BoundsTreeIter<Iter, Boundable> begin() const { return BoundsTreeIter<Iter, Boundable>(tree->begin()); }
+	IteratorEnd end() const { return IteratorEnd(); }
+};
 
-using WorldPartIter = IteratorGroup<IteratorFactoryWithEnd<BoundsTreeIter<TreeIterator, Part>>, 2>;
-using ConstWorldPartIter = IteratorGroup<IteratorFactoryWithEnd<BoundsTreeIter<ConstTreeIterator, const Part>>, 2>;
+using WorldPartIter = IteratorGroup<BoundsTreeIterFactory<TreeIterator, Part, BoundsTree<Part>>, MAX_LAYERS>;
+using ConstWorldPartIter = IteratorGroup<BoundsTreeIterFactory<ConstTreeIterator, const Part, const BoundsTree<Part>>, MAX_LAYERS>;
 
-class Layer;
+/*
+	A layer holds parts in its own BoundsTree, the colissionMatrix of the world determines which layers collide
+	
+	Terrain layers hold anchored parts, their trees are not updated every tick, and terrain layers never collide with each other
+*/
+class Layer {
+public:
+	BoundsTree<Part> tree;
+	bool isTerrainLayer;
+
+	Layer(bool isTerrainLayer) : isTerrainLayer(isTerrainLayer) {}
+};
 
 class WorldPrototype {
 private:
@@ -41,13 +69,31 @@ private:
 	friend class ConnectedPhysical;
 	friend class Part;
 
+	std::vector<BroadphasePair> currentObjectPairs;
+	std::vector<BroadphasePair> currentTerrainPairs;
 	std::vector<Colission> currentObjectColissions;
 	std::vector<Colission> currentTerrainColissions;
 
+	std::unique_ptr<Broadphase> broadphase;
+	// incremented whenever parts are added, removed, moved to another layer or std::moved
+	size_t partSetVersion = 0;
+
+	// number of nested batch edits, while it isn't 0 the bounds of edited parts are not updated in the trees
+	int batchEditDepth = 0;
+	// the physicals edited in the current batch edit, with a part of each
+	std::vector<const Part*> batchEditedPhysicals;
+	void addBatchEdit(const Part* part);
+	// brings the bounds in the trees up to date with the edits of the current batch, the trees can't be restructured before that
+	void applyBatchEdits();
+
 	void setPartCFrame(Part* part, const GlobalCFrame& newCFrame);
 	void updatePartBounds(const Part* updatedPart, const Bounds& oldBounds);
 	void updatePartGroupBounds(const Part* mainPart, const Bounds& oldMainPartBounds);
-	void removePartFromTrees(const Part* part);
+	void removePartFromTrees(Part* part);
+
+	// physicals are swapped with the last one when removed, indexInWorld is kept up to date
+	void addToPhysicals(MotorizedPhysical* phys);
+	void removeFromPhysicals(const MotorizedPhysical* phys);
 
 
 	// These 3 methods do not edit the given physicals, they just adjust the world and it's BoundsTrees to match the new situation
@@ -75,7 +121,7 @@ private:
 	BoundsTree<Part>& getTreeForPart(const Part* part);
 	const BoundsTree<Part>& getTreeForPart(const Part* part) const;
 
-	std::vector<Layer> layers;
+	std::vector<std::unique_ptr<Layer>> layers;
 	// signifies which layers collide
 	LargeSymmetricMatrix<bool> colissionMatrix;
 
@@ -86,12 +132,18 @@ protected:
 	virtual void handleConstraints();
 	virtual void update();
 
+	// called during a tick right after the external forces are applied, before colissions and constraints add theirs
+	virtual void onExternalForcesApplied() {}
+	// the phases of a tick that compute and apply forces, before update moves the physicals, these do not change the structure of the world
+	void computeForces();
+
 public:
 
 	std::vector<ExternalForce*> externalForces;
 
-	BoundsTree<Part> objectTree;
-	BoundsTree<Part> terrainTree;
+	// the trees of the DEFAULT_LAYER and DEFAULT_TERRAIN_LAYER
+	BoundsTree<Part>& objectTree;
+	BoundsTree<Part>& terrainTree;
 
 	std::vector<ConstraintGroup> constraints;
 
@@ -112,13 +164,49 @@ public:
 
 	virtual void tick();
 
-	void addPart(Part* part);
+	void addPart(Part* part, int layer = DEFAULT_LAYER);
 	void removePart(Part* part);
 	void removeMainPhysical(MotorizedPhysical* part);
 
-	void addTerrainPart(Part* part);
+	void addTerrainPart(Part* part, int layer = DEFAULT_TERRAIN_LAYER);
 	void optimizeTerrain();
 
+	/*
+		Starts a batch of edits, until it is committed CFrame and scale changes of parts don't update the trees. 
+		Committing updates each edited physical once, however often it was edited, and refits the nodes above them in a single pass, each node at most once. 
+		Batches can be nested, only committing the outermost batch updates the trees. 
+		Adding, removing or attaching parts during a batch applies the edits so far first, ticking the world is not allowed. 
+		Use BatchEdit to commit the batch at the end of a scope. 
+	*/
+	void beginBatchEdit();
+	void commitBatchEdit();
+	inline bool isInBatchEdit() const { return batchEditDepth != 0; }
+
+	/*
+		Adds many parts at once, if they are many compared to the parts already in the layer the tree is rebuilt in one pass
+		instead of inserting the parts one by one. This is much faster for large numbers of parts, and gives a better structured tree. 
+	*/
+	void addParts(Part* const* parts, size_t count, int layer = DEFAULT_LAYER);
+	void addTerrainParts(Part* const* parts, size_t count, int layer = DEFAULT_TERRAIN_LAYER);
+	inline void addParts(const std::vector<Part*>& parts, int layer = DEFAULT_LAYER) { addParts(parts.data(), parts.size(), layer); }
+	inline void addTerrainParts(const std::vector<Part*>& parts, int layer = DEFAULT_TERRAIN_LAYER) { addTerrainParts(parts.data(), parts.size(), layer); }
+
+	/*
+		Creates a new empty layer and returns its index, at most MAX_LAYERS layers can exist. 
+		The new layer does not collide with any layer until enabled with setLayersCollide
+	*/
+	int createLayer(bool isTerrainLayer);
+	void setLayersCollide(int layerA, int layerB, bool collide);
+	bool doLayersCollide(int layerA, int layerB) const;
+	inline size_t getLayerCount() const { return layers.size(); }
+	inline Layer& getLayer(int layer) { return *layers[layer]; }
+	inline const Layer& getLayer(int layer) const { return *layers[layer]; }
+
+	// the world takes ownership of the given broadphase, the default is a TreeBroadphase
+	void setBroadphase(Broadphase* newBroadphase);
+	inline Broadphase& getBroadphase() { return *broadphase; }
+	inline size_t getPartSetVersion() const { return partSetVersion; }
+
 	inline size_t getPartCount(int partsMask = ALL_PARTS) const {
 		return objectCount;
 	}
@@ -128,6 +216,13 @@ public:
 	virtual double getPotentialEnergyOfPhysical(const MotorizedPhysical& p) const;
 	virtual double getTotalEnergy() const;
 
+	/*
+		Walks every structure of the world and adds up the bytes it holds, per subsystem.
+		The transient categories hold the peaks recorded since MemoryAccounting::resetTransientPeaks.
+		Parts that are not in the world, and what hard constraints allocate, are not counted.
+	*/
+	MemoryUsage getMemoryUsage() const;
+
 	void addExternalForce(ExternalForce* force);
 	void removeExternalForce(ExternalForce* force);
 
@@ -141,15 +236,14 @@ public:
 	IteratorFactoryWithEnd<DoubleFilterIter<Filter>> iterPartsFiltered(const Filter& filter, int partsMask = ALL_PARTS) {
 
 		size_t size = 0;
-		TreeIterFactory<Part, Filter> iters[2];
-		if (partsMask & FREE_PARTS) {
-			iters[size++] = objectTree.iterFiltered(filter);
-		}
-		if (partsMask & TERRAIN_PARTS) {
-			iters[size++] = terrainTree.iterFiltered(filter);
+		TreeIterFactory<Part, Filter> iters[MAX_LAYERS];
+		for(std::unique_ptr<Layer>& layer : layers) {
+			if(partsMask & (layer->isTerrainLayer ? TERRAIN_PARTS : FREE_PARTS)) {
+				iters[size++] = layer->tree.iterFiltered(filter);
+			}
 		}
 
-		IteratorGroup<TreeIterFactory<Part, Filter>, 2> group(iters, size);
+		IteratorGroup<TreeIterFactory<Part, Filter>, MAX_LAYERS> group(iters, size);
 
 		DoubleFilterIter<Filter> doubleFilter(group, IteratorEnd(), filter);
 		
@@ -160,15 +254,14 @@ public:
 	IteratorFactoryWithEnd<ConstDoubleFilterIter<Filter>> iterPartsFiltered(const Filter& filter, int partsMask = ALL_PARTS) const {
 
 		size_t size = 0;
-		TreeIterFactory<Part, Filter> iters[2];
-		if (partsMask & FREE_PARTS) {
-			iters[size++] = objectTree.iterFiltered(filter);
-		}
-		if (partsMask & TERRAIN_PARTS) {
-			iters[size++] = terrainTree.iterFiltered(filter);
+		TreeIterFactory<const Part, Filter> iters[MAX_LAYERS];
+		for(const std::unique_ptr<Layer>& layer : layers) {
+			if(partsMask & (layer->isTerrainLayer ? TERRAIN_PARTS : FREE_PARTS)) {
+				iters[size++] = static_cast<const BoundsTree<Part>&>(layer->tree).iterFiltered(filter);
+			}
 		}
 
-		IteratorGroup<TreeIterFactory<Part, Filter>, 2> group(iters, size);
+		IteratorGroup<TreeIterFactory<const Part, Filter>, MAX_LAYERS> group(iters, size);
 
 		ConstDoubleFilterIter<Filter> doubleFilter(group, IteratorEnd(), filter);
 
@@ -179,6 +272,17 @@ public:
 	IteratorFactoryWithEnd<ConstWorldPartIter> iterParts(int partsMask = ALL_PARTS) const;
 };
 
+// begins a batch edit on the given world and commits it at the end of the scope
+class BatchEdit {
+	WorldPrototype& world;
+public:
+	inline BatchEdit(WorldPrototype& world) : world(world) { world.beginBatchEdit(); }
+	inline ~BatchEdit() { world.commitBatchEdit(); }
+
+	BatchEdit(const BatchEdit&) = delete;
+	BatchEdit& operator=(const BatchEdit&) = delete;
+};
+
 class ExternalForce {
 public:
 	virtual void apply(WorldPrototype* world) = 0;
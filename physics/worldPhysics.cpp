@@ -14,6 +14,7 @@
 #include "debug.h"
 #include "constants.h"
 #include "physicsProfiler.h"
+#include "zoneProfiler.h"
 
 #include <vector>
 
@@ -217,65 +218,26 @@ inline void runColissionTests(Part& p1, Part& p2, WorldPrototype& world, std::ve
 	physicsMeasure.mark(PhysicsProcess::COLISSION_OTHER);
 }
 
-void recursiveFindColissionsInternal(WorldPrototype& world, std::vector<Colission>& colissions, TreeNode& trunkNode);
-void recursiveFindColissionsBetween(WorldPrototype& world, std::vector<Colission>& colissions, TreeNode& first, TreeNode& second);
-
-void recursiveFindColissionsInternal(WorldPrototype& world, std::vector<Colission>& colissions, TreeNode& trunkNode) {
-	// within the same node
-	if (trunkNode.isLeafNode() || trunkNode.isGroupHead)
-		return;
-
-	for (int i = 0; i < trunkNode.nodeCount; i++) {
-		TreeNode& A = trunkNode[i];
-		recursiveFindColissionsInternal(world, colissions, A);
-		for (int j = i + 1; j < trunkNode.nodeCount; j++) {
-			TreeNode& B = trunkNode[j];
-			recursiveFindColissionsBetween(world, colissions, A, B);
-		}
-	}
-}
-
-void recursiveFindColissionsBetween(WorldPrototype& world, std::vector<Colission>& colissions, TreeNode& first, TreeNode& second) {
-	if (!intersects(first.bounds, second.bounds)) return;
-	
-	if (first.isLeafNode() && second.isLeafNode()) {
-		Part* firstObj = static_cast<Part*>(first.object);
-		Part* secondObj = static_cast<Part*>(second.object);
+inline void runColissionTestsChecked(Part& p1, Part& p2, WorldPrototype& world, std::vector<Colission>& colissions) {
 #ifdef CATCH_INTERSECTION_ERRORS
-		try {
-			runColissionTests(*firstObj, *secondObj, world, colissions);
-		} catch(const std::exception& err) {
-			Log::fatal("Error occurred during intersection: %s", err.what());
+	try {
+		runColissionTests(p1, p2, world, colissions);
+	} catch(const std::exception& err) {
+		Log::fatal("Error occurred during intersection: %s", err.what());
 
-			Debug::saveIntersectionError(firstObj, secondObj, "colError");
+		Debug::saveIntersectionError(&p1, &p2, "colError");
 
-			throw err;
-		} catch(...) {
-			Log::fatal("Unknown error occured during intersection");
+		throw err;
+	} catch(...) {
+		Log::fatal("Unknown error occured during intersection");
 
-			Debug::saveIntersectionError(firstObj, secondObj, "colError");
+		Debug::saveIntersectionError(&p1, &p2, "colError");
 
-			throw "exit";
-		}
+		throw "exit";
+	}
 #else
-		runColissionTests(*firstObj, *secondObj, world, colissions);
+	runColissionTests(p1, p2, world, colissions);
 #endif
-	} else {
-		bool preferFirst = computeCost(first.bounds) <= computeCost(second.bounds);
-		if (preferFirst && !first.isLeafNode() || second.isLeafNode()) {
-			// split first
-
-			for (TreeNode& node : first) {
-				recursiveFindColissionsBetween(world, colissions, node, second);
-			}
-		} else {
-			// split second
-
-			for (TreeNode& node : second) {
-				recursiveFindColissionsBetween(world, colissions, first, node);
-			}
-		}
-	}
 }
 
 /*
@@ -283,37 +245,57 @@ void recursiveFindColissionsBetween(WorldPrototype& world, std::vector<Colission
 */
 
 void WorldPrototype::tick() {
+	PROFILE_FRAME("tick");
+	assert(!isInBatchEdit());
+	Debug::logTick(age);
 	
+	computeForces();
+
+	update();
+}
+
+void WorldPrototype::computeForces() {
 	findColissions();
 
 	physicsMeasure.mark(PhysicsProcess::EXTERNALS);
 	applyExternalForces();
+	onExternalForcesApplied();
 
 	handleColissions();
 
 	intersectionStatistics.nextTally();
 	
 	handleConstraints();
-
-	update();
 }
 
 void WorldPrototype::applyExternalForces() {
+	PROFILE_ZONE("applyExternalForces");
 	for (ExternalForce* force : externalForces) {
 		force->apply(this);
 	}
 }
 
 void WorldPrototype::findColissions() {
+	PROFILE_ZONE("findColissions");
 	physicsMeasure.mark(PhysicsProcess::COLISSION_OTHER);
 
 	currentObjectColissions.clear();
 	currentTerrainColissions.clear();
 
-	recursiveFindColissionsInternal(*this, currentObjectColissions, objectTree.rootNode);
-	recursiveFindColissionsBetween(*this, currentTerrainColissions, objectTree.rootNode, terrainTree.rootNode);
+	currentObjectPairs.clear();
+	currentTerrainPairs.clear();
+
+	broadphase->findCandidatePairs(*this, currentObjectPairs, currentTerrainPairs);
+
+	for(const BroadphasePair& pair : currentObjectPairs) {
+		runColissionTestsChecked(*pair.p1, *pair.p2, *this, currentObjectColissions);
+	}
+	for(const BroadphasePair& pair : currentTerrainPairs) {
+		runColissionTestsChecked(*pair.p1, *pair.p2, *this, currentTerrainColissions);
+	}
 }
 void WorldPrototype::handleColissions() {
+	PROFILE_ZONE("handleColissions");
 	physicsMeasure.mark(PhysicsProcess::COLISSION_HANDLING);
 	for (Colission c : currentObjectColissions) {
 		handleCollision(*c.p1, *c.p2, c.intersection, c.exitVector);
@@ -323,21 +305,38 @@ void WorldPrototype::handleColissions() {
 	}
 }
 void WorldPrototype::handleConstraints() {
+	PROFILE_ZONE("handleConstraints");
 	physicsMeasure.mark(PhysicsProcess::CONSTRAINTS);
 	for (const ConstraintGroup& group : constraints) {
 		group.apply();
 	}
 }
 void WorldPrototype::update() {
+	PROFILE_ZONE("update");
 	physicsMeasure.mark(PhysicsProcess::UPDATING);
-	for (MotorizedPhysical* physical : iterPhysicals()) {
-		physical->update(this->deltaT);
+	{
+		PROFILE_ZONE("updatePhysicals");
+		for (MotorizedPhysical* physical : iterPhysicals()) {
+			physical->update(this->deltaT);
+		}
 	}
 
 	physicsMeasure.mark(PhysicsProcess::UPDATE_TREE_BOUNDS);
-	objectTree.recalculateBounds();
+	{
+		PROFILE_ZONE("recalculateBounds");
+		for(std::unique_ptr<Layer>& layer : layers) {
+			if(!layer->isTerrainLayer) layer->tree.recalculateBounds();
+		}
+	}
 	physicsMeasure.mark(PhysicsProcess::UPDATE_TREE_STRUCTURE);
-	objectTree.improveStructure();
+	{
+		PROFILE_ZONE("improveStructure");
+		if(broadphase->usesTreeStructure()) {
+			for(std::unique_ptr<Layer>& layer : layers) {
+				if(!layer->isTerrainLayer) layer->tree.improveStructure();
+			}
+		}
+	}
 	age++;
 }
 
@@ -0,0 +1,99 @@
+#include "zoneProfiler.h"
+
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <algorithm>
+
+namespace ZoneProfiler {
+size_t maxEventsPerThread = 1 << 18;
+
+static std::atomic<uint32_t> currentFrame(0);
+
+static std::mutex threadBuffersMutex;
+// buffers are never freed, threads may outlive an export
+static std::vector<std::unique_ptr<ZoneThreadBuffer>> threadBuffers;
+
+static ZoneThreadBuffer* registerThread() {
+	std::lock_guard<std::mutex> lock(threadBuffersMutex);
+	ZoneThreadBuffer* buffer = new ZoneThreadBuffer();
+	buffer->events.reserve(maxEventsPerThread);
+	buffer->threadIndex = static_cast<uint32_t>(threadBuffers.size());
+	threadBuffers.emplace_back(buffer);
+	return buffer;
+}
+
+ZoneThreadBuffer& getThreadBuffer() {
+	thread_local ZoneThreadBuffer* buffer = registerThread();
+	return *buffer;
+}
+
+uint32_t getCurrentFrame() {
+	return currentFrame.load(std::memory_order_relaxed);
+}
+
+void nextFrame() {
+	currentFrame.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void writeEscaped(std::ostream& ostream, const char* str) {
+	for(; *str != '\0'; str++) {
+		if(*str == '"' || *str == '\\') ostream << '\\';
+		ostream << *str;
+	}
+}
+
+void exportChromeTrace(std::ostream& ostream) {
+	std::lock_guard<std::mutex> lock(threadBuffersMutex);
+
+	int64_t firstStart = INT64_MAX;
+	for(const std::unique_ptr<ZoneThreadBuffer>& buffer : threadBuffers) {
+		for(const ZoneEvent& event : buffer->events) {
+			firstStart = std::min(firstStart, event.startNanos);
+		}
+	}
+
+	std::ios::fmtflags oldFlags = ostream.flags();
+	ostream << std::fixed;
+	ostream.precision(3);
+
+	ostream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+	bool first = true;
+	for(const std::unique_ptr<ZoneThreadBuffer>& buffer : threadBuffers) {
+		if(!first) ostream << ',';
+		first = false;
+		ostream << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer->threadIndex << ",\"args\":{\"name\":\"Thread " << buffer->threadIndex << "\"}}";
+
+		for(const ZoneEvent& event : buffer->events) {
+			// timestamps are in microseconds
+			ostream << ",\n{\"name\":\"";
+			writeEscaped(ostream, event.name);
+			ostream << "\",\"cat\":\"physics\",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->threadIndex;
+			ostream << ",\"ts\":" << (event.startNanos - firstStart) / 1000.0;
+			ostream << ",\"dur\":" << (event.endNanos - event.startNanos) / 1000.0;
+			ostream << ",\"args\":{\"frame\":" << event.frame << ",\"depth\":" << event.depth << "}}";
+		}
+	}
+	ostream << "\n]}\n";
+
+	ostream.flags(oldFlags);
+}
+
+void clear() {
+	std::lock_guard<std::mutex> lock(threadBuffersMutex);
+	for(const std::unique_ptr<ZoneThreadBuffer>& buffer : threadBuffers) {
+		buffer->events.clear();
+		buffer->events.reserve(maxEventsPerThread);
+		buffer->droppedEvents = 0;
+	}
+}
+
+size_t getEventCount() {
+	std::lock_guard<std::mutex> lock(threadBuffersMutex);
+	size_t total = 0;
+	for(const std::unique_ptr<ZoneThreadBuffer>& buffer : threadBuffers) {
+		total += buffer->events.size();
+	}
+	return total;
+}
+};
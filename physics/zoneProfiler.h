@@ -0,0 +1,91 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+#include <iostream>
+#include <cstdint>
+
+/*
+	Hierarchical zone profiler
+
+	Records nested, named time zones per thread, grouped into frames (usually one frame per world tick),
+	and exports them in the Chrome trace event format, which can be opened in chrome://tracing or Perfetto.
+
+	Every thread records into its own buffer, so recording needs no locks. The buffer is reserved when a thread first
+	records, so recording never allocates inside a timed zone, events that don't fit are dropped.
+	Exporting or clearing must only happen while no thread is recording.
+
+	The profiler is only compiled in when ENABLE_ZONE_PROFILER is defined,
+	otherwise PROFILE_ZONE and PROFILE_FRAME expand to nothing and have no overhead at all.
+*/
+
+struct ZoneEvent {
+	// must be a string literal, or otherwise outlive the profiler
+	const char* name;
+	int64_t startNanos;
+	int64_t endNanos;
+	uint32_t frame;
+	uint32_t depth;
+};
+
+struct ZoneThreadBuffer {
+	std::vector<ZoneEvent> events;
+	uint32_t threadIndex;
+	uint32_t currentDepth = 0;
+	size_t droppedEvents = 0;
+};
+
+namespace ZoneProfiler {
+// the number of events reserved for each thread, events beyond this are dropped until clear is called
+// changes apply to threads that start recording afterwards, and to all threads after clear
+extern size_t maxEventsPerThread;
+
+ZoneThreadBuffer& getThreadBuffer();
+uint32_t getCurrentFrame();
+void nextFrame();
+
+inline int64_t now() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// writes all recorded events of all threads as a Chrome trace JSON object
+void exportChromeTrace(std::ostream& ostream);
+void clear();
+size_t getEventCount();
+};
+
+class ZoneScope {
+	ZoneThreadBuffer& buffer;
+	const char* name;
+	int64_t startNanos;
+	uint32_t frame;
+public:
+	inline ZoneScope(const char* name) : buffer(ZoneProfiler::getThreadBuffer()), name(name), startNanos(ZoneProfiler::now()), frame(ZoneProfiler::getCurrentFrame()) {
+		buffer.currentDepth++;
+	}
+	inline ~ZoneScope() {
+		buffer.currentDepth--;
+		// never grow the buffer, reallocating would be timed by the enclosing zones
+		if(buffer.events.size() < buffer.events.capacity()) {
+			buffer.events.push_back(ZoneEvent{name, startNanos, ZoneProfiler::now(), frame, buffer.currentDepth});
+		} else {
+			buffer.droppedEvents++;
+		}
+	}
+
+	ZoneScope(const ZoneScope&) = delete;
+	ZoneScope& operator=(const ZoneScope&) = delete;
+};
+
+#define ZONE_CONCAT_INNER(a, b) a##b
+#define ZONE_CONCAT(a, b) ZONE_CONCAT_INNER(a, b)
+
+#ifdef ENABLE_ZONE_PROFILER
+// profiles the rest of the enclosing scope
+#define PROFILE_ZONE(name) ZoneScope ZONE_CONCAT(zoneScope, __LINE__)(name)
+// starts a new frame, and profiles the rest of the enclosing scope as the zone for this frame
+#define PROFILE_FRAME(name) ZoneProfiler::nextFrame(); ZoneScope ZONE_CONCAT(zoneScope, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_FRAME(name)
+#endif
@@ -0,0 +1,89 @@
+#include "testsMain.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../benchmarks/worldBenchmark.h"
+#include "../benchmarks/benchmarkResults.h"
+#include "../benchmarks/benchmarkCompare.h"
+
+#include "../physics/geometry/basicShapes.h"
+
+class CompareTestBenchmark : public WorldBenchmark {
+public:
+	CompareTestBenchmark(const char* name) : WorldBenchmark(name, 8) {}
+
+	void init() override {
+		createFloor(10, 10, 2);
+		world.addPart(new Part(Box(1.0, 1.0, 1.0), GlobalCFrame(0.0, 2.0, 0.0), basicProperties));
+	}
+};
+
+static CompareTestBenchmark compareTestA("compareTestA");
+static CompareTestBenchmark compareTestB("compareTestB");
+
+static BenchmarkResult measure(Benchmark& bench) {
+	BenchmarkResult result{&bench, 0.0};
+	bench.init();
+	bench.run();
+	bench.clearResults();
+	for(int i = 0; i < 3; i++) {
+		bench.run();
+		result.runMillis.push_back(1.0 + i * 0.01);
+	}
+	result.statistics = computeStatistics(result.runMillis);
+	bench.cleanup();
+	return result;
+}
+
+static bool compare(const std::string& baseline, const std::string& current) {
+	std::istringstream baselineStream(baseline);
+	std::istringstream currentStream(current);
+	return compareBenchmarkResults(baselineStream, currentStream, 5.0);
+}
+
+static bool isRejected(const std::string& baseline, const std::string& current) {
+	try {
+		compare(baseline, current);
+		return false;
+	} catch(const char*) {
+		return true;
+	}
+}
+
+TEST_CASE(writtenBenchmarkResultsCompare) {
+	std::vector<BenchmarkResult> results{measure(compareTestA), measure(compareTestB)};
+
+	bool oldSampleMemory = WorldBenchmark::sampleMemoryEveryTick;
+	std::stringstream withoutTickMemory;
+	WorldBenchmark::sampleMemoryEveryTick = false;
+	writeJSON(withoutTickMemory, results, 1, 3);
+	std::stringstream withTickMemory;
+	WorldBenchmark::sampleMemoryEveryTick = true;
+	writeJSON(withTickMemory, results, 1, 3);
+	WorldBenchmark::sampleMemoryEveryTick = oldSampleMemory;
+
+	ASSERT_TRUE(withoutTickMemory.str().find("\"memoryPeakPerTick\":false") != std::string::npos);
+	ASSERT_TRUE(withTickMemory.str().find("\"memoryPeakPerTick\":true") != std::string::npos);
+
+	ASSERT_FALSE(compare(withoutTickMemory.str(), withoutTickMemory.str()));
+	ASSERT_FALSE(compare(withoutTickMemory.str(), withTickMemory.str()));
+
+	std::vector<BenchmarkResult> onlyA{results[0]};
+	std::stringstream missingB;
+	writeJSON(missingB, onlyA, 1, 3);
+	// a benchmark that disappeared from the results fails the comparison, a new one does not
+	ASSERT_TRUE(compare(withoutTickMemory.str(), missingB.str()));
+	ASSERT_FALSE(compare(missingB.str(), withoutTickMemory.str()));
+}
+
+TEST_CASE(malformedBenchmarkResultsAreRejected) {
+	std::string valid = "{\"benchmarks\":[{\"name\":\"a\",\"runsMs\":[1.0,1.1]}]}";
+	ASSERT_FALSE(isRejected(valid, valid));
+
+	ASSERT_TRUE(isRejected(valid, "{\"benchmarks\":[{\"runsMs\":[1.0,1.1]}]}"));
+	ASSERT_TRUE(isRejected("{\"benchmarks\":[{\"name\":3,\"runsMs\":[1.0]}]}", valid));
+	ASSERT_TRUE(isRejected(valid, "{\"benchmarks\":{}}"));
+	ASSERT_TRUE(isRejected(valid, "{\"benchmarks\":[{\"name\":\"a\",\"flag\":fals}]}"));
+}
@@ -6,7 +6,13 @@
 #include "../util/log.h"
 #include "../physics/math/cframe.h"
 #include "../physics/datastructures/buffers.h"
+#include "../physics/latencyHistogram.h"
+#include "../physics/zoneProfiler.h"
+#include "../physics/profiling.h"
+#include "../physics/hardwareCounters.h"
 #include <vector>
+#include <string>
+#include <sstream>
 
 volatile double t;
 
@@ -149,3 +155,155 @@ TEST_CASE(profileSmallVectorOfVectorsJustRight) {
 
 	Log::debug("Total %d", sum);
 }*/
+
+TEST_CASE(latencyHistogramPercentiles) {
+	LatencyHistogram histogram;
+	for(uint64_t i = 1; i <= 100000; i++) {
+		histogram.record(i * 1000);
+	}
+
+	ASSERT_STRICT(histogram.getCount() == 100000);
+	ASSERT_STRICT(histogram.getMin() == 1000);
+	ASSERT_STRICT(histogram.getMax() == 100000000);
+	ASSERT_TOLERANT(histogram.getMean() == 50000500.0, 0.001);
+	ASSERT_TOLERANT(histogram.getPercentile(50.0) / 50000000.0 == 1.0, 0.035);
+	ASSERT_TOLERANT(histogram.getPercentile(99.0) / 99000000.0 == 1.0, 0.035);
+	ASSERT_TOLERANT(histogram.getPercentile(99.9) / 99900000.0 == 1.0, 0.035);
+	ASSERT_STRICT(histogram.getPercentile(100.0) == 100000000);
+
+	// small values are counted exactly
+	LatencyHistogram small;
+	for(uint64_t i = 0; i < 10; i++) small.record(i);
+	ASSERT_STRICT(small.getPercentile(50.0) == 4);
+	ASSERT_STRICT(small.getPercentile(0.0) == 0);
+}
+
+TEST_CASE(latencyHistogramMergeAndReset) {
+	LatencyHistogram whole;
+	LatencyHistogram firstHalf;
+	LatencyHistogram secondHalf;
+	for(uint64_t i = 0; i < 5000; i++) {
+		uint64_t value = (i * 7919) % 1000000;
+		whole.record(value);
+		if(i % 2 == 0) firstHalf.record(value); else secondHalf.record(value);
+	}
+
+	LatencyHistogram merged = firstHalf;
+	merged.merge(secondHalf);
+	ASSERT_STRICT(merged.getCount() == whole.getCount());
+	ASSERT_STRICT(merged.getMin() == whole.getMin());
+	ASSERT_STRICT(merged.getMax() == whole.getMax());
+	for(double percentile : {10.0, 50.0, 90.0, 99.0, 99.9}) {
+		ASSERT_STRICT(merged.getPercentile(percentile) == whole.getPercentile(percentile));
+	}
+
+	merged.reset();
+	ASSERT_STRICT(merged.getCount() == 0);
+	ASSERT_STRICT(merged.getPercentile(99.0) == 0);
+}
+
+TEST_CASE(hardwareCountsBetweenMultiplexedReadings) {
+	// the first interval ran half the time, the second all of it. Scaled totals would drop from 2000 to 1500
+	HardwareCounterReading start;
+	HardwareCounterReading first;
+	first.counts[HardwareCounter::CYCLES] = 1000;
+	first.counts[HardwareCounter::INSTRUCTIONS] = 500;
+	first.timeEnabled = 200;
+	first.timeRunning = 100;
+	HardwareCounterReading second;
+	second.counts[HardwareCounter::CYCLES] = 1500;
+	second.counts[HardwareCounter::INSTRUCTIONS] = 500;
+	second.timeEnabled = 300;
+	second.timeRunning = 200;
+
+	HardwareCounterValues firstCounts = countsBetween(start, first);
+	ASSERT_STRICT(firstCounts[HardwareCounter::CYCLES] == 2000);
+	ASSERT_STRICT(firstCounts[HardwareCounter::INSTRUCTIONS] == 1000);
+	HardwareCounterValues secondCounts = countsBetween(first, second);
+	ASSERT_STRICT(secondCounts[HardwareCounter::CYCLES] == 500);
+	ASSERT_STRICT(secondCounts[HardwareCounter::INSTRUCTIONS] == 0);
+
+	// readings from before a reset of the counters never give wrapped around counts
+	HardwareCounterValues backwards = countsBetween(second, start);
+	for(uint64_t count : backwards.values) ASSERT_STRICT(count == 0);
+}
+
+enum class TestProcess {
+	FIRST,
+	SECOND,
+	COUNT
+};
+
+TEST_CASE(profilerWithoutHardwareCounters) {
+	const char* labels[]{"first", "second"};
+	BreakdownAverageProfiler<TestProcess> profiler(labels, 10);
+
+	// most virtual machines have no PMU, the test can only check the fallback where the counters can't be opened
+	if(HardwareCounters::enable()) {
+		HardwareCounters::disable();
+	} else {
+		ASSERT_FALSE(HardwareCounters::isEnabled());
+		ASSERT_TRUE(HardwareCounters::getUnavailableReason() != nullptr);
+		for(size_t c = 0; c < static_cast<size_t>(HardwareCounter::COUNT); c++) {
+			ASSERT_FALSE(HardwareCounters::isAvailable(static_cast<HardwareCounter>(c)));
+		}
+	}
+	ASSERT_FALSE(HardwareCounters::isEnabled());
+
+	profiler.resetHardwareCounts();
+	for(int i = 0; i < 5; i++) {
+		profiler.mark(TestProcess::FIRST);
+		profiler.mark(TestProcess::SECOND);
+		profiler.end();
+	}
+	for(const HardwareCounterValues& counts : profiler.hardwareCounts) {
+		for(uint64_t count : counts.values) ASSERT_STRICT(count == 0);
+	}
+}
+
+// the line of the exported trace describing the zone with the given name
+static std::string findTraceEvent(const std::string& trace, const std::string& name) {
+	std::istringstream lines(trace);
+	std::string line;
+	while(std::getline(lines, line)) {
+		if(line.find("\"name\":\"" + name + "\"") != std::string::npos && line.find("\"ph\":\"X\"") != std::string::npos) return line;
+	}
+	return "";
+}
+
+TEST_CASE(zoneProfilerChromeTrace) {
+	ZoneProfiler::clear();
+
+	ZoneProfiler::nextFrame();
+	uint32_t firstFrame = ZoneProfiler::getCurrentFrame();
+	{
+		ZoneScope tick("tick");
+		{
+			ZoneScope outer("outer");
+			ZoneScope inner("inner");
+		}
+	}
+	ZoneProfiler::nextFrame();
+	{
+		ZoneScope tick("secondTick");
+	}
+	ASSERT_STRICT(ZoneProfiler::getEventCount() == 4);
+
+	std::ostringstream stream;
+	ZoneProfiler::exportChromeTrace(stream);
+	std::string trace = stream.str();
+	ZoneProfiler::clear();
+
+	std::string tick = findTraceEvent(trace, "tick");
+	std::string outer = findTraceEvent(trace, "outer");
+	std::string inner = findTraceEvent(trace, "inner");
+	std::string secondTick = findTraceEvent(trace, "secondTick");
+	std::string firstFrameArg = "\"frame\":" + std::to_string(firstFrame) + ",";
+	std::string secondFrameArg = "\"frame\":" + std::to_string(firstFrame + 1) + ",";
+
+	ASSERT_TRUE(tick.find(firstFrameArg) != std::string::npos && tick.find("\"depth\":0}") != std::string::npos);
+	ASSERT_TRUE(outer.find(firstFrameArg) != std::string::npos && outer.find("\"depth\":1}") != std::string::npos);
+	ASSERT_TRUE(inner.find(firstFrameArg) != std::string::npos && inner.find("\"depth\":2}") != std::string::npos);
+	ASSERT_TRUE(secondTick.find(secondFrameArg) != std::string::npos && secondTick.find("\"depth\":0}") != std::string::npos);
+	ASSERT_TRUE(trace.find("\"thread_name\"") != std::string::npos);
+}
@@ -2,6 +2,7 @@
 
 #include "compare.h"
 #include "../physics/misc/toString.h"
+#include <algorithm>
 
 #include "randomValues.h"
 #include "estimateMotion.h"
@@ -10,6 +11,11 @@
 #include "../physics/part.h"
 #include "../physics/physical.h"
 #include "../physics/constraints/fixedConstraint.h"
+#include "../physics/constraints/motorConstraint.h"
+#include "../physics/world.h"
+#include "../physics/broadphase/treeBroadphase.h"
+#include "../physics/broadphase/sweepAndPruneBroadphase.h"
+#include "../physics/broadphase/spatialHashBroadphase.h"
 
 
 #define ASSERT(x) ASSERT_STRICT(x)
@@ -238,3 +244,432 @@ TEST_CASE(testAttachConnectedPhysicalToConnectedPhysical) {
 	}
 }
 
+
+TEST_CASE(testBulkAddParts) {
+	WorldPrototype world(0.005);
+	world.addPart(createPart());
+
+	std::vector<Part*> parts;
+	for(int i = 0; i < 500; i++) {
+		Part* p = createPart();
+		p->setCFrame(GlobalCFrame(i % 10 * 2.0, i / 10 % 10 * 2.0, i / 100 * 2.0));
+		if(i % 7 == 0) {
+			// multi part physicals must stay together in one group
+			p->attach(createPart(), CFrame(0.0, 0.5, 0.0));
+			p->attach(createPart(), new FixedConstraint(), CFrame(0.5, 0.0, 0.0), CFrame(0.0, 0.0, 0.0));
+		}
+		parts.push_back(p);
+	}
+	// adding a part twice, or another part of an already added physical is ignored
+	parts.push_back(parts[0]);
+	world.addParts(parts);
+
+	ASSERT_TRUE(world.isValid());
+	ASSERT(world.physicals.size() == 501);
+	ASSERT(world.objectTree.getNumberOfObjects() == world.getPartCount());
+	for(Part* p : parts) {
+		world.objectTree.findGroupFor(p, p->getStrictBounds());
+	}
+	// 4^5 > 500 groups, multi part groups add at most 2 more levels
+	ASSERT_TRUE(world.objectTree.rootNode.getLengthOfLongestBranch() <= 7);
+
+	std::vector<Part*> terrain;
+	for(int i = 0; i < 100; i++) {
+		Part* p = createPart();
+		p->setCFrame(GlobalCFrame(i * 2.0, -5.0, 0.0));
+		terrain.push_back(p);
+	}
+	world.addTerrainParts(terrain);
+	ASSERT_TRUE(world.isValid());
+	ASSERT(world.terrainTree.getNumberOfObjects() == 100);
+
+	// small batches are inserted into the existing tree instead of rebuilding it
+	for(int batch = 0; batch < 10; batch++) {
+		std::vector<Part*> smallBatch;
+		for(int i = 0; i < 3; i++) {
+			Part* p = createPart();
+			p->setCFrame(GlobalCFrame(batch * 2.0, i * 2.0, -10.0));
+			smallBatch.push_back(p);
+		}
+		world.addParts(smallBatch);
+		for(Part* p : smallBatch) {
+			world.objectTree.findGroupFor(p, p->getStrictBounds());
+		}
+	}
+	ASSERT_TRUE(world.isValid());
+	ASSERT(world.physicals.size() == 531);
+	ASSERT(world.objectTree.getNumberOfObjects() == world.getPartCount() - world.terrainTree.getNumberOfObjects());
+}
+
+TEST_CASE(testCollisionLayers) {
+	WorldPrototype world(0.005);
+	int debrisLayer = world.createLayer(false);
+	ASSERT_FALSE(world.doLayersCollide(DEFAULT_LAYER, debrisLayer));
+	ASSERT_TRUE(world.doLayersCollide(DEFAULT_LAYER, DEFAULT_TERRAIN_LAYER));
+	world.setLayersCollide(debrisLayer, DEFAULT_TERRAIN_LAYER, true);
+
+	Part* a = createPart();
+	Part* b = createPart();
+	Part* debris = createPart();
+	b->setCFrame(GlobalCFrame(0.9, 0.1, 0.05));
+	debris->setCFrame(GlobalCFrame(-0.9, -0.1, 0.05));
+	world.addPart(a);
+	world.addPart(b);
+	world.addPart(debris, debrisLayer);
+
+	ASSERT_TRUE(world.isValid());
+	ASSERT(debris->layer == debrisLayer);
+	ASSERT(world.getLayer(debrisLayer).tree.getNumberOfObjects() == 1);
+	ASSERT(world.objectTree.getNumberOfObjects() == 2);
+
+	// attached parts move into the layer of the physical they join
+	Part* attached = createPart();
+	debris->attach(attached, CFrame(0.0, 2.0, 0.0));
+	ASSERT(attached->layer == debrisLayer);
+	ASSERT_TRUE(world.isValid());
+
+	world.tick();
+
+	// a and b overlap and are pushed apart, the debris overlaps a but is in a layer that does not collide with it
+	ASSERT_TRUE(a->parent->mainPhysical->motionOfCenterOfMass.translation.velocity != Vec3(0.0, 0.0, 0.0));
+	ASSERT_TRUE(debris->parent->mainPhysical->motionOfCenterOfMass.translation.velocity == Vec3(0.0, 0.0, 0.0));
+	ASSERT_TRUE(world.isValid());
+}
+
+static std::vector<std::pair<Part*, Part*>> normalizedPairs(const std::vector<BroadphasePair>& pairs, bool keepOrder) {
+	std::vector<std::pair<Part*, Part*>> result;
+	for(const BroadphasePair& pair : pairs) {
+		if(keepOrder || pair.p1 < pair.p2) {
+			result.emplace_back(pair.p1, pair.p2);
+		} else {
+			result.emplace_back(pair.p2, pair.p1);
+		}
+	}
+	std::sort(result.begin(), result.end());
+	return result;
+}
+
+static bool haveSameCandidatePairs(WorldPrototype& world, Broadphase& a, Broadphase& b) {
+	std::vector<BroadphasePair> objectPairsA, terrainPairsA, objectPairsB, terrainPairsB;
+	a.findCandidatePairs(world, objectPairsA, terrainPairsA);
+	b.findCandidatePairs(world, objectPairsB, terrainPairsB);
+	return normalizedPairs(objectPairsA, false) == normalizedPairs(objectPairsB, false) && normalizedPairs(terrainPairsA, true) == normalizedPairs(terrainPairsB, true);
+}
+
+TEST_CASE(testSweepAndPruneMatchesTree) {
+	WorldPrototype world(0.005);
+	int debrisLayer = world.createLayer(false);
+	world.setLayersCollide(debrisLayer, DEFAULT_TERRAIN_LAYER, true);
+
+	std::vector<Part*> parts;
+	for(int i = 0; i < 200; i++) {
+		Part* p = createPart();
+		p->setCFrame(GlobalCFrame(i % 6 * 0.9, i / 6 % 6 * 0.9, i / 36 * 0.9));
+		if(i % 9 == 0) {
+			p->attach(createPart(), CFrame(0.0, 0.5, 0.0));
+		}
+		parts.push_back(p);
+	}
+	world.addParts(parts.data(), 150);
+	world.addParts(parts.data() + 150, 50, debrisLayer);
+	world.addTerrainPart(new Part(Box(20.0, 1.0, 20.0), GlobalCFrame(0.0, -0.5, 0.0), {1.0, 1.0, 1.0}));
+
+	TreeBroadphase tree;
+	SweepAndPruneBroadphase sap;
+	ASSERT_TRUE(haveSameCandidatePairs(world, tree, sap));
+
+	// the incremental path, only the positions changed
+	for(MotorizedPhysical* phys : world.physicals) {
+		phys->setCFrame(phys->getCFrame().localToGlobal(CFrame(Vec3(0.3, -0.2, 0.1), Rotation::rotY(0.2))));
+	}
+	ASSERT_TRUE(haveSameCandidatePairs(world, tree, sap));
+
+	// the set of parts changed
+	world.removePart(parts[3]);
+	world.addPart(createPart(), debrisLayer);
+	ASSERT_TRUE(haveSameCandidatePairs(world, tree, sap));
+
+	world.setBroadphase(new SweepAndPruneBroadphase());
+	world.tick();
+	world.tick();
+	ASSERT_TRUE(world.isValid());
+}
+
+TEST_CASE(testSpatialHashMatchesTree) {
+	WorldPrototype world(0.005);
+	int debrisLayer = world.createLayer(false);
+	world.setLayersCollide(debrisLayer, DEFAULT_TERRAIN_LAYER, true);
+	world.setLayersCollide(debrisLayer, DEFAULT_LAYER, true);
+
+	std::vector<Part*> parts;
+	for(int i = 0; i < 6000; i++) {
+		Part* p = new Part(Box(0.4, 0.4, 0.4), GlobalCFrame(i % 20 * 0.35 - 3.0, i / 20 % 15 * 0.35 - 2.0, i / 300 * 0.35 - 3.0), {1.0, 1.0, 1.0});
+		if(i % 13 == 0) {
+			p->attach(new Part(Box(0.4, 0.4, 0.4), GlobalCFrame(), {1.0, 1.0, 1.0}), CFrame(0.0, 0.3, 0.0));
+		}
+		parts.push_back(p);
+	}
+	// parts larger than a cell go through the trees
+	parts.push_back(new Part(Box(3.0, 0.5, 0.5), GlobalCFrame(0.0, 0.0, 0.0), {1.0, 1.0, 1.0}));
+	parts.push_back(new Part(Box(0.5, 3.0, 0.5), GlobalCFrame(0.5, 0.5, 0.0), {1.0, 1.0, 1.0}));
+	world.addParts(parts.data(), 4000);
+	world.addParts(parts.data() + 4000, parts.size() - 4000, debrisLayer);
+	world.addTerrainPart(new Part(Box(20.0, 1.0, 20.0), GlobalCFrame(0.0, -2.5, 0.0), {1.0, 1.0, 1.0}));
+
+	TreeBroadphase tree;
+	SpatialHashBroadphase grid(-1, 1);
+	SpatialHashBroadphase threadedGrid(-1, 4);
+	ASSERT_TRUE(haveSameCandidatePairs(world, tree, grid));
+	ASSERT_TRUE(haveSameCandidatePairs(world, tree, threadedGrid));
+
+	// the order of the pairs does not depend on the number of threads
+	std::vector<BroadphasePair> objectPairsA, terrainPairsA, objectPairsB, terrainPairsB;
+	grid.findCandidatePairs(world, objectPairsA, terrainPairsA);
+	threadedGrid.findCandidatePairs(world, objectPairsB, terrainPairsB);
+	ASSERT_TRUE(objectPairsA.size() == objectPairsB.size());
+	bool sameOrder = true;
+	for(size_t i = 0; i < objectPairsA.size(); i++) {
+		if(objectPairsA[i].p1 != objectPairsB[i].p1 || objectPairsA[i].p2 != objectPairsB[i].p2) sameOrder = false;
+	}
+	ASSERT_TRUE(sameOrder);
+
+	world.setBroadphase(new SpatialHashBroadphase(-1, 2));
+	world.tick();
+	ASSERT_TRUE(world.isValid());
+}
+
+static bool hasOutdatedGroupFor(BoundsTree<Part>& tree, const Part* part) {
+	NodeStack stack = tree.find(part, part->getStrictBounds());
+	for(TreeStackElement* element = stack.stack; element <= stack.top; element++) {
+		if(element->node->isGroupHead) return element->node->hasOutdatedSubBounds;
+	}
+	return false;
+}
+
+TEST_CASE(testRigidGroupRefit) {
+	WorldPrototype world(0.005);
+	Part* vehicle = new Part(Box(1.0, 1.0, 1.0), GlobalCFrame(0.0, 0.0, 0.0, Rotation::fromEulerAngles(0.3, 0.2, 0.1)), {1.0, 1.0, 1.0});
+	std::vector<Part*> vehicleParts{vehicle};
+	for(int i = 1; i < 40; i++) {
+		Part* p = new Part(Box(1.0, 1.0, 1.0), GlobalCFrame(), {1.0, 1.0, 1.0});
+		vehicle->attach(p, CFrame(i % 10 * 1.0, i / 10 * 1.0, 0.0));
+		vehicleParts.push_back(p);
+	}
+	world.addPart(vehicle);
+	Part* jointed = new Part(Box(1.0, 1.0, 1.0), GlobalCFrame(20.0, 0.0, 0.0), {1.0, 1.0, 1.0});
+	jointed->attach(new Part(Box(1.0, 1.0, 1.0), GlobalCFrame(), {1.0, 1.0, 1.0}), new FixedConstraint(), CFrame(0.5, 0.0, 0.0), CFrame(0.0, 0.0, 0.0));
+	world.addPart(jointed);
+	Part* obstacle = new Part(Box(1.0, 1.0, 1.0), vehicleParts[25]->getCFrame().localToGlobal(CFrame(0.0, 0.0, 0.9)), {1.0, 1.0, 1.0});
+	world.addPart(obstacle);
+
+	world.tick();
+	ASSERT_TRUE(world.isValid());
+	// only groups that can't move internally are refitted as a whole
+	ASSERT_TRUE(hasOutdatedGroupFor(world.objectTree, vehicle));
+	ASSERT_FALSE(hasOutdatedGroupFor(world.objectTree, jointed));
+
+	// the pair tests look inside the outdated group
+	TreeBroadphase tree;
+	SweepAndPruneBroadphase sweepAndPrune;
+	ASSERT_TRUE(haveSameCandidatePairs(world, tree, sweepAndPrune));
+	std::vector<BroadphasePair> objectPairs, terrainPairs;
+	tree.findCandidatePairs(world, objectPairs, terrainPairs);
+	ASSERT_TRUE(std::any_of(objectPairs.begin(), objectPairs.end(), [&](const BroadphasePair& pair) {
+		return pair.p1 == vehicleParts[25] && pair.p2 == obstacle || pair.p1 == obstacle && pair.p2 == vehicleParts[25];
+	}));
+	// the pair tests search the group in its own frame, its nodes aren't brought back to global bounds
+	ASSERT_TRUE(hasOutdatedGroupFor(world.objectTree, vehicle));
+	SpatialHashBroadphase grid(-1, 1);
+	ASSERT_TRUE(haveSameCandidatePairs(world, tree, grid));
+	ASSERT_TRUE(hasOutdatedGroupFor(world.objectTree, vehicle));
+
+	// parts inside an outdated group can still be found and moved
+	world.tick();
+	ASSERT_TRUE(hasOutdatedGroupFor(world.objectTree, vehicle));
+	for(Part* p : vehicleParts) {
+		world.objectTree.findGroupFor(p, p->getStrictBounds());
+	}
+	vehicleParts[7]->setCFrame(GlobalCFrame(3.0, 4.0, 5.0));
+	ASSERT_TRUE(world.isValid());
+	world.tick();
+	vehicleParts[12]->detach();
+	ASSERT_TRUE(world.isValid());
+	ASSERT_STRICT(world.getPartCount() == 43);
+}
+
+TEST_CASE(testPhysicalIndexAfterRemoval) {
+	WorldPrototype world(0.005);
+	std::vector<Part*> parts;
+	for(int i = 0; i < 20; i++) {
+		Part* p = new Part(Box(1.0, 1.0, 1.0), GlobalCFrame(i * 2.0, 0.0, 0.0), {1.0, 1.0, 1.0});
+		parts.push_back(p);
+	}
+	Part* attached = new Part(Box(1.0, 1.0, 1.0), GlobalCFrame(), {1.0, 1.0, 1.0});
+	parts[5]->attach(attached, CFrame(0.0, 2.0, 0.0));
+	for(Part* p : parts) {
+		world.addPart(p);
+	}
+
+	// removing from the middle swaps the last physical into the hole
+	delete parts[3];
+	delete parts[0];
+	delete parts[19];
+	ASSERT_STRICT(world.physicals.size() == 17);
+	for(size_t i = 0; i < world.physicals.size(); i++) {
+		ASSERT_STRICT(world.physicals[i]->indexInWorld == i);
+	}
+
+	// detaching a part gives it a new physical at the end of the list
+	attached->detach();
+	ASSERT_STRICT(world.physicals.size() == 18);
+	ASSERT_STRICT(attached->parent->mainPhysical->indexInWorld == 17);
+	ASSERT_TRUE(world.isValid());
+}
+
+TEST_CASE(testBatchEdit) {
+	WorldPrototype world(0.005);
+	std::vector<Part*> parts;
+	for(int i = 0; i < 50; i++) {
+		Part* p = new Part(Box(1.0, 1.0, 1.0), GlobalCFrame(i * 2.0, 0.0, 0.0), {1.0, 1.0, 1.0});
+		world.addPart(p);
+		parts.push_back(p);
+	}
+	Part* attached = new Part(Box(1.0, 1.0, 1.0), GlobalCFrame(), {1.0, 1.0, 1.0});
+	parts[10]->attach(attached, CFrame(0.0, 2.0, 0.0));
+
+	{
+		BatchEdit batch(world);
+		for(int i = 0; i < 50; i++) {
+			parts[i]->setCFrame(GlobalCFrame(0.0, i * 3.0, 100.0));
+		}
+		attached->setWidth(3.0);
+		// the trees are only refitted when the batch is committed
+		Bounds oldBounds(Position(20.0, 0.0, 0.0) - Vec3(0.5, 0.5, 0.5), Position(20.0, 0.0, 0.0) + Vec3(0.5, 0.5, 0.5));
+		world.objectTree.find(parts[10], oldBounds);
+
+		// removing a part during a batch still works
+		delete parts[20];
+		parts.erase(parts.begin() + 20);
+	}
+
+	ASSERT_TRUE(world.isValid());
+	ASSERT_FALSE(world.isInBatchEdit());
+	ASSERT_STRICT(world.objectTree.getNumberOfObjects() == 50);
+	for(Part* p : parts) {
+		world.objectTree.find(p, p->getStrictBounds());
+	}
+	world.objectTree.find(attached, attached->getStrictBounds());
+	TreeBroadphase tree;
+	SweepAndPruneBroadphase sweepAndPrune;
+	ASSERT_TRUE(haveSameCandidatePairs(world, tree, sweepAndPrune));
+	// a few physicals, the nodes they share are refitted once
+	{
+		BatchEdit batch(world);
+		parts[3]->setCFrame(GlobalCFrame(-10.0, 0.0, 0.0));
+		parts[3]->setCFrame(GlobalCFrame(-20.0, 0.0, 0.0));
+		attached->setCFrame(GlobalCFrame(-30.0, 0.0, 0.0));
+	}
+	ASSERT_TRUE(world.isValid());
+	world.objectTree.find(parts[3], parts[3]->getStrictBounds());
+	world.objectTree.find(parts[10], parts[10]->getStrictBounds());
+	world.objectTree.find(attached, attached->getStrictBounds());
+
+	world.tick();
+	ASSERT_TRUE(world.isValid());
+}
+
+static bool isLinkedToTree(const WorldPrototype& world, const Part* part) {
+	if(part->treeNode == nullptr || part->treeNode->object != part) return false;
+	const TreeNode* highest = part->treeNode;
+	while(highest->parent != nullptr) highest = highest->parent;
+	return highest == &world.getLayer(part->layer).tree.rootNode;
+}
+
+TEST_CASE(testPartsKeepTheirTreeNode) {
+	WorldPrototype world(0.005);
+	std::vector<Part*> parts;
+	for(int i = 0; i < 100; i++) {
+		Part* p = createPart();
+		p->setCFrame(GlobalCFrame(i % 10 * 2.0, i / 10 * 2.0, 0.0));
+		parts.push_back(p);
+	}
+	world.addParts(parts);
+	for(int i = 0; i < 100; i++) {
+		Part* p = createPart();
+		p->setCFrame(GlobalCFrame(i * 0.7, -3.0, i % 3 * 1.0));
+		world.addPart(p);
+		parts.push_back(p);
+	}
+	Part* attached = createPart();
+	parts[4]->attach(attached, CFrame(0.0, 2.0, 0.0));
+	parts.push_back(attached);
+	for(Part* p : parts) ASSERT_TRUE(isLinkedToTree(world, p));
+
+	// moving parts around and restructuring the tree moves their nodes
+	for(int i = 0; i < 200; i += 3) {
+		parts[i]->setCFrame(GlobalCFrame(-i * 1.0, 5.0, 0.0));
+	}
+	for(int i = 0; i < 3; i++) world.objectTree.improveStructure();
+	ASSERT_TRUE(world.isValid());
+	for(Part* p : parts) ASSERT_TRUE(isLinkedToTree(world, p));
+
+	for(int i = 199; i >= 0; i -= 2) {
+		delete parts[i];
+		parts.erase(parts.begin() + i);
+	}
+	ASSERT_TRUE(world.isValid());
+	ASSERT_STRICT(world.objectTree.getNumberOfObjects() == parts.size());
+	for(Part* p : parts) ASSERT_TRUE(isLinkedToTree(world, p));
+
+	// a part removed from the world forgets its node
+	attached->detach();
+	ASSERT_TRUE(isLinkedToTree(world, attached));
+	world.removePart(attached);
+	ASSERT_TRUE(attached->treeNode == nullptr);
+}
+
+TEST_CASE(testCachedMassProperties) {
+	WorldPrototype world(0.005);
+	Part* base = new Part(Box(2.0, 1.0, 1.0), GlobalCFrame(0.0, 0.0, 0.0), {1.0, 1.0, 1.0});
+	Part* arm = new Part(Box(1.0, 3.0, 1.0), GlobalCFrame(), {1.0, 1.0, 1.0});
+	Part* hand = new Part(Box(0.5, 0.5, 0.5), GlobalCFrame(), {2.0, 1.0, 1.0});
+	Part* wheel = new Part(Sphere(0.7), GlobalCFrame(), {1.0, 1.0, 1.0});
+	MotorConstraint* motor = new MotorConstraint(Vec3(0.0, 0.0, 2.0), 0.0);
+	base->attach(arm, motor, CFrame(1.0, 0.5, 0.0), CFrame(0.0, -1.5, 0.0));
+	arm->attach(hand, new FixedConstraint(), CFrame(0.0, 1.5, 0.0), CFrame(0.3, 0.0, 0.0));
+	base->attach(wheel, new FixedConstraint(), CFrame(-1.0, 0.0, 0.0), CFrame(0.0, 0.0, 0.0));
+	world.addPart(base);
+	MotorizedPhysical* phys = base->parent->mainPhysical;
+	phys->motionOfCenterOfMass.rotation.angularVelocity = Vec3(0.1, 0.2, 0.3);
+
+	double cachedMass = phys->totalMass;
+	// the motor swings the arm and hand around, the properties cached during the ticks must follow them
+	for(int round = 0; round < 5; round++) {
+		double angleBefore = motor->getCurrentAngle();
+		Vec3 centerOfMassBefore = phys->totalCenterOfMass;
+		SymmetricMat3 momentResponseBefore = phys->momentResponse;
+
+		for(int i = 0; i < 20; i++) {
+			world.tick();
+		}
+
+		ASSERT_TRUE(motor->getCurrentAngle() != angleBefore);
+		ASSERT_TRUE(lengthSquared(phys->totalCenterOfMass - centerOfMassBefore) > 0.000001);
+		ASSERT_FALSE(tolerantEquals(phys->momentResponse, momentResponseBefore, 0.000001));
+
+		cachedMass = phys->totalMass;
+		Vec3 cachedCenterOfMass = phys->totalCenterOfMass;
+		SymmetricMat3 cachedMomentResponse = phys->momentResponse;
+		phys->refreshPhysicalProperties();
+		ASSERT_TOLERANT(cachedMass == phys->totalMass, 0.000001);
+		ASSERT_TOLERANT(cachedCenterOfMass == phys->totalCenterOfMass, 0.000001);
+		ASSERT_TOLERANT(cachedMomentResponse == phys->momentResponse, 0.000001);
+	}
+
+	// resizing a part invalidates the cached properties
+	hand->setWidth(2.0);
+	double massAfterResize = phys->totalMass;
+	ASSERT_TRUE(massAfterResize > cachedMass);
+	phys->refreshPhysicalProperties();
+	ASSERT_TOLERANT(massAfterResize == phys->totalMass, 0.000001);
+}
@@ -5,6 +5,9 @@
 
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include <sstream>
+#include <thread>
+#include <atomic>
 
 #include "../physics/world.h"
 #include "../physics/inertia.h"
@@ -17,6 +20,10 @@
 #include "../physics/geometry/shape.h"
 #include "../physics/geometry/polyhedron.h"
 #include "../physics/geometry/normalizedPolyhedron.h"
+#include "../physics/geometry/heightfieldShapeClass.h"
+#include "../physics/geometry/triangleMeshShapeClass.h"
+#include "../physics/geometry/intersection.h"
+#include "../physics/debug.h"
 #include "../util/log.h"
 
 
@@ -381,3 +388,312 @@ TEST_CASE(testShapeNativeScaling) {
 
 	ASSERT(shape2.getInertia() == scaledTestPoly.getInertiaAroundCenterOfMass());
 }
+
+// a slope rising along x, from y=-1 at x=-1 to y=0 at x=1
+static HeightfieldShapeClass createSlopeHeightfield(int samples) {
+	std::vector<float> heights(samples * samples);
+	for(int k = 0; k < samples; k++) {
+		for(int i = 0; i < samples; i++) {
+			heights[k * samples + i] = float(i) / (samples - 1) - 1.0f;
+		}
+	}
+	return HeightfieldShapeClass(samples, samples, heights.data());
+}
+
+TEST_CASE(heightfieldSurface) {
+	HeightfieldShapeClass slope = createSlopeHeightfield(65);
+	ASSERT_TOLERANT(slope.getHeightAt(0.0, 0.3) == -0.5, 0.0001);
+	ASSERT_TOLERANT(slope.getHeightAt(1.0, -1.0) == 0.0, 0.0001);
+	ASSERT_TRUE(slope.containsPoint(Vec3(0.0, -0.6, 0.0)));
+	ASSERT_FALSE(slope.containsPoint(Vec3(0.0, -0.4, 0.0)));
+	ASSERT_FALSE(slope.containsPoint(Vec3(1.5, -0.9, 0.0)));
+
+	// straight down onto the slope
+	ASSERT_TOLERANT(slope.getIntersectionDistance(Vec3(0.5, 2.0, 0.2), Vec3(0.0, -1.0, 0.0)) == 2.25, 0.0001);
+	// diagonally, crossing many cells before hitting
+	ASSERT_TOLERANT(slope.getIntersectionDistance(Vec3(-2.0, 0.0, -2.0), Vec3(1.0, -0.25, 1.0)) == 2.0, 0.0001);
+	ASSERT_TRUE(slope.getIntersectionDistance(Vec3(0.5, 2.0, 0.2), Vec3(0.0, 1.0, 0.0)) == INFINITY);
+}
+
+TEST_CASE(heightfieldColission) {
+	HeightfieldShapeClass slope = createSlopeHeightfield(257);
+	Shape terrain = Heightfield(&slope, 100.0, 20.0, 100.0);
+	Shape box = Box(1.0, 1.0, 1.0);
+
+	// the surface is at y = -5 at x = 0
+	ASSERT_FALSE(intersectsTransformed(terrain, box, CFrame(0.0, -4.0, 3.0)).has_value());
+	std::optional<Intersection> result = intersectsTransformed(terrain, box, CFrame(0.0, -5.2, 3.0));
+	ASSERT_TRUE(result.has_value());
+	// pushed out perpendicular to the slope, up and towards -x
+	ASSERT_TRUE(result.value().exitVector.y > 0.0);
+	ASSERT_TRUE(result.value().exitVector.x < 0.0);
+
+	// the same test with the heightfield second gives the opposite exitVector
+	CFrame boxToTerrain(0.0, -5.2, 3.0);
+	std::optional<Intersection> swapped = intersectsTransformed(box, terrain, ~boxToTerrain);
+	ASSERT_TRUE(swapped.has_value());
+	ASSERT_TOLERANT(boxToTerrain.localToRelative(swapped.value().exitVector) == -result.value().exitVector, 0.0001);
+
+	// a part standing on the heightfield in a world does not fall through
+	WorldPrototype world(0.005);
+	world.addTerrainPart(new Part(terrain, GlobalCFrame(0.0, 0.0, 0.0), {1.0, 1.0, 0.7}));
+	Part* block = new Part(box, GlobalCFrame(-30.0, -7.0, 0.0), {1.0, 0.0, 0.7});
+	world.addPart(block);
+	for(int i = 0; i < 400; i++) {
+		block->parent->mainPhysical->applyForceAtCenterOfMass(Vec3(0.0, -10.0, 0.0) * block->getMass());
+		world.tick();
+	}
+	ASSERT_TRUE(block->getCFrame().getPosition().y > Fix<32>(-8.5));
+}
+
+// a flat grid of cells x cells squares of size 1 in the xz plane, facing up
+static Polyhedron createFloorMesh(int cells) {
+	std::vector<Vec3f> vertices;
+	for(int k = 0; k <= cells; k++) {
+		for(int i = 0; i <= cells; i++) {
+			vertices.push_back(Vec3f(float(i - cells / 2.0), 0.0f, float(k - cells / 2.0)));
+		}
+	}
+	std::vector<Triangle> triangles;
+	for(int k = 0; k < cells; k++) {
+		for(int i = 0; i < cells; i++) {
+			int v00 = k * (cells + 1) + i;
+			int v10 = v00 + 1;
+			int v01 = v00 + cells + 1;
+			int v11 = v01 + 1;
+			triangles.push_back(Triangle{v00, v11, v10});
+			triangles.push_back(Triangle{v00, v01, v11});
+		}
+	}
+	return Polyhedron(vertices.data(), triangles.data(), static_cast<int>(vertices.size()), static_cast<int>(triangles.size()));
+}
+
+TEST_CASE(triangleMeshSurface) {
+	Shape mesh = TriangleMesh(Library::createBox(2.0f, 4.0f, 6.0f));
+	ASSERT_TOLERANT(mesh.getHeight() == 4.0, 0.0001);
+	ASSERT_TRUE(mesh.containsPoint(Vec3(0.3, 1.2, -2.1)));
+	ASSERT_FALSE(mesh.containsPoint(Vec3(0.3, 2.5, -2.1)));
+	ASSERT_FALSE(mesh.containsPoint(Vec3(-1.5, 0.2, 0.1)));
+
+	ASSERT_TOLERANT(mesh.getIntersectionDistance(Vec3(0.3, 5.0, 0.1), Vec3(0.0, -1.0, 0.0)) == 3.0, 0.0001);
+	ASSERT_TRUE(mesh.getIntersectionDistance(Vec3(0.3, 5.0, 0.1), Vec3(0.0, 1.0, 0.0)) == INFINITY);
+}
+
+TEST_CASE(triangleMeshColission) {
+	Shape floor = TriangleMesh(createFloorMesh(100));
+	const TriangleMeshShapeClass& floorMesh = static_cast<const TriangleMeshShapeClass&>(*floor.baseShape);
+	ASSERT_STRICT(floorMesh.getTriangles().size() == 20000);
+
+	// the tree only gives the triangles near the queried bounds
+	int visited = 0;
+	floorMesh.forEachTriangleInBounds(Vec3f(0.1f, -1.0f, 0.1f), Vec3f(0.11f, 1.0f, 0.11f), [&visited](const Triangle&) {visited++; });
+	ASSERT_TRUE(visited > 0 && visited <= 16);
+
+	Shape box = Box(1.0, 1.0, 1.0);
+	ASSERT_FALSE(intersectsTransformed(floor, box, CFrame(3.3, 0.6, 2.1)).has_value());
+	std::optional<Intersection> result = intersectsTransformed(floor, box, CFrame(3.3, 0.3, 2.1));
+	ASSERT_TRUE(result.has_value());
+	ASSERT_TOLERANT(result.value().exitVector == Vec3(0.0, 0.2, 0.0), 0.0001);
+	// the floor is only solid from above
+	ASSERT_FALSE(intersectsTransformed(floor, box, CFrame(3.3, -0.3, 2.1)).has_value());
+
+	CFrame boxToFloor(3.3, 0.3, 2.1);
+	std::optional<Intersection> swapped = intersectsTransformed(box, floor, ~boxToFloor);
+	ASSERT_TRUE(swapped.has_value());
+	ASSERT_TOLERANT(boxToFloor.localToRelative(swapped.value().exitVector) == -result.value().exitVector, 0.0001);
+
+	// a part standing on the mesh in a world does not fall through
+	WorldPrototype world(0.005);
+	world.addTerrainPart(new Part(floor, GlobalCFrame(0.0, 0.0, 0.0), {1.0, 1.0, 0.7}));
+	Part* block = new Part(box, GlobalCFrame(10.3, 0.45, -7.6), {1.0, 0.0, 0.7});
+	world.addPart(block);
+	for(int i = 0; i < 400; i++) {
+		block->parent->mainPhysical->applyForceAtCenterOfMass(Vec3(0.0, -10.0, 0.0) * block->getMass());
+		world.tick();
+	}
+	ASSERT_TRUE(block->getCFrame().getPosition().y > Fix<32>(0.0));
+}
+
+// spheres and axis aligned boxes have a known penetration, the shape class specific GJK and EPA must find it
+TEST_CASE(specializedColissionMatchesAnalytic) {
+	Shape firstSphere = Sphere(0.6);
+	Shape secondSphere = Sphere(0.4);
+	Vec3 directions[]{Vec3(1.0, 0.0, 0.0), normalize(Vec3(0.3, -0.8, 0.5)), normalize(Vec3(-0.6, 0.2, 0.9))};
+	double distances[]{0.3, 0.7, 0.95, 1.05, 1.5};
+	for(const Vec3& direction : directions) {
+		for(double distance : distances) {
+			std::optional<Intersection> result = intersectsTransformed(firstSphere, secondSphere, CFrame(direction * distance, Rotation::fromEulerAngles(0.4, -0.3, 1.2)));
+			ASSERT_STRICT(result.has_value() == (distance < 1.0));
+			// EPA only approximates the curved surface, so the direction is only roughly along the centers
+			if(result) {
+				ASSERT_TOLERANT(length(result.value().exitVector) == 1.0 - distance, 0.005);
+				ASSERT_TRUE(normalize(result.value().exitVector) * direction > 0.99);
+			}
+		}
+	}
+
+	Shape firstBox = Box(1.0, 2.0, 0.7);
+	Shape secondBox = Box(0.8, 0.6, 1.0);
+	Vec3 halfExtentSum(0.9, 1.3, 0.85);
+	Vec3 boxOffsets[]{Vec3(0.7, 0.9, 0.2), Vec3(-0.3, 1.1, -0.5), Vec3(0.2, -0.4, 0.8), Vec3(0.1, 0.2, -0.3), Vec3(0.95, 0.1, 0.1), Vec3(0.1, 1.35, 0.0), Vec3(0.5, -0.5, -0.9)};
+	for(const Vec3& offset : boxOffsets) {
+		std::optional<Intersection> result = intersectsTransformed(firstBox, secondBox, CFrame(offset));
+		Vec3 expectedExit(0.0, 0.0, 0.0);
+		double smallestPenetration = 1E10;
+		for(int axis = 0; axis < 3; axis++) {
+			double penetration = halfExtentSum[axis] - std::abs(offset[axis]);
+			if(penetration < smallestPenetration) {
+				smallestPenetration = penetration;
+				expectedExit = Vec3(0.0, 0.0, 0.0);
+				expectedExit[axis] = (offset[axis] > 0) ? penetration : -penetration;
+			}
+		}
+		ASSERT_STRICT(result.has_value() == (smallestPenetration > 0));
+		if(result) {
+			ASSERT_TOLERANT(result.value().exitVector == expectedExit, 0.0001);
+		}
+	}
+}
+
+// a box built as a polyhedron goes through the polyhedron GJK and EPA, which must agree with those of the box class
+TEST_CASE(specializedColissionMatchesPolyhedron) {
+	NormalizedPolyhedron boxHull = Library::createBox(1.0f, 2.0f, 0.7f).normalized();
+	Shape box = Box(1.0, 2.0, 0.7);
+	Shape boxAsHull(&boxHull, 1.0, 2.0, 0.7);
+	NormalizedPolyhedron icosa = Library::icosahedron.normalized();
+	Shape others[]{Box(0.8, 0.6, 1.0), Sphere(0.6), Cylinder(0.5, 1.3), Shape(&icosa, 1.1, 0.9, 1.4)};
+	CFrame offsets[]{CFrame(Vec3(0.3, 0.4, -0.2), Rotation::fromEulerAngles(0.3, 0.7, 0.1)), CFrame(Vec3(0.9, -0.5, 0.6), Rotation::fromEulerAngles(-0.2, 0.1, 1.1)), CFrame(Vec3(-0.6, 1.1, 0.4), Rotation::fromEulerAngles(0.9, -0.4, 0.3)), CFrame(3.0, 0.0, 0.0)};
+
+	for(const Shape& other : others) {
+		for(const CFrame& offset : offsets) {
+			std::optional<Intersection> boxFirst = intersectsTransformed(box, other, offset);
+			std::optional<Intersection> hullFirst = intersectsTransformed(boxAsHull, other, offset);
+			ASSERT_STRICT(boxFirst.has_value() == hullFirst.has_value());
+			if(boxFirst) {
+				ASSERT_TOLERANT(boxFirst.value().intersection == hullFirst.value().intersection, 0.0001);
+				ASSERT_TOLERANT(boxFirst.value().exitVector == hullFirst.value().exitVector, 0.0001);
+			}
+
+			std::optional<Intersection> boxSecond = intersectsTransformed(other, box, offset);
+			std::optional<Intersection> hullSecond = intersectsTransformed(other, boxAsHull, offset);
+			ASSERT_STRICT(boxSecond.has_value() == hullSecond.has_value());
+			if(boxSecond) {
+				ASSERT_TOLERANT(boxSecond.value().intersection == hullSecond.value().intersection, 0.0001);
+				ASSERT_TOLERANT(boxSecond.value().exitVector == hullSecond.value().exitVector, 0.0001);
+			}
+		}
+	}
+}
+
+TEST_CASE(worldMemoryUsage) {
+	NormalizedPolyhedron icosa = Library::icosahedron.normalized();
+	NormalizedPolyhedron wedge = Library::wedge.normalized();
+	WorldPrototype world(0.005);
+	world.addTerrainPart(new Part(Box(10.0, 1.0, 10.0), GlobalCFrame(0.0, -1.0, 0.0), {1.0, 1.0, 0.7}));
+	world.addPart(new Part(Shape(&icosa), GlobalCFrame(0.0, 1.0, 0.0), {1.0, 1.0, 0.7}));
+	world.addPart(new Part(Shape(&icosa), GlobalCFrame(3.0, 1.0, 0.0), {1.0, 1.0, 0.7}));
+	world.addPart(new Part(Shape(&wedge), GlobalCFrame(6.0, 1.0, 0.0), {1.0, 1.0, 0.7}));
+
+	MemoryUsage usage = world.getMemoryUsage();
+	ASSERT_STRICT(usage[MemoryCategory::PARTS] == 4 * sizeof(Part));
+	ASSERT_STRICT(usage[MemoryCategory::SHARED_SHAPES] == icosa.getMemoryUsage());
+	ASSERT_STRICT(usage[MemoryCategory::UNIQUE_SHAPES] == wedge.getMemoryUsage());
+	ASSERT_TRUE(usage[MemoryCategory::OBJECT_TREES] > usage[MemoryCategory::TERRAIN_TREES]);
+	ASSERT_TRUE(usage[MemoryCategory::PHYSICALS] >= 3 * sizeof(MotorizedPhysical));
+	ASSERT_TRUE(usage[MemoryCategory::COMPUTATION_BUFFERS] > 0);
+
+	MemoryAccounting::resetTransientPeaks();
+	MemoryAccounting::recordTransient(MemoryCategory::SERIALIZATION, 300);
+	MemoryAccounting::recordTransient(MemoryCategory::SERIALIZATION, 100);
+	ASSERT_STRICT(world.getMemoryUsage()[MemoryCategory::SERIALIZATION] == 300);
+	MemoryAccounting::resetTransientPeaks();
+	ASSERT_STRICT(world.getMemoryUsage()[MemoryCategory::SERIALIZATION] == 0);
+}
+
+TEST_CASE(debugCaptureRing) {
+	World<Part> world(0.005);
+	world.addTerrainPart(new Part(Box(10.0, 1.0, 10.0), GlobalCFrame(0.0, -1.0, 0.0), {1.0, 1.0, 0.7}));
+	world.addPart(new Part(Box(1.0, 1.0, 1.0), GlobalCFrame(0.0, -0.1, 0.0), {1.0, 1.0, 0.7}));
+
+	// nothing is recorded while the capture is disabled
+	world.tick();
+	ASSERT_STRICT(Debug::getRecordCount() == 0);
+
+	Debug::enableCapture(16);
+	size_t cursor = 0;
+	std::vector<Debug::Record> records;
+	for(int i = 0; i < 20; i++) world.tick();
+	Debug::readRecords(cursor, records);
+	ASSERT_STRICT(records.size() == 16);
+	ASSERT_STRICT(Debug::getRecordCount() == 16);
+	ASSERT_TRUE(Debug::getDroppedRecordCount() > 0);
+
+	bool foundIntersection = false;
+	for(size_t i = 0; i < records.size(); i++) {
+		if(records[i].kind == Debug::RecordKind::POINT && records[i].type == Debug::INTERSECTION) foundIntersection = true;
+		if(i != 0) ASSERT_TRUE(records[i].tick >= records[i - 1].tick);
+	}
+	ASSERT_TRUE(foundIntersection);
+	ASSERT_TRUE(records.front().tick >= 1 && records.back().tick < world.age);
+
+	// only new records are read after the cursor
+	records.clear();
+	Debug::logPoint(Position(1.0, 2.0, 3.0), Debug::CENTER_OF_MASS);
+	Debug::readRecords(cursor, records);
+	ASSERT_STRICT(records.size() == 1);
+	ASSERT_TRUE(records[0].position == Position(1.0, 2.0, 3.0));
+
+	std::ostringstream dump;
+	Debug::dumpCapture(dump);
+	ASSERT_STRICT(dump.str().size() == 32 + 16 * sizeof(Debug::Record));
+	ASSERT_TRUE(dump.str().compare(0, 8, "P3DDEBUG") == 0);
+
+	Debug::disableCapture();
+	world.tick();
+	ASSERT_STRICT(Debug::getRecordCount() == 0);
+}
+
+TEST_CASE(debugCaptureReadWhileLogging) {
+	Debug::enableCapture(64);
+
+	// every record has the same value in all of its fields, a torn record would mix two values
+	std::atomic<int> finishedWriters(0);
+	std::vector<std::thread> writers;
+	for(int w = 0; w < 2; w++) {
+		writers.emplace_back([w, &finishedWriters]() {
+			for(int i = 0; i < 20000; i++) {
+				double value = w * 100000.0 + i;
+				Debug::logVector(Position(value, value, value), Vec3(value, value, value), Debug::INFO_VEC);
+			}
+			finishedWriters++;
+		});
+	}
+
+	size_t cursor = 0;
+	std::vector<Debug::Record> records;
+	bool allRecordsWhole = true;
+	size_t readCount = 0;
+	auto checkRecords = [&]() {
+		for(const Debug::Record& record : records) {
+			double value = record.vector.x;
+			if(record.kind != Debug::RecordKind::VECTOR || !(record.vector == Vec3(value, value, value)) || !(record.position == Position(value, value, value))) {
+				allRecordsWhole = false;
+			}
+		}
+		readCount += records.size();
+		records.clear();
+	};
+	while(finishedWriters < 2) {
+		Debug::readRecords(cursor, records);
+		checkRecords();
+	}
+	for(std::thread& writer : writers) writer.join();
+	Debug::readRecords(cursor, records);
+	checkRecords();
+
+	ASSERT_TRUE(allRecordsWhole);
+	ASSERT_TRUE(readCount > 0);
+	// once logging stopped, every record still in the buffer is committed and read
+	ASSERT_STRICT(cursor == 40000);
+	Debug::disableCapture();
+}
@@ -0,0 +1,509 @@
+#include "testsMain.h"
+
+#include "compare.h"
+#include "../physics/misc/toString.h"
+
+#include <sstream>
+#include <string>
+#include <cmath>
+#include <memory>
+
+#include "../physics/world.h"
+#include "../physics/part.h"
+#include "../physics/physical.h"
+#include "../physics/geometry/basicShapes.h"
+#include "../physics/misc/shapeLibrary.h"
+#include "../physics/misc/gravityForce.h"
+#include "../physics/constraints/motorConstraint.h"
+#include "../physics/datastructures/alignedPtr.h"
+#include "../physics/misc/chunkedSerialization.h"
+#include "../physics/misc/serialization.h"
+#include "../util/serializeBasicTypes.h"
+#include "../physics/misc/deltaSerialization.h"
+#include "../physics/misc/rollbackBuffer.h"
+#include "../physics/misc/tickCapture.h"
+#include "../physics/synchonizedWorld.h"
+#include "../physics/geometry/heightfieldShapeClass.h"
+#include "../physics/geometry/triangleMeshShapeClass.h"
+
+#define ASSERT(x) ASSERT_TOLERANT(x, 0.000001)
+
+static const PartProperties basicProperties{1.0, 0.5, 0.2};
+
+static void buildTestWorld(WorldPrototype& world) {
+	world.addExternalForce(new DirectionalGravity(Vec3(0, -10, 0)));
+	for(int i = 0; i < 10; i++) {
+		world.addPart(new Part(Box(1.0, 2.0, 3.0), GlobalCFrame(i * 3.0, 1.0, 0.0), basicProperties));
+	}
+	Part* a = new Part(Box(1.0, 1.0, 1.0), GlobalCFrame(0.0, 10.0, 0.0), basicProperties);
+	Part* b = new Part(Library::icosahedron, GlobalCFrame(0.0, 12.0, 0.0), basicProperties);
+	Part* c = new Part(Sphere(1.0), GlobalCFrame(0.0, 14.0, 0.0), basicProperties);
+	a->attach(b, new MotorConstraint(Vec3(0, 1, 0), 0.3), CFrame(0, 1, 0), CFrame(0, -1, 0));
+	a->attach(c, CFrame(1, 0, 0));
+	world.addPart(a);
+	world.addTerrainPart(new Part(Box(100.0, 1.0, 100.0), GlobalCFrame(0.0, -1.0, 0.0), basicProperties));
+}
+
+// writes the world to a chunked file and reads it back into loaded, the file and the session must outlive the loaded parts
+struct ChunkedRoundTrip {
+	UniqueAlignedPointer<char> file;
+	std::unique_ptr<ChunkedDeSerializationSession> session;
+
+	ChunkedRoundTrip(const WorldPrototype& world, WorldPrototype& loaded, size_t itemsPerChunk = 4096) {
+		std::ostringstream ostream;
+		ChunkedSerializationSession serializer(std::vector<const ShapeClass*>(), itemsPerChunk);
+		serializer.serializeWorld(world, ostream);
+		std::string bytes = ostream.str();
+
+		// the file would normally be mapped at a page boundary, this makes the polyhedron data zero copy
+		file = UniqueAlignedPointer<char>(bytes.size(), CHUNK_ALIGNMENT);
+		std::copy(bytes.begin(), bytes.end(), file.get());
+
+		session = std::make_unique<ChunkedDeSerializationSession>(file.get(), bytes.size());
+		session->deserializeWorld(loaded);
+	}
+};
+
+TEST_CASE(chunkedWorldRoundTrip) {
+	World<Part> world(0.005);
+	buildTestWorld(world);
+	for(int i = 0; i < 20; i++) world.tick();
+
+	World<Part> loaded(0.005);
+	ChunkedRoundTrip roundTrip(world, loaded, 4);
+
+	ASSERT_STRICT(loaded.physicals.size() == world.physicals.size());
+	ASSERT_STRICT(loaded.getPartCount() == world.getPartCount());
+	ASSERT_STRICT(loaded.externalForces.size() == world.externalForces.size());
+	ASSERT_STRICT(loaded.age == world.age);
+	ASSERT_TRUE(loaded.isValid());
+
+	for(int j = 0; j < 2; j++) {
+		for(size_t i = 0; i < world.physicals.size(); i++) {
+			const MotorizedPhysical& original = *world.physicals[i];
+			const MotorizedPhysical& copy = *loaded.physicals[i];
+			ASSERT(copy.getCFrame() == original.getCFrame());
+			ASSERT(copy.motionOfCenterOfMass.translation.velocity == original.motionOfCenterOfMass.translation.velocity);
+			ASSERT(copy.totalMass == original.totalMass);
+			ASSERT(copy.totalCenterOfMass == original.totalCenterOfMass);
+		}
+		// both worlds must continue identically
+		for(int i = 0; i < 20; i++) {
+			world.tick();
+			loaded.tick();
+		}
+	}
+}
+
+// adds a layer of free parts that only collides with itself and the terrain, and a second terrain layer that only collides with it
+static void buildLayeredTestWorld(WorldPrototype& world) {
+	buildTestWorld(world);
+	int freeLayer = world.createLayer(false);
+	int terrainLayer = world.createLayer(true);
+	world.setLayersCollide(freeLayer, freeLayer, true);
+	world.setLayersCollide(freeLayer, DEFAULT_TERRAIN_LAYER, true);
+	world.setLayersCollide(freeLayer, terrainLayer, true);
+	for(int i = 0; i < 3; i++) {
+		world.addPart(new Part(Box(1.0, 1.0, 1.0), GlobalCFrame(i * 3.0, 5.0, 0.0), basicProperties), freeLayer);
+	}
+	world.addTerrainPart(new Part(Box(10.0, 1.0, 10.0), GlobalCFrame(0.0, 3.0, 0.0), basicProperties), terrainLayer);
+}
+
+static bool haveSameLayers(const WorldPrototype& a, const WorldPrototype& b) {
+	if(a.getLayerCount() != b.getLayerCount()) return false;
+	for(size_t i = 0; i < a.getLayerCount(); i++) {
+		const Layer& layerA = a.getLayer(static_cast<int>(i));
+		const Layer& layerB = b.getLayer(static_cast<int>(i));
+		if(layerA.isTerrainLayer != layerB.isTerrainLayer) return false;
+		if(layerA.tree.getNumberOfObjects() != layerB.tree.getNumberOfObjects()) return false;
+		for(size_t j = 0; j < a.getLayerCount(); j++) {
+			if(a.doLayersCollide(static_cast<int>(i), static_cast<int>(j)) != b.doLayersCollide(static_cast<int>(i), static_cast<int>(j))) return false;
+		}
+	}
+	for(size_t i = 0; i < a.physicals.size(); i++) {
+		if(a.physicals[i]->getMainPart()->layer != b.physicals[i]->getMainPart()->layer) return false;
+	}
+	return true;
+}
+
+TEST_CASE(chunkedWorldLayersRoundTrip) {
+	World<Part> world(0.005);
+	buildLayeredTestWorld(world);
+	ASSERT_FALSE(world.doLayersCollide(DEFAULT_LAYER, world.getLayerCount() - 2));
+
+	World<Part> loaded(0.005);
+	ChunkedRoundTrip roundTrip(world, loaded, 4);
+
+	ASSERT_TRUE(loaded.isValid());
+	ASSERT_STRICT(loaded.getPartCount() == world.getPartCount());
+	ASSERT_TRUE(haveSameLayers(world, loaded));
+}
+
+TEST_CASE(streamWorldLayersRoundTrip) {
+	World<Part> world(0.005);
+	buildLayeredTestWorld(world);
+
+	std::stringstream stream;
+	SerializationSessionPrototype serializer;
+	serializer.serializeWorld(world, stream);
+
+	DeSerializationSessionPrototype deserializer;
+	World<Part> loaded(0.005);
+	deserializer.deserializeWorld(loaded, stream);
+
+	ASSERT_TRUE(loaded.isValid());
+	ASSERT_STRICT(loaded.physicals.size() == world.physicals.size());
+	ASSERT_STRICT(loaded.getPartCount() == world.getPartCount());
+	ASSERT_TRUE(haveSameLayers(world, loaded));
+}
+
+static bool isRejected(const std::string& bytes) {
+	UniqueAlignedPointer<char> buf(bytes.size() + 1, CHUNK_ALIGNMENT);
+	std::copy(bytes.begin(), bytes.end(), buf.get());
+	try {
+		ChunkedDeSerializationSession deserializer(buf, bytes.size());
+		World<Part> loaded(0.005);
+		deserializer.deserializeWorld(loaded);
+	} catch(const SerializationException&) {
+		return true;
+	}
+	return false;
+}
+
+TEST_CASE(chunkedWorldRejectsMalformedFiles) {
+	World<Part> world(0.005);
+	buildTestWorld(world);
+
+	std::ostringstream ostream;
+	ChunkedSerializationSession serializer;
+	serializer.serializeWorld(world, ostream);
+	const std::string bytes = ostream.str();
+	ASSERT_FALSE(isRejected(bytes));
+	ASSERT_TRUE(isRejected(bytes.substr(0, bytes.size() / 2)));
+
+	const ChunkedFileHeader& header = *reinterpret_cast<const ChunkedFileHeader*>(bytes.data());
+	const ChunkDirectoryEntry* directory = reinterpret_cast<const ChunkDirectoryEntry*>(bytes.data() + sizeof(ChunkedFileHeader));
+	size_t shapeTableOffset = 0;
+	size_t physicalsOffset = 0;
+	for(size_t i = 0; i < header.chunkCount; i++) {
+		if(directory[i].type == ChunkType::SHAPE_TABLE) shapeTableOffset = directory[i].offset;
+		if(directory[i].type == ChunkType::PHYSICALS && physicalsOffset == 0) physicalsOffset = directory[i].offset;
+	}
+	const PhysicalsChunkHeader& chunkHeader = *reinterpret_cast<const PhysicalsChunkHeader*>(bytes.data() + physicalsOffset);
+	size_t firstPhysical = physicalsOffset + chunkHeader.physicalsOffset;
+
+	// every corrupted field must be caught before it is used to index the file
+	std::string corrupted = bytes;
+	reinterpret_cast<ChunkedPhysicalRecord*>(&corrupted[firstPhysical])->partCount = 0;
+	ASSERT_TRUE(isRejected(corrupted));
+
+	corrupted = bytes;
+	reinterpret_cast<ChunkedPhysicalRecord*>(&corrupted[firstPhysical])->firstPartIndex = 1000000;
+	ASSERT_TRUE(isRejected(corrupted));
+
+	corrupted = bytes;
+	reinterpret_cast<PhysicalsChunkHeader*>(&corrupted[physicalsOffset])->partsOffset = uint64_t(1) << 62;
+	ASSERT_TRUE(isRejected(corrupted));
+
+	corrupted = bytes;
+	reinterpret_cast<PhysicalsChunkHeader*>(&corrupted[physicalsOffset])->physicalCount = 1000000;
+	ASSERT_TRUE(isRejected(corrupted));
+
+	corrupted = bytes;
+	reinterpret_cast<ChunkedPartRecord*>(&corrupted[physicalsOffset + chunkHeader.partsOffset])->layer = MAX_LAYERS;
+	ASSERT_TRUE(isRejected(corrupted));
+
+	// the default terrain layer can't hold free parts
+	corrupted = bytes;
+	reinterpret_cast<ChunkedPartRecord*>(&corrupted[physicalsOffset + chunkHeader.partsOffset])->layer = DEFAULT_TERRAIN_LAYER;
+	ASSERT_TRUE(isRejected(corrupted));
+
+	// these fail after other parts were decoded, which are freed again
+	corrupted = bytes;
+	reinterpret_cast<ChunkedPartRecord*>(&corrupted[physicalsOffset + chunkHeader.partsOffset])[chunkHeader.partCount - 1].shapeIndex = 1000000;
+	ASSERT_TRUE(isRejected(corrupted));
+
+	const ChunkedPhysicalRecord* physicalRecords = reinterpret_cast<const ChunkedPhysicalRecord*>(bytes.data() + firstPhysical);
+	uint32_t lastMainPart = 0;
+	for(uint32_t i = 0; i < chunkHeader.physicalCount; i++) {
+		if(physicalRecords[i].parentIndex == CHUNK_NO_PARENT) lastMainPart = physicalRecords[i].firstPartIndex;
+	}
+	corrupted = bytes;
+	reinterpret_cast<ChunkedPartRecord*>(&corrupted[physicalsOffset + chunkHeader.partsOffset])[lastMainPart].layer = DEFAULT_TERRAIN_LAYER;
+	ASSERT_TRUE(isRejected(corrupted));
+
+	bool corruptedShape = false;
+	corrupted = bytes;
+	ShapeTableEntry* entries = reinterpret_cast<ShapeTableEntry*>(&corrupted[shapeTableOffset]);
+	for(size_t i = 0; i < directory[0].itemCount; i++) {
+		if(entries[i].kind != ShapeTableEntryKind::KNOWN) {
+			entries[i].dataOffset = ~uint64_t(0) - 8;
+			corruptedShape = true;
+		}
+	}
+	ASSERT_TRUE(corruptedShape);
+	ASSERT_TRUE(isRejected(corrupted));
+}
+
+TEST_CASE(deltaSnapshotReplication) {
+	World<Part> world(0.005);
+	World<Part> replica(0.005);
+	buildTestWorld(world);
+	buildTestWorld(replica);
+
+	DeltaEncoder encoder;
+	DeltaDecoder decoder;
+	encoder.setBase(world);
+	decoder.setBase(replica);
+
+	std::vector<char> delta;
+	ASSERT_STRICT(encoder.encodeDelta(world, delta) == 0);
+
+	for(int i = 0; i < 50; i++) {
+		world.tick();
+		delta.clear();
+		encoder.encodeDelta(world, delta);
+		decoder.applyDelta(replica, delta.data(), delta.size());
+	}
+
+	for(size_t i = 0; i < world.physicals.size(); i++) {
+		const MotorizedPhysical& original = *world.physicals[i];
+		const MotorizedPhysical& copy = *replica.physicals[i];
+		ASSERT_TOLERANT(copy.getCFrame() == original.getCFrame(), 0.001);
+		ASSERT_TOLERANT(copy.motionOfCenterOfMass.translation.velocity == original.motionOfCenterOfMass.translation.velocity, 0.002);
+	}
+	ASSERT_TRUE(replica.isValid());
+
+	// with a tight budget only part of the changes are sent, the rest follows in later deltas
+	world.tick();
+	delta.clear();
+	size_t sent = encoder.encodeDelta(world, delta, 24);
+	ASSERT_TRUE(delta.size() <= 24);
+	ASSERT_TRUE(sent < world.physicals.size());
+	decoder.applyDelta(replica, delta.data(), delta.size());
+}
+
+TEST_CASE(deltaQuantizationLimits) {
+	// the full precision of a Position, on both sides of the origin
+	DeltaQuantization exact;
+	exact.positionFractionBits = 32;
+	World<Part> world(0.005);
+	World<Part> replica(0.005);
+	for(World<Part>* w : {&world, &replica}) {
+		w->addPart(new Part(Box(1.0, 1.0, 1.0), GlobalCFrame(-3.3, 2.0, -7.7), basicProperties));
+		w->addPart(new Part(Box(1.0, 1.0, 1.0), GlobalCFrame(5.1, -2.0, 0.0), basicProperties));
+	}
+	DeltaEncoder encoder(exact);
+	DeltaDecoder decoder(exact);
+	encoder.setBase(world);
+	decoder.setBase(replica);
+
+	world.physicals[0]->getMainPart()->setCFrame(GlobalCFrame(Position(-3.25, 2.5, -7.875)));
+	world.physicals[1]->getMainPart()->setCFrame(GlobalCFrame(Position(-0.0625, -2.0, 0.5)));
+	std::vector<char> delta;
+	encoder.encodeDelta(world, delta);
+	decoder.applyDelta(replica, delta.data(), delta.size());
+	for(size_t i = 0; i < world.physicals.size(); i++) {
+		ASSERT_STRICT(replica.physicals[i]->getCFrame().position == world.physicals[i]->getCFrame().position);
+	}
+
+	// the decoder must reject what the encoder rejects
+	DeltaQuantization invalid;
+	invalid.positionFractionBits = 0;
+	bool rejected = false;
+	try {
+		DeltaDecoder invalidDecoder(invalid);
+	} catch(const std::logic_error&) {
+		rejected = true;
+	}
+	ASSERT_TRUE(rejected);
+}
+
+static void collectCFrames(const Physical& phys, std::vector<GlobalCFrame>& cframes) {
+	cframes.push_back(phys.getCFrame());
+	for(const ConnectedPhysical& child : phys.childPhysicals) {
+		collectCFrames(child, cframes);
+	}
+}
+
+static std::vector<GlobalCFrame> collectCFrames(const WorldPrototype& world) {
+	std::vector<GlobalCFrame> cframes;
+	for(const MotorizedPhysical* phys : world.physicals) {
+		collectCFrames(*phys, cframes);
+	}
+	return cframes;
+}
+
+TEST_CASE(rollbackBufferRestore) {
+	World<Part> world(0.005);
+	buildTestWorld(world);
+
+	RollbackBuffer buffer(10);
+	buffer.reserve(world);
+
+	std::vector<GlobalCFrame> cframesAtAge10;
+	for(int i = 0; i < 20; i++) {
+		buffer.capture(world);
+		world.tick();
+		if(world.age == 10) cframesAtAge10 = collectCFrames(world);
+	}
+	ASSERT_STRICT(buffer.getSnapshotCount() == 10);
+	ASSERT_STRICT(buffer.getNewestAge() == 19);
+	ASSERT_STRICT(buffer.getOldestAge() == 10);
+	ASSERT_FALSE(buffer.hasSnapshot(9));
+
+	std::vector<GlobalCFrame> cframesAtAge20 = collectCFrames(world);
+
+	buffer.restore(world, 10);
+	ASSERT_STRICT(world.age == 10);
+	ASSERT_STRICT(buffer.getSnapshotCount() == 1);
+	ASSERT_TRUE(world.isValid());
+	std::vector<GlobalCFrame> restored = collectCFrames(world);
+	for(size_t i = 0; i < restored.size(); i++) {
+		ASSERT(restored[i] == cframesAtAge10[i]);
+	}
+
+	// resimulating from the restored state must give the same result
+	for(int t = 0; t < 10; t++) {
+		world.tick();
+	}
+	std::vector<GlobalCFrame> resimulated = collectCFrames(world);
+	for(size_t i = 0; i < resimulated.size(); i++) {
+		ASSERT(resimulated[i] == cframesAtAge20[i]);
+	}
+}
+
+TEST_CASE(tickCaptureReplay) {
+	SynchronizedWorld<Part> world(0.005);
+	buildTestWorld(world);
+
+	std::ostringstream ostream;
+	TickCapture capture(ostream, world.deltaT);
+	world.setCapture(&capture);
+	for(int i = 0; i < 30; i++) {
+		if(i % 3 == 0) world.physicals[0]->applyForceAtCenterOfMass(Vec3(0.0, 30.0, 5.0));
+		if(i == 15) world.syncModification([&world]() {
+			world.addPart(new Part(Sphere(0.5), GlobalCFrame(5.0, 6.0, 0.0), basicProperties));
+		});
+		world.tick();
+	}
+	world.setCapture(nullptr);
+	capture.finish(world);
+	ASSERT_STRICT(capture.getKeyframeCount() == 2);
+	ASSERT_STRICT(capture.getTickCount() == 30);
+
+	std::string bytes = ostream.str();
+	UniqueAlignedPointer<char> buf(bytes.size(), CHUNK_ALIGNMENT);
+	std::copy(bytes.begin(), bytes.end(), buf.get());
+
+	TickReplay replay(buf, bytes.size());
+	ASSERT_STRICT(replay.getKeyframeCount() == 2);
+	ASSERT_STRICT(replay.getFirstAge() == 0);
+	ASSERT_STRICT(replay.getEndAge() == world.age);
+	replay.skipTo(replay.getEndAge());
+	ASSERT_TRUE(replay.isFinished());
+
+	const World<Part>& replayed = replay.getWorld();
+	ASSERT_STRICT(replayed.physicals.size() == world.physicals.size());
+	ASSERT_TRUE(replayed.isValid());
+	std::vector<GlobalCFrame> original = collectCFrames(world);
+	std::vector<GlobalCFrame> rerun = collectCFrames(replayed);
+	for(size_t i = 0; i < original.size(); i++) {
+		ASSERT(rerun[i] == original[i]);
+	}
+}
+
+static bool isRejectedTickCapture(const std::string& bytes) {
+	UniqueAlignedPointer<char> buf(bytes.size() + 1, CHUNK_ALIGNMENT);
+	std::copy(bytes.begin(), bytes.end(), buf.get());
+	try {
+		TickReplay replay(buf, bytes.size());
+	} catch(const SerializationException&) {
+		return true;
+	}
+	return false;
+}
+
+TEST_CASE(tickCaptureRejectsMalformedRecords) {
+	SynchronizedWorld<Part> world(0.005);
+	buildTestWorld(world);
+
+	std::ostringstream ostream;
+	TickCapture capture(ostream, world.deltaT);
+	world.setCapture(&capture);
+	world.physicals[0]->applyForceAtCenterOfMass(Vec3(0.0, 30.0, 5.0));
+	world.tick();
+	world.setCapture(nullptr);
+	capture.finish(world);
+	const std::string bytes = ostream.str();
+	ASSERT_FALSE(isRejectedTickCapture(bytes));
+
+	// the first record is the keyframe, its data starts after padding up to CHUNK_ALIGNMENT
+	const size_t firstRecord = sizeof(TickCaptureHeader);
+	ASSERT_TRUE(reinterpret_cast<const TickCaptureRecordHeader*>(&bytes[firstRecord])->type == TickCaptureRecordType::KEYFRAME);
+
+	std::string corrupted = bytes;
+	reinterpret_cast<TickCaptureRecordHeader*>(&corrupted[firstRecord])->size = 1;
+	ASSERT_TRUE(isRejectedTickCapture(corrupted));
+
+	// a size that would wrap around when added to the offset
+	corrupted = bytes;
+	reinterpret_cast<TickCaptureRecordHeader*>(&corrupted[firstRecord])->size = ~uint64_t(0) - 16;
+	ASSERT_TRUE(isRejectedTickCapture(corrupted));
+
+	corrupted = bytes;
+	reinterpret_cast<TickCaptureRecordHeader*>(&corrupted[firstRecord])->type = static_cast<TickCaptureRecordType>(100);
+	ASSERT_TRUE(isRejectedTickCapture(corrupted));
+
+	ASSERT_TRUE(isRejectedTickCapture(bytes.substr(0, bytes.size() - 1)));
+}
+
+TEST_CASE(heightfieldRoundTrip) {
+	std::vector<float> heights(33 * 17);
+	for(size_t i = 0; i < heights.size(); i++) {
+		heights[i] = float(std::sin(i * 0.37));
+	}
+	HeightfieldShapeClass heightfield(33, 17, heights.data());
+
+	World<Part> world(0.005);
+	world.addTerrainPart(new Part(Heightfield(&heightfield, 200.0, 10.0, 100.0), GlobalCFrame(0.0, -5.0, 0.0), basicProperties));
+	world.addPart(new Part(Box(1.0, 1.0, 1.0), GlobalCFrame(0.0, 10.0, 0.0), basicProperties));
+
+	// chunked files store shape classes other than polyhedra with the dynamic ShapeClass serializer
+	World<Part> loaded(0.005);
+	ChunkedRoundTrip roundTrip(world, loaded);
+
+	ASSERT_STRICT(loaded.getPartCount() == 2);
+	const Part& terrain = *loaded.iterParts(TERRAIN_PARTS).begin();
+	ASSERT_TRUE(terrain.hitbox.baseShape->intersectionClassID == HEIGHTFIELD_CLASS_ID);
+	const HeightfieldShapeClass& loadedHeightfield = static_cast<const HeightfieldShapeClass&>(*terrain.hitbox.baseShape);
+	ASSERT_STRICT(loadedHeightfield.getSamplesX() == 33);
+	ASSERT_STRICT(loadedHeightfield.getSamplesZ() == 17);
+	ASSERT_TRUE(loadedHeightfield.getQuantizedHeights() == heightfield.getQuantizedHeights());
+	ASSERT_STRICT(terrain.hitbox.getWidth() == 200.0);
+	ASSERT_STRICT(terrain.hitbox.getHeight() == 10.0);
+	ASSERT_STRICT(terrain.hitbox.getDepth() == 100.0);
+}
+
+TEST_CASE(triangleMeshRoundTrip) {
+	Polyhedron mesh = Library::createBox(3.0f, 1.0f, 2.0f);
+	Shape meshShape = TriangleMesh(mesh);
+	const TriangleMeshShapeClass& meshClass = static_cast<const TriangleMeshShapeClass&>(*meshShape.baseShape);
+
+	World<Part> world(0.005);
+	world.addTerrainPart(new Part(meshShape, GlobalCFrame(0.0, -5.0, 0.0), basicProperties));
+
+	World<Part> loaded(0.005);
+	ChunkedRoundTrip roundTrip(world, loaded);
+
+	ASSERT_STRICT(loaded.getPartCount() == 1);
+	const Part& terrain = *loaded.iterParts(TERRAIN_PARTS).begin();
+	ASSERT_TRUE(terrain.hitbox.baseShape->intersectionClassID == TRIANGLE_MESH_CLASS_ID);
+	const TriangleMeshShapeClass& loadedMesh = static_cast<const TriangleMeshShapeClass&>(*terrain.hitbox.baseShape);
+	ASSERT_STRICT(loadedMesh.getVertices().size() == meshClass.getVertices().size());
+	ASSERT_STRICT(loadedMesh.getTriangles().size() == meshClass.getTriangles().size());
+	// the triangles are stored in tree order, so the rebuilt tree matches
+	ASSERT_STRICT(loadedMesh.getNodes().size() == meshClass.getNodes().size());
+	ASSERT_TRUE(loadedMesh.containsPoint(Vec3(0.2, 0.3, -0.4)));
+	ASSERT_STRICT(terrain.hitbox.getWidth() == 3.0);
+}
@@ -0,0 +1,117 @@
+#include "mappedFile.h"
+
+#include <string>
+#include <utility>
+
+#include "serializeBasicTypes.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#undef ERROR
+
+MappedFile::MappedFile(const char* fileName) : data(nullptr), size(0), fileHandle(INVALID_HANDLE_VALUE), mappingHandle(nullptr) {
+	fileHandle = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+	if(fileHandle == INVALID_HANDLE_VALUE) {
+		throw SerializationException("Could not open file " + std::string(fileName));
+	}
+
+	LARGE_INTEGER fileSize;
+	if(!GetFileSizeEx(fileHandle, &fileSize)) {
+		close();
+		throw SerializationException("Could not read size of file " + std::string(fileName));
+	}
+	size = static_cast<size_t>(fileSize.QuadPart);
+	if(size == 0) return;
+
+	mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if(mappingHandle == nullptr) {
+		close();
+		throw SerializationException("Could not map file " + std::string(fileName));
+	}
+
+	data = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	if(data == nullptr) {
+		close();
+		throw SerializationException("Could not map view of file " + std::string(fileName));
+	}
+}
+
+void MappedFile::close() {
+	if(data != nullptr) UnmapViewOfFile(data);
+	if(mappingHandle != nullptr) CloseHandle(mappingHandle);
+	if(fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+	data = nullptr;
+	mappingHandle = nullptr;
+	fileHandle = INVALID_HANDLE_VALUE;
+	size = 0;
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept : data(other.data), size(other.size), fileHandle(other.fileHandle), mappingHandle(other.mappingHandle) {
+	other.data = nullptr;
+	other.size = 0;
+	other.fileHandle = INVALID_HANDLE_VALUE;
+	other.mappingHandle = nullptr;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+	std::swap(data, other.data);
+	std::swap(size, other.size);
+	std::swap(fileHandle, other.fileHandle);
+	std::swap(mappingHandle, other.mappingHandle);
+	return *this;
+}
+
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const char* fileName) : data(nullptr), size(0), fileDescriptor(-1) {
+	fileDescriptor = open(fileName, O_RDONLY);
+	if(fileDescriptor == -1) {
+		throw SerializationException("Could not open file " + std::string(fileName));
+	}
+
+	struct stat fileInfo;
+	if(fstat(fileDescriptor, &fileInfo) != 0) {
+		close();
+		throw SerializationException("Could not read size of file " + std::string(fileName));
+	}
+	size = static_cast<size_t>(fileInfo.st_size);
+	if(size == 0) return;
+
+	void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	if(mapping == MAP_FAILED) {
+		close();
+		throw SerializationException("Could not map file " + std::string(fileName));
+	}
+	data = static_cast<const char*>(mapping);
+}
+
+void MappedFile::close() {
+	if(data != nullptr) munmap(const_cast<char*>(data), size);
+	if(fileDescriptor != -1) ::close(fileDescriptor);
+	data = nullptr;
+	fileDescriptor = -1;
+	size = 0;
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept : data(other.data), size(other.size), fileDescriptor(other.fileDescriptor) {
+	other.data = nullptr;
+	other.size = 0;
+	other.fileDescriptor = -1;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+	std::swap(data, other.data);
+	std::swap(size, other.size);
+	std::swap(fileDescriptor, other.fileDescriptor);
+	return *this;
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+	close();
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+
+/*
+	A read-only view of a file mapped into memory. 
+	The contents are paged in lazily by the OS, so opening a large file is cheap and only the accessed parts are ever read. 
+	The view stays valid for as long as the MappedFile exists. 
+*/
+class MappedFile {
+	const char* data;
+	size_t size;
+#ifdef _WIN32
+	void* fileHandle;
+	void* mappingHandle;
+#else
+	int fileDescriptor;
+#endif
+
+	void close();
+public:
+	// throws SerializationException if the file could not be opened or mapped
+	MappedFile(const char* fileName);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	inline const char* getData() const { return data; }
+	inline size_t getSize() const { return size; }
+};